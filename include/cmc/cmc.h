@@ -17,6 +17,7 @@
 #include "../common/taus113-v2.h"
 #include "../fewbody-0.24/fewbody.h"
 #include "cmc_core.h"
+#include "cmc_evlog.h"
 #include "CMCConfig.h"
 #include "stdarg.h"
 #include "cmc_mpi.h"
@@ -43,15 +44,6 @@
 //void append_to_table(int which_table, int num, ...);
 
 
-/*-------------------------------------------------------------------------
- * Table API example
- *
- * Save snapshots as HDF5 Tables
- *
- *-------------------------------------------------------------------------
- */
-#define NFIELDS  (hsize_t)  62
-
 /*************************** Parameters ******************************/
 /* Large number, but still SF_INFINITY - 1 <> SF_INFINITY */
 #define SF_INFINITY 1.0e10
@@ -96,9 +88,10 @@
 
 #define MAX_STRING_LENGTH 2048
 
-//MPI: For MPI-IO
-#define STR_BUF_LEN 10000
-#define STR_WRBUF_LEN 100000000
+//MPI: For MPI-IO, initial size of the output buffers; they grow as needed
+#define PARABUF_MIN 65536
+//MPI: Largest number of files flushed together by PrintParaFileOutput
+#define MPI_PARA_MAXFILES 32
 
 /*-------------------------------------------------------------c
 *
@@ -123,81 +116,6 @@
 *
 *-------------------------------------------------------------*/
 
-/*-------------------------------------------------------------------------
- * Table API example
- *
- * Save snapshots as HDF5 Tables
- *
- * #1:id #2:m[MSUN] #3:r #4:vr #5:vt #6:E #7:J #8:binflag #9:m0[MSUN] #10:m1[MSUN] #11:id0 #12:id1 #13:a[AU] #14:e #15:startype #16:luminosity[LSUN] #17:radius[RSUN]  #18:bin_startype0 #19:bin_startype1 #20:bin_star_lum0[LSUN] #21:bin_star_lum1[LSUN] #22:bin_star_radius0[RSUN] #23:bin_star_radius1[RSUN] 24.bin.Eb 25.eta 26.star.phi#27:rad0 #28:rad1 #29:tb #30:lum0 #31:lum1 #32:massc0 #33:massc1 #34:radc0 #35:radc1 #36:menv0 #37:menv1 #38:renv0 #39:renv1 #40:tms0 #41:tms1 #42:dmdt0 #43:dmdt1 #44:radrol0 #45:radrol1 #46:ospin0 #47:ospin1 #48:B0 #49:B1 #50:formation0 #51:formation1 #52:bacc0 #53:bacc1 #54:tacc0 $55:tacc1 #56:mass0_0 #57:mass0_1 #58:epoch0 #59:epoch1 #60:ospin #61:B #62:formation
- *-------------------------------------------------------------------------
- */
-
- typedef struct Snapshot
- {
-  long id;
-  double m;
-  double r;
-  double vr;
-  double vt;
-  double E;
-  double J;
-  long binflag;
-  double m0;
-  double m1;
-  long id0;
-  long id1;
-  double a;
-  double e;
-  int startype;
-  double luminosity;
-  double radius;
-  int bin_startype0;
-  int bin_startype1;
-  double bin_star_lum0;
-  double bin_star_lum1;
-  double bin_star_radius0;
-  double bin_star_radius1;
-  double bin_Eb;
-  double eta;
-  double star_phi;
-  double rad0;
-  double rad1;
-  double tb;
-  double lum0;
-  double lum1;
-  double massc0;
-  double massc1;
-  double radc0;
-  double radc1;
-  double menv0;
-  double menv1;
-  double renv0;
-  double renv1;
-  double tms0;
-  double tms1;
-  double dmdt0;
-  double dmdt1;
-  double radrol0;
-  double radrol1;
-  double ospin0;
-  double ospin1;
-  double B0;
-  double B1;
-  double formation0;
-  double formation1;
-  double bacc0;
-  double bacc1;
-  double tacc0;
-  double tacc1;
-  double mass0_0;
-  double mass0_1;
-  double epoch0;
-  double epoch1;
-  double ospin;
-  double B;
-  double formation;
- } Snapshot;
-
 //#1:time #2:k1 #3:k2 #4:k3 #5:id1 #6:id2 #7:id3 #8:m1 #9:m2 #10:m3 #11:type1 #12:type2 #13:type3 #14:rad1 #15:rad2 #16:rad3 #17:Eb #18:ecc #19:a(au) #20:rp(au)
 typedef struct LightCollision
 {
@@ -514,6 +432,14 @@ typedef struct{
 */
 	double zams_mass;
 /**
+* @brief whether the star is still on its unperturbed single-star track (see SE_TRACK_CACHE)
+*/
+	int se_pristine;
+/**
+* @brief wall time (s) of the last BSE call for this object; used to predict its cost (see SE_BALANCE)
+*/
+	double se_cost;
+/**
 * @brief stellar types (see bse_wrap/bse/bse.f for the list)
 */
 	int se_k;
@@ -740,6 +666,16 @@ typedef struct{
 * @brief Units used for time window parameters. Possible choices: Gyr, Trel, and Tcr
 */
         int SNAPSHOT_WINDOW_UNITS;
+#define PARAMDOC_SNAPSHOT_WINDOW_FIELDS "Columns to write in the snapshots of each time window. \n#The format is fields_w0;fields_w1 ... etc., each one all, basic, or a comma separated list of column names" 
+/**
+* @brief Columns to write in the snapshots of each time window. The format is fields_w0;fields_w1 ... etc., each one all, basic, or a comma separated list of column names
+*/
+        int SNAPSHOT_WINDOW_FIELDS;
+#define PARAMDOC_SNAPSHOT_WINDOW_SAMPLE "Subsampling of the snapshots of each time window. \n#The format is sample_w0;sample_w1 ... etc., each one all, random:<fraction> or radial:<stride>" 
+/**
+* @brief Subsampling of the snapshots of each time window. The format is sample_w0;sample_w1 ... etc., each one all, random:<fraction> or radial:<stride>
+*/
+        int SNAPSHOT_WINDOW_SAMPLE;
 #define PARAMDOC_IDUM "random number generator seed"
 /**
 * @brief random number generator seed
@@ -1390,8 +1326,170 @@ typedef struct{
 * @brief enable or disable timers. This would return a detailed profiling of the code, but uses barriers, so might slow down the code a bit.
 */
 	int TIMER;
+#define PARAMDOC_SE_TRACK_CACHE "use precomputed single-star evolutionary tracks for unperturbed single stars (0=off, 1=on, 2=validate the tracks against BSE)"
+/**
+* @brief use precomputed single-star evolutionary tracks for unperturbed single stars (0=off, 1=on, 2=validate the tracks against BSE)
+*/
+	int SE_TRACK_CACHE;
+#define PARAMDOC_SE_TRACK_CACHE_NMASS "number of ZAMS mass grid points in the single-star track cache"
+/**
+* @brief number of ZAMS mass grid points in the single-star track cache
+*/
+	int SE_TRACK_CACHE_NMASS;
+#define PARAMDOC_SE_TRACK_CACHE_NTIME "number of (logarithmically spaced) time points per track in the single-star track cache"
+/**
+* @brief number of (logarithmically spaced) time points per track in the single-star track cache
+*/
+	int SE_TRACK_CACHE_NTIME;
+#define PARAMDOC_SE_TRACK_CACHE_FILE "file to load the single-star track cache from (it is built and written there if missing or incompatible)"
+/**
+* @brief file to load the single-star track cache from (it is built and written there if missing or incompatible)
+*/
+	int SE_TRACK_CACHE_FILE;
+#define PARAMDOC_PETERS_FAST_PATH_TOL "binary BHs with a timestep shorter than this fraction of their GW inspiral time are advanced with fixed RK4 steps instead of the adaptive GSL integrator (0 to always use GSL)"
+/**
+* @brief binary BHs with a timestep shorter than this fraction of their GW inspiral time are advanced with fixed RK4 steps instead of the adaptive GSL integrator (0 to always use GSL)
+*/
+	int PETERS_FAST_PATH_TOL;
+#define PARAMDOC_SE_OVERLAP "interpolate the single-star track cache on a worker thread while the dynamics runs (needs SE_TRACK_CACHE=1)"
+/**
+* @brief interpolate the single-star track cache on a worker thread while the dynamics runs (needs SE_TRACK_CACHE=1)
+*/
+	int SE_OVERLAP;
+#define PARAMDOC_SE_COST_PROFILE "print the time spent in BSE and fewbody per processor and the most expensive object of each timestep to the log file"
+/**
+* @brief print the time spent in BSE and fewbody per processor and the most expensive object of each timestep to the log file
+*/
+	int SE_COST_PROFILE;
+#define PARAMDOC_SE_BALANCE "redistribute the BSE evolution of single stars among the processors according to their measured cost"
+/**
+* @brief redistribute the BSE evolution of single stars among the processors according to their measured cost
+*/
+	int SE_BALANCE;
+#define PARAMDOC_BININT_INTEGRATOR "integrator for binary interactions in fewbody (0=Runge-Kutta rk8pd, 1=algorithmic regularization with Bulirsch-Stoer extrapolation, 2=the latter only for encounters with PN terms)"
+/**
+* @brief integrator for binary interactions in fewbody (0=Runge-Kutta rk8pd, 1=algorithmic regularization with Bulirsch-Stoer extrapolation, 2=the latter only for encounters with PN terms)
+*/
+	int BININT_INTEGRATOR;
+#define PARAMDOC_BININT_THREADS "number of threads for binary interactions (0=do each fewbody scattering as it comes up; N>0=collect the scatterings of the timestep and run them on N threads)"
+/**
+* @brief number of threads for binary interactions (0=do each fewbody scattering as it comes up; N>0=collect the scatterings of the timestep and run them on N threads)
+*/
+	int BININT_THREADS;
+#define PARAMDOC_BININT_BALANCE "move queued binary interactions from busy to idle processors before integrating them (0=off, 1=on; implies batching, see BININT_THREADS)"
+/**
+* @brief move queued binary interactions from busy to idle processors before integrating them (0=off, 1=on; implies batching, see BININT_THREADS)
+*/
+	int BININT_BALANCE;
+#define PARAMDOC_BININT_FLYBY "replace fewbody by an analytic secular estimate for distant flybys whose pericenter exceeds this many binary apocenters (0=always use fewbody)"
+/**
+* @brief replace fewbody by an analytic secular estimate for distant flybys whose pericenter exceeds this many binary apocenters (0=always use fewbody)
+*/
+	int BININT_FLYBY;
+#define PARAMDOC_BININT_FLYBY_VALIDATE "integrate the encounters selected by BININT_FLYBY with fewbody as well, keep the fewbody outcome and log how far the analytic one was off (0=off, 1=on)"
+/**
+* @brief integrate the encounters selected by BININT_FLYBY with fewbody as well, keep the fewbody outcome and log how far the analytic one was off (0=off, 1=on)
+*/
+	int BININT_FLYBY_VALIDATE;
+#define PARAMDOC_BININT_MAX_STEPS "limit fewbody to this many integration steps per binary interaction, ten times that for black hole encounters with PN terms, instead of 60 s of CPU time (0=use the CPU time limit)"
+/**
+* @brief limit fewbody to this many integration steps per binary interaction, ten times that for black hole encounters with PN terms, instead of 60 s of CPU time (0=use the CPU time limit)
+*/
+	int BININT_MAX_STEPS;
+#define PARAMDOC_BININT_ESCALATE "with BININT_MAX_STEPS and queued binary interactions, first try each one with 1/BININT_ESCALATE of the step limit, and leave the ones that need more to the end of the timestep (0=off)"
+/**
+* @brief with BININT_MAX_STEPS and queued binary interactions, first try each one with 1/BININT_ESCALATE of the step limit, and leave the ones that need more to the end of the timestep (0=off)
+*/
+	int BININT_ESCALATE;
+#define PARAMDOC_BININT_DUMP "write the fewbody inputs of every binary interaction to <outprefix>.binint.<rank>.fb.gz, for fewbody_bench_replay (0=off)"
+/**
+* @brief write the fewbody inputs of every binary interaction to <outprefix>.binint.<rank>.fb.gz, for fewbody_bench_replay (0=off)
+*/
+	int BININT_DUMP;
+#define PARAMDOC_BININT_PN_RPERI "with BH_CAPTURE, turn on the post-Newtonian terms only for encounters whose estimated closest approach is within BININT_PN_RPERI gravitational radii (0=whenever BH_CAPTURE asks for them)"
+/**
+* @brief with BH_CAPTURE, turn on the post-Newtonian terms only for encounters whose estimated closest approach is within BININT_PN_RPERI gravitational radii (0=whenever BH_CAPTURE asks for them)
+*/
+	int BININT_PN_RPERI;
+#define PARAMDOC_BININT_WEAK_E "integrate binary interactions whose energy is below BININT_WEAK_E times the magnitude of the total energy of the cluster with the accuracy BININT_WEAK_ACC (0=off)"
+/**
+* @brief integrate binary interactions whose energy is below BININT_WEAK_E times the magnitude of the total energy of the cluster with the accuracy BININT_WEAK_ACC (0=off)
+*/
+	int BININT_WEAK_E;
+#define PARAMDOC_BININT_WEAK_ACC "absolute and relative accuracy of the integrator for the binary interactions picked out by BININT_WEAK_E"
+/**
+* @brief absolute and relative accuracy of the integrator for the binary interactions picked out by BININT_WEAK_E
+*/
+	int BININT_WEAK_ACC;
+#define PARAMDOC_BININT_POLICY_VALIDATE "also integrate every BININT_POLICY_VALIDATE-th binary interaction relaxed by BININT_PN_RPERI or BININT_WEAK_E with the full accuracy and post-Newtonian terms, to measure the time saved (0=off)"
+/**
+* @brief also integrate every BININT_POLICY_VALIDATE-th binary interaction relaxed by BININT_PN_RPERI or BININT_WEAK_E with the full accuracy and post-Newtonian terms, to measure the time saved (0=off)
+*/
+	int BININT_POLICY_VALIDATE;
+#define PARAMDOC_BINARY_LOGS "write the escape, collision, semergedisrupt and bhmerger logs as fixed-size binary records (<prefix>.esc.bin etc.) instead of text; cmc_logconv turns them back into the text files"
+/**
+* @brief write the escape log as fixed-size binary records (<prefix>.esc.bin) instead of text (<prefix>.esc.dat); cmc_logconv turns it back into the text file
+*/
+	int BINARY_LOGS;
+#define PARAMDOC_SNAPSHOT_IO_MODE "how snapshots are written: 0=each node appends its stars to the file in turn, 1=the root node collects the stars and writes them, 2=all nodes write at once with parallel HDF5 (needs an HDF5 built with MPI, otherwise 1 is used)"
+/**
+* @brief how snapshots are written: 0=each node appends its stars to the file in turn, 1=the root node collects the stars and writes them, 2=all nodes write at once with parallel HDF5 (needs an HDF5 built with MPI, otherwise 1 is used)
+*/
+	int SNAPSHOT_IO_MODE;
+#define PARAMDOC_SNAPSHOT_CHUNK "number of stars per chunk of the HDF5 snapshot tables"
+/**
+* @brief number of stars per chunk of the HDF5 snapshot tables
+*/
+	int SNAPSHOT_CHUNK;
+#define PARAMDOC_SNAPSHOT_COMPRESS "compression of the HDF5 snapshot tables: 0=none, 1=gzip, 2=shuffle+gzip, 3=lz4, 4=zstd (3 and 4 need the HDF5 filter plugins)"
+/**
+* @brief compression of the HDF5 snapshot tables: 0=none, 1=gzip, 2=shuffle+gzip, 3=lz4, 4=zstd (3 and 4 need the HDF5 filter plugins)
+*/
+	int SNAPSHOT_COMPRESS;
+#define PARAMDOC_SNAPSHOT_COMPRESS_LEVEL "compression level for gzip (1-9) and zstd (1-22) compression of the HDF5 snapshot tables"
+/**
+* @brief compression level for gzip (1-9) and zstd (1-22) compression of the HDF5 snapshot tables
+*/
+	int SNAPSHOT_COMPRESS_LEVEL;
+#define PARAMDOC_ASYNC_IO "write snapshots and checkpoints on a background I/O thread while the run goes on (0=off, 1=on)"
+/**
+* @brief write snapshots and checkpoints on a background I/O thread while the run goes on (0=off, 1=on)
+*/
+	int ASYNC_IO;
+#define PARAMDOC_RESTART_FORMAT "format of the checkpoints: 0=one raw file per processor, restartable on the same number of processors only; 1=one shared file holding only the live stars and binaries, restartable on any number of processors"
+/**
+* @brief format of the checkpoints: 0=one raw file per processor, restartable on the same number of processors only; 1=one shared file holding only the live stars and binaries, restartable on any number of processors
+*/
+	int RESTART_FORMAT;
+#define PARAMDOC_CHECKPOINT_FULL_INTERVAL "every how many checkpoints a full one is written; those in between hold only the blocks changed since the last full one (0 or 1=all full)"
+/**
+* @brief every how many checkpoints a full one is written; those in between hold only the blocks changed since the last full one (0 or 1=all full)
+*/
+	int CHECKPOINT_FULL_INTERVAL;
+#define PARAMDOC_CHECKPOINT_COMPRESS "compression of the full per-processor checkpoints: 0=none, 1=zlib, 2=byte shuffle of the star and binary records, then zlib"
+/**
+* @brief compression of the full per-processor checkpoints: 0=none, 1=zlib, 2=byte shuffle of the star and binary records, then zlib
+*/
+	int CHECKPOINT_COMPRESS;
 } parsed_t;
 
+/**
+* @brief  append-only text buffer for output that is flushed to file with MPI-IO
+*/
+typedef struct{
+/**
+* @brief  null-terminated contents
+*/
+	char *s;
+/**
+* @brief  number of characters in the buffer
+*/
+	long long len;
+/**
+* @brief  allocated size
+*/
+	long long size;
+} parabuf_t;
 
 /**
 * @brief  struct containing the units used
@@ -1713,6 +1811,240 @@ typedef struct{
 	double rh;
 } clusdyn_struct_t;
 
+/**
+* @brief quantities tabulated for each point of a single-star track
+*/
+enum {SE_TRACK_KW, SE_TRACK_MASS0, SE_TRACK_MT, SE_TRACK_RADIUS, SE_TRACK_LUM, SE_TRACK_MC, SE_TRACK_RC,
+	SE_TRACK_MENV, SE_TRACK_RENV, SE_TRACK_OSPIN, SE_TRACK_EPOCH, SE_TRACK_TMS, SE_TRACK_NQ};
+
+/**
+* @brief table of single-star tracks on a log(ZAMS mass) x log(time) grid for one metallicity
+*/
+typedef struct{
+/**
+* @brief metallicity the tracks were computed for
+*/
+	double metallicity;
+/**
+* @brief number of grid points in mass and time
+*/
+	int nmass, ntime;
+/**
+* @brief log10 of the ZAMS mass range (MSUN)
+*/
+	double lmmin, lmmax;
+/**
+* @brief log10 of the time range (Myr)
+*/
+	double ltmin, ltmax;
+/**
+* @brief track data, SE_TRACK_NQ doubles per point, indexed as [(imass*ntime+itime)*SE_TRACK_NQ+q]
+*/
+	double *p;
+/**
+* @brief number of single-star updates done from the table, with BSE, and validated against BSE
+*/
+	long ncached, nbse, nvalidated;
+/**
+* @brief maximum relative error of the tabulated mass, radius and luminosity in validation mode
+*/
+	double maxerr_mt, maxerr_radius, maxerr_lum;
+/**
+* @brief number of single-star updates taken from the states prefetched during the dynamics (see SE_OVERLAP)
+*/
+	long nprefetched;
+/**
+* @brief number of local stars covered by the prefetch, the time it was done for, and the capacity of the arrays
+*/
+	long npre, npre_alloc;
+	double pre_tphys;
+/**
+* @brief ZAMS mass and stellar type of each star when the prefetch was started
+*/
+	double *pre_zams;
+	int *pre_kw;
+/**
+* @brief prefetched states, SE_TRACK_NQ doubles per local star (kw=-1 if the star could not be interpolated)
+*/
+	double *pre;
+} se_track_table_t;
+
+/**
+* @brief Peters-equation state of all binary black holes of a timestep, advanced together by the fast path
+*/
+typedef struct{
+/**
+* @brief number of binaries in the batch
+*/
+	long n;
+/**
+* @brief batch position of each local star index up to kmax (-1 if the star is not in the batch)
+*/
+	long *slot, kmax;
+/**
+* @brief semi-major axis and eccentricity (code units), updated in place
+*/
+	double *a, *e;
+/**
+* @brief Peters prefactor m1*m2*(m1+m2)*madhoc^3/c^5 in code units
+*/
+	double *mG3c5;
+/**
+* @brief pericenter distance below which the binary merges
+*/
+	double *rmin;
+/**
+* @brief PETERS_DONE, PETERS_MERGED or PETERS_NEAR_MERGER (left to the GSL integrator)
+*/
+	int *status;
+} peters_batch_t;
+
+/**
+* @brief BSE state of a single star, evolved on whichever processor has the time (see SE_BALANCE)
+*/
+typedef struct{
+/**
+* @brief local index of the star on the owning processor, and its id
+*/
+	long k, id;
+/**
+* @brief ZAMS mass (MSUN)
+*/
+	double zams_mass;
+/**
+* @brief stellar type
+*/
+	int kw;
+/**
+* @brief BSE state, same meaning as the se_* fields of star_t
+*/
+	double mass0, mt, radius, lum, mc, rc, menv, renv, ospin, B_0, bacc, tacc, epoch, tms, bhspin, tphys;
+/**
+* @brief pulsar information extracted from the bcm array
+*/
+	double scm_formation, scm_B;
+/**
+* @brief kick velocities returned by BSE
+*/
+	double vs[20];
+/**
+* @brief wall time (s) of the BSE call
+*/
+	double cost;
+} se_task_t;
+
+/**
+* @brief time spent in BSE and fewbody on this processor during the current timestep
+*/
+typedef struct{
+/**
+* @brief total time (s) and number of BSE calls, and the most expensive one with the id of its star
+*/
+	double se_time, se_max;
+	long se_n, se_max_id;
+/**
+* @brief total time (s) and number of fewbody calls, and the most expensive one with the id of one of the objects
+*/
+	double fb_time, fb_max;
+	long fb_n, fb_max_id;
+/**
+* @brief number of single-star BSE tasks sent to and received from other processors
+*/
+	long nsent, nrecv;
+} se_cost_profile_t;
+
+/* how the outcome of a binary interaction was found */
+#define BININT_PATH_FEWBODY 0 /* integrated with fewbody */
+#define BININT_PATH_FLYBY 1 /* analytic distant flyby (see BININT_FLYBY) */
+#define BININT_PATH_VALIDATE 2 /* both, keeping the fewbody outcome (see BININT_FLYBY_VALIDATE) */
+
+/* what the accuracy policy relaxed for a binary interaction */
+#define BININT_RELAX_PN 1 /* post-Newtonian terms off (see BININT_PN_RPERI) */
+#define BININT_RELAX_ACC 2 /* looser accuracy (see BININT_WEAK_E) */
+
+/**
+* @brief the fewbody settings the accuracy policy may change
+*/
+typedef struct{
+	int PN1, PN2, PN25, PN3, PN35, integrator;
+	double absacc, relacc;
+} binint_accuracy_t;
+
+/**
+* @brief a binary-single or binary-binary encounter, set up in the pair loop and integrated separately (see BININT_THREADS)
+*/
+typedef struct{
+/**
+* @brief local indices of the two interacting objects
+*/
+	long k, kp;
+/**
+* @brief type of interaction
+*/
+	int isbinbin;
+/**
+* @brief encounter parameters as passed to binint_do()
+*/
+	double rperi, w[4], W, rcm, vcm[4];
+/**
+* @brief initial binding energy, fewbody time and maximum impact parameter
+*/
+	double BEi, t, bmax;
+/**
+* @brief wall time (s) of the fewbody call
+*/
+	double cost;
+/**
+* @brief how the outcome was found (BININT_PATH_*), and with BININT_FLYBY_VALIDATE
+* whether fewbody disagreed with the analytic outcome and by how much in e
+*/
+	int path, mismatch;
+	double flyby_de;
+/**
+* @brief whether the encounter was put aside for a second round with the full step limit (see BININT_ESCALATE)
+*/
+	int escalated;
+/**
+* @brief what the accuracy policy relaxed (BININT_RELAX_* bits), and the settings it started from
+*/
+	int relaxed;
+	binint_accuracy_t full;
+/**
+* @brief with BININT_POLICY_VALIDATE, whether the encounter is also integrated with
+* the full settings, and the wall time (s) and |DeltaE/E| of that integration
+*/
+	int sampled;
+	double full_cost, full_de;
+/**
+* @brief units of the encounter in cluster units, and the fewbody units and parameters
+*/
+	fb_units_t cmc_units, fb_units;
+	fb_input_t input;
+	fb_hier_t hier;
+	fb_ret_t retval;
+/**
+* @brief random streams used by fewbody; point to the task's own streams when batched
+*/
+	gsl_rng *rng;
+	struct rng_t113_state *rng_st, st;
+/**
+* @brief seed of the task's own streams
+*/
+	unsigned long seed;
+/**
+* @brief processor the encounter is integrated on (see BININT_BALANCE)
+*/
+	int dest;
+/**
+* @brief input part of the binint log, written out when the outcome is applied
+*/
+	char *log;
+} binint_task_t;
+
+#define PETERS_DONE 0
+#define PETERS_MERGED 1
+#define PETERS_NEAR_MERGER 2
+
 /********************** Function Declarations ************************/
 double sqr(double x);
 double cub(double x);
@@ -1797,7 +2129,13 @@ long FindZero_r_serial(long kmin, long kmax, double r);
 long FindZero_r(long x1, long x2, double r);
 long FindZero_Q(long j, long x1, long x2, double E, double J);
 double potentialDifference(int particleIndex);
-void mpi_para_file_write(char* wrbuf, long long *len, long long *prev_cum_offset, MPI_File* fh);
+void parabuf_reserve(parabuf_t *b, long long n);
+void parabuf_printf(parabuf_t *b, const char *fmt, ...);
+void parabuf_append(parabuf_t *b, const void *data, long long n);
+void parabuf_truncate(parabuf_t *b, long long len);
+void parabuf_free(parabuf_t *b);
+void mpi_para_file_write(parabuf_t *wrbuf, long long *prev_cum_offset, MPI_File* fh);
+void mpi_para_files_write(int n, parabuf_t **wrbuf, long long **prev_cum_offset, MPI_File **fh);
 void ComputeEnergy(void);
 void mpi_close_node_buffers(void);
 void para_file_write(char* wrbuf, long long *len, long long *prev_cum_offset, MPI_File* fh);
@@ -1823,6 +2161,8 @@ void print_bh_snapshot(void);
 void get_physical_units(void);
 void update_vars(void);
 void save_restart_file(void);
+void aio_wait(void);
+void aio_finish(void);
 
 void print_version(FILE *stream);
 void cmc_print_usage(FILE *stream, char *argv[]);
@@ -1864,8 +2204,34 @@ void cp_SEvars_to_newbinary(long oldk, int oldkbi, long knew, int kbinew);
 void cp_starSEvars_to_binmember(star_t instar, long binindex, int bid);
 void cp_starmass_to_binmember(star_t instar, long binindex, int bid);
 void integrate_a_e_peters_eqn(long binidx);
+void peters_rhs(double mG3c5, double a, double e, double *dadt, double *dedt);
+void peters_apply(long kb, double a, double e, int collision);
+void peters_fast_path(long n, double *a, double *e, double *mG3c5, double *rmin, double t_final, int *status);
+void peters_batch_init(peters_batch_t *pb);
+int peters_batch_apply(peters_batch_t *pb, long k, long kb);
+void peters_batch_free(peters_batch_t *pb);
 double r_of_m(double M);
 void cmc_bse_comenv(binary_t *tempbinary, double cmc_l_unit, double RbloodySUN, double *zpars, double *vs, int *fb);
+void se_track_build(int im);
+int se_track_load(double lmmin, double lmmax, double ltmax);
+void se_track_save(void);
+void se_track_cache_init(void);
+void se_track_cache_free(void);
+int se_track_lookup(long k, double tphys, double *q);
+int se_track_evolve(long k, double tphysf);
+void se_track_validate(long k, double *q);
+void se_track_print_stats(void);
+void se_overlap_start(double tphysf);
+void se_overlap_finish(void);
+void se_task_from_star(se_task_t *t, long k);
+void se_task_to_star(se_task_t *t, long k);
+void se_evolve_single_bse(se_task_t *t, double tphysf);
+void se_cost_record(long id, double dt);
+void fb_cost_record(long id, double dt);
+void se_cost_print_stats(void);
+void se_balance_exchange(double tphysf);
+se_task_t *se_balance_result(long k);
+void se_balance_free(void);
 
 /* Fewbody stuff */
 void destroy_obj(long i);
@@ -1928,9 +2294,11 @@ double coll_CE_twogiant(double M1, double M2, double Mc1, double Mc2, double R1,
 void print_initial_binaries(void);
 
 void bs_calcunits(fb_obj_t *obj[2], fb_units_t *bs_units);
+void binsingle_setup(double *t, long ksin, long kbin, double W, double bmax, fb_hier_t *hier, fb_input_t *fb_input, fb_units_t *units_out, gsl_rng *rng);
 fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hier_t *hier, gsl_rng *rng);
 
 void bb_calcunits(fb_obj_t *obj[2], fb_units_t *bb_units);
+void binbin_setup(double *t, long k, long kp, double W, double bmax, fb_hier_t *hier, fb_input_t *fb_input, fb_units_t *units_out, gsl_rng *rng);
 fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hier, gsl_rng *rng);
 
 double binint_get_mass(long k, long kp, long id);
@@ -1939,7 +2307,19 @@ long binint_get_indices(long k, long kp, long id, int *bi);
 void binint_log_obj(fb_obj_t *obj, fb_units_t units);
 void binint_log_status(fb_ret_t retval, double vesc);
 void binint_log_collision(const char interaction_type[], long id, double mass, double r, fb_obj_t obj, long k, long kp, long startype);
+void log_collision(evlog_coll_t *rec);
+void binint_prepare(binint_task_t *task, long k, long kp, double rperi, double w[4], double W, double rcm, double vcm[4], gsl_rng *rng);
+void binint_dump(binint_task_t *task);
+void binint_run(binint_task_t *task, fb_ctx_t *ctx);
+void binint_apply(binint_task_t *task);
 void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm, double vcm[4], gsl_rng *rng);
+void binint_batch_add(long k, long kp, double rperi, double w[4], double W, double rcm, double vcm[4], gsl_rng *rng);
+void binint_batch_run(gsl_rng *rng);
+fb_ctx_t *binint_ctx_get(long i);
+void binint_hier_get(fb_hier_t *hier);
+void binint_hier_put(fb_hier_t hier);
+void binint_path_record(binint_task_t *task);
+void binint_path_print_stats(void);
 
 double simul_relax(gsl_rng *rng);
 double simul_relax_new(void);
@@ -2149,14 +2529,10 @@ void write_snapshot(char *filename, int bh_only, char *tablename);
 /**
 * @brief Macro that prints given args into char buffer of the corresponding file.
 *
-* @param file File to be written to. This macro does not actually write to the file, but instead stores the data into the corresponding char buffer.
+* @param file File to be written to. This macro does not actually write to the file, but instead appends the data to the corresponding buffer.
 * @param args... arguments for standard printf
 */
-#define parafprintf(file, args...)                       \
-do { sprintf(mpi_ ## file ## _buf, args);               \
-strcat(mpi_ ## file ## _wrbuf, mpi_ ## file ## _buf);   \
-mpi_ ## file ## _len += strlen(mpi_ ## file ## _buf); }         \
-while(0)
+#define parafprintf(file, args...) parabuf_printf(&(mpi_ ## file ## _wrbuf), args)
 
 /**
 * @brief Prints out given arguments into char buffer corresponding to given file, done only by the root node.
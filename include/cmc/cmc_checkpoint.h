@@ -0,0 +1,40 @@
+/* vi: set filetype=c.doxygen: */
+
+/* Per-processor checkpoint files: the pieces of memory a checkpoint is made
+   of, and the routines that write them out, raw or compressed, and read them
+   back.  Only zlib is needed here, so that the checkpoint benchmark can be
+   built on its own. */
+#ifndef _CMC_CHECKPOINT_H
+#define _CMC_CHECKPOINT_H
+
+#include <stdio.h>
+
+/* compression of the checkpoints (CHECKPOINT_COMPRESS) */
+#define CHECKPOINT_COMPRESS_NONE 0
+#define CHECKPOINT_COMPRESS_ZLIB 1
+#define CHECKPOINT_COMPRESS_SHUFFLE_ZLIB 2
+
+/* most pieces in a checkpoint */
+#define CHECKPOINT_MAXSEG 8
+
+/**
+* @brief One piece of a per-processor checkpoint, which is the concatenation
+* of the pieces in the order they are written
+*/
+typedef struct{
+	char *p;
+	size_t size;
+/**
+* @brief size of the records the piece is an array of (1 if it is not one), for the shuffle filter
+*/
+	size_t recsize;
+} checkpoint_seg_t;
+
+int checkpoint_write(FILE *fp, checkpoint_seg_t *seg, int nseg, int compress);
+int checkpoint_read(FILE *fp, checkpoint_seg_t *seg, int nseg, int compressed);
+
+/* in cmc_aio.c */
+char *aio_checkpoint_buffer(size_t size);
+void aio_checkpoint_submit(char *filename, checkpoint_seg_t *seg, int nseg, int compress, char *delete_file);
+
+#endif
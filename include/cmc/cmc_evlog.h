@@ -0,0 +1,164 @@
+/* vi: set filetype=c.doxygen: */
+
+/* Binary event logs: fixed-size records that are written in place of the
+   formatted text of a log file, and the code that turns them back into text.
+   Kept free of MPI so that the converter can be built on its own. */
+#ifndef _CMC_EVLOG_H
+#define _CMC_EVLOG_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define EVLOG_MAGIC "CMCEVLOG"
+#define EVLOG_VERSION 1
+/* byte order check */
+#define EVLOG_ENDIAN 0x01020304
+
+/* event types */
+#define EVLOG_ESC 1
+#define EVLOG_COLL 2
+#define EVLOG_SEMERGE 3
+#define EVLOG_BHMERGER 4
+
+/* most stars a collision record lists; fewbody interactions have at most four */
+#define EVLOG_COLL_MAX 16
+/* longest interaction type name in a record, with the terminating null */
+#define EVLOG_NAME_LEN 32
+
+/* longest text line a record can turn into */
+#define EVLOG_LINE_LEN 4096
+
+/**
+* @brief Header at the start of a binary event log
+*/
+typedef struct{
+/**
+* @brief EVLOG_MAGIC, without the terminating null
+*/
+	char tag[8];
+/**
+* @brief EVLOG_VERSION
+*/
+	int version;
+/**
+* @brief EVLOG_ENDIAN as written by the machine that made the file
+*/
+	int endian;
+/**
+* @brief event type, one of EVLOG_*
+*/
+	int type;
+/**
+* @brief size in bytes of each record
+*/
+	int recsize;
+} evlog_header_t;
+
+/**
+* @brief One escaping star, with the columns of the text escape file. Integers are kept as long so that the record has no padding.
+*/
+typedef struct{
+	long tcount;
+	double t, m, r, vr, vt, r_peri, r_apo, Rtidal, phi_rtidal, phi_zero, E, J;
+	long id;
+/**
+* @brief 1 for a binary, 0 for a single star
+*/
+	long binflag;
+/**
+* @brief binary component masses [MSUN], ids, semimajor axis [AU] and eccentricity
+*/
+	double m0, m1;
+	long id0, id1;
+	double a, e;
+/**
+* @brief stellar type of a single star, and of the binary components
+*/
+	long startype, kw0, kw1;
+/**
+* @brief single star quantities
+*/
+	double bhspin, ospin, B, formation;
+/**
+* @brief binary quantities, two per component except for tb, in the order of the columns of the text file
+*/
+	double rad[2], tb, lum[2], massc[2], radc[2], menv[2], renv[2], tms[2], dmdt[2], radrol[2], bospin[2], bB[2], bformation[2], bacc[2], tacc[2], mass0[2], epoch[2], bbhspin[2];
+} evlog_esc_t;
+
+/**
+* @brief One collision, with the columns of the text collision file
+*/
+typedef struct{
+	double t;
+/**
+* @brief interaction type, e.g. single-single or binary-binary
+*/
+	char kind[EVLOG_NAME_LEN];
+/**
+* @brief id, mass [MSUN] and stellar type of the merger product, and its radial position
+*/
+	long idm;
+	double mm, r;
+	long typem;
+/**
+* @brief number of stars that collided, and their ids, masses [MSUN] and stellar types
+*/
+	long n;
+	long id[EVLOG_COLL_MAX];
+	double m[EVLOG_COLL_MAX];
+	long type[EVLOG_COLL_MAX];
+/**
+* @brief 1 for a single-single collision, which also has the columns below
+*/
+	long ss;
+/**
+* @brief impact parameter [RSUN], relative speed at infinity [km/s], radii [RSUN], pericenter [RSUN] and collision multiplier
+*/
+	double b, vinf, rad1, rad2, rperi, coll_mult;
+} evlog_coll_t;
+
+/**
+* @brief One binary merger or disruption from stellar evolution, with the columns of the text semergedisrupt file
+*/
+typedef struct{
+	double t;
+/**
+* @brief disruptboth, disrupt1 or disrupt2
+*/
+	char kind[EVLOG_NAME_LEN];
+/**
+* @brief 1 if one star remains, whose id, mass and stellar type are idr, mr and typer
+*/
+	long remnant;
+	long idr, id1, id2;
+	double mr, m1, m2, r;
+	long typer, type1, type2;
+} evlog_semerge_t;
+
+/**
+* @brief One black hole merger, with the columns of the text bhmerger file
+*/
+typedef struct{
+	double t;
+	char kind[EVLOG_NAME_LEN];
+	double r;
+	long id1, id2;
+/**
+* @brief columns 6 to 21 of the text file, from m1 to e_500M
+*/
+	double v[16];
+} evlog_bhmerger_t;
+
+extern const char *evlog_esc_header;
+extern const char *evlog_coll_header;
+extern const char *evlog_semerge_header;
+extern const char *evlog_bhmerger_header;
+
+void evlog_header_init(evlog_header_t *head, int type, int recsize);
+int evlog_header_check(evlog_header_t *head, int type, int recsize);
+int evlog_esc_format(char *s, size_t n, evlog_esc_t *rec);
+int evlog_coll_format(char *s, size_t n, evlog_coll_t *rec);
+int evlog_semerge_format(char *s, size_t n, evlog_semerge_t *rec);
+int evlog_bhmerger_format(char *s, size_t n, evlog_bhmerger_t *rec);
+
+#endif
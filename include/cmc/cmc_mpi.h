@@ -1,9 +1,34 @@
 /* vi: set filetype=c.doxygen: */
 
 /* Contains all MPI related variables and functions */
+#ifndef _CMC_MPI_H
+#define _CMC_MPI_H
+
 #include <mpi.h>
 #include <stdio.h>
 
+/* number of 32-bit digits needed to hold any sum of doubles exactly: the
+   bits from 2^-1074 up to 2^1024 plus headroom for carries */
+#define EXACT_SUM_NDIGIT 68
+
+/**
+* @brief Exact (order-independent) accumulator for a sum of doubles.  Every addend is split into 32-bit digits of a fixed-point number whose least significant bit is 2^-1074, so the accumulated value does not depend on the order of the additions, and hence neither on how the addends are partitioned over the processors.
+*/
+typedef struct{
+/**
+* @brief digits in base 2^32, least significant first; each is kept in a 64-bit slot so many additions can be done before the carries have to be propagated
+*/
+	long long d[EXACT_SUM_NDIGIT];
+/**
+* @brief number of additions since the carries were last propagated
+*/
+	long nadd;
+/**
+* @brief sum of any non-finite addends (inf/nan)
+*/
+	double special;
+} exact_sum_t;
+
 void mpiFindIndices( long N, int blkSize, int i, int* mpiStart, int* mpiEnd );
 void mpiFindIndicesSpecial( long N, int* mpiStart, int* mpiEnd );
 void mpiFindIndicesSpecialGen( long N, int i, int* mpiStart, int* mpiEnd );
@@ -13,3 +38,9 @@ void mpiFindDispAndLen( long N, int* mpiDisp, int* mpiLen );
 void mpiFindDispAndLenCustom( long N, int blkSize, int* mpiDisp, int* mpiLen );
 void mpiFindIndicesCustom( long N, int blkSize, int i, int* mpiStart, int* mpiEnd );
 MPI_Comm inv_comm_create(int procs, MPI_Comm old_comm);
+void exact_sum_init(exact_sum_t *s);
+void exact_sum_add(exact_sum_t *s, double x);
+double exact_sum_value(exact_sum_t *s);
+void exact_sum_allreduce(exact_sum_t *s, int count, MPI_Comm comm);
+
+#endif
@@ -0,0 +1,191 @@
+/* vi: set filetype=c.doxygen: */
+
+/* Snapshot tables: the record written for each star, and the routines that
+   create and fill the HDF5 tables holding them.  Only HDF5 is needed here,
+   so that the snapshot benchmark can be built on its own. */
+#ifndef _CMC_SNAPSHOT_H
+#define _CMC_SNAPSHOT_H
+
+#include "hdf5.h"
+#include "hdf5_hl.h"
+
+#define NFIELDS  (hsize_t)  62
+
+/* index of each column in the full record, named after the column and in the
+   order of the field table in cmc_snapshot.c */
+enum{
+	SNAPSHOT_FIELD_id, SNAPSHOT_FIELD_m_MSUN, SNAPSHOT_FIELD_r, SNAPSHOT_FIELD_vr, SNAPSHOT_FIELD_vt,
+	SNAPSHOT_FIELD_E, SNAPSHOT_FIELD_J, SNAPSHOT_FIELD_binflag, SNAPSHOT_FIELD_m0_MSUN,
+	SNAPSHOT_FIELD_m1_MSUN, SNAPSHOT_FIELD_id0, SNAPSHOT_FIELD_id1, SNAPSHOT_FIELD_a_AU,
+	SNAPSHOT_FIELD_e, SNAPSHOT_FIELD_startype, SNAPSHOT_FIELD_luminosity_LSUN,
+	SNAPSHOT_FIELD_radius_RSUN, SNAPSHOT_FIELD_bin_startype0, SNAPSHOT_FIELD_bin_startype1,
+	SNAPSHOT_FIELD_bin_star_lum0_LSUN, SNAPSHOT_FIELD_bin_star_lum1_LSUN,
+	SNAPSHOT_FIELD_bin_star_radius0_RSUN, SNAPSHOT_FIELD_bin_star_radius1_RSUN, SNAPSHOT_FIELD_bin_Eb,
+	SNAPSHOT_FIELD_eta, SNAPSHOT_FIELD_star_phi, SNAPSHOT_FIELD_rad0, SNAPSHOT_FIELD_rad1,
+	SNAPSHOT_FIELD_tb, SNAPSHOT_FIELD_lum0, SNAPSHOT_FIELD_lum1, SNAPSHOT_FIELD_massc0,
+	SNAPSHOT_FIELD_massc1, SNAPSHOT_FIELD_radc0, SNAPSHOT_FIELD_radc1, SNAPSHOT_FIELD_menv0,
+	SNAPSHOT_FIELD_menv1, SNAPSHOT_FIELD_renv0, SNAPSHOT_FIELD_renv1, SNAPSHOT_FIELD_tms0,
+	SNAPSHOT_FIELD_tms1, SNAPSHOT_FIELD_dmdt0, SNAPSHOT_FIELD_dmdt1, SNAPSHOT_FIELD_radrol0,
+	SNAPSHOT_FIELD_radrol1, SNAPSHOT_FIELD_ospin0, SNAPSHOT_FIELD_ospin1, SNAPSHOT_FIELD_B0,
+	SNAPSHOT_FIELD_B1, SNAPSHOT_FIELD_formation0, SNAPSHOT_FIELD_formation1, SNAPSHOT_FIELD_bacc0,
+	SNAPSHOT_FIELD_bacc1, SNAPSHOT_FIELD_tacc0, SNAPSHOT_FIELD_tacc1, SNAPSHOT_FIELD_mass0_0,
+	SNAPSHOT_FIELD_mass0_1, SNAPSHOT_FIELD_epoch0, SNAPSHOT_FIELD_epoch1, SNAPSHOT_FIELD_ospin,
+	SNAPSHOT_FIELD_B, SNAPSHOT_FIELD_formation
+};
+
+/* compression of the snapshot tables (SNAPSHOT_COMPRESS) */
+#define SNAPSHOT_COMPRESS_NONE 0
+#define SNAPSHOT_COMPRESS_GZIP 1
+#define SNAPSHOT_COMPRESS_SHUFFLE_GZIP 2
+#define SNAPSHOT_COMPRESS_LZ4 3
+#define SNAPSHOT_COMPRESS_ZSTD 4
+
+/* ids of the registered HDF5 filter plugins for lz4 and zstd */
+#define SNAPSHOT_FILTER_LZ4 32004
+#define SNAPSHOT_FILTER_ZSTD 32015
+
+/* columns written for SNAPSHOT_WINDOW_FIELDS=basic */
+#define SNAPSHOT_FIELDS_BASIC "id,m_MSUN,r,vr,vt,binflag,startype,bin_startype0,bin_startype1"
+
+/*-------------------------------------------------------------------------
+ * Table API example
+ *
+ * Save snapshots as HDF5 Tables
+ *
+ * #1:id #2:m[MSUN] #3:r #4:vr #5:vt #6:E #7:J #8:binflag #9:m0[MSUN] #10:m1[MSUN] #11:id0 #12:id1 #13:a[AU] #14:e #15:startype #16:luminosity[LSUN] #17:radius[RSUN]  #18:bin_startype0 #19:bin_startype1 #20:bin_star_lum0[LSUN] #21:bin_star_lum1[LSUN] #22:bin_star_radius0[RSUN] #23:bin_star_radius1[RSUN] 24.bin.Eb 25.eta 26.star.phi#27:rad0 #28:rad1 #29:tb #30:lum0 #31:lum1 #32:massc0 #33:massc1 #34:radc0 #35:radc1 #36:menv0 #37:menv1 #38:renv0 #39:renv1 #40:tms0 #41:tms1 #42:dmdt0 #43:dmdt1 #44:radrol0 #45:radrol1 #46:ospin0 #47:ospin1 #48:B0 #49:B1 #50:formation0 #51:formation1 #52:bacc0 #53:bacc1 #54:tacc0 $55:tacc1 #56:mass0_0 #57:mass0_1 #58:epoch0 #59:epoch1 #60:ospin #61:B #62:formation
+ *-------------------------------------------------------------------------
+ */
+
+ typedef struct Snapshot
+ {
+  long id;
+  double m;
+  double r;
+  double vr;
+  double vt;
+  double E;
+  double J;
+  long binflag;
+  double m0;
+  double m1;
+  long id0;
+  long id1;
+  double a;
+  double e;
+  int startype;
+  double luminosity;
+  double radius;
+  int bin_startype0;
+  int bin_startype1;
+  double bin_star_lum0;
+  double bin_star_lum1;
+  double bin_star_radius0;
+  double bin_star_radius1;
+  double bin_Eb;
+  double eta;
+  double star_phi;
+  double rad0;
+  double rad1;
+  double tb;
+  double lum0;
+  double lum1;
+  double massc0;
+  double massc1;
+  double radc0;
+  double radc1;
+  double menv0;
+  double menv1;
+  double renv0;
+  double renv1;
+  double tms0;
+  double tms1;
+  double dmdt0;
+  double dmdt1;
+  double radrol0;
+  double radrol1;
+  double ospin0;
+  double ospin1;
+  double B0;
+  double B1;
+  double formation0;
+  double formation1;
+  double bacc0;
+  double bacc1;
+  double tacc0;
+  double tacc1;
+  double mass0_0;
+  double mass0_1;
+  double epoch0;
+  double epoch1;
+  double ospin;
+  double B;
+  double formation;
+ } Snapshot;
+
+/**
+* @brief A subset of the columns of a snapshot table.  The records are then
+* packed, with only these columns, in the order of the full record and each
+* column aligned to its size.
+*/
+typedef struct{
+/**
+* @brief number of columns
+*/
+	int n;
+/**
+* @brief index of each column in the full record
+*/
+	int idx[NFIELDS];
+/**
+* @brief offset of each column in the packed record
+*/
+	size_t offset[NFIELDS];
+/**
+* @brief size of each column, so that packing makes no HDF5 calls
+*/
+	size_t colsize[NFIELDS];
+/**
+* @brief size of a packed record
+*/
+	size_t size;
+} snapshot_fields_t;
+
+/**
+* @brief How the snapshot tables are stored
+*/
+typedef struct{
+/**
+* @brief number of records per chunk
+*/
+	hsize_t chunk;
+/**
+* @brief compression, one of SNAPSHOT_COMPRESS_*
+*/
+	int compress;
+/**
+* @brief compression level, for the filters that take one
+*/
+	int level;
+/**
+* @brief columns to write, NULL for all of them
+*/
+	snapshot_fields_t *fields;
+/**
+* @brief number of stars each record stands for when the snapshot is subsampled, 0 if it is not
+*/
+	double weight;
+} snapshot_opts_t;
+
+hid_t snapshot_type(snapshot_fields_t *fields);
+int snapshot_fields_parse(const char *spec, snapshot_fields_t *fields);
+int snapshot_fields_has(snapshot_fields_t *fields, int idx);
+size_t snapshot_pack(Snapshot *data, hsize_t nrecords, snapshot_fields_t *fields);
+int snapshot_filter_avail(int compress);
+int snapshot_make_table(hid_t file, const char *tablename, hsize_t nrecords, void *data, snapshot_opts_t *opts);
+int snapshot_append_records(hid_t file, const char *tablename, hsize_t nrecords, void *data, snapshot_opts_t *opts);
+
+/* in cmc_aio.c */
+void aio_snapshot_reserve(size_t bytes);
+void aio_snapshot_submit(char *filename, char *tablename, snapshot_opts_t *opts, void *objs, long n, size_t bytes);
+
+#endif
@@ -40,6 +40,7 @@ _EXTERN_ double Eescaped, Jescaped, Eintescaped, Ebescaped;
 _EXTERN_ double initial_total_mass, Mtotal;
 /* mass lost due to stellar evolution */
 _EXTERN_ double DMse, DMrejuv;
+_EXTERN_ exact_sum_t DMse_sum;
 /******************* Input file parameters *************************/
 _EXTERN_ long N_STAR_DIM, N_STAR_DIM_OPT, N_BIN_DIM, N_BIN_DIM_OPT, T_MAX_COUNT, MASS_PC_COUNT, STELLAR_EVOLUTION, TIDAL_TREATMENT, SS_COLLISION, TIDAL_CAPTURE, BH_CAPTURE, TC_POLYTROPE, STAR_AGING_SCHEME, PREAGING, NO_MASS_BINS, NO_BSE_NATAL_KICK_ARRAY, NO_BSE_FPRIMC_ARRAY, NO_BSE_QCRIT_ARRAY;
 _EXTERN_ long SNAPSHOT_DELTACOUNT, BH_SNAPSHOT_DELTACOUNT, PULSAR_DELTACOUNT, MAX_WCLOCK_TIME, CHECKPOINT_INTERVAL, CHECKPOINTS_TO_KEEP;
@@ -61,6 +62,8 @@ _EXTERN_ char *TT_FILE;
 _EXTERN_ char *DF_FILE;
 _EXTERN_ char *SNAPSHOT_WINDOWS;
 _EXTERN_ char *SNAPSHOT_WINDOW_UNITS;
+_EXTERN_ char *SNAPSHOT_WINDOW_FIELDS;
+_EXTERN_ char *SNAPSHOT_WINDOW_SAMPLE;
 _EXTERN_ int MASS_PC_BH_INCLUDE;
 /**
 * @brief Variable to store the input parameter which indicates the number of samples per processor to be used for Sample Sort. Defaults to the number of processors if not set.
@@ -96,6 +99,7 @@ _EXTERN_ FILE *bhsummaryfile, *escbhsummaryfile, *newbhfile, *bhmergerfile;
 /* BSE input file parameters */
 _EXTERN_ int BSE_CEMERGEFLAG, BSE_CEKICKFLAG, BSE_CEHESTARFLAG, BSE_CEFLAG, BSE_TFLAG, BSE_IFFLAG, BSE_WDFLAG, BSE_BHFLAG, BSE_BHSPINFLAG, BSE_REMNANTFLAG, BSE_IDUM, BSE_WINDFLAG, BSE_QCFLAG, BSE_EDDLIMFLAG, BSE_AIC, BSE_BDECAYFAC, BSE_HTPMB, BSE_ST_TIDE, BSE_ST_CR, BSE_REJUVFLAG, BSE_USSN, BSE_KICKFLAG, BSE_GRFLAG, BSE_BHMS_COLL_FLAG;
 _EXTERN_ double BSE_POLAR_KICK_ANGLE, BH_RADIUS_MULTIPLYER, BSE_BHSPINMAG;
+_EXTERN_ double PETERS_FAST_PATH_TOL;
 _EXTERN_ double BSE_PTS1, BSE_PTS2, BSE_PTS3, BSE_NETA, BSE_BWIND, BSE_HEWIND, BSE_ALPHA1, BSE_LAMBDAF, BSE_MXNS, BSE_BCONST, BSE_CK, BSE_REJUV_FAC, BSE_SIGMA, BSE_SIGMADIV, BSE_BHSIGMAFRAC, BSE_BETA, BSE_EDDFAC, BSE_GAMMA, BSE_XI, BSE_ACC2, BSE_PISN, BSE_EPSNOV, BSE_ECSN, BSE_ECSN_MLOW, BSE_REMBAR_MASSLOSS, BSE_ZSUN, BSE_DON_LIM, BSE_ACC_LIM;
 /* binary stuff */
 _EXTERN_ long N_b, N_bb, N_bs, last_hole;
@@ -119,6 +123,7 @@ _EXTERN_ FILE *binaryfile, *threebbfile, *threebbprobabilityfile, *lightcollisio
 _EXTERN_ FILE *corefile;
 _EXTERN_ FILE *fp_lagrad, *fp_log, *fp_denprof;
 _EXTERN_ FILE *timerfile;
+_EXTERN_ gzFile binintdumpfile;
 // Meagan: file for tracking potential fluctuations for innermost 1000 stars
 
 /**
@@ -127,19 +132,9 @@ _EXTERN_ FILE *timerfile;
 _EXTERN_ MPI_File mpi_logfile, mpi_binintfile, mpi_escfile, mpi_collisionfile, mpi_pulsarfile, mpi_morepulsarfile, mpi_triplefile, mpi_tidalcapturefile, mpi_semergedisruptfile, mpi_removestarfile, mpi_relaxationfile;
 
 /**
-* @brief MPI: String buffers to store intermediate data that is finally flush out to files using MPI-IO
+* @brief MPI: Buffers to store intermediate data that is finally flush out to files using MPI-IO
 */
-_EXTERN_ char mpi_logfile_buf[STR_BUF_LEN], mpi_escfile_buf[STR_BUF_LEN], mpi_binintfile_buf[STR_BUF_LEN], mpi_collisionfile_buf[STR_BUF_LEN], mpi_pulsarfile_buf[STR_BUF_LEN], mpi_morepulsarfile_buf[STR_BUF_LEN], mpi_triplefile_buf[STR_BUF_LEN],mpi_tidalcapturefile_buf[STR_BUF_LEN], mpi_semergedisruptfile_buf[STR_BUF_LEN], mpi_removestarfile_buf[STR_BUF_LEN], mpi_relaxationfile_buf[STR_BUF_LEN];
-
-/**
-* @brief MPI: String buffers to store intermediate data that is finally flush out to files using MPI-IO
-*/
-_EXTERN_ char mpi_logfile_wrbuf[STR_WRBUF_LEN], mpi_escfile_wrbuf[STR_WRBUF_LEN], mpi_binintfile_wrbuf[STR_WRBUF_LEN], mpi_collisionfile_wrbuf[STR_WRBUF_LEN], mpi_pulsarfile_wrbuf[STR_WRBUF_LEN], mpi_morepulsarfile_wrbuf[STR_WRBUF_LEN], mpi_triplefile_wrbuf[STR_BUF_LEN], mpi_tidalcapturefile_wrbuf[STR_WRBUF_LEN], mpi_semergedisruptfile_wrbuf[STR_WRBUF_LEN], mpi_removestarfile_wrbuf[STR_WRBUF_LEN], mpi_relaxationfile_wrbuf[STR_WRBUF_LEN];
-
-/**
-* @brief MPI: Variables to maintail the length of the buffers until the next flush
-*/
-_EXTERN_ long long mpi_logfile_len, mpi_escfile_len, mpi_binintfile_len, mpi_collisionfile_len, mpi_pulsarfile_len, mpi_morepulsarfile_len, mpi_triplefile_len, mpi_tidalcapturefile_len, mpi_semergedisruptfile_len, mpi_removestarfile_len, mpi_relaxationfile_len;
+_EXTERN_ parabuf_t mpi_logfile_wrbuf, mpi_escfile_wrbuf, mpi_binintfile_wrbuf, mpi_collisionfile_wrbuf, mpi_pulsarfile_wrbuf, mpi_morepulsarfile_wrbuf, mpi_triplefile_wrbuf, mpi_tidalcapturefile_wrbuf, mpi_semergedisruptfile_wrbuf, mpi_removestarfile_wrbuf, mpi_relaxationfile_wrbuf;
 
 /**
 * @brief MPI: Variables to maintain the total offset of the file
@@ -153,19 +148,9 @@ _EXTERN_ long long mpi_logfile_ofst_total, mpi_escfile_ofst_total, mpi_binaryfil
 _EXTERN_ MPI_File mpi_bhsummaryfile, mpi_escbhsummaryfile, mpi_newbhfile, mpi_bhmergerfile, mpi_threebbfile, mpi_threebbprobabilityfile, mpi_lightcollisionfile, mpi_threebbdebugfile;
 
 /**
-* @brief MPI: String buffers to store intermediate data that is finally flush out to files using MPI-IO
-*/
-_EXTERN_ char mpi_bhsummaryfile_buf[STR_BUF_LEN], mpi_escbhsummaryfile_buf[STR_BUF_LEN], mpi_newbhfile_buf[STR_BUF_LEN], mpi_bhmergerfile_buf[STR_BUF_LEN], mpi_threebbfile_buf[STR_BUF_LEN], mpi_threebbprobabilityfile_buf[STR_BUF_LEN], mpi_lightcollisionfile_buf[STR_BUF_LEN], mpi_threebbdebugfile_buf[STR_BUF_LEN];
-
-/**
-* @brief MPI: String buffers to store intermediate data that is finally flush out to files using MPI-IO
-*/
-_EXTERN_ char mpi_bhsummaryfile_wrbuf[STR_WRBUF_LEN], mpi_escbhsummaryfile_wrbuf[STR_WRBUF_LEN], mpi_newbhfile_wrbuf[STR_WRBUF_LEN], mpi_bhmergerfile_wrbuf[STR_WRBUF_LEN], mpi_threebbfile_wrbuf[STR_WRBUF_LEN], mpi_threebbprobabilityfile_wrbuf[STR_WRBUF_LEN], mpi_lightcollisionfile_wrbuf[STR_WRBUF_LEN], mpi_threebbdebugfile_wrbuf[STR_WRBUF_LEN];
-
-/**
-* @brief MPI: Variables to maintail the length of the buffers until the next flush
+* @brief MPI: Buffers to store intermediate data that is finally flush out to files using MPI-IO
 */
-_EXTERN_ long long mpi_bhsummaryfile_len, mpi_escbhsummaryfile_len, mpi_newbhfile_len, mpi_bhmergerfile_len, mpi_threebbfile_len, mpi_threebbprobabilityfile_len, mpi_lightcollisionfile_len, mpi_threebbdebugfile_len;
+_EXTERN_ parabuf_t mpi_bhsummaryfile_wrbuf, mpi_escbhsummaryfile_wrbuf, mpi_newbhfile_wrbuf, mpi_bhmergerfile_wrbuf, mpi_threebbfile_wrbuf, mpi_threebbprobabilityfile_wrbuf, mpi_lightcollisionfile_wrbuf, mpi_threebbdebugfile_wrbuf;
 
 /**
 * @brief MPI: Variables to maintain the total offset of the file
@@ -370,3 +355,14 @@ _EXTERN_ double OVERWRITE_MCLUS;
 _EXTERN_ double *snapshot_windows;
 _EXTERN_ int *snapshot_window_counters;
 _EXTERN_ int snapshot_window_count;
+/* single-star track cache */
+_EXTERN_ int SE_TRACK_CACHE, SE_TRACK_CACHE_NMASS, SE_TRACK_CACHE_NTIME, SE_OVERLAP;
+/* BSE/fewbody cost profiling and balancing */
+_EXTERN_ int SE_COST_PROFILE, SE_BALANCE;
+/* integrator and worker threads for binary interactions */
+_EXTERN_ int BININT_INTEGRATOR, BININT_THREADS, BININT_BALANCE, BININT_FLYBY_VALIDATE, BININT_ESCALATE, BININT_DUMP, BININT_POLICY_VALIDATE, BINARY_LOGS, SNAPSHOT_IO_MODE, SNAPSHOT_COMPRESS, SNAPSHOT_COMPRESS_LEVEL, ASYNC_IO, RESTART_FORMAT, CHECKPOINT_FULL_INTERVAL, CHECKPOINT_COMPRESS;
+_EXTERN_ double BININT_FLYBY, BININT_PN_RPERI, BININT_WEAK_E, BININT_WEAK_ACC;
+_EXTERN_ long BININT_MAX_STEPS, SNAPSHOT_CHUNK;
+_EXTERN_ se_cost_profile_t se_cost_profile;
+_EXTERN_ char *SE_TRACK_CACHE_FILE;
+_EXTERN_ se_track_table_t se_track_table;
@@ -0,0 +1,64 @@
+/* -*- linux-c -*- */
+/* bench_binsingle.h
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#define FB_TIDALTOL 1.0e-5
+#define FB_SPEEDTOL 5.0e-2
+
+#define FB_MSTAR (1.0 * FB_CONST_MSUN) /* mass of each of the three stars */
+
+#define FB_A1 (1.0 * FB_CONST_AU)
+#define FB_E1 0.0
+
+#define FB_VINF 0.2 /* in units of v_crit */
+#define FB_BMAX 2.0 /* in units of a_1 */
+
+#define FB_TSTOP 1.0e7 /* in units of t_dyn */
+#define FB_TCPUSTOP 60.0 /* in seconds */
+#define FB_COUNTSTOP 0 /* in integration steps; 0=no limit */
+
+#define FB_ABSACC 1.0e-9 /* absolute accuracy of integrator */
+#define FB_RELACC 1.0e-9 /* relative accuracy of integrator */
+#define FB_NCOUNT 500 /* number of timesteps between calls to classify() */
+
+#define FB_KS 0
+#define FB_INTEGRATOR FB_INTEGRATOR_RK8PD
+
+#define FB_FEXP 1.0 /* expansion factor of merger product */
+
+#define FB_NSCAT 200 /* number of scatterings in the set */
+#define FB_NRHS 200000 /* number of derivatives evaluations in the RHS loop */
+
+#define FB_SEED 0UL
+#define FB_DEBUG 0
+
+/* totals over one scattering set */
+typedef struct{
+	int npreserve, nexchange, nionize, ntriple, nmerge, nincomplete;
+	long nsteps;
+	double twall, tcpu, dEmean, dEmax;
+} bench_stats_t;
+
+void print_usage(FILE *stream);
+int calc_units(fb_obj_t *obj[2], fb_units_t *units);
+double bench_wtime(void);
+void bench_setup(fb_hier_t *hier, fb_input_t input, fb_units_t *units, double mstar, double vinf, double b,
+		 gsl_rng *rng, struct rng_t113_state *curr_st);
+void bench_realloc(fb_scratch_t *scratch, int ks);
+double bench_rhs(fb_hier_t *hier, fb_input_t input, fb_units_t units, long nrhs, int prealloc);
+void bench_scatter(fb_input_t input, double mstar, double vinf, double bmax, int nscat, unsigned long int seed, bench_stats_t *stats);
+void bench_print_stats(FILE *stream, const char *name, int nscat, bench_stats_t *stats);
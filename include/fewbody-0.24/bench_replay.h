@@ -0,0 +1,50 @@
+/* -*- linux-c -*- */
+/* bench_replay.h
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#define FB_NREPEAT 2 /* runs of each scattering, to check they give the same outcome */
+#define FB_NMAX 0 /* largest number of scatterings to replay; 0=all */
+
+#define FB_SEED 0UL /* for the gsl rng, which fewbody does not draw from */
+#define FB_DEBUG 0
+
+/* parameters replacing the dumped ones; negative to keep what was dumped */
+typedef struct{
+	int integrator;
+	long countstop;
+	double tcpustop, absacc, relacc;
+} replay_opts_t;
+
+/* totals over the replayed scatterings */
+typedef struct{
+	long nscat, nincomplete, nmismatch, nsteps, nstepsmax, imax;
+	double twall, twallmax, tcpu, dEmean, dEmax;
+} replay_stats_t;
+
+/* what is compared between repeats of one scattering */
+typedef struct{
+	int retval, nstar, nobj;
+	long count;
+	double t, DeltaE, DeltaL;
+	double m[FB_MAX_PACK_NSTAR], x[FB_MAX_PACK_NSTAR][3], v[FB_MAX_PACK_NSTAR][3];
+} replay_outcome_t;
+
+void print_usage(FILE *stream);
+double bench_wtime(void);
+void replay_outcome(fb_hier_t *hier, fb_ret_t *retval, double t, replay_outcome_t *outcome);
+int replay_file(const char *fname, fb_ctx_t *ctx, replay_opts_t *opts, int nrepeat, long nmax, int verbose, replay_stats_t *stats);
+void replay_print_stats(FILE *stream, replay_stats_t *stats);
@@ -22,8 +22,10 @@
 #define _FEWBODY_H 1
 
 #include <stdio.h>
+#include <zlib.h>
 #include <gsl/gsl_nan.h>
 #include <gsl/gsl_rng.h>
+#include <gsl/gsl_odeiv.h>
 #include "../common/taus113-v2.h"
 
 /* version information */
@@ -53,6 +55,20 @@
 #define FB_ROOTSOLVER_REL_ACC 1.0e-11
 #define FB_MAX_STRING_LENGTH 2048
 #define FB_MAX_LOGENTRY_LENGTH (32 * FB_MAX_STRING_LENGTH)
+#define FB_MAX_PACK_NSTAR 16 /* largest hier fb_pack_hier_size() handles */
+#define FB_FLYBY_NSTEP 1000 /* RK4 steps in true anomaly for fb_flyby() */
+#define FB_SCAT_MAGIC "FBSCAT" /* file tag written by fb_open_scatterings() */
+#define FB_SCAT_VERSION 1
+
+/* integrators, selected with fb_input_t.integrator */
+#define FB_INTEGRATOR_RK8PD 0 /* GSL's Runge-Kutta Prince-Dormand (8,9), optionally with K-S regularization */
+#define FB_INTEGRATOR_ARBS 1 /* algorithmic regularization with Bulirsch-Stoer extrapolation */
+
+/* algorithmic regularization integrator */
+#define FB_AR_KMAX 8 /* maximum number of columns in the extrapolation tableau */
+#define FB_AR_KOPT 5 /* column at which we aim to converge */
+#define FB_AR_SAFETY 0.94 /* safety factor for the step size estimate */
+#define FB_AR_TSTOP_TOL 1.0e-6 /* fraction of a step by which it may miss tstop before it is coasted onto it */
 
 /* a struct containing the units used */
 typedef struct{
@@ -100,6 +116,21 @@ typedef struct fb_obj{
 	double last_pn_J;
 } fb_obj_t;
 
+/* scratch space for the derivatives functions; allocated once per fewbody() call,
+   sized for the initial (and hence largest) number of stars */
+typedef struct{
+	int nmax; /* maximum number of stars */
+	int kmax; /* nmax*(nmax-1)/2, maximum number of separations */
+	double *fm; /* fm[nmax*nmax*3], Newtonian pairwise forces */
+	double *fmr; /* fmr[nmax*nmax*3], PN pairwise forces */
+	double **Q, **P, **p, **A, **TP, **TQ, **UQ; /* K-S vectors, [kmax][4] */
+	double *d; /* d[kmax] */
+} fb_scratch_t;
+
+/* number of separations for four stars; the K-S derivatives function keeps its
+   work space on the stack up to this size */
+#define FB_KS_KSMALL 6
+
 /* parameters for the K-S integrator */
 typedef struct{
 	int nstar; /* number of actual stars */
@@ -109,6 +140,7 @@ typedef struct{
 	double **amat; /* amat[nstar][kstar] */
 	double **Tmat; /* Tmat[kstar][kstar] */
 	double Einit; /* initial energy used in integration scheme */
+	fb_scratch_t *scratch; /* work space for fb_ks_func() */
 } fb_ks_params_t;
 
 /* parameters for the non-regularized integrator */
@@ -121,8 +153,27 @@ typedef struct{
 	int PN3;
 	int PN35;
 	fb_units_t units;
+	fb_scratch_t *scratch; /* work space for fb_nonks_func() */
 } fb_nonks_params_t;
 
+/* state of the algorithmic regularization integrator */
+typedef struct{
+	int nstar; /* number of stars being integrated */
+	int dim; /* 6*nstar+2: positions and velocities, then t and pt */
+	int pn; /* whether any PN terms are on */
+	double h; /* step in the regularized time */
+	double pt; /* time momentum: minus the Newtonian energy */
+	fb_nonks_params_t *params; /* masses and PN switches */
+	double *z; /* z[dim], state during the leapfrog substeps */
+	double *w; /* w[3*nstar], auxiliary velocities for velocity-dependent forces */
+	double *v0; /* v0[3*nstar], velocities at the start of a kick */
+	double *aN; /* aN[3*nstar], Newtonian accelerations */
+	double *apn; /* apn[3*nstar], PN accelerations */
+	double *ytmp, *ftmp; /* ytmp[6*nstar], ftmp[6*nstar], buffers for fb_nonks_func() */
+	double **prev, **curr; /* rows of the extrapolation tableau, [FB_AR_KMAX][dim] */
+	long nrej; /* number of rejected steps */
+} fb_ar_t;
+
 /* the hierarchy data structure */
 typedef struct{
 	int nstarinit; /* initial number of stars (may not equal nstar if there are collisions) */
@@ -141,6 +192,7 @@ typedef struct{
 	int Dflag; /* 0=don't print to stdout, 1=print to stdout */
 	double dt; /* time interval between printouts will always be greater than this value */
 	double tcpustop; /* cpu stopping time, in units of seconds */
+	long countstop; /* maximum number of integration steps, which unlike tcpustop does not depend on the machine (0=no limit) */
 	double absacc; /* absolute accuracy of the integrator */
 	double relacc; /* relative accuracy of the integrator */
 	int ncount; /* number of integration steps between each call to fb_classify() */
@@ -155,6 +207,7 @@ typedef struct{
 	int PN35;
 	double BH_REFF;
 	double BHNS_TDE_FLAG;
+	int integrator; /* FB_INTEGRATOR_RK8PD or FB_INTEGRATOR_ARBS */
 } fb_input_t;
 
 /* return parameters */
@@ -176,8 +229,33 @@ typedef struct{
 	int Nosc; /* number of oscillations of the quantity s^2 (McMillan & Hut 1996) (Nosc=Nmin-1, so resonance if Nosc>=1) */
 } fb_ret_t;
 
+/* work space of fewbody() that is kept from one call to the next, sized for up
+   to nmax stars, so that a long run of scatterings does not go through the
+   allocator for each one (see fb_malloc_ctx()); not to be shared by threads */
+typedef struct{
+	int nmax; /* largest number of stars */
+	fb_hier_t *phier; /* phier[n], perturbation tree for n stars, allocated when first needed */
+	fb_ks_params_t ks_params; /* arrays sized for nmax stars */
+	fb_nonks_params_t nonks_params; /* arrays sized for nmax stars */
+	fb_scratch_t scratch;
+	fb_ar_t ar; /* sized for nmax stars */
+	double *y; /* integration variables, sized for K-S with nmax stars */
+	gsl_odeiv_step **ks_step, **nonks_step; /* [n], GSL stepper for n objects, allocated when first needed */
+	gsl_odeiv_evolve **ks_evolve, **nonks_evolve; /* [n], likewise */
+	gsl_odeiv_control *control;
+} fb_ctx_t;
+
 /* fewbody.c */
 fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t, gsl_rng *rng, struct rng_t113_state *curr_st);
+void fb_malloc_ctx(fb_ctx_t *ctx, int nmax);
+void fb_free_ctx(fb_ctx_t *ctx);
+fb_ret_t fewbody_ctx(fb_ctx_t *ctx, fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t, gsl_rng *rng, struct rng_t113_state *curr_st);
+
+/* fewbody_ar.c */
+void fb_malloc_ar(fb_ar_t *ar, int nstar);
+void fb_init_ar(fb_ar_t *ar, fb_nonks_params_t *params, const double *y);
+void fb_free_ar(fb_ar_t *ar);
+int fb_ar_apply(fb_ar_t *ar, double *t, double tstop, double absacc, double relacc, double *y);
 
 /* fewbody_classify.c */
 int fb_classify(fb_hier_t *hier, double t, double tidaltol, double speedtol, fb_units_t units, fb_input_t input);
@@ -193,10 +271,18 @@ int fb_collide(fb_hier_t *hier, double f_exp, fb_units_t units, gsl_rng *rng, st
 void fb_merge(fb_obj_t *obj1, fb_obj_t *obj2, int nstarinit, double f_exp, fb_units_t units, gsl_rng *rng, struct rng_t113_state *curr_st, double bh_reff);
 void fb_bh_merger(double m1, double m2, double a1, double a2, double *mass_frac, double *afinal, double *v_para, double *v_perp, struct rng_t113_state *curr_st);
 
+/* fewbody_flyby.c */
+double fb_flyby_ratio(fb_hier_t *hier);
+void fb_flyby(fb_hier_t *hier, double *t, fb_ret_t *retval);
+
 /* fewbody_hier.c */
 void fb_malloc_hier(fb_hier_t *hier);
+void fb_clear_hier(fb_hier_t *hier);
 void fb_init_hier(fb_hier_t *hier);
 void fb_free_hier(fb_hier_t hier);
+size_t fb_pack_hier_size(int nstarinit);
+void fb_pack_hier(fb_hier_t *hier, char *buf);
+void fb_unpack_hier(const char *buf, fb_hier_t *hier);
 void fb_trickle(fb_hier_t *hier, double t);
 void fb_elkcirt(fb_hier_t *hier, double t);
 int fb_create_indices(int *hi, int nstar);
@@ -215,10 +301,15 @@ void fb_free_ks_params(fb_ks_params_t ks_params);
 void fb_malloc_nonks_params(fb_nonks_params_t *nonks_params);
 void fb_init_nonks_params(fb_nonks_params_t *nonks_params, fb_hier_t hier);
 void fb_free_nonks_params(fb_nonks_params_t nonks_params);
+void fb_malloc_scratch(fb_scratch_t *scratch, int nmax);
+void fb_free_scratch(fb_scratch_t *scratch);
 
 /* fewbody_io.c */
 void fb_print_version(FILE *stream);
 void fb_print_story(fb_obj_t *star, int nstar, double t, char *logentry);
+gzFile fb_open_scatterings(const char *fname, const char *mode);
+int fb_write_scattering(gzFile fp, fb_input_t *input, fb_units_t *units, fb_hier_t *hier, double t, struct rng_t113_state *curr_st);
+int fb_read_scattering(gzFile fp, fb_input_t *input, fb_units_t *units, fb_hier_t *hier, double *t, struct rng_t113_state *curr_st);
 
 /* fewbody_isolate.c */
 int fb_collapse(fb_hier_t *hier, double t, double tidaltol, double speedtol, fb_units_t units, fb_nonks_params_t nonks_params, fb_input_t input);
@@ -253,6 +344,7 @@ void fb_free_vector(double *v);
 void fb_free_matrix(double **m);
 double fb_sqr(double x);
 double fb_cub(double x);
+double fb_cputime(void);
 double fb_dot(double x[3], double y[3]);
 double fb_mod(double x[3]);
 int fb_cross(double x[3], double y[3], double z[3]);
@@ -0,0 +1,288 @@
+/* vi: set filetype=c.doxygen: */
+/* Writes and reads back synthetic per-processor checkpoints with each
+   CHECKPOINT_COMPRESS setting, one file per processor as in a run, and
+   reports their size and the time it takes on the number of processors it is
+   started on.  Running it with mpirun -np 1, 2, 4, ... gives the scaling with
+   the number of processors.  The star and binary arrays look like those of a
+   real run: the dimensions come from the same formula, most stars are single
+   with the binary fields unused, the binaries leave the stellar evolution
+   fields of their star unused, and the tails of the arrays are empty. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <mpi.h>
+#include "cmc.h"
+#include "cmc_checkpoint.h"
+
+#define BENCH_NSTAR 1000000
+#define BENCH_FBIN 0.1
+#define BENCH_DIR "."
+
+/**
+* @brief prints the usage
+*
+* @param stream output stream
+*/
+static void print_usage(FILE *stream)
+{
+	fprintf(stream, "USAGE:\n");
+	fprintf(stream, "  mpirun -np <procs> cmc_bench_checkpoint [options...]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "OPTIONS:\n");
+	fprintf(stream, "  -n --nstar <n>      : total number of stars, split over the processors [%d]\n", BENCH_NSTAR);
+	fprintf(stream, "  -b --fbin <f>       : fraction of binaries [%g]\n", BENCH_FBIN);
+	fprintf(stream, "  -d --dir <dir>      : scratch directory, on the file system the checkpoints go to [%s]\n", BENCH_DIR);
+	fprintf(stream, "  -h --help           : display this help text\n");
+}
+
+/**
+* @brief fills in the arrays of one processor
+*
+* @param stars stars, nstardim of them
+* @param bins binaries, nbindim of them
+* @param n number of stars in use
+* @param fbin fraction of binaries
+* @param nstardim dimension of the star array
+* @param nbindim dimension of the binary array
+* @param seed seed of the processor
+*/
+static void bench_fill(star_t *stars, binary_t *bins, long n, double fbin, long nstardim, long nbindim, long seed)
+{
+	long i, nb=0;
+	star_t *s;
+	binary_t *b;
+
+	srand48(seed);
+	memset(stars, 0, nstardim * sizeof(star_t));
+	memset(bins, 0, nbindim * sizeof(binary_t));
+	for (i=1; i<=n && i<nstardim; i++) {
+		s = &stars[i];
+		s->r = (double) i / n;
+		s->vr = drand48() - 0.5;
+		s->vt = drand48();
+		s->m = 1.0e-6 * (0.1 + drand48());
+		s->E = -1.0 + drand48();
+		s->J = drand48();
+		s->phi = -1.0 - drand48();
+		s->rnew = s->r;
+		s->vrnew = s->vr;
+		s->vtnew = s->vt;
+		s->rOld = s->r;
+		s->r_peri = 0.5 * s->r;
+		s->r_apo = 1.5 * s->r;
+		s->id = seed * nstardim + i;
+		s->Uoldrold = s->Uoldrnew = s->phi;
+		if (drand48() < fbin && nb + 1 < nbindim) {
+			nb++;
+			s->binind = nb;
+			b = &bins[nb];
+			b->inuse = 1;
+			b->id1 = 2 * s->id;
+			b->id2 = 2 * s->id + 1;
+			b->m1 = 0.6 * s->m;
+			b->m2 = 0.4 * s->m;
+			b->a = pow(10.0, 3.0 * drand48() - 2.0);
+			b->e = sqrt(drand48());
+			b->rad1 = b->rad2 = drand48();
+			b->bse_kw[0] = 1;
+			b->bse_kw[1] = (drand48() < 0.5 ? 0 : 1);
+			b->bse_zams_mass[0] = b->bse_mass0[0] = b->bse_mass[0] = 0.6 * s->m;
+			b->bse_zams_mass[1] = b->bse_mass0[1] = b->bse_mass[1] = 0.4 * s->m;
+			b->bse_radius[0] = b->bse_radius[1] = drand48();
+			b->bse_lum[0] = b->bse_lum[1] = drand48();
+			b->bse_menv[0] = b->bse_menv[1] = drand48();
+			b->bse_renv[0] = b->bse_renv[1] = drand48();
+			b->bse_tms[0] = b->bse_tms[1] = 1.0e4 * drand48();
+			b->bse_ospin[0] = b->bse_ospin[1] = drand48();
+			b->bse_tb = 1.0e3 * drand48();
+		} else {
+			s->se_mass = s->zams_mass = 0.1 + 10.0 * drand48();
+			s->se_k = (s->se_mass > 8.0 ? 13 : 1);
+			s->se_radius = pow(s->se_mass, 0.8);
+			s->se_lum = pow(s->se_mass, 3.5);
+			s->se_tms = 1.0e4 * pow(s->se_mass, -2.5);
+			s->se_ospin = drand48();
+			s->se_tphys = 100.0;
+			s->rad = s->se_radius;
+		}
+	}
+}
+
+/**
+* @brief writes the checkpoint of this processor with the given compression, then reads it back and compares
+*
+* @param fname checkpoint file of this processor
+* @param seg pieces of the checkpoint
+* @param back pieces to read it back into, of the same sizes
+* @param nseg number of pieces
+* @param compress one of CHECKPOINT_COMPRESS_*
+* @param name description of the compression
+* @param myid rank
+* @param procs number of processors
+*/
+static void bench_run(char *fname, checkpoint_seg_t *seg, checkpoint_seg_t *back, int nseg, int compress, const char *name, int myid, int procs)
+{
+	FILE *fp;
+	double t0, tw, tr, twrite, tread, size=0.0, total, raw=0.0, rawtotal;
+	int k, ok, allok, err=0;
+
+	for (k=0; k<nseg; k++) {
+		raw += seg[k].size;
+		memset(back[k].p, 0, back[k].size);
+	}
+
+	/* the time of a checkpoint is that of the slowest processor */
+	MPI_Barrier(MPI_COMM_WORLD);
+	t0 = MPI_Wtime();
+	if ((fp = fopen(fname, "wb")) == NULL || checkpoint_write(fp, seg, nseg, compress) != 0) {
+		err = 1;
+	}
+	if (fp != NULL) {
+		/* include the flush to the file system, not just to the page cache */
+		fflush(fp);
+		fsync(fileno(fp));
+		size = ftell(fp);
+		fclose(fp);
+	}
+	tw = MPI_Wtime() - t0;
+	MPI_Reduce(&tw, &twrite, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	t0 = MPI_Wtime();
+	if ((fp = fopen(fname, "rb")) == NULL || checkpoint_read(fp, back, nseg, compress != CHECKPOINT_COMPRESS_NONE) != 0) {
+		err = 1;
+	}
+	if (fp != NULL) {
+		fclose(fp);
+	}
+	tr = MPI_Wtime() - t0;
+	MPI_Reduce(&tr, &tread, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	ok = !err;
+	for (k=0; k<nseg && ok; k++) {
+		ok = (memcmp(seg[k].p, back[k].p, seg[k].size) == 0);
+	}
+	MPI_Reduce(&ok, &allok, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&size, &total, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&raw, &rawtotal, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	remove(fname);
+
+	if (myid == 0) {
+		printf("%5d %-14s %10.1f %7.2f %9.3f %9.3f %10.1f %10.1f %s\n", procs, name, total / 1048576.0, rawtotal / total,
+		       twrite, tread, rawtotal / 1048576.0 / twrite, rawtotal / 1048576.0 / tread, allok ? "ok" : "MISMATCH");
+		fflush(stdout);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const char *short_opts = "n:b:d:h";
+	const struct option long_opts[] = {
+		{"nstar", required_argument, NULL, 'n'},
+		{"fbin", required_argument, NULL, 'b'},
+		{"dir", required_argument, NULL, 'd'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	struct {int compress; const char *name;} settings[] = {
+		{CHECKPOINT_COMPRESS_NONE, "none"},
+		{CHECKPOINT_COMPRESS_ZLIB, "zlib"},
+		{CHECKPOINT_COMPRESS_SHUFFLE_ZLIB, "shuffle+zlib"}
+	};
+	int nsettings = sizeof(settings) / sizeof(settings[0]);
+	int myid, procs, i, k, c, nseg=4;
+	long nstar=BENCH_NSTAR, n, nstardim, nbindim;
+	double fbin=BENCH_FBIN;
+	char dir[1024]=BENCH_DIR, fname[1100];
+	star_t *stars, *stars2;
+	binary_t *bins, *bins2;
+	clus_struct_t cl, cl2;
+	unsigned int rng[4]={12345, 67890, 13579, 24680}, rng2[4];
+	checkpoint_seg_t seg[CHECKPOINT_MAXSEG], back[CHECKPOINT_MAXSEG];
+
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &procs);
+
+	while ((c = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
+		switch (c) {
+		case 'n':
+			nstar = strtol(optarg, NULL, 10);
+			break;
+		case 'b':
+			fbin = strtod(optarg, NULL);
+			break;
+		case 'd':
+			strncpy(dir, optarg, sizeof(dir)-1);
+			break;
+		case 'h':
+			if (myid == 0) print_usage(stdout);
+			MPI_Finalize();
+			return(0);
+		default:
+			if (myid == 0) print_usage(stderr);
+			MPI_Finalize();
+			return(1);
+		}
+	}
+
+	/* local share of the stars, and the array dimensions a run would allocate for it */
+	n = nstar / procs + (myid < nstar % procs ? 1 : 0);
+	nstardim = 1 + nstar / procs + 2 * (long) (fbin * nstar) / procs;
+	nbindim = nstar / (2 * procs) + (long) (fbin * nstar) / procs;
+	nstardim = (long) floor(1.5 * ((double) nstardim));
+	nbindim = (long) floor(1.5 * ((double) nbindim));
+
+	stars = (star_t *) malloc(nstardim * sizeof(star_t));
+	stars2 = (star_t *) malloc(nstardim * sizeof(star_t));
+	bins = (binary_t *) malloc(nbindim * sizeof(binary_t));
+	bins2 = (binary_t *) malloc(nbindim * sizeof(binary_t));
+	if (stars == NULL || stars2 == NULL || bins == NULL || bins2 == NULL) {
+		fprintf(stderr, "cannot allocate the arrays for %ld stars on processor %d.\n", n, myid);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	bench_fill(stars, bins, n, fbin, nstardim, nbindim, myid + 1);
+	memset(&cl, 0, sizeof(cl));
+	cl.N_MAX_NEW = n;
+
+	/* the same pieces as a checkpoint of a run, minus the global variables */
+	seg[0].p = (char *) rng;
+	seg[0].size = sizeof(rng);
+	seg[0].recsize = 1;
+	seg[1].p = (char *) &cl;
+	seg[1].size = sizeof(clus_struct_t);
+	seg[1].recsize = 1;
+	seg[2].p = (char *) stars;
+	seg[2].size = nstardim * sizeof(star_t);
+	seg[2].recsize = sizeof(star_t);
+	seg[3].p = (char *) bins;
+	seg[3].size = nbindim * sizeof(binary_t);
+	seg[3].recsize = sizeof(binary_t);
+	for (k=0; k<nseg; k++) {
+		back[k] = seg[k];
+	}
+	back[0].p = (char *) rng2;
+	back[1].p = (char *) &cl2;
+	back[2].p = (char *) stars2;
+	back[3].p = (char *) bins2;
+
+	snprintf(fname, sizeof(fname), "%s/bench_checkpoint-%d.bin", dir, myid);
+	if (myid == 0) {
+		printf("# %ld stars, %g binaries, on %d processors: star arrays of %ld x %lu bytes, binary arrays of %ld x %lu bytes\n",
+		       nstar, fbin, procs, nstardim, (unsigned long) sizeof(star_t), nbindim, (unsigned long) sizeof(binary_t));
+		printf("# procs compression   size[MB]   ratio  write[s]   read[s] write[MB/s] read[MB/s] check\n");
+	}
+	for (i=0; i<nsettings; i++) {
+		bench_run(fname, seg, back, nseg, settings[i].compress, settings[i].name, myid, procs);
+	}
+
+	free(stars);
+	free(stars2);
+	free(bins);
+	free(bins2);
+	MPI_Finalize();
+	return(0);
+}
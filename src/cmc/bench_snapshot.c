@@ -0,0 +1,288 @@
+/* vi: set filetype=c.doxygen: */
+/* Writes and reads back a synthetic snapshot table with each combination of
+   chunk size and compression, to choose SNAPSHOT_CHUNK and SNAPSHOT_COMPRESS.
+   The records look like those of a real snapshot: most stars single, with the
+   binary columns set to -100 or NaN, and the rest binaries with the single
+   star columns set to -100. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include "cmc_snapshot.h"
+
+#define BENCH_NREC 1000000
+#define BENCH_FBIN 0.1
+#define BENCH_FILE "bench_snapshot.h5"
+
+/**
+* @brief prints the usage
+*
+* @param stream output stream
+*/
+static void print_usage(FILE *stream)
+{
+	fprintf(stream, "USAGE:\n");
+	fprintf(stream, "  cmc_bench_snapshot [options...]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "OPTIONS:\n");
+	fprintf(stream, "  -n --nrec <n>       : number of stars in the snapshot [%d]\n", BENCH_NREC);
+	fprintf(stream, "  -b --fbin <f>       : fraction of binaries [%g]\n", BENCH_FBIN);
+	fprintf(stream, "  -c --chunk <n>      : only try this chunk size [10, 256, 2048, 16384]\n");
+	fprintf(stream, "  -f --fields <list>  : write only these columns (comma separated, or \"basic\") [all]\n");
+	fprintf(stream, "  -o --outfile <file> : scratch file [%s]\n", BENCH_FILE);
+	fprintf(stream, "  -h --help           : display this help text\n");
+}
+
+/**
+* @brief wall clock time in seconds
+*
+* @return time
+*/
+static double bench_wtime(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + 1.0e-6 * tv.tv_usec);
+}
+
+/**
+* @brief fills in n synthetic snapshot records
+*
+* @param objs records
+* @param n number of records
+* @param fbin fraction of binaries
+*/
+static void bench_fill(Snapshot *objs, long n, double fbin)
+{
+	long i;
+	double x, nan=0.0/0.0;
+	Snapshot *o;
+
+	srand48(1);
+	for (i=0; i<n; i++) {
+		o = &objs[i];
+		x = drand48();
+		o->id = i + 1;
+		o->m = 0.08 * pow(1.0 - 0.99 * drand48(), -1.0/1.3);
+		o->r = (double) i / n * (1.0 + 0.01 * drand48());
+		o->vr = drand48() - 0.5;
+		o->vt = drand48();
+		o->E = -1.0 + drand48();
+		o->J = drand48();
+		o->star_phi = -1.0 - drand48();
+		if (x < fbin) {
+			o->binflag = 1;
+			o->m0 = o->m * 0.6;
+			o->m1 = o->m * 0.4;
+			o->id0 = 2 * n + 2 * i;
+			o->id1 = 2 * n + 2 * i + 1;
+			o->a = pow(10.0, 3.0 * drand48() - 2.0);
+			o->e = sqrt(drand48());
+			o->startype = -100;
+			o->luminosity = -100;
+			o->radius = -100;
+			o->bin_startype0 = 1;
+			o->bin_startype1 = (drand48() < 0.5 ? 0 : 1);
+			o->bin_star_lum0 = drand48();
+			o->bin_star_lum1 = drand48();
+			o->bin_star_radius0 = drand48();
+			o->bin_star_radius1 = drand48();
+			o->bin_Eb = -drand48();
+			o->eta = 10.0 * drand48();
+			o->rad0 = o->rad1 = o->tb = o->lum0 = o->lum1 = drand48();
+			o->massc0 = o->massc1 = o->radc0 = o->radc1 = 0.0;
+			o->menv0 = o->menv1 = o->renv0 = o->renv1 = drand48();
+			o->tms0 = o->tms1 = 1.0e4 * drand48();
+			o->dmdt0 = o->dmdt1 = o->radrol0 = o->radrol1 = 0.0;
+			o->ospin0 = o->ospin1 = drand48();
+			o->B0 = o->B1 = o->formation0 = o->formation1 = 0.0;
+			o->bacc0 = o->bacc1 = o->tacc0 = o->tacc1 = 0.0;
+			o->mass0_0 = o->m0;
+			o->mass0_1 = o->m1;
+			o->epoch0 = o->epoch1 = 0.0;
+			o->ospin = o->B = o->formation = -100;
+		} else {
+			o->binflag = -100;
+			o->m0 = o->m1 = -100;
+			o->id0 = o->id1 = -100;
+			o->a = o->e = -100;
+			o->startype = (o->m > 20.0 ? 14 : (o->m > 8.0 ? 13 : 1));
+			o->luminosity = pow(o->m, 3.5);
+			o->radius = pow(o->m, 0.8);
+			o->bin_startype0 = o->bin_startype1 = -100;
+			o->bin_star_lum0 = o->bin_star_lum1 = -100;
+			o->bin_star_radius0 = o->bin_star_radius1 = -100;
+			o->bin_Eb = o->eta = -100;
+			o->rad0 = o->rad1 = o->tb = o->lum0 = o->lum1 = nan;
+			o->massc0 = o->massc1 = o->radc0 = o->radc1 = nan;
+			o->menv0 = o->menv1 = o->renv0 = o->renv1 = nan;
+			o->tms0 = o->tms1 = o->dmdt0 = o->dmdt1 = o->radrol0 = o->radrol1 = nan;
+			o->ospin0 = o->ospin1 = o->B0 = o->B1 = o->formation0 = o->formation1 = nan;
+			o->bacc0 = o->bacc1 = o->tacc0 = o->tacc1 = nan;
+			o->mass0_0 = o->mass0_1 = o->epoch0 = o->epoch1 = nan;
+			o->ospin = drand48();
+			o->B = 0.0;
+			o->formation = 0.0;
+		}
+	}
+}
+
+/**
+* @brief writes the records with the given settings, then reads them back and compares
+*
+* @param fname scratch file
+* @param objs records
+* @param back space for the records read back
+* @param n number of records
+* @param opts chunking, compression and columns
+* @param name description of the compression
+*/
+static void bench_run(char *fname, Snapshot *objs, Snapshot *back, long n, snapshot_opts_t *opts, const char *name)
+{
+	hid_t file, dset, type;
+	double t0, twrite, tread;
+	size_t recsize = opts->fields == NULL ? sizeof(Snapshot) : opts->fields->size;
+	struct stat st;
+	int ok;
+
+	remove(fname);
+	t0 = bench_wtime();
+	file = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	/* write the table in two pieces, as it would be from two nodes */
+	snapshot_make_table(file, "0(t=0)", n/2, objs, opts);
+	snapshot_append_records(file, "0(t=0)", n - n/2, (char *) objs + (n/2) * recsize, opts);
+	H5Fclose(file);
+	twrite = bench_wtime() - t0;
+
+	stat(fname, &st);
+
+	t0 = bench_wtime();
+	file = H5Fopen(fname, H5F_ACC_RDONLY, H5P_DEFAULT);
+	dset = H5Dopen2(file, "0(t=0)", H5P_DEFAULT);
+	type = snapshot_type(opts->fields);
+	H5Dread(dset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, back);
+	H5Tclose(type);
+	H5Dclose(dset);
+	H5Fclose(file);
+	tread = bench_wtime() - t0;
+
+	/* NaN != NaN, so compare the bits */
+	ok = (memcmp(objs, back, n * recsize) == 0);
+
+	printf("%-14s %8lu %10.3f %10.3f %10.1f %8.2f %s\n", name, (unsigned long) opts->chunk,
+	       twrite, tread, st.st_size / 1048576.0, (double) n * recsize / st.st_size, ok ? "ok" : "MISMATCH");
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *short_opts = "n:b:c:f:o:h";
+	const struct option long_opts[] = {
+		{"nrec", required_argument, NULL, 'n'},
+		{"fbin", required_argument, NULL, 'b'},
+		{"chunk", required_argument, NULL, 'c'},
+		{"fields", required_argument, NULL, 'f'},
+		{"outfile", required_argument, NULL, 'o'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	hsize_t chunks[4] = {10, 256, 2048, 16384};
+	int nchunk=4, i, j, k, c;
+	long n=BENCH_NREC;
+	double fbin=BENCH_FBIN;
+	char fname[1024]=BENCH_FILE, name[32], *fieldspec=NULL;
+	Snapshot *objs, *back;
+	snapshot_opts_t opts;
+	snapshot_fields_t fields;
+	size_t recsize;
+	struct {int compress; int level; const char *name;} settings[] = {
+		{SNAPSHOT_COMPRESS_NONE, 0, "none"},
+		{SNAPSHOT_COMPRESS_GZIP, 1, "gzip"},
+		{SNAPSHOT_COMPRESS_GZIP, 6, "gzip"},
+		{SNAPSHOT_COMPRESS_SHUFFLE_GZIP, 1, "shuffle+gzip"},
+		{SNAPSHOT_COMPRESS_SHUFFLE_GZIP, 6, "shuffle+gzip"},
+		{SNAPSHOT_COMPRESS_LZ4, 0, "lz4"},
+		{SNAPSHOT_COMPRESS_ZSTD, 3, "zstd"},
+		{SNAPSHOT_COMPRESS_ZSTD, 9, "zstd"}
+	};
+	int nsettings = sizeof(settings) / sizeof(settings[0]);
+
+	while ((c = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
+		switch (c) {
+		case 'n':
+			n = strtol(optarg, NULL, 10);
+			break;
+		case 'b':
+			fbin = strtod(optarg, NULL);
+			break;
+		case 'c':
+			chunks[0] = strtol(optarg, NULL, 10);
+			nchunk = 1;
+			break;
+		case 'f':
+			fieldspec = optarg;
+			break;
+		case 'o':
+			strncpy(fname, optarg, sizeof(fname)-1);
+			break;
+		case 'h':
+			print_usage(stdout);
+			return(0);
+		default:
+			print_usage(stderr);
+			return(1);
+		}
+	}
+	if (n < 2) {
+		fprintf(stderr, "need at least 2 records.\n");
+		return(1);
+	}
+	if (fieldspec != NULL && snapshot_fields_parse(fieldspec, &fields) != 0) {
+		fprintf(stderr, "unknown column in \"%s\".\n", fieldspec);
+		return(1);
+	}
+
+	objs = (Snapshot *) calloc(n, sizeof(Snapshot));
+	back = (Snapshot *) calloc(n, sizeof(Snapshot));
+	if (objs == NULL || back == NULL) {
+		fprintf(stderr, "cannot allocate %ld records.\n", n);
+		return(1);
+	}
+	bench_fill(objs, n, fbin);
+	recsize = snapshot_pack(objs, n, fieldspec != NULL ? &fields : NULL);
+
+	printf("# %ld records of %lu bytes (%.1f MB), %g binaries\n", n, (unsigned long) recsize,
+	       (double) n * recsize / 1048576.0, fbin);
+	printf("# compression     chunk   write[s]    read[s]  size[MB]    ratio check\n");
+	for (i=0; i<nsettings; i++) {
+		if (!snapshot_filter_avail(settings[i].compress)) {
+			printf("# %s: filter not available, skipped\n", settings[i].name);
+			/* skip the other levels of the same filter too */
+			for (k=i+1; k<nsettings && settings[k].compress == settings[i].compress; k++);
+			i = k - 1;
+			continue;
+		}
+		if (settings[i].compress == SNAPSHOT_COMPRESS_NONE || settings[i].compress == SNAPSHOT_COMPRESS_LZ4) {
+			snprintf(name, sizeof(name), "%s", settings[i].name);
+		} else {
+			snprintf(name, sizeof(name), "%s-%d", settings[i].name, settings[i].level);
+		}
+		for (j=0; j<nchunk; j++) {
+			opts.chunk = chunks[j];
+			opts.compress = settings[i].compress;
+			opts.level = settings[i].level;
+			opts.fields = fieldspec != NULL ? &fields : NULL;
+			opts.weight = 0.0;
+			bench_run(fname, objs, back, n, &opts, name);
+		}
+	}
+
+	remove(fname);
+	free(objs);
+	free(back);
+	return(0);
+}
@@ -63,6 +63,7 @@ int main(int argc, char *argv[])
 {
 	struct tms tmsbuf, tmsbufref;
 	long i;
+	int mpi_thread_level;
 	gsl_rng *rng;
 	const gsl_rng_type *rng_type=gsl_rng_mt19937;
 
@@ -79,7 +80,8 @@ int main(int argc, char *argv[])
 	t_comm=0.0;
 
 	//MPI: Some code from the main branch might have been removed in the MPI version. Please check.
-	MPI_Init(&argc, &argv);
+	//MPI: Only the main thread makes MPI calls; the worker threads of SE_OVERLAP and ASYNC_IO do not.
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &mpi_thread_level);
 	MPI_Comm_size(MPI_COMM_WORLD,&procs);
 	MPI_Comm_rank(MPI_COMM_WORLD,&myid);
 
@@ -106,6 +108,13 @@ int main(int argc, char *argv[])
 	/* parse input parameter file, and read input data */
 	parser(argc, argv, rng);
 
+	/* MPI: the worker threads of SE_OVERLAP and ASYNC_IO need at least MPI_THREAD_FUNNELED; the level is the same on every rank, so they all turn them off together */
+	if (mpi_thread_level < MPI_THREAD_FUNNELED && (SE_OVERLAP || ASYNC_IO)) {
+		wprintf("the MPI library only provides thread level %d, turning off SE_OVERLAP and ASYNC_IO\n", mpi_thread_level);
+		SE_OVERLAP = 0;
+		ASYNC_IO = 0;
+	}
+
 	/* MPI: These variables are used for storing data partitioning related information in the parallel version. These arrays store the start and end indices in the global array that each processor is responsible for processing. In the serial version, these are used to mimic the parallel version to obtain comparable results. */
 	Start = (int *) calloc(procs, sizeof(int));
 	End = (int *) calloc(procs, sizeof(int));
@@ -174,6 +183,7 @@ int main(int argc, char *argv[])
 
 	/* initialize stellar evolution things */
 	DMse = 0.0;
+	exact_sum_init(&DMse_sum);
 
 	if (STELLAR_EVOLUTION > 0) {
 		if(RESTART_TCOUNT == 0 )
@@ -278,6 +288,10 @@ int main(int argc, char *argv[])
 
 		/* Perturb velocities of all N_MAX stars. 
 		 * Using sr[], sv[], get NEW E, J for all stars */
+		/* interpolate the single-star tracks on a worker thread while the dynamics runs */
+		if (STELLAR_EVOLUTION > 0 && SE_OVERLAP)
+			se_overlap_start(TotalTime / MEGA_YEAR);
+
 		tmpTimeStart = timeStartSimple();
 		if (PERTURB > 0)
 			dynamics_apply(Dt, rng);
@@ -288,11 +302,15 @@ int main(int argc, char *argv[])
 			do_stellar_evolution(rng);
 		timeEndSimple(tmpTimeStart, &t_se);
 
+		/* the BSE and fewbody cost profile of the timestep, which also covers the dynamics when stellar evolution is off */
+		se_cost_print_stats();
+
 		tmpTimeStart = timeStartSimple();
 		Prev_Dt = Dt;
 
 		/* evolve stars up to new time */
 		DMse = 0.0;
+		exact_sum_init(&DMse_sum);
 
 		/* some numbers necessary to implement Stodolkiewicz's
 		 * energy conservation scheme */
@@ -405,6 +423,9 @@ int main(int argc, char *argv[])
 
 	save_restart_file();
 
+	/* wait for the snapshots and checkpoints still being written */
+	aio_finish();
+
 	times(&tmsbuf);
 	t_full = MPI_Wtime() - tmpTimeStart_full;
 
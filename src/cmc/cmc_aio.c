@@ -0,0 +1,408 @@
+/* vi: set filetype=c.doxygen: */
+/* Background I/O thread for ASYNC_IO: snapshots and checkpoints are copied
+   into staging buffers on the main thread and written out by this thread
+   while the next timestep runs.  The thread makes no MPI calls (MPI is only
+   initialized with MPI_THREAD_FUNNELED), and while it runs the main thread
+   makes no HDF5 calls, since HDF5 is usually not built thread-safe. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "cmc.h"
+#include "cmc_vars.h"
+#include "cmc_snapshot.h"
+#include "cmc_checkpoint.h"
+
+/* most snapshots queued at a time before the main thread has to wait */
+#define AIO_MAXJOBS 8
+/* most bytes of gathered snapshots held on the root node at a time, unless a single snapshot is larger */
+#define AIO_MAXBYTES (1L<<30)
+
+#define AIO_SNAPSHOT 1
+#define AIO_CHECKPOINT 2
+
+/**
+* @brief a file to be written by the I/O thread
+*/
+typedef struct aio_job{
+	int type;
+	char filename[500];
+	char tablename[500];
+/**
+* @brief file to delete once the job is written, if not empty (old checkpoint)
+*/
+	char delete_file[500];
+	snapshot_opts_t opts;
+/**
+* @brief records of a snapshot, owned by the job
+*/
+	void *objs;
+	long n;
+	size_t bytes;
+/**
+* @brief pieces of a checkpoint, pointing into the checkpoint staging buffer
+*/
+	checkpoint_seg_t seg[CHECKPOINT_MAXSEG];
+	int nseg;
+/**
+* @brief compression of a checkpoint, one of CHECKPOINT_COMPRESS_*
+*/
+	int compress;
+	struct aio_job *next;
+} aio_job_t;
+
+static pthread_t aio_thread;
+static pthread_mutex_t aio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t aio_cond = PTHREAD_COND_INITIALIZER;
+static aio_job_t *aio_head = NULL, *aio_tail = NULL;
+static int aio_running = 0, aio_stop = 0, aio_njobs = 0, aio_checkpoint_pending = 0;
+/* set if the I/O thread could not be started: the jobs are then written as they are submitted, which only changes what this node does and not the collectives of the callers */
+static int aio_foreground = 0;
+/* bytes of snapshot records queued or reserved */
+static size_t aio_bytes = 0;
+/* first error the thread ran into, reported by the main thread */
+static char aio_error[1024] = "";
+
+/* checkpoint staging buffer, reused from one checkpoint to the next */
+static char *aio_checkpoint_buf = NULL;
+static size_t aio_checkpoint_size = 0;
+
+/**
+* @brief writes a snapshot table, creating the file if needed
+*
+* @param job job
+*
+* @return 0 on success, -1 on failure
+*/
+static int aio_write_snapshot(aio_job_t *job)
+{
+	hid_t file;
+	int ret;
+
+	H5E_BEGIN_TRY {
+		file = H5Fopen(job->filename, H5F_ACC_RDWR, H5P_DEFAULT);
+		if (file < 0) {
+			file = H5Fcreate(job->filename, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+		}
+	} H5E_END_TRY
+	if (file < 0) {
+		return(-1);
+	}
+	ret = snapshot_make_table(file, job->tablename, job->n, job->objs, &job->opts);
+	if (H5Fclose(file) < 0) {
+		ret = -1;
+	}
+	return(ret);
+}
+
+/**
+* @brief writes a checkpoint file
+*
+* @param job job
+*
+* @return 0 on success, -1 on failure
+*/
+static int aio_write_checkpoint(aio_job_t *job)
+{
+	FILE *fp;
+	int ret=0;
+
+	if ((fp = fopen(job->filename, "wb")) == NULL) {
+		return(-1);
+	}
+	if (checkpoint_write(fp, job->seg, job->nseg, job->compress) != 0) {
+		ret = -1;
+	}
+	if (fclose(fp) != 0) {
+		ret = -1;
+	}
+	return(ret);
+}
+
+/**
+* @brief loop of the I/O thread: takes the jobs in the order they were queued
+*
+* @param arg unused
+*
+* @return NULL
+*/
+static void *aio_loop(void *arg)
+{
+	aio_job_t *job;
+	int ret;
+
+	while (1) {
+		pthread_mutex_lock(&aio_mutex);
+		while (aio_head == NULL && !aio_stop) {
+			pthread_cond_wait(&aio_cond, &aio_mutex);
+		}
+		if (aio_head == NULL) {
+			pthread_mutex_unlock(&aio_mutex);
+			break;
+		}
+		job = aio_head;
+		pthread_mutex_unlock(&aio_mutex);
+
+		if (job->type == AIO_SNAPSHOT) {
+			ret = aio_write_snapshot(job);
+		} else {
+			ret = aio_write_checkpoint(job);
+		}
+		/* only drop the old checkpoint once the new one is safely written */
+		if (ret == 0 && job->delete_file[0] != '\0') {
+			remove(job->delete_file);
+		}
+
+		pthread_mutex_lock(&aio_mutex);
+		if (ret != 0 && aio_error[0] == '\0') {
+			snprintf(aio_error, sizeof(aio_error), "could not write %s \"%s\"%s%s.",
+				 job->type == AIO_SNAPSHOT ? "snapshot" : "checkpoint", job->filename,
+				 job->type == AIO_SNAPSHOT ? " table " : "", job->type == AIO_SNAPSHOT ? job->tablename : "");
+		}
+		aio_head = job->next;
+		if (aio_head == NULL) {
+			aio_tail = NULL;
+		}
+		aio_njobs--;
+		aio_bytes -= job->bytes;
+		if (job->type == AIO_CHECKPOINT) {
+			aio_checkpoint_pending = 0;
+		}
+		pthread_cond_broadcast(&aio_cond);
+		pthread_mutex_unlock(&aio_mutex);
+
+		free(job->objs);
+		free(job);
+	}
+
+	return NULL;
+}
+
+/**
+* @brief exits if the I/O thread failed to write something. Called with aio_mutex held.
+*/
+static void aio_check_error(void)
+{
+	if (aio_error[0] != '\0') {
+		eprintf("%s\n", aio_error);
+		pthread_mutex_unlock(&aio_mutex);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+}
+
+/**
+* @brief writes a job right away on the main thread, for when the I/O thread cannot be started
+*
+* @param job job, freed once written
+*/
+static void aio_run_foreground(aio_job_t *job)
+{
+	int rc;
+
+	rc = (job->type == AIO_SNAPSHOT) ? aio_write_snapshot(job) : aio_write_checkpoint(job);
+	if (rc != 0) {
+		eprintf("could not write \"%s\".\n", job->filename);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+	if (job->delete_file[0] != '\0') {
+		remove(job->delete_file);
+	}
+	aio_bytes -= job->bytes;
+	free(job->objs);
+	free(job);
+}
+
+/**
+* @brief queues a job, starting the I/O thread on first use. If the thread cannot be started the job, and every later one, is written right away.
+*
+* @param job job, owned by the queue from now on
+*/
+static void aio_submit(aio_job_t *job)
+{
+	int rc;
+
+	job->next = NULL;
+	if (aio_foreground) {
+		aio_run_foreground(job);
+		return;
+	}
+	if (!aio_running) {
+		aio_stop = 0;
+		rc = pthread_create(&aio_thread, NULL, aio_loop, NULL);
+		if (rc) {
+			wprintf("return code from pthread_create() is %d, writing in the foreground\n", rc);
+			aio_foreground = 1;
+			aio_run_foreground(job);
+			return;
+		}
+		aio_running = 1;
+	}
+
+	pthread_mutex_lock(&aio_mutex);
+	/* the staging buffers are only reused once the I/O thread is done with them */
+	while (aio_njobs >= AIO_MAXJOBS) {
+		pthread_cond_wait(&aio_cond, &aio_mutex);
+	}
+	aio_check_error();
+	if (aio_tail == NULL) {
+		aio_head = job;
+	} else {
+		aio_tail->next = job;
+	}
+	aio_tail = job;
+	aio_njobs++;
+	if (job->type == AIO_CHECKPOINT) {
+		aio_checkpoint_pending = 1;
+	}
+	pthread_cond_broadcast(&aio_cond);
+	pthread_mutex_unlock(&aio_mutex);
+}
+
+/**
+* @brief Waits, before the root node gathers a snapshot, until the snapshots still queued and this one fit in AIO_MAXBYTES, so that the gathered snapshots waiting on the root node take a bounded amount of memory. The bytes are held until the snapshot is written.
+*
+* @param bytes size of the snapshot records that are about to be gathered and passed to aio_snapshot_submit()
+*/
+void aio_snapshot_reserve(size_t bytes)
+{
+	if (aio_running) {
+		pthread_mutex_lock(&aio_mutex);
+		while (aio_bytes > 0 && aio_bytes + bytes > AIO_MAXBYTES) {
+			pthread_cond_wait(&aio_cond, &aio_mutex);
+		}
+		aio_check_error();
+		aio_bytes += bytes;
+		pthread_mutex_unlock(&aio_mutex);
+	} else {
+		aio_bytes += bytes;
+	}
+}
+
+/**
+* @brief Hands a gathered snapshot table to the I/O thread
+*
+* @param filename HDF5 file, created if it does not exist yet
+* @param tablename name of the table
+* @param opts chunking, compression and columns
+* @param objs records, packed if opts->fields is set; the I/O thread frees them once written
+* @param n number of records
+* @param bytes size reserved for the records with aio_snapshot_reserve()
+*/
+void aio_snapshot_submit(char *filename, char *tablename, snapshot_opts_t *opts, void *objs, long n, size_t bytes)
+{
+	aio_job_t *job;
+
+	job = (aio_job_t *) calloc(1, sizeof(aio_job_t));
+	job->type = AIO_SNAPSHOT;
+	snprintf(job->filename, sizeof(job->filename), "%s", filename);
+	snprintf(job->tablename, sizeof(job->tablename), "%s", tablename);
+	job->opts = *opts;
+	job->objs = objs;
+	job->n = n;
+	job->bytes = bytes;
+	aio_submit(job);
+}
+
+/**
+* @brief Returns the checkpoint staging buffer, after waiting for the previous checkpoint to be written out of it
+*
+* @param size size the buffer needs
+*
+* @return buffer, to be filled and then passed on with aio_checkpoint_submit()
+*/
+char *aio_checkpoint_buffer(size_t size)
+{
+	if (aio_running) {
+		pthread_mutex_lock(&aio_mutex);
+		while (aio_checkpoint_pending) {
+			pthread_cond_wait(&aio_cond, &aio_mutex);
+		}
+		aio_check_error();
+		pthread_mutex_unlock(&aio_mutex);
+	}
+
+	if (size > aio_checkpoint_size) {
+		free(aio_checkpoint_buf);
+		aio_checkpoint_buf = (char *) malloc(size);
+		if (aio_checkpoint_buf == NULL) {
+			eprintf("cannot allocate %lu bytes for the checkpoint staging buffer.\n", (unsigned long) size);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+		aio_checkpoint_size = size;
+	}
+	return(aio_checkpoint_buf);
+}
+
+/**
+* @brief Hands the filled checkpoint staging buffer to the I/O thread, which also compresses it
+*
+* @param filename checkpoint file
+* @param seg pieces of the checkpoint, in the staging buffer
+* @param nseg number of pieces
+* @param compress compression, one of CHECKPOINT_COMPRESS_*
+* @param delete_file older checkpoint to delete once this one is written, or NULL
+*/
+void aio_checkpoint_submit(char *filename, checkpoint_seg_t *seg, int nseg, int compress, char *delete_file)
+{
+	aio_job_t *job;
+	int k;
+
+	job = (aio_job_t *) calloc(1, sizeof(aio_job_t));
+	job->type = AIO_CHECKPOINT;
+	snprintf(job->filename, sizeof(job->filename), "%s", filename);
+	if (delete_file != NULL) {
+		snprintf(job->delete_file, sizeof(job->delete_file), "%s", delete_file);
+	}
+	for (k=0; k<nseg; k++) {
+		job->seg[k] = seg[k];
+	}
+	job->nseg = nseg;
+	job->compress = compress;
+	aio_submit(job);
+}
+
+/**
+* @brief Waits until everything queued has been written
+*/
+void aio_wait(void)
+{
+	if (!aio_running) {
+		return;
+	}
+
+	pthread_mutex_lock(&aio_mutex);
+	while (aio_njobs > 0) {
+		pthread_cond_wait(&aio_cond, &aio_mutex);
+	}
+	aio_check_error();
+	pthread_mutex_unlock(&aio_mutex);
+}
+
+/**
+* @brief Writes out everything still queued, stops the I/O thread and frees the staging buffer
+*/
+void aio_finish(void)
+{
+	int rc;
+
+	if (aio_running) {
+		aio_wait();
+
+		pthread_mutex_lock(&aio_mutex);
+		aio_stop = 1;
+		pthread_cond_broadcast(&aio_cond);
+		pthread_mutex_unlock(&aio_mutex);
+
+		rc = pthread_join(aio_thread, NULL);
+		if (rc) {
+			eprintf("return code from pthread_join() is %d\n", rc);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+		aio_running = 0;
+	}
+
+	free(aio_checkpoint_buf);
+	aio_checkpoint_buf = NULL;
+	aio_checkpoint_size = 0;
+}
@@ -19,9 +19,8 @@
 void create_rwalk_file(char *fname) {
 
     MPI_File mpi_rwalk_file;
-    char mpi_rwalk_file_buf[10000];
-    char mpi_rwalk_file_wrbuf[10000000];
-    long long mpi_rwalk_file_len=0, mpi_rwalk_file_ofst_total=0;
+    parabuf_t mpi_rwalk_file_wrbuf = {NULL, 0, 0};
+    long long mpi_rwalk_file_ofst_total=0;
     MPI_File_open(MPI_COMM_WORLD, fname, MPI_MODE_CREATE | MPI_MODE_APPEND, MPI_INFO_NULL, &mpi_rwalk_file);
 	 if(tcount==1)
 		 MPI_File_set_size(mpi_rwalk_file, 0);
@@ -29,8 +28,9 @@ void create_rwalk_file(char *fname) {
   pararootfprintf(rwalk_file, "\n");
   pararootfprintf(rwalk_file, 
           "# 1:index, 2:Time, 3:r, 4:Trel, 5:dt, 6:l2_scale, 7:n_steps, 8:beta 9:n_local, 10:W, 11:P_orb, 12:n_orb\n");
-  mpi_para_file_write(mpi_rwalk_file_wrbuf, &mpi_rwalk_file_len, &mpi_rwalk_file_ofst_total, &mpi_rwalk_file);
+  mpi_para_file_write(&mpi_rwalk_file_wrbuf, &mpi_rwalk_file_ofst_total, &mpi_rwalk_file);
   MPI_File_close(&mpi_rwalk_file);
+  parabuf_free(&mpi_rwalk_file_wrbuf);
 }
 
 /**
@@ -54,9 +54,8 @@ void write_rwalk_data(char *fname, long index, double Trel, double dt,
 
 	double r = star_r[index];
     MPI_File mpi_rwalk_file;
-    char mpi_rwalk_file_buf[10000];
-    char mpi_rwalk_file_wrbuf[10000000];
-    long long mpi_rwalk_file_len=0, mpi_rwalk_file_ofst_total=0;
+    parabuf_t mpi_rwalk_file_wrbuf = {NULL, 0, 0};
+    long long mpi_rwalk_file_ofst_total=0;
     MPI_File_open(MPI_COMM_WORLD, fname, MPI_MODE_CREATE | MPI_MODE_APPEND, MPI_INFO_NULL, &mpi_rwalk_file);
 	 if(tcount==1)
 		 MPI_File_set_size(mpi_rwalk_file, 0);
@@ -64,8 +63,9 @@ void write_rwalk_data(char *fname, long index, double Trel, double dt,
   parafprintf(rwalk_file, "%li %g %g %g %g %g %g %g %g %g %g %g\n", 
       index, TotalTime, r, Trel, dt, sqrt(l2_scale), n_steps, beta, n_local, W, P_orb, n_orb);
 
-  mpi_para_file_write(mpi_rwalk_file_wrbuf, &mpi_rwalk_file_len, &mpi_rwalk_file_ofst_total, &mpi_rwalk_file);
+  mpi_para_file_write(&mpi_rwalk_file_wrbuf, &mpi_rwalk_file_ofst_total, &mpi_rwalk_file);
   MPI_File_close(&mpi_rwalk_file);
+  parabuf_free(&mpi_rwalk_file_wrbuf);
 }
 
 /**
@@ -25,7 +25,7 @@ void bb_calcunits(fb_obj_t *obj[2], fb_units_t *bb_units)
 }
 
 /**
-* @brief the main attraction
+* @brief sets up the fewbody hierarchy, input parameters and units of a binary-binary encounter (logging the input), without integrating it
 *
 * @param t ?
 * @param k index of star 1
@@ -33,11 +33,11 @@ void bb_calcunits(fb_obj_t *obj[2], fb_units_t *bb_units)
 * @param W ?
 * @param bmax ?
 * @param hier ?
+* @param fb_input fewbody input parameters
+* @param units_out fewbody units
 * @param rng gsl rng
-*
-* @return ?
 */
-fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hier, gsl_rng *rng)
+void binbin_setup(double *t, long k, long kp, double W, double bmax, fb_hier_t *hier, fb_input_t *fb_input, fb_units_t *units_out, gsl_rng *rng)
 {
 	int j;
 	long jbin, jbinp;
@@ -46,7 +46,6 @@ fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hi
     int num_bh=0;
 	fb_units_t fb_units;
 	fb_input_t input;
-	fb_ret_t retval;
 
 	/* a useful definition */
 	jbin = star[k].binind;
@@ -66,7 +65,14 @@ fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hi
 	input.tstop = 1.0e7;
 	input.Dflag = 0;
 	input.dt = 0.0;
-	input.tcpustop = 60.0;
+	/* a step budget makes the outcome independent of the machine and its load */
+	if (BININT_MAX_STEPS > 0) {
+		input.tcpustop = GSL_POSINF;
+		input.countstop = BININT_MAX_STEPS;
+	} else {
+		input.tcpustop = 60.0;
+		input.countstop = 0;
+	}
 	input.absacc = 1.0e-9;
 	input.relacc = 1.0e-9;
 	input.ncount = 500;
@@ -81,6 +87,7 @@ fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hi
     input.BHNS_TDE_FLAG = BHNS_TDE;
 	input.firstlogentry[0] = '\0';
 	input.fexp = 1.0;
+	input.integrator = FB_INTEGRATOR_RK8PD;
 	fb_debug = 0;
 
     /* If we have more than one black hole, adjust the integrator,
@@ -92,11 +99,17 @@ fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hi
 
     if((num_bh > 1) & BH_CAPTURE){
         input.tcpustop *= 10.;
+        input.countstop *= 10;
         input.PN1 = 0;
         input.PN2 = 0;
         input.PN25 = 1;
         input.speedtol = 0.05;
     }
+
+	/* algorithmic regularization for every encounter, or just the PN ones */
+	if (BININT_INTEGRATOR == 1 || (BININT_INTEGRATOR == 2 && (input.PN1 || input.PN2 || input.PN25 || input.PN3 || input.PN35))) {
+		input.integrator = FB_INTEGRATOR_ARBS;
+	}
 	
 	/* initialize a few things for integrator */
 	*t = 0.0;
@@ -218,9 +231,31 @@ fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hi
 	}
 
 	
-	/* call fewbody! */
-	retval = fewbody(input, fb_units, hier, t, rng, curr_st);
+	/* hand the integrator parameters back */
+	*fb_input = input;
+	*units_out = fb_units;
+}
+
+/**
+* @brief the main attraction
+*
+* @param t ?
+* @param k index of star 1
+* @param kp index of star 2
+* @param W ?
+* @param bmax ?
+* @param hier ?
+* @param rng gsl rng
+*
+* @return ?
+*/
+fb_ret_t binbin(double *t, long k, long kp, double W, double bmax, fb_hier_t *hier, gsl_rng *rng)
+{
+	fb_input_t input;
+	fb_units_t fb_units;
+
+	binbin_setup(t, k, kp, W, bmax, hier, &input, &fb_units, rng);
 
-	/* and return */
-	return(retval);
+	/* call fewbody! */
+	return(fewbody(input, fb_units, hier, t, rng, curr_st));
 }
@@ -0,0 +1,752 @@
+/* -*- linux-c -*- */
+/* vi: set filetype=c.doxygen: */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "cmc.h"
+#include "cmc_vars.h"
+
+/* binary interactions of the current timestep, in the order they were picked */
+static binint_task_t *binint_batch = NULL;
+static long binint_batch_n = 0, binint_batch_alloc = 0;
+
+/* tasks this processor integrates (its own plus those received from others),
+   and the next one to be handed out to a worker */
+static binint_task_t **binint_batch_todo = NULL;
+static long binint_batch_ntodo = 0;
+static long binint_batch_next = 0;
+static pthread_mutex_t binint_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* tasks that reached the reduced step limit and wait to be integrated again
+   with the full one (see BININT_ESCALATE), and whether that is being done */
+static binint_task_t **binint_batch_esc = NULL;
+static long binint_batch_nesc = 0;
+static int binint_batch_escalating = 0;
+
+/* fewbody work space of each worker thread, kept from one timestep to the next */
+static fb_ctx_t *binint_ctx = NULL;
+static long binint_nctx = 0;
+
+/* hierarchies of applied encounters, by number of stars, kept for reuse */
+static fb_hier_t *binint_hier_pool[FB_MAX_PACK_NSTAR+1];
+static long binint_hier_npool[FB_MAX_PACK_NSTAR+1], binint_hier_apool[FB_MAX_PACK_NSTAR+1];
+
+/* what travels between processors with a task: the header, then the fewbody
+   input without the (unused) log entry, then the packed hierarchy */
+typedef struct{
+	int nstarinit, path, mismatch, escalated, relaxed, sampled;
+	unsigned long seed;
+	double t, cost, flyby_de, full_cost, full_de;
+	binint_accuracy_t full;
+	fb_units_t fb_units;
+	fb_ret_t retval;
+} binint_wire_t;
+
+/* how many encounters took each path since the last binint_path_print_stats(),
+   and how the analytic flybys compared with fewbody in validation mode; and
+   the cost and energy errors of the encounters relaxed by the accuracy policy,
+   with the full integrations of the sampled ones */
+static struct{
+	long n[3], nmismatch, nescalated, nlimit;
+	double de_sum, de_max;
+	long nrelaxed, npn, nweak, nsampled;
+	double relaxed_cost, relaxed_de_sum, relaxed_de_max, relaxed_dE;
+	double sampled_cost, sampled_full_cost, sampled_de_sum, full_de_sum;
+} binint_path_stats;
+
+#define BININT_INPUT_HEAD (offsetof(fb_input_t, firstlogentry))
+#define BININT_INPUT_TAIL (sizeof(fb_input_t) - offsetof(fb_input_t, fexp))
+
+/**
+* @brief Queues a binary interaction picked in the pair loop of dynamics_apply().
+* Everything that draws from the main random streams or reads the cluster (the
+* impact parameter, the orientations, the fewbody initial conditions) is done
+* here, so the queue can later be integrated in any order.  Each task gets its
+* own random streams for fewbody, seeded from the main stream in pick order.
+*
+* @param k index of 1st star
+* @param kp index of 2nd star
+* @param rperi ?
+* @param w[4] ?
+* @param W ?
+* @param rcm ?
+* @param vcm[4] ?
+* @param rng gsl rng
+*/
+void binint_batch_add(long k, long kp, double rperi, double w[4], double W, double rcm, double vcm[4], gsl_rng *rng)
+{
+	binint_task_t *task;
+	long long len0;
+	unsigned long seed;
+
+	if (binint_batch_n >= binint_batch_alloc) {
+		binint_batch_alloc = (binint_batch_alloc == 0) ? 64 : 2 * binint_batch_alloc;
+		binint_batch = (binint_task_t *) realloc(binint_batch, binint_batch_alloc * sizeof(binint_task_t));
+		if (binint_batch == NULL) {
+			eprintf("cannot allocate the binary interaction queue\n");
+			exit_cleanly(-1, __FUNCTION__);
+		}
+	}
+	task = &(binint_batch[binint_batch_n]);
+
+	/* the setup logs the input; hold that back so each encounter's log stays in one piece */
+	len0 = mpi_binintfile_wrbuf.len;
+	binint_prepare(task, k, kp, rperi, w, W, rcm, vcm, rng);
+	task->log = strdup(mpi_binintfile_wrbuf.len > len0 ? mpi_binintfile_wrbuf.s + len0 : "");
+	parabuf_truncate(&mpi_binintfile_wrbuf, len0);
+
+	seed = rng_t113_int_new(curr_st);
+	task->seed = seed;
+	task->dest = myid;
+	reset_rng_t113_new(seed, &(task->st));
+	task->rng_st = &(task->st);
+	task->rng = gsl_rng_alloc(rng->type);
+	gsl_rng_set(task->rng, seed);
+	if (BININT_DUMP) {
+		binint_dump(task);
+	}
+
+	binint_batch_n++;
+}
+
+/**
+* @brief The fewbody work space of worker thread i, allocated for four stars
+* the first time it is asked for.  Not thread safe: get the ones the workers
+* need before starting them.
+*
+* @param i thread number
+*
+* @return the work space
+*/
+fb_ctx_t *binint_ctx_get(long i)
+{
+	long j;
+
+	if (i >= binint_nctx) {
+		binint_ctx = (fb_ctx_t *) realloc(binint_ctx, (i+1) * sizeof(fb_ctx_t));
+		for (j=binint_nctx; j<=i; j++) {
+			fb_malloc_ctx(&(binint_ctx[j]), 4);
+		}
+		binint_nctx = i+1;
+	}
+
+	return(&(binint_ctx[i]));
+}
+
+/**
+* @brief Allocates the arrays of a fewbody hierarchy for hier->nstarinit stars,
+* reusing those of an encounter that has been applied if there is one.  Main
+* thread only.
+*
+* @param hier hierarchy with nstarinit set
+*/
+void binint_hier_get(fb_hier_t *hier)
+{
+	int n = hier->nstarinit;
+
+	if (n <= FB_MAX_PACK_NSTAR && binint_hier_npool[n] > 0) {
+		*hier = binint_hier_pool[n][--binint_hier_npool[n]];
+		fb_clear_hier(hier);
+	} else {
+		fb_malloc_hier(hier);
+	}
+}
+
+/**
+* @brief Gives the arrays of a hierarchy back for reuse by binint_hier_get().
+* Main thread only.
+*
+* @param hier hierarchy
+*/
+void binint_hier_put(fb_hier_t hier)
+{
+	int n = hier.nstarinit;
+
+	if (n > FB_MAX_PACK_NSTAR) {
+		fb_free_hier(hier);
+		return;
+	}
+	if (binint_hier_npool[n] >= binint_hier_apool[n]) {
+		binint_hier_apool[n] = (binint_hier_apool[n] == 0) ? 64 : 2 * binint_hier_apool[n];
+		binint_hier_pool[n] = (fb_hier_t *) realloc(binint_hier_pool[n], binint_hier_apool[n] * sizeof(fb_hier_t));
+	}
+	binint_hier_pool[n][binint_hier_npool[n]++] = hier;
+}
+
+/**
+* @brief Integrates a task with 1/BININT_ESCALATE of its step limit.  If it
+* reaches that limit, its initial conditions and random streams are restored
+* so that it can be integrated again with the full limit, giving the same
+* outcome as if that had been done in the first place.
+*
+* @param task the encounter
+* @param ctx fewbody work space of the calling thread
+*
+* @return 1 if the task has to be integrated again
+*/
+static int binint_escalate_try(binint_task_t *task, fb_ctx_t *ctx)
+{
+	long countstop=task->input.countstop, reduced=MAX(countstop/BININT_ESCALATE, 1);
+	double t0=task->t;
+	char *ic;
+
+	ic = (char *) malloc(fb_pack_hier_size(task->hier.nstarinit));
+	fb_pack_hier(&(task->hier), ic);
+
+	task->input.countstop = reduced;
+	binint_run(task, ctx);
+	task->input.countstop = countstop;
+
+	if (task->retval.count >= reduced) {
+		fb_unpack_hier(ic, &(task->hier));
+		task->t = t0;
+		gsl_rng_set(task->rng, task->seed);
+		reset_rng_t113_new(task->seed, &(task->st));
+		task->escalated = 1;
+	}
+	free(ic);
+
+	return(task->escalated);
+}
+
+/**
+* @brief Worker loop: integrates queued tasks until the queue is empty.  With
+* BININT_ESCALATE, the tasks that need more than the reduced step limit are
+* put aside for a second round.
+*
+* @param arg the thread number, cast to a pointer
+*
+* @return NULL
+*/
+static void *binint_batch_loop(void *arg)
+{
+	long i;
+	double cost;
+	binint_task_t *task;
+	fb_ctx_t *ctx = &(binint_ctx[(long) arg]);
+
+	while (1) {
+		pthread_mutex_lock(&binint_batch_mutex);
+		i = binint_batch_next++;
+		pthread_mutex_unlock(&binint_batch_mutex);
+
+		if (i >= binint_batch_ntodo) {
+			break;
+		}
+		task = binint_batch_todo[i];
+		if (binint_batch_escalating) {
+			cost = task->cost;
+			binint_run(task, ctx);
+			task->cost += cost;
+		} else if (BININT_ESCALATE > 1 && task->input.countstop > 0) {
+			if (binint_escalate_try(task, ctx)) {
+				pthread_mutex_lock(&binint_batch_mutex);
+				binint_batch_esc[binint_batch_nesc++] = task;
+				pthread_mutex_unlock(&binint_batch_mutex);
+			}
+		} else {
+			binint_run(task, ctx);
+		}
+	}
+
+	return(NULL);
+}
+
+/**
+* @brief Predicted relative cost of integrating a task.  Nothing better is known
+* before the integration, so this only accounts for the number of bodies and
+* for the ten times longer CPU limit of the post-Newtonian encounters.
+*
+* @param task the encounter
+*
+* @return predicted cost
+*/
+static double binint_task_weight(binint_task_t *task)
+{
+	double c = task->isbinbin ? 2.0 : 1.0;
+
+	if (task->input.PN1 || task->input.PN2 || task->input.PN25 || task->input.PN3 || task->input.PN35) {
+		c *= 10.0;
+	}
+
+	return(c);
+}
+
+/**
+* @brief Size in bytes of one task on the wire; all tasks use the size of a binary-binary one.
+*
+* @return slot size
+*/
+static size_t binint_wire_size(void)
+{
+	return(sizeof(binint_wire_t) + BININT_INPUT_HEAD + BININT_INPUT_TAIL + fb_pack_hier_size(4));
+}
+
+/**
+* @brief Packs the initial conditions (or, with result set, the outcome) of a task.
+*
+* @param task the encounter
+* @param buf slot of binint_wire_size() bytes
+* @param result whether to pack the outcome of the integration
+*/
+static void binint_wire_pack(binint_task_t *task, char *buf, int result)
+{
+	binint_wire_t w;
+
+	w.nstarinit = task->hier.nstarinit;
+	w.seed = task->seed;
+	w.t = task->t;
+	w.cost = task->cost;
+	w.path = task->path;
+	w.mismatch = task->mismatch;
+	w.flyby_de = task->flyby_de;
+	w.escalated = task->escalated;
+	w.relaxed = task->relaxed;
+	w.sampled = task->sampled;
+	w.full = task->full;
+	w.full_cost = task->full_cost;
+	w.full_de = task->full_de;
+	w.fb_units = task->fb_units;
+	if (result) {
+		w.retval = task->retval;
+	} else {
+		memset(&(w.retval), 0, sizeof(fb_ret_t));
+	}
+	memcpy(buf, &w, sizeof(binint_wire_t));
+	buf += sizeof(binint_wire_t);
+	memcpy(buf, &(task->input), BININT_INPUT_HEAD);
+	buf += BININT_INPUT_HEAD;
+	memcpy(buf, &(task->input.fexp), BININT_INPUT_TAIL);
+	buf += BININT_INPUT_TAIL;
+	fb_pack_hier(&(task->hier), buf);
+}
+
+/**
+* @brief Unpacks a slot written by binint_wire_pack().  For initial conditions
+* (result unset) the hierarchy and random streams of the task are allocated
+* here; an outcome is unpacked into the owner's task as it stands.
+*
+* @param task the encounter
+* @param buf slot of binint_wire_size() bytes
+* @param result whether the slot holds the outcome of the integration
+* @param rng_type type of the gsl rng
+*/
+static void binint_wire_unpack(binint_task_t *task, const char *buf, int result, const gsl_rng_type *rng_type)
+{
+	binint_wire_t w;
+
+	memcpy(&w, buf, sizeof(binint_wire_t));
+	buf += sizeof(binint_wire_t);
+	task->t = w.t;
+	task->cost = w.cost;
+	if (result) {
+		task->retval = w.retval;
+		task->path = w.path;
+		task->mismatch = w.mismatch;
+		task->flyby_de = w.flyby_de;
+		task->escalated = w.escalated;
+		task->full_cost = w.full_cost;
+		task->full_de = w.full_de;
+	} else {
+		memcpy(&(task->input), buf, BININT_INPUT_HEAD);
+		memcpy(&(task->input.fexp), buf + BININT_INPUT_HEAD, BININT_INPUT_TAIL);
+		task->input.firstlogentry[0] = '\0';
+		task->fb_units = w.fb_units;
+		task->seed = w.seed;
+		task->hier.nstarinit = w.nstarinit;
+		binint_hier_get(&(task->hier));
+		reset_rng_t113_new(w.seed, &(task->st));
+		task->rng_st = &(task->st);
+		task->rng = gsl_rng_alloc(rng_type);
+		gsl_rng_set(task->rng, w.seed);
+		task->log = NULL;
+		task->escalated = 0;
+		task->relaxed = w.relaxed;
+		task->sampled = w.sampled;
+		task->full = w.full;
+		task->full_cost = 0.0;
+		task->full_de = 0.0;
+	}
+	buf += BININT_INPUT_HEAD + BININT_INPUT_TAIL;
+	fb_unpack_hier(buf, &(task->hier));
+}
+
+/**
+* @brief Ships queued tasks from processors with a high predicted fewbody cost
+* to processors with a low one, the same way se_balance_exchange() moves BSE
+* work: the transfers are planned identically on all processors from the
+* gathered totals, overloaded processors being matched with underloaded ones in
+* rank order, and each one sends tasks (in pick order) until its share is
+* filled.  Returns the received tasks, which the caller integrates along with
+* its own and hands back with binint_balance_return().
+*
+* @param rng_type type of the gsl rng
+* @param nrecv number of received tasks
+* @param counts send and receive counts/displacements (bytes) for the return trip, allocated here
+* @param sendbuf send buffer, reused for the returned outcomes
+*
+* @return the received tasks
+*/
+static binint_task_t *binint_balance_exchange(const gsl_rng_type *rng_type, long *nrecv, int **counts, char **sendbuf)
+{
+	long i, j, nsend;
+	double *load, *excess, *want, mycost=0.0, mean, amt, c;
+	int *sendcounts, *recvcounts, *sdispls, *rdispls, p, r, s;
+	size_t slot = binint_wire_size();
+	char *recvbuf;
+	binint_task_t *recv;
+
+	load = (double *) malloc(procs * sizeof(double));
+	excess = (double *) malloc(procs * sizeof(double));
+	want = (double *) calloc(procs, sizeof(double));
+	*counts = (int *) calloc(4 * procs, sizeof(int));
+	sendcounts = *counts;
+	recvcounts = *counts + procs;
+	sdispls = *counts + 2 * procs;
+	rdispls = *counts + 3 * procs;
+
+	for (i=0; i<binint_batch_n; i++) {
+		mycost += binint_task_weight(&(binint_batch[i]));
+	}
+
+	double tmpTimeStart = timeStartSimple();
+	MPI_Allgather(&mycost, 1, MPI_DOUBLE, load, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	/* match overloaded with underloaded processors in rank order */
+	mean = 0.0;
+	for (p=0; p<procs; p++) mean += load[p];
+	mean /= procs;
+	for (p=0; p<procs; p++) excess[p] = load[p] - mean;
+	r = 0;
+	for (s=0; s<procs; s++) {
+		while (excess[s] > 0.0) {
+			while (r < procs && excess[r] >= 0.0) r++;
+			if (r == procs) break;
+			amt = MIN(excess[s], -excess[r]);
+			if (s == myid) want[r] += amt;
+			excess[s] -= amt;
+			excess[r] += amt;
+		}
+	}
+
+	/* fill the shares, sending a task if at least half of it fits */
+	p = 0;
+	for (i=0; i<binint_batch_n; i++) {
+		c = binint_task_weight(&(binint_batch[i]));
+		while (p < procs && want[p] < 0.5 * c) p++;
+		if (p == procs) break;
+		binint_batch[i].dest = p;
+		want[p] -= c;
+		sendcounts[p]++;
+	}
+
+	tmpTimeStart = timeStartSimple();
+	MPI_Alltoall(sendcounts, 1, MPI_INT, recvcounts, 1, MPI_INT, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	nsend = *nrecv = 0;
+	for (p=0; p<procs; p++) {
+		sdispls[p] = nsend;
+		rdispls[p] = *nrecv;
+		nsend += sendcounts[p];
+		*nrecv += recvcounts[p];
+	}
+
+	*sendbuf = (char *) malloc((nsend + 1) * slot);
+	recvbuf = (char *) malloc((*nrecv + 1) * slot);
+
+	/* pack in destination order; sdispls is used as the running position */
+	for (i=0; i<binint_batch_n; i++) {
+		p = binint_batch[i].dest;
+		if (p == myid) continue;
+		j = sdispls[p]++;
+		binint_wire_pack(&(binint_batch[i]), *sendbuf + j * slot, 0);
+	}
+	for (p=0; p<procs; p++) {
+		sdispls[p] -= sendcounts[p];
+	}
+
+	/* counts and displacements in bytes */
+	for (p=0; p<procs; p++) {
+		sendcounts[p] *= slot;
+		recvcounts[p] *= slot;
+		sdispls[p] *= slot;
+		rdispls[p] *= slot;
+	}
+
+	tmpTimeStart = timeStartSimple();
+	MPI_Alltoallv(*sendbuf, sendcounts, sdispls, MPI_BYTE, recvbuf, recvcounts, rdispls, MPI_BYTE, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	recv = (binint_task_t *) malloc((*nrecv + 1) * sizeof(binint_task_t));
+	for (i=0; i<*nrecv; i++) {
+		binint_wire_unpack(&(recv[i]), recvbuf + i * slot, 0, rng_type);
+		recv[i].dest = myid;
+	}
+
+	free(recvbuf);
+	free(load);
+	free(excess);
+	free(want);
+
+	return(recv);
+}
+
+/**
+* @brief Sends the outcomes of the tasks received by binint_balance_exchange()
+* back to their owners, and unpacks the outcomes of the tasks this processor
+* sent away into its queue.
+*
+* @param recv the received tasks, freed here
+* @param nrecv number of received tasks
+* @param counts counts and displacements from binint_balance_exchange(), freed here
+* @param sendbuf send buffer from binint_balance_exchange(), freed here
+*/
+static void binint_balance_return(binint_task_t *recv, long nrecv, int *counts, char *sendbuf)
+{
+	long i, j;
+	int p, *sendcounts=counts, *recvcounts=counts+procs, *sdispls=counts+2*procs, *rdispls=counts+3*procs;
+	size_t slot = binint_wire_size();
+	char *recvbuf;
+
+	recvbuf = (char *) malloc((nrecv + 1) * slot);
+	for (i=0; i<nrecv; i++) {
+		binint_wire_pack(&(recv[i]), recvbuf + i * slot, 1);
+		binint_hier_put(recv[i].hier);
+		gsl_rng_free(recv[i].rng);
+	}
+
+	double tmpTimeStart = timeStartSimple();
+	MPI_Alltoallv(recvbuf, recvcounts, rdispls, MPI_BYTE, sendbuf, sendcounts, sdispls, MPI_BYTE, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	/* the outcomes come back in the order the tasks were packed */
+	for (p=0; p<procs; p++) {
+		sdispls[p] /= slot;
+	}
+	for (i=0; i<binint_batch_n; i++) {
+		p = binint_batch[i].dest;
+		if (p == myid) continue;
+		j = sdispls[p]++;
+		binint_wire_unpack(&(binint_batch[i]), sendbuf + j * slot, 1, NULL);
+	}
+
+	free(recvbuf);
+	free(recv);
+	free(counts);
+	free(sendbuf);
+}
+
+/**
+* @brief Integrates the tasks in binint_batch_todo on up to BININT_THREADS
+* threads, the calling thread being one of them.
+*/
+static void binint_batch_work(void)
+{
+	pthread_t *threads;
+	long i, nthreads, nstarted=0;
+	int rc;
+
+	nthreads = MIN(MAX(BININT_THREADS, 1), MAX(binint_batch_ntodo, 1));
+	threads = (pthread_t *) malloc(nthreads * sizeof(pthread_t));
+	binint_ctx_get(nthreads-1);
+	binint_batch_next = 0;
+
+	for (i=1; i<nthreads; i++) {
+		rc = pthread_create(&(threads[nstarted]), NULL, binint_batch_loop, (void *) (nstarted+1));
+		if (rc) {
+			wprintf("return code from pthread_create() is %d, running with %ld threads\n", rc, nstarted+1);
+			break;
+		}
+		nstarted++;
+	}
+	binint_batch_loop((void *) 0);
+
+	for (i=0; i<nstarted; i++) {
+		rc = pthread_join(threads[i], NULL);
+		if (rc) {
+			eprintf("return code from pthread_join() is %d\n", rc);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+	}
+	free(threads);
+}
+
+/**
+* @brief Integrates the queued binary interactions on BININT_THREADS threads
+* (the calling thread being one of them), after moving some of them to other
+* processors if BININT_BALANCE is set, then applies the outcomes in the order
+* the encounters were picked, so the result does not depend on the number of
+* threads or processors, or on which one finished first.  Collective if
+* BININT_BALANCE is set.
+*
+* @param rng gsl rng
+*/
+void binint_batch_run(gsl_rng *rng)
+{
+	long i, nrecv=0;
+	int balance, *counts=NULL;
+	char *sendbuf=NULL;
+	binint_task_t *recv=NULL;
+
+	balance = (BININT_BALANCE && procs > 1);
+	if (binint_batch_n == 0 && !balance) {
+		return;
+	}
+
+	if (balance) {
+		recv = binint_balance_exchange(rng->type, &nrecv, &counts, &sendbuf);
+	}
+
+	/* own tasks that stayed here, then the ones received */
+	binint_batch_todo = (binint_task_t **) malloc((binint_batch_n + nrecv + 1) * sizeof(binint_task_t *));
+	binint_batch_ntodo = 0;
+	for (i=0; i<binint_batch_n; i++) {
+		if (binint_batch[i].dest == myid) {
+			binint_batch_todo[binint_batch_ntodo++] = &(binint_batch[i]);
+		}
+	}
+	for (i=0; i<nrecv; i++) {
+		binint_batch_todo[binint_batch_ntodo++] = &(recv[i]);
+	}
+
+	binint_batch_esc = (binint_task_t **) malloc((binint_batch_ntodo + 1) * sizeof(binint_task_t *));
+	binint_batch_nesc = 0;
+	binint_batch_escalating = 0;
+	binint_batch_work();
+	free(binint_batch_todo);
+
+	/* second round for the ones that needed more than the reduced step limit */
+	if (binint_batch_nesc > 0) {
+		binint_batch_todo = binint_batch_esc;
+		binint_batch_ntodo = binint_batch_nesc;
+		binint_batch_escalating = 1;
+		binint_batch_work();
+		binint_batch_escalating = 0;
+	}
+	free(binint_batch_esc);
+	binint_batch_esc = NULL;
+	binint_batch_nesc = 0;
+	binint_batch_todo = NULL;
+	binint_batch_ntodo = 0;
+
+	if (balance) {
+		binint_balance_return(recv, nrecv, counts, sendbuf);
+	}
+
+	for (i=0; i<binint_batch_n; i++) {
+		binint_apply(&(binint_batch[i]));
+		gsl_rng_free(binint_batch[i].rng);
+	}
+	binint_batch_n = 0;
+}
+
+/**
+* @brief Counts the path the outcome of an encounter took (see BININT_FLYBY),
+* whether it needed a second round or ran out of steps (see BININT_MAX_STEPS),
+* and what the accuracy policy saved on it (see BININT_PN_RPERI and BININT_WEAK_E).
+*
+* @param task the encounter, after binint_run()
+*/
+void binint_path_record(binint_task_t *task)
+{
+	double de;
+
+	binint_path_stats.n[task->path]++;
+	binint_path_stats.nescalated += task->escalated;
+	if (task->input.countstop > 0 && task->retval.count >= task->input.countstop) {
+		binint_path_stats.nlimit++;
+	}
+	if (task->path == BININT_PATH_VALIDATE) {
+		binint_path_stats.nmismatch += task->mismatch;
+		binint_path_stats.de_sum += task->flyby_de;
+		binint_path_stats.de_max = MAX(binint_path_stats.de_max, task->flyby_de);
+	}
+	if (task->relaxed && task->path != BININT_PATH_FLYBY) {
+		de = fabs(task->retval.DeltaEfrac);
+		binint_path_stats.nrelaxed++;
+		binint_path_stats.npn += ((task->relaxed & BININT_RELAX_PN) != 0);
+		binint_path_stats.nweak += ((task->relaxed & BININT_RELAX_ACC) != 0);
+		binint_path_stats.relaxed_cost += task->cost;
+		binint_path_stats.relaxed_de_sum += de;
+		binint_path_stats.relaxed_de_max = MAX(binint_path_stats.relaxed_de_max, de);
+		binint_path_stats.relaxed_dE += fabs(task->retval.DeltaE) * task->cmc_units.E;
+		if (task->sampled) {
+			binint_path_stats.nsampled++;
+			binint_path_stats.sampled_cost += task->cost;
+			binint_path_stats.sampled_full_cost += task->full_cost;
+			binint_path_stats.sampled_de_sum += de;
+			binint_path_stats.full_de_sum += task->full_de;
+		}
+	}
+}
+
+/**
+* @brief Prints the number of binary interactions of the timestep that went
+* through fewbody and through the analytic flyby to the log file (if
+* BININT_FLYBY is set), with the comparison of the two in validation mode,
+* the number that needed a second round or ran out of steps (if
+* BININT_MAX_STEPS is set), and the number relaxed by the accuracy policy with
+* their cost and energy errors (if BININT_PN_RPERI or BININT_WEAK_E is set).
+* The time saved by the policy is estimated from the encounters sampled with
+* BININT_POLICY_VALIDATE.  Resets the counts.  Collective.
+*/
+void binint_path_print_stats(void)
+{
+	double buf[18], sum[18], bufmax[2], summax[2], speedup;
+
+	if (BININT_FLYBY > 0.0 || BININT_MAX_STEPS > 0 || BININT_PN_RPERI > 0.0 || BININT_WEAK_E > 0.0) {
+		buf[0] = binint_path_stats.n[BININT_PATH_FEWBODY];
+		buf[1] = binint_path_stats.n[BININT_PATH_FLYBY];
+		buf[2] = binint_path_stats.n[BININT_PATH_VALIDATE];
+		buf[3] = binint_path_stats.nmismatch;
+		buf[4] = binint_path_stats.de_sum;
+		buf[5] = binint_path_stats.nescalated;
+		buf[6] = binint_path_stats.nlimit;
+		buf[7] = binint_path_stats.npn;
+		buf[8] = binint_path_stats.nweak;
+		buf[9] = binint_path_stats.nsampled;
+		buf[10] = binint_path_stats.relaxed_cost;
+		buf[11] = binint_path_stats.relaxed_de_sum;
+		buf[12] = binint_path_stats.relaxed_dE;
+		buf[13] = binint_path_stats.sampled_cost;
+		buf[14] = binint_path_stats.sampled_full_cost;
+		buf[15] = binint_path_stats.full_de_sum;
+		buf[16] = binint_path_stats.nrelaxed;
+		buf[17] = binint_path_stats.sampled_de_sum;
+		bufmax[0] = binint_path_stats.de_max;
+		bufmax[1] = binint_path_stats.relaxed_de_max;
+
+		double tmpTimeStart = timeStartSimple();
+		MPI_Reduce(buf, sum, 18, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(bufmax, summax, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		timeEndSimple(tmpTimeStart, &t_comm);
+
+		if (BININT_FLYBY > 0.0 && BININT_FLYBY_VALIDATE) {
+			pararootfprintf(logfile, "%s(): fewbody=%.0f validated=%.0f mismatched=%.0f mean|de|=%g max|de|=%g\n",
+				__FUNCTION__, sum[0], sum[2], sum[3], (sum[2] > 0.0) ? sum[4] / sum[2] : 0.0, summax[0]);
+		} else if (BININT_FLYBY > 0.0) {
+			pararootfprintf(logfile, "%s(): fewbody=%.0f flyby=%.0f\n", __FUNCTION__, sum[0], sum[1]);
+		}
+		if (BININT_MAX_STEPS > 0) {
+			pararootfprintf(logfile, "%s(): step limit: retried=%.0f out_of_steps=%.0f\n", __FUNCTION__, sum[5], sum[6]);
+		}
+		if (BININT_PN_RPERI > 0.0 || BININT_WEAK_E > 0.0) {
+			pararootfprintf(logfile, "%s(): accuracy policy: no_PN=%.0f weak=%.0f t_wall=%g s mean|dE/E|=%g max|dE/E|=%g sum|dE|/|Etot|=%g\n",
+				__FUNCTION__, sum[7], sum[8], sum[10], (sum[16] > 0.0) ? sum[11] / sum[16] : 0.0,
+				summax[1], sum[12] / fabs(Etotal.tot));
+			if (sum[9] > 0.0) {
+				speedup = (sum[13] > 0.0) ? sum[14] / sum[13] : 1.0;
+				pararootfprintf(logfile, "%s(): accuracy policy sample: n=%.0f t_relaxed=%g s t_full=%g s speedup=%g est_saved=%g s full_mean|dE/E|=%g relaxed_mean|dE/E|=%g\n",
+					__FUNCTION__, sum[9], sum[13], sum[14], speedup, sum[10] * (speedup - 1.0), sum[15] / sum[9], sum[17] / sum[9]);
+			}
+		}
+	}
+
+	memset(&binint_path_stats, 0, sizeof(binint_path_stats));
+}
@@ -24,7 +24,7 @@ void bs_calcunits(fb_obj_t *obj[2], fb_units_t *bs_units)
 }
 
 /**
-* @brief ?
+* @brief sets up the fewbody hierarchy, input parameters and units of a binary-single encounter (logging the input), without integrating it
 *
 * @param t ?
 * @param ksin ?
@@ -32,11 +32,11 @@ void bs_calcunits(fb_obj_t *obj[2], fb_units_t *bs_units)
 * @param W ?
 * @param bmax ?
 * @param hier ?
+* @param fb_input fewbody input parameters
+* @param units_out fewbody units
 * @param rng ?
-*
-* @return ?
 */
-fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hier_t *hier, gsl_rng *rng)
+void binsingle_setup(double *t, long ksin, long kbin, double W, double bmax, fb_hier_t *hier, fb_input_t *fb_input, fb_units_t *units_out, gsl_rng *rng)
 {
 	int j;
 	long jbin;
@@ -44,7 +44,6 @@ fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hi
 	double vc, b, rtid, m0, m1, a1, e1, m10, m11;
 	fb_units_t fb_units;
 	fb_input_t input;
-	fb_ret_t retval;
 	
 	/* a useful definition */
 	jbin = star[kbin].binind;
@@ -62,7 +61,14 @@ fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hi
 	input.tstop = 1.0e7;
 	input.Dflag = 0;
 	input.dt = 0.0;
-	input.tcpustop = 60.0;
+	/* a step budget makes the outcome independent of the machine and its load */
+	if (BININT_MAX_STEPS > 0) {
+		input.tcpustop = GSL_POSINF;
+		input.countstop = BININT_MAX_STEPS;
+	} else {
+		input.tcpustop = 60.0;
+		input.countstop = 0;
+	}
 	input.absacc = 1.0e-9;
 	input.relacc = 1.0e-9;
 	input.ncount = 500;
@@ -77,6 +83,7 @@ fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hi
     input.BHNS_TDE_FLAG = BHNS_TDE;
 	input.firstlogentry[0] = '\0';
 	input.fexp = 1.0;
+	input.integrator = FB_INTEGRATOR_RK8PD;
 	fb_debug = 0;
 
 
@@ -88,11 +95,17 @@ fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hi
 
     if((num_bh) > 1 & BH_CAPTURE){
         input.tcpustop *= 10.;
+        input.countstop *= 10;
         input.PN1 = 0;
         input.PN2 = 0;
         input.PN25 = 1;
         input.speedtol = 0.05;
     }
+
+	/* algorithmic regularization for every encounter, or just the PN ones */
+	if (BININT_INTEGRATOR == 1 || (BININT_INTEGRATOR == 2 && (input.PN1 || input.PN2 || input.PN25 || input.PN3 || input.PN35))) {
+		input.integrator = FB_INTEGRATOR_ARBS;
+	}
 	
 	/* initialize a few things for integrator */
 	*t = 0.0;
@@ -190,9 +203,31 @@ fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hi
 	fb_downsync(&(hier->hier[hier->hi[2]+0]), *t);
 	fb_upsync(&(hier->hier[hier->hi[2]+0]), *t);
 	
-	/* call fewbody! */
-	retval = fewbody(input, fb_units, hier, t, rng, curr_st);
+	/* hand the integrator parameters back */
+	*fb_input = input;
+	*units_out = fb_units;
+}
+
+/**
+* @brief sets up the binary-single encounter and integrates it with fewbody
+*
+* @param t ?
+* @param ksin ?
+* @param kbin ?
+* @param W ?
+* @param bmax ?
+* @param hier ?
+* @param rng ?
+*
+* @return ?
+*/
+fb_ret_t binsingle(double *t, long ksin, long kbin, double W, double bmax, fb_hier_t *hier, gsl_rng *rng)
+{
+	fb_input_t input;
+	fb_units_t fb_units;
+
+	binsingle_setup(t, ksin, kbin, W, bmax, hier, &input, &fb_units, rng);
 
-	/* and return */
-	return(retval);
+	/* call fewbody! */
+	return(fewbody(input, fb_units, hier, t, rng, curr_st));
 }
@@ -0,0 +1,239 @@
+/* vi: set filetype=c.doxygen: */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "cmc_checkpoint.h"
+
+#define CHECKPOINT_ZMAGIC "CMCZRSTR"
+
+/* raw size of the chunks a piece is compressed in, rounded down to whole records */
+#define CHECKPOINT_ZCHUNK 1048576
+
+/**
+* @brief Header of a compressed checkpoint.  It is followed by the size and
+* the record size of each piece (two longs per piece), then by the pieces, each
+* cut into chunks of whole records: for each chunk, the length of its zlib
+* stream (int, 0 if the chunk is stored as it is) and the stream.
+*/
+typedef struct{
+/**
+* @brief CHECKPOINT_ZMAGIC, without the terminating null
+*/
+	char tag[8];
+	int compress;
+	int nseg;
+} checkpoint_zheader_t;
+
+/**
+* @brief Groups the bytes of an array of records by their position in the
+* record, so that the slowly varying bytes of a field end up next to each
+* other, which zlib compresses much better
+*
+* @param in records
+* @param out shuffled bytes
+* @param n number of bytes, a multiple of recsize
+* @param recsize size of a record
+*/
+static void checkpoint_shuffle(const char *in, char *out, size_t n, size_t recsize)
+{
+	size_t nrec=n/recsize, r, b;
+
+	for (r=0; r<nrec; r++) {
+		for (b=0; b<recsize; b++) {
+			out[b*nrec + r] = in[r*recsize + b];
+		}
+	}
+}
+
+/**
+* @brief Undoes checkpoint_shuffle()
+*
+* @param in shuffled bytes
+* @param out records
+* @param n number of bytes, a multiple of recsize
+* @param recsize size of a record
+*/
+static void checkpoint_unshuffle(const char *in, char *out, size_t n, size_t recsize)
+{
+	size_t nrec=n/recsize, r, b;
+
+	for (r=0; r<nrec; r++) {
+		for (b=0; b<recsize; b++) {
+			out[r*recsize + b] = in[b*nrec + r];
+		}
+	}
+}
+
+/**
+* @brief raw size of the chunks of a piece
+*
+* @param seg piece
+*
+* @return size
+*/
+static size_t checkpoint_chunk_size(checkpoint_seg_t *seg)
+{
+	size_t nrec=CHECKPOINT_ZCHUNK/seg->recsize;
+
+	return((nrec > 0 ? nrec : 1) * seg->recsize);
+}
+
+/**
+* @brief Writes a checkpoint, either as the raw concatenation of its pieces or compressed
+*
+* @param fp file
+* @param seg pieces
+* @param nseg number of pieces
+* @param compress one of CHECKPOINT_COMPRESS_*
+*
+* @return 0 on success, -1 on failure
+*/
+int checkpoint_write(FILE *fp, checkpoint_seg_t *seg, int nseg, int compress)
+{
+	checkpoint_zheader_t head;
+	size_t chunk, maxchunk=0, off, n;
+	char *sbuf=NULL, *zbuf=NULL, *src;
+	uLongf zlen;
+	long sizes[2];
+	int k, len, ret=0;
+
+	if (compress == CHECKPOINT_COMPRESS_NONE) {
+		for (k=0; k<nseg; k++) {
+			if (seg[k].size > 0 && fwrite(seg[k].p, 1, seg[k].size, fp) != seg[k].size) {
+				return(-1);
+			}
+		}
+		return(0);
+	}
+
+	memset(&head, 0, sizeof(head));
+	memcpy(head.tag, CHECKPOINT_ZMAGIC, sizeof(head.tag));
+	head.compress = compress;
+	head.nseg = nseg;
+	if (fwrite(&head, sizeof(head), 1, fp) != 1) {
+		return(-1);
+	}
+	for (k=0; k<nseg; k++) {
+		sizes[0] = seg[k].size;
+		sizes[1] = seg[k].recsize;
+		if (fwrite(sizes, sizeof(long), 2, fp) != 2) {
+			return(-1);
+		}
+		chunk = checkpoint_chunk_size(&seg[k]);
+		if (chunk > maxchunk) maxchunk = chunk;
+	}
+
+	sbuf = (char *) malloc(maxchunk);
+	zbuf = (char *) malloc(compressBound(maxchunk));
+	if (sbuf == NULL || zbuf == NULL) {
+		free(sbuf);
+		free(zbuf);
+		return(-1);
+	}
+
+	for (k=0; k<nseg && ret==0; k++) {
+		chunk = checkpoint_chunk_size(&seg[k]);
+		for (off=0; off<seg[k].size && ret==0; off+=n) {
+			n = seg[k].size - off < chunk ? seg[k].size - off : chunk;
+			src = seg[k].p + off;
+			if (compress == CHECKPOINT_COMPRESS_SHUFFLE_ZLIB && seg[k].recsize > 1) {
+				checkpoint_shuffle(src, sbuf, n, seg[k].recsize);
+				src = sbuf;
+			}
+			zlen = compressBound(maxchunk);
+			if (compress2((Bytef *) zbuf, &zlen, (Bytef *) src, n, Z_BEST_SPEED) == Z_OK && zlen < n) {
+				len = zlen;
+				if (fwrite(&len, sizeof(int), 1, fp) != 1 || fwrite(zbuf, 1, zlen, fp) != zlen) {
+					ret = -1;
+				}
+			} else {
+				/* stored as is, so not shuffled either */
+				len = 0;
+				if (fwrite(&len, sizeof(int), 1, fp) != 1 || fwrite(seg[k].p + off, 1, n, fp) != n) {
+					ret = -1;
+				}
+			}
+		}
+	}
+
+	free(sbuf);
+	free(zbuf);
+	return(ret);
+}
+
+/**
+* @brief Reads a checkpoint back into its pieces, which must have the sizes they were written with
+*
+* @param fp file
+* @param seg pieces
+* @param nseg number of pieces
+* @param compressed 0 if the checkpoint was written with CHECKPOINT_COMPRESS_NONE, 1 otherwise
+*
+* @return 0 on success, -1 on failure
+*/
+int checkpoint_read(FILE *fp, checkpoint_seg_t *seg, int nseg, int compressed)
+{
+	checkpoint_zheader_t head;
+	size_t chunk, maxchunk=0, off, n;
+	char *sbuf=NULL, *zbuf=NULL, *dst;
+	uLongf ulen;
+	long sizes[2];
+	int k, len, ret=0;
+
+	if (!compressed) {
+		for (k=0; k<nseg; k++) {
+			if (seg[k].size > 0 && fread(seg[k].p, 1, seg[k].size, fp) != seg[k].size) {
+				return(-1);
+			}
+		}
+		return(0);
+	}
+
+	if (fread(&head, sizeof(head), 1, fp) != 1 || strncmp(head.tag, CHECKPOINT_ZMAGIC, sizeof(head.tag)) != 0 ||
+	    head.nseg != nseg) {
+		return(-1);
+	}
+	for (k=0; k<nseg; k++) {
+		if (fread(sizes, sizeof(long), 2, fp) != 2 || sizes[0] != (long) seg[k].size || sizes[1] != (long) seg[k].recsize) {
+			return(-1);
+		}
+		chunk = checkpoint_chunk_size(&seg[k]);
+		if (chunk > maxchunk) maxchunk = chunk;
+	}
+
+	sbuf = (char *) malloc(maxchunk);
+	zbuf = (char *) malloc(compressBound(maxchunk));
+	if (sbuf == NULL || zbuf == NULL) {
+		free(sbuf);
+		free(zbuf);
+		return(-1);
+	}
+
+	for (k=0; k<nseg && ret==0; k++) {
+		chunk = checkpoint_chunk_size(&seg[k]);
+		for (off=0; off<seg[k].size && ret==0; off+=n) {
+			n = seg[k].size - off < chunk ? seg[k].size - off : chunk;
+			if (fread(&len, sizeof(int), 1, fp) != 1 || len < 0 || (uLong) len > compressBound(maxchunk)) {
+				ret = -1;
+			} else if (len == 0) {
+				if (fread(seg[k].p + off, 1, n, fp) != n) {
+					ret = -1;
+				}
+			} else {
+				dst = (head.compress == CHECKPOINT_COMPRESS_SHUFFLE_ZLIB && seg[k].recsize > 1) ? sbuf : seg[k].p + off;
+				ulen = n;
+				if (fread(zbuf, 1, len, fp) != (size_t) len ||
+				    uncompress((Bytef *) dst, &ulen, (Bytef *) zbuf, len) != Z_OK || ulen != n) {
+					ret = -1;
+				} else if (dst == sbuf) {
+					checkpoint_unshuffle(sbuf, seg[k].p + off, n, seg[k].recsize);
+				}
+			}
+		}
+	}
+
+	free(sbuf);
+	free(zbuf);
+	return(ret);
+}
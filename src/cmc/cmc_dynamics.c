@@ -51,8 +51,8 @@ void dynamics_apply(double dt, gsl_rng *rng)
     if (0) {
         /* if (tcount%50==0 || tcount==1) { */
         MPI_File mpi_binfp;
-        char mpi_binfp_buf[10000], mpi_binfp_wrbuf[10000000];
-        long long mpi_binfp_len=0, mpi_binfp_ofst_total=0;
+        parabuf_t mpi_binfp_wrbuf = {NULL, 0, 0};
+        long long mpi_binfp_ofst_total=0;
         sprintf(filename, "a_e2.%04ld.dat", tcount);
         MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &mpi_binfp);
         MPI_File_set_size(mpi_binfp, 0);
@@ -61,8 +61,9 @@ void dynamics_apply(double dt, gsl_rng *rng)
                 parafprintf(binfp, "%g %g\n", binary[star[j].binind].a, sqr(binary[star[j].binind].e));
             }
         }
-        mpi_para_file_write(mpi_binfp_wrbuf, &mpi_binfp_len, &mpi_binfp_ofst_total, &mpi_binfp);
+        mpi_para_file_write(&mpi_binfp_wrbuf, &mpi_binfp_ofst_total, &mpi_binfp);
         MPI_File_close(&mpi_binfp);
+        parabuf_free(&mpi_binfp_wrbuf);
     }
     /* DEBUG */
 
@@ -418,13 +419,21 @@ are skipped if they already interacted in 3bb loop!  */
 			if (star[k].binind > 0 && star[kp].binind > 0) {
 				/* binary--binary */
 				print_interaction_status("BB");
-				binint_do(k, kp, rperi, w, W, rcm, vcm, rng);
+				if (BININT_THREADS > 0 || BININT_BALANCE) {
+					binint_batch_add(k, kp, rperi, w, W, rcm, vcm, rng);
+				} else {
+					binint_do(k, kp, rperi, w, W, rcm, vcm, rng);
+				}
 				/* parafprintf(collisionfile, "BB %g %g\n", TotalTime, rcm); */
 			} else if (star[k].binind > 0 || star[kp].binind > 0) {
 				/* binary--single */
 				print_interaction_status("BS");
 
-				binint_do(k, kp, rperi, w, W, rcm, vcm, rng);
+				if (BININT_THREADS > 0 || BININT_BALANCE) {
+					binint_batch_add(k, kp, rperi, w, W, rcm, vcm, rng);
+				} else {
+					binint_do(k, kp, rperi, w, W, rcm, vcm, rng);
+				}
 				/* parafprintf(collisionfile, "BS %g %g\n", TotalTime, rcm); */
 			} else {
 				/* single--single */
@@ -508,6 +517,10 @@ are skipped if they already interacted in 3bb loop!  */
 		}
 	}
 
+	/* integrate the queued binary interactions and apply their outcomes */
+	binint_batch_run(rng);
+	binint_path_print_stats();
+
     //MPI: Reduction for File IO - relaxationfile
 	double tmpTimeStart = timeStartSimple();
     double buf_comm_dbl[3][4];
@@ -70,6 +70,8 @@ void zero_star(long j)
 	star[j].se_renv = 0.0;
 	star[j].se_tms = 0.0;
 	star[j].se_bhspin = 0.0;
+	star[j].se_pristine = 0;
+	star[j].se_cost = 0.0;
 }
 
 /**
@@ -1330,34 +1332,221 @@ void binint_log_status(fb_ret_t retval, double vesc)
 void binint_log_collision(const char interaction_type[], long id,
 			  double mass, double r, fb_obj_t obj, long k, long kp, long startype)
 {
+	evlog_coll_t rec;
 	int j;
-	
-	parafprintf(collisionfile, "t=%g %s idm=%ld(mm=%g) id1=%ld(m1=%g)",
-		TotalTime, interaction_type, id, 
-		mass * units.mstar / FB_CONST_MSUN, obj.id[0], 
-		binint_get_mass(k, kp, obj.id[0]) * units.mstar 
-						  / FB_CONST_MSUN);
-	for (j=1; j<obj.ncoll; j++) {
-		parafprintf(collisionfile, ":id%d=%ld(m%d=%g)", 
-			j+1, obj.id[j], j+1,
-			binint_get_mass(k, kp, obj.id[j]) * units.mstar 
-							  / FB_CONST_MSUN);
-	}
-	parafprintf(collisionfile," (r=%g) ", r);
+
+	memset(&rec, 0, sizeof(rec));
+	rec.t = TotalTime;
+	strncpy(rec.kind, interaction_type, EVLOG_NAME_LEN-1);
+	rec.idm = id;
+	rec.mm = mass * units.mstar / FB_CONST_MSUN;
+	rec.r = r;
 //Sourav
-	parafprintf(collisionfile, "typem=%ld ", startype);
-	for (j=0; j<obj.ncoll; j++) {
-		parafprintf(collisionfile, "type%d=%ld ", j+1, 
-				binint_get_startype(k, kp, obj.id[j]));// Use this, not the Fewbody type, since this is changed by BSE after mergers
+	rec.typem = startype;
+	/* fewbody interactions merge at most four stars, well below EVLOG_COLL_MAX */
+	rec.n = obj.ncoll < EVLOG_COLL_MAX ? obj.ncoll : EVLOG_COLL_MAX;
+	for (j=0; j<rec.n; j++) {
+		rec.id[j] = obj.id[j];
+		rec.m[j] = binint_get_mass(k, kp, obj.id[j]) * units.mstar / FB_CONST_MSUN;
+		rec.type[j] = binint_get_startype(k, kp, obj.id[j]);// Use this, not the Fewbody type, since this is changed by BSE after mergers
 	}
-	parafprintf(collisionfile, "\n");
+	log_collision(&rec);
 }
 
+/**
+* @brief Writes a collision file entry, either as a line of text or, if BINARY_LOGS is set, as a binary record
+*
+* @param rec collision
+*/
+void log_collision(evlog_coll_t *rec)
+{
+	char line[EVLOG_LINE_LEN];
+	int n;
 
+	if (BINARY_LOGS) {
+		parabuf_append(&mpi_collisionfile_wrbuf, rec, sizeof(evlog_coll_t));
+	} else {
+		n = evlog_coll_format(line, sizeof(line), rec);
+		parabuf_append(&mpi_collisionfile_wrbuf, line, n < (int) sizeof(line) ? n : (int) sizeof(line) - 1);
+	}
+}
 
 /**
-* @brief do binary interaction (bin-bin or bin-single)
+* @brief Writes a bhmerger file entry, either as a line of text or, if BINARY_LOGS is set, as a binary record; the arguments are the columns of the text file
+*/
+static void log_bhmerger(double t, const char *kind, double r, long id1, long id2,
+			 double m1, double m2, double spin1, double spin2, double m_final, double spin_final,
+			 double vkick, double v_esc, double a_final, double e_final,
+			 double a_50M, double e_50M, double a_100M, double e_100M, double a_500M, double e_500M)
+{
+	evlog_bhmerger_t rec;
+	char line[EVLOG_LINE_LEN];
+	int n;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.t = t;
+	strncpy(rec.kind, kind, EVLOG_NAME_LEN-1);
+	rec.r = r;
+	rec.id1 = id1;
+	rec.id2 = id2;
+	rec.v[0] = m1;
+	rec.v[1] = m2;
+	rec.v[2] = spin1;
+	rec.v[3] = spin2;
+	rec.v[4] = m_final;
+	rec.v[5] = spin_final;
+	rec.v[6] = vkick;
+	rec.v[7] = v_esc;
+	rec.v[8] = a_final;
+	rec.v[9] = e_final;
+	rec.v[10] = a_50M;
+	rec.v[11] = e_50M;
+	rec.v[12] = a_100M;
+	rec.v[13] = e_100M;
+	rec.v[14] = a_500M;
+	rec.v[15] = e_500M;
+
+	if (BINARY_LOGS) {
+		parabuf_append(&mpi_bhmergerfile_wrbuf, &rec, sizeof(rec));
+	} else {
+		n = evlog_bhmerger_format(line, sizeof(line), &rec);
+		parabuf_append(&mpi_bhmergerfile_wrbuf, line, n < (int) sizeof(line) ? n : (int) sizeof(line) - 1);
+	}
+}
+
+
+
+/**
+* @brief copies the fewbody settings the accuracy policy may change from input to acc
 *
+* @param input fewbody input parameters
+* @param acc the settings
+*/
+static void binint_accuracy_get(fb_input_t *input, binint_accuracy_t *acc)
+{
+	acc->PN1 = input->PN1;
+	acc->PN2 = input->PN2;
+	acc->PN25 = input->PN25;
+	acc->PN3 = input->PN3;
+	acc->PN35 = input->PN35;
+	acc->integrator = input->integrator;
+	acc->absacc = input->absacc;
+	acc->relacc = input->relacc;
+}
+
+/**
+* @brief copies the settings saved by binint_accuracy_get() back to input
+*
+* @param input fewbody input parameters
+* @param acc the settings
+*/
+static void binint_accuracy_set(fb_input_t *input, binint_accuracy_t *acc)
+{
+	input->PN1 = acc->PN1;
+	input->PN2 = acc->PN2;
+	input->PN25 = acc->PN25;
+	input->PN3 = acc->PN3;
+	input->PN35 = acc->PN35;
+	input->integrator = acc->integrator;
+	input->absacc = acc->absacc;
+	input->relacc = acc->relacc;
+}
+
+/**
+* @brief estimates the closest approach of the bodies in an encounter that has
+* been set up, as the smaller of the pericenter of the incoming orbit and the
+* pericenters of the binaries
+*
+* @param hier the encounter, in fewbody units
+*
+* @return the estimate, in fewbody units
+*/
+static double binint_peri_estimate(fb_hier_t *hier)
+{
+	int i;
+	double r[3], v[3], h[3], M, E, hmod, e, rp;
+
+	M = hier->obj[0]->m + hier->obj[1]->m;
+	for (i=0; i<3; i++) {
+		r[i] = hier->obj[0]->x[i] - hier->obj[1]->x[i];
+		v[i] = hier->obj[0]->v[i] - hier->obj[1]->v[i];
+	}
+	E = 0.5 * fb_dot(v, v) - M / fb_mod(r);
+	fb_cross(r, v, h);
+	hmod = fb_mod(h);
+	e = sqrt(MAX(0.0, 1.0 + 2.0 * E * sqr(hmod) / sqr(M)));
+	rp = sqr(hmod) / M / (1.0 + e);
+
+	for (i=0; i<2; i++) {
+		if (hier->obj[i]->n == 2) {
+			rp = MIN(rp, hier->obj[i]->a * (1.0 - hier->obj[i]->e));
+		}
+	}
+
+	return(rp);
+}
+
+/**
+* @brief applies the accuracy policy to an encounter that has been set up:
+* turns the post-Newtonian terms off if the bodies are not expected to get
+* close enough for them to matter (see BININT_PN_RPERI), and loosens the
+* accuracy if the energy of the encounter is small next to that of the
+* cluster (see BININT_WEAK_E).  With BININT_POLICY_VALIDATE, picks the relaxed
+* encounters that are also integrated with the full settings.
+*
+* @param task the encounter
+*/
+static void binint_policy(binint_task_t *task)
+{
+	static long nrelaxed=0;
+	double clight, M, mk, mkp, Eenc;
+	fb_input_t *input=&(task->input);
+
+	binint_accuracy_get(input, &(task->full));
+	task->relaxed = 0;
+	task->sampled = 0;
+	task->full_cost = 0.0;
+	task->full_de = 0.0;
+
+	if (BININT_PN_RPERI > 0.0 && (input->PN1 || input->PN2 || input->PN25 || input->PN3 || input->PN35)) {
+		clight = FB_CONST_C / task->fb_units.v;
+		M = task->hier.obj[0]->m + task->hier.obj[1]->m;
+		if (binint_peri_estimate(&(task->hier)) > BININT_PN_RPERI * M / sqr(clight)) {
+			input->PN1 = 0;
+			input->PN2 = 0;
+			input->PN25 = 0;
+			input->PN3 = 0;
+			input->PN35 = 0;
+			if (BININT_INTEGRATOR == 2) {
+				input->integrator = FB_INTEGRATOR_RK8PD;
+			}
+			task->relaxed |= BININT_RELAX_PN;
+		}
+	}
+
+	if (BININT_WEAK_E > 0.0 && BININT_WEAK_ACC > MAX(input->absacc, input->relacc)) {
+		mk = star_m[get_global_idx(task->k)] * madhoc;
+		mkp = star_m[get_global_idx(task->kp)] * madhoc;
+		Eenc = task->BEi + 0.5 * mk * mkp / (mk + mkp) * sqr(task->W);
+		if (Eenc < BININT_WEAK_E * fabs(Etotal.tot)) {
+			input->absacc = BININT_WEAK_ACC;
+			input->relacc = BININT_WEAK_ACC;
+			task->relaxed |= BININT_RELAX_ACC;
+		}
+	}
+
+	if (task->relaxed && BININT_POLICY_VALIDATE > 0) {
+		task->sampled = (nrelaxed % BININT_POLICY_VALIDATE == 0);
+		nrelaxed++;
+	}
+}
+
+/**
+* @brief sets up a binary interaction (bin-bin or bin-single) for fewbody:
+* computes the initial binding energy and the units of the encounter, and
+* prepares the fewbody hierarchy and input (see binint_run() and binint_apply())
+*
+* @param task the encounter
 * @param k index of 1st star
 * @param kp index of 2nd star
 * @param rperi ?
@@ -1367,19 +1556,13 @@ void binint_log_collision(const char interaction_type[], long id,
 * @param vcm[4] ?
 * @param rng gsl rng
 */
-void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm, double vcm[4], gsl_rng *rng)
+void binint_prepare(binint_task_t *task, long k, long kp, double rperi, double w[4], double W, double rcm, double vcm[4], gsl_rng *rng)
 {
-	int i, j, isbinsingle=0, isbinbin=0, sid=-1, bid=-1, istriple, bi, nmerged;
-	long ksin=-1, kbin=-1, jbin, jbinp, knew, knewp=-1, oldk;
-	double t, bmax, wp, wx[4], wy[4], wz[4], vnew[4], alpha, BEi, BEf=0.0;
+	int i, isbinsingle=0, isbinbin=0;
+	long ksin=-1, kbin=-1, jbin, jbinp;
+	double BEi;
 	fb_hier_t hier;
-	fb_units_t cmc_units, printing_units;
-	fb_ret_t retval;
-	fb_obj_t threeobjs[3];
-	char string1[1024], string2[1024];
-	star_t tempstar, tempstar2;
-	double vs[20], VK0;
-	double energy_from_outer=0.;
+	fb_units_t cmc_units;
 
 	/* perform actions that are specific to the type of binary interaction */
 	if (star[k].binind != 0 && star[kp].binind != 0) {
@@ -1435,17 +1618,278 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
 		exit(1);
 	}
 	
-	/* malloc hier (based on value of hier.nstarinit) */
+	/* malloc hier (based on value of hier.nstarinit), or reuse one of the same size */
+	binint_hier_get(&hier);
+
+	task->k = k;
+	task->kp = kp;
+	task->isbinbin = isbinbin;
+	task->rperi = rperi;
+	task->W = W;
+	task->rcm = rcm;
+	for (i=0; i<4; i++) {
+		task->w[i] = w[i];
+		task->vcm[i] = vcm[i];
+	}
+	task->BEi = BEi;
+	task->cmc_units = cmc_units;
+	task->hier = hier;
+	task->rng = rng;
+	task->rng_st = curr_st;
+	task->log = NULL;
+	task->cost = 0.0;
+	task->escalated = 0;
+
+	task->t = 0;
+	task->bmax = rperi * sqrt(1.0 + 2.0 * ((star_m[get_global_idx(k)] + star_m[get_global_idx(kp)]) * madhoc) / (rperi * sqr(W)));
+
+	/* set up the encounter */
+	if (isbinbin) {
+		binbin_setup(&(task->t), k, kp, W, task->bmax, &(task->hier), &(task->input), &(task->fb_units), rng);
+	} else {
+		binsingle_setup(&(task->t), ksin, kbin, W, task->bmax, &(task->hier), &(task->input), &(task->fb_units), rng);
+	}
+	binint_policy(task);
+}
+
+/**
+* @brief finds the top-level object of hier made of the same stars as obj
+*
+* @param hier hierarchy to search
+* @param obj object to look for
+*
+* @return the matching object, or NULL
+*/
+static fb_obj_t *binint_match_obj(fb_hier_t *hier, fb_obj_t *obj)
+{
+	int i, j, l, found;
+
+	for (i=0; i<hier->nobj; i++) {
+		if (hier->obj[i]->n != obj->n) {
+			continue;
+		}
+		found = 0;
+		for (j=0; j<obj->n; j++) {
+			for (l=0; l<obj->n; l++) {
+				if (hier->obj[i]->id[l] == obj->id[j]) {
+					found++;
+					break;
+				}
+			}
+		}
+		if (found == obj->n) {
+			return(hier->obj[i]);
+		}
+	}
+
+	return(NULL);
+}
+
+/**
+* @brief runs both the analytic flyby (on a copy of the hierarchy) and fewbody,
+* keeps the fewbody outcome and records how far the analytic one was from it
+*
+* @param task the encounter
+*/
+static void binint_flyby_validate(binint_task_t *task, fb_ctx_t *ctx)
+{
+	int i;
+	double t;
+	char *buf;
+	fb_hier_t hier;
+	fb_ret_t retval;
+	fb_obj_t *obj;
+
+	task->path = BININT_PATH_VALIDATE;
+
+	hier.nstarinit = task->hier.nstarinit;
 	fb_malloc_hier(&hier);
+	buf = (char *) malloc(fb_pack_hier_size(hier.nstarinit));
+	fb_pack_hier(&(task->hier), buf);
+	fb_unpack_hier(buf, &hier);
+	free(buf);
+	t = task->t;
+	fb_flyby(&hier, &t, &retval);
+
+	task->retval = fewbody_ctx(ctx, task->input, task->fb_units, &(task->hier), &(task->t), task->rng, task->rng_st);
+
+	/* the flyby leaves the objects as they came in, so anything else is a miss */
+	if (task->retval.retval != 1 || task->hier.nobj != hier.nobj) {
+		task->mismatch = 1;
+	} else {
+		for (i=0; i<task->hier.nobj; i++) {
+			obj = binint_match_obj(&hier, task->hier.obj[i]);
+			if (obj == NULL) {
+				task->mismatch = 1;
+			} else if (obj->n == 2) {
+				task->flyby_de = MAX(task->flyby_de, fabs(obj->e - task->hier.obj[i]->e));
+			}
+		}
+	}
 
-	t=0;
-	bmax = rperi * sqrt(1.0 + 2.0 * ((star_m[get_global_idx(k)] + star_m[get_global_idx(kp)]) * madhoc) / (rperi * sqr(W)));
+	fb_free_hier(hier);
+}
 
-	/* call fewbody! */
-	if (isbinbin) {
-		retval = binbin(&t, k, kp, W, bmax, &hier, rng);
+/**
+* @brief integrates a copy of an encounter relaxed by the accuracy policy with
+* the settings it would have had otherwise, and records the wall time and
+* energy error of that integration; the task itself is left as it was
+*
+* @param task the encounter
+* @param ctx fewbody work space of the calling thread
+*/
+static void binint_policy_validate(binint_task_t *task, fb_ctx_t *ctx)
+{
+	double t;
+	char *buf;
+	fb_hier_t hier;
+	fb_input_t *input;
+	fb_ret_t retval;
+	struct rng_t113_state st;
+	struct timespec ts0, ts1;
+
+	hier.nstarinit = task->hier.nstarinit;
+	fb_malloc_hier(&hier);
+	buf = (char *) malloc(fb_pack_hier_size(hier.nstarinit));
+	fb_pack_hier(&(task->hier), buf);
+	fb_unpack_hier(buf, &hier);
+	free(buf);
+	input = (fb_input_t *) malloc(sizeof(fb_input_t));
+	*input = task->input;
+	binint_accuracy_set(input, &(task->full));
+	t = task->t;
+	st = *(task->rng_st);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts0);
+	retval = fewbody_ctx(ctx, *input, task->fb_units, &hier, &t, task->rng, &st);
+	clock_gettime(CLOCK_MONOTONIC, &ts1);
+	task->full_cost += (ts1.tv_sec - ts0.tv_sec) + 1.0e-9 * (ts1.tv_nsec - ts0.tv_nsec);
+	task->full_de = fabs(retval.DeltaEfrac);
+
+	free(input);
+	fb_free_hier(hier);
+}
+
+/**
+* @brief integrates a binary interaction set up by binint_prepare() with
+* fewbody, or replaces it by the analytic outcome of a distant flyby if it is
+* one (see BININT_FLYBY).  Encounters sampled by the accuracy policy are
+* first integrated with the full settings as well (see BININT_POLICY_VALIDATE).
+* Touches nothing but the task, so it may run on a worker thread.
+*
+* @param task the encounter
+* @param ctx fewbody work space of the calling thread
+*/
+void binint_run(binint_task_t *task, fb_ctx_t *ctx)
+{
+	struct timespec ts0, ts1;
+	double ratio;
+
+	task->path = BININT_PATH_FEWBODY;
+	task->mismatch = 0;
+	task->flyby_de = 0.0;
+	ratio = (BININT_FLYBY > 0.0) ? fb_flyby_ratio(&(task->hier)) : 0.0;
+	if (task->sampled && !(ratio > 0.0 && ratio >= BININT_FLYBY)) {
+		binint_policy_validate(task, ctx);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts0);
+	if (ratio > 0.0 && ratio >= BININT_FLYBY) {
+		if (BININT_FLYBY_VALIDATE) {
+			binint_flyby_validate(task, ctx);
+		} else {
+			task->path = BININT_PATH_FLYBY;
+			fb_flyby(&(task->hier), &(task->t), &(task->retval));
+		}
 	} else {
-		retval = binsingle(&t, ksin, kbin, W, bmax, &hier, rng);
+		task->retval = fewbody_ctx(ctx, task->input, task->fb_units, &(task->hier), &(task->t), task->rng, task->rng_st);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts1);
+	task->cost = (ts1.tv_sec - ts0.tv_sec) + 1.0e-9 * (ts1.tv_nsec - ts0.tv_nsec);
+}
+
+/**
+* @brief appends the fewbody inputs of an encounter set up by binint_prepare()
+* to the dump file (see BININT_DUMP), so it can be rerun by fewbody_bench_replay.
+*
+* @param task the encounter
+*/
+void binint_dump(binint_task_t *task)
+{
+	if (fb_write_scattering(binintdumpfile, &(task->input), &(task->fb_units), &(task->hier), task->t, task->rng_st)) {
+		wprintf("cannot write binary interaction to the dump file; not dumping any more\n");
+		BININT_DUMP = 0;
+		gzclose(binintdumpfile);
+	}
+}
+
+/**
+* @brief do binary interaction (bin-bin or bin-single)
+*
+* @param k index of 1st star
+* @param kp index of 2nd star
+* @param rperi ?
+* @param w[4] ?
+* @param W ?
+* @param rcm ?
+* @param vcm[4] ?
+* @param rng gsl rng
+*/
+void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm, double vcm[4], gsl_rng *rng)
+{
+	binint_task_t task;
+
+	binint_prepare(&task, k, kp, rperi, w, W, rcm, vcm, rng);
+	if (BININT_DUMP) {
+		binint_dump(&task);
+	}
+	binint_run(&task, binint_ctx_get(0));
+	binint_apply(&task);
+}
+
+/**
+* @brief applies the outcome of an integrated binary interaction to the
+* cluster: creates the new objects, destroys the progenitors and updates
+* the binding energy budget.  Hands the fewbody memory of the task back for reuse.
+*
+* @param task the encounter
+*/
+void binint_apply(binint_task_t *task)
+{
+	int i, j, isbinbin, sid=-1, bid=-1, istriple, bi, nmerged;
+	long k, kp, knew, knewp=-1, oldk;
+	double t, wp, wx[4], wy[4], wz[4], vnew[4], alpha, BEi, BEf=0.0;
+	double *w, W, rcm, *vcm;
+	fb_hier_t hier;
+	fb_units_t cmc_units, printing_units;
+	fb_ret_t retval;
+	fb_obj_t threeobjs[3];
+	char string1[1024], string2[1024];
+	star_t tempstar, tempstar2;
+	double vs[20], VK0;
+	double energy_from_outer=0.;
+
+	k = task->k;
+	kp = task->kp;
+	isbinbin = task->isbinbin;
+	w = task->w;
+	W = task->W;
+	rcm = task->rcm;
+	vcm = task->vcm;
+	BEi = task->BEi;
+	t = task->t;
+	hier = task->hier;
+	cmc_units = task->cmc_units;
+	retval = task->retval;
+
+	fb_cost_record(star[k].id, task->cost);
+	binint_path_record(task);
+
+	/* input part of the log, if it was held back while the encounter was queued */
+	if (task->log != NULL) {
+		parafprintf(binintfile, "%s", task->log);
+		free(task->log);
+		task->log = NULL;
 	}
 
 	/* set up axes */
@@ -1643,7 +2087,7 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
                             star[knew].se_radius = hier.obj[i]->R * cmc_units.l / BH_RADIUS_MULTIPLYER * units.l / RSUN;
                             star[knew].Eint = 0;
                             if(WRITE_BH_INFO && tempstar.se_k == 14 && star[knew].se_k == 14)
-                                parafprintf(bhmergerfile, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g\n",
+                                log_bhmerger(
                                                           TotalTime, (isbinbin?"binary-binary":"binary-single"),
                                                           star_r[get_global_idx(knew)], hier.obj[i]->id[0],hier.obj[i]->id[nmerged], 
                                                           binint_get_mass(k, kp, hier.obj[i]->id[0]) * units.mstar / FB_CONST_MSUN, 
@@ -1731,7 +2175,7 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
                             tempstar.se_radius = hier.obj[i]->obj[0]->R * cmc_units.l/ BH_RADIUS_MULTIPLYER * units.l / RSUN;
                             tempstar.Eint = 0;
                             if(WRITE_BH_INFO && tempstar2.se_k == 14 && tempstar.se_k == 14)
-                                parafprintf(bhmergerfile, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g\n",
+                                log_bhmerger(
                                                           TotalTime, (isbinbin?"binary-binary":"binary-single"),
                                                           star_r[get_global_idx(knew)], hier.obj[i]->obj[0]->id[0],hier.obj[i]->obj[0]->id[nmerged], 
                                                           binint_get_mass(k, kp, hier.obj[i]->obj[0]->id[0]) * units.mstar / FB_CONST_MSUN, 
@@ -1813,7 +2257,7 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
                             tempstar.se_radius = hier.obj[i]->obj[1]->R * cmc_units.l/ BH_RADIUS_MULTIPLYER * units.l / RSUN;
                             tempstar.Eint = 0;
                             if(WRITE_BH_INFO && tempstar2.se_k == 14 && tempstar.se_k == 14)
-                                parafprintf(bhmergerfile, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g\n",
+                                log_bhmerger(
                                                           TotalTime, (isbinbin?"binary-binary":"binary-single"),
                                                           star_r[get_global_idx(knew)], hier.obj[i]->obj[1]->id[0],hier.obj[i]->obj[1]->id[nmerged], 
                                                           binint_get_mass(k, kp, hier.obj[i]->obj[1]->id[0]) * units.mstar / FB_CONST_MSUN, 
@@ -1948,7 +2392,7 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
                             star[knewp].se_radius = hier.obj[i]->obj[sid]->R * cmc_units.l/ BH_RADIUS_MULTIPLYER * units.l / RSUN;
                             star[knewp].Eint = 0;
                             if(WRITE_BH_INFO && star[knewp].se_k == 14 && tempstar.se_k == 14 )
-                                parafprintf(bhmergerfile, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g\n",
+                                log_bhmerger(
                                                           TotalTime, (isbinbin?"binary-binary":"binary-single"),
                                                           star_r[get_global_idx(knew)], hier.obj[i]->obj[sid]->id[0],hier.obj[i]->obj[sid]->id[nmerged], 
                                                           binint_get_mass(k, kp, hier.obj[i]->obj[sid]->id[0]) * units.mstar / FB_CONST_MSUN, 
@@ -2031,7 +2475,7 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
                             tempstar.se_radius = hier.obj[i]->obj[bid]->obj[0]->R * cmc_units.l/ BH_RADIUS_MULTIPLYER * units.l / RSUN;
                             tempstar.Eint = 0;
                             if(WRITE_BH_INFO && tempstar2.se_k == 14 && tempstar.se_k == 14)
-                                parafprintf(bhmergerfile, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g\n",
+                                log_bhmerger(
                                                           TotalTime, (isbinbin?"binary-binary":"binary-single"),
                                                           star_r[get_global_idx(knew)], hier.obj[i]->obj[bid]->obj[0]->id[0],hier.obj[i]->obj[bid]->obj[0]->id[nmerged], 
                                                           binint_get_mass(k, kp, hier.obj[i]->obj[bid]->obj[0]->id[0]) * units.mstar / FB_CONST_MSUN, 
@@ -2104,7 +2548,7 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
                             tempstar.se_radius = hier.obj[i]->obj[bid]->obj[1]->R * cmc_units.l/ BH_RADIUS_MULTIPLYER * units.l / RSUN;
                             tempstar.Eint = 0;
                             if(WRITE_BH_INFO && tempstar2.se_k == 14 && tempstar.se_k == 14)
-                                parafprintf(bhmergerfile, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g\n",
+                                log_bhmerger(
                                                           TotalTime, (isbinbin?"binary-binary":"binary-single"),
                                                           star_r[get_global_idx(knew)], hier.obj[i]->obj[bid]->obj[1]->id[0],hier.obj[i]->obj[bid]->obj[1]->id[nmerged], 
                                                           binint_get_mass(k, kp, hier.obj[i]->obj[bid]->obj[1]->id[0]) * units.mstar / FB_CONST_MSUN, 
@@ -2176,8 +2620,8 @@ void binint_do(long k, long kp, double rperi, double w[4], double W, double rcm,
 		}
 	}
 	
-	/* free Fewbody memory */
-	fb_free_hier(hier);
+	/* keep the Fewbody memory for the next encounter */
+	binint_hier_put(hier);
 }
 
 /**
@@ -2911,10 +3355,10 @@ void binary_bh_merger(long k, long kb, long knew, int kprev0, int kprev1, struct
 	star[knew].se_bhspin = afinal;
 
     if(WRITE_BH_INFO)
-        parafprintf(bhmergerfile, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g -100 -100 -100 -100 -100 -100\n", TotalTime, "isolat-binary",
+        log_bhmerger(TotalTime, "isolat-binary",
                                         star_r[get_global_idx(knew)], binary[kb].id1,binary[kb].id2, m1,m2,chi1,chi2,
                                         (m1+m2)*mass_frac, afinal,vk, 
                                         sqrt(-2*star_phi[get_global_idx(knew)])*(units.l/units.t) / 1.0e5, 
-                                        binary[kb].a*units.l/AU,binary[kb].e);
+                                        binary[kb].a*units.l/AU,binary[kb].e, -100, -100, -100, -100, -100, -100);
 }
 
@@ -0,0 +1,174 @@
+/* vi: set filetype=c.doxygen: */
+#include <stdio.h>
+#include <string.h>
+#include "cmc_evlog.h"
+
+/**
+* @brief column header of the text escape file
+*/
+const char *evlog_esc_header = "#1:tcount #2:t #3:m[MSUN] #4:r #5:vr #6:vt #7:r_peri #8:r_apo #9:Rtidal #10:phi_rtidal #11:phi_zero #12:E #13:J #14:id #15:binflag #16:m0[MSUN] #17:m1[MSUN] #18:id0 #19:id1 #20:a #21:e #22:startype #23:bin_startype0 #24:bin_startype1 #25:rad0 #26:rad1 #27:tb #28:lum0 #29:lum1 #30:massc0 #31:massc1 #32:radc0 #33:radc1 #34:menv0 #35:menv1 #36:renv0 #37:renv1 #38:tms0 #39:tms1 #40:dmdt0 #41:dmdt1 #42:radrol0 #43:radrol1 #44:ospin0 #45:ospin1 #46:B0 #47:B1 #48:formation0 #49:formation1 #50:bacc0 #51:bacc1 #52:tacc0 $53:tacc1 #54:mass0_0 #55:mass0_1 #56:epoch0 #57:epoch1 #58:bhspin #59:bhspin1 #60:bhspin2 #61:ospin #62:B #63:formation\n";
+
+/**
+* @brief column header of the text collision file
+*/
+const char *evlog_coll_header = "# time interaction_type id_merger(mass_merger) id1(m1):id2(m2):id3(m3):... (r) type_merger type1 ...\n";
+
+/**
+* @brief column header of the text semergedisrupt file
+*/
+const char *evlog_semerge_header = "# time interaction_type id_rem(mass_rem) id1(m1):id2(m2) (r)\n";
+
+/**
+* @brief column header of the text bhmerger file
+*/
+const char *evlog_bhmerger_header = "#1:time #2:type #3.r #4:id1 #5:id2 #6:m1[MSUN] #7:m2[MSUN] #8:spin1 #9:spin2 #10:m_final[MSUN] #11:spin_final #12:vkick[km/s] #13:v_esc[km/s] #14:a_final[AU] #15:e_final #16:a_50M[AU] #17:e_50 #18:a_100M[AU] #19:e_100M #20:a_500M[AU] #21:e_500M\n"
+	"#NOTE: if repeated mergers occur in fewbody (binary-single or binary-binary), the initial masses will be wrong; check collision.log\n";
+
+/**
+* @brief room left in an output string of size n after len characters, for snprintf
+*/
+static size_t evlog_room(size_t n, int len)
+{
+	return((size_t) len < n ? n - len : 0);
+}
+
+/**
+* @brief Fills in the header of a binary event log
+*
+* @param head header
+* @param type event type
+* @param recsize size of each record
+*/
+void evlog_header_init(evlog_header_t *head, int type, int recsize)
+{
+	memset(head, 0, sizeof(evlog_header_t));
+	memcpy(head->tag, EVLOG_MAGIC, sizeof(head->tag));
+	head->version = EVLOG_VERSION;
+	head->endian = EVLOG_ENDIAN;
+	head->type = type;
+	head->recsize = recsize;
+}
+
+/**
+* @brief Checks that a header read from a file matches what this code writes
+*
+* @param head header
+* @param type expected event type
+* @param recsize expected size of each record
+*
+* @return 0 if the header matches, -1 otherwise
+*/
+int evlog_header_check(evlog_header_t *head, int type, int recsize)
+{
+	if (strncmp(head->tag, EVLOG_MAGIC, sizeof(head->tag)) != 0 || head->version != EVLOG_VERSION ||
+	    head->endian != EVLOG_ENDIAN || head->type != type || head->recsize != recsize) {
+		return(-1);
+	}
+	return(0);
+}
+
+/**
+* @brief Formats an escaping star as the line of the text escape file it stands for
+*
+* @param s output string
+* @param n size of s
+* @param rec record
+*
+* @return number of characters that the line takes, as for snprintf
+*/
+int evlog_esc_format(char *s, size_t n, evlog_esc_t *rec)
+{
+	int len;
+
+	len = snprintf(s, n, "%ld %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %ld ",
+		rec->tcount, rec->t, rec->m, rec->r, rec->vr, rec->vt, rec->r_peri,
+		rec->r_apo, rec->Rtidal, rec->phi_rtidal, rec->phi_zero, rec->E, rec->J, rec->id);
+
+	if (rec->binflag) {
+		len += snprintf(s+len, evlog_room(n, len), "1 %.8g %.8g %ld %ld %.8g %.8g ",
+			rec->m0, rec->m1, rec->id0, rec->id1, rec->a, rec->e);
+	} else {
+		len += snprintf(s+len, evlog_room(n, len), "0 0 0 0 0 0 0 ");
+	}
+
+	if (!rec->binflag) {
+		len += snprintf(s+len, evlog_room(n, len), "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na %g %g %g\n",
+			(int) rec->startype, rec->bhspin, rec->ospin, rec->B, rec->formation);
+	} else {
+		len += snprintf(s+len, evlog_room(n, len), "na %d %d %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g na %g %g na na na\n",
+			(int) rec->kw0, (int) rec->kw1, rec->rad[0], rec->rad[1], rec->tb, rec->lum[0], rec->lum[1], rec->massc[0], rec->massc[1], rec->radc[0], rec->radc[1], rec->menv[0], rec->menv[1], rec->renv[0], rec->renv[1], rec->tms[0], rec->tms[1], rec->dmdt[0], rec->dmdt[1], rec->radrol[0], rec->radrol[1], rec->bospin[0], rec->bospin[1], rec->bB[0], rec->bB[1], rec->bformation[0], rec->bformation[1], rec->bacc[0], rec->bacc[1], rec->tacc[0], rec->tacc[1], rec->mass0[0], rec->mass0[1], rec->epoch[0], rec->epoch[1], rec->bbhspin[0], rec->bbhspin[1]);
+	}
+
+	return(len);
+}
+
+/**
+* @brief Formats a collision as the line of the text collision file it stands for
+*
+* @param s output string
+* @param n size of s
+* @param rec record
+*
+* @return number of characters that the line takes, as for snprintf
+*/
+int evlog_coll_format(char *s, size_t n, evlog_coll_t *rec)
+{
+	int len, j;
+
+	if (rec->ss) {
+		return(snprintf(s, n, "t=%g %s idm=%ld(mm=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typem=%d type1=%d type2=%d b[RSUN]=%g vinf[km/s]=%g rad1=%g rad2=%g rperi=%g coll_mult=%g\n",
+			rec->t, rec->kind, rec->idm, rec->mm, rec->id[0], rec->m[0], rec->id[1], rec->m[1],
+			rec->r, (int) rec->typem, (int) rec->type[0], (int) rec->type[1],
+			rec->b, rec->vinf, rec->rad1, rec->rad2, rec->rperi, rec->coll_mult));
+	}
+
+	len = snprintf(s, n, "t=%g %s idm=%ld(mm=%g) id1=%ld(m1=%g)",
+		rec->t, rec->kind, rec->idm, rec->mm, rec->id[0], rec->m[0]);
+	for (j=1; j<rec->n; j++) {
+		len += snprintf(s+len, evlog_room(n, len), ":id%d=%ld(m%d=%g)", j+1, rec->id[j], j+1, rec->m[j]);
+	}
+	len += snprintf(s+len, evlog_room(n, len), " (r=%g) typem=%ld ", rec->r, rec->typem);
+	for (j=0; j<rec->n; j++) {
+		len += snprintf(s+len, evlog_room(n, len), "type%d=%ld ", j+1, rec->type[j]);
+	}
+	len += snprintf(s+len, evlog_room(n, len), "\n");
+
+	return(len);
+}
+
+/**
+* @brief Formats a binary merger or disruption as the line of the text semergedisrupt file it stands for
+*
+* @param s output string
+* @param n size of s
+* @param rec record
+*
+* @return number of characters that the line takes, as for snprintf
+*/
+int evlog_semerge_format(char *s, size_t n, evlog_semerge_t *rec)
+{
+	if (!rec->remnant) {
+		return(snprintf(s, n, "t=%g %s id1=%ld(m1=%g) id2=%ld(m2=%g) (r=%g) type1=%d type2=%d\n",
+			rec->t, rec->kind, rec->id1, rec->m1, rec->id2, rec->m2, rec->r, (int) rec->type1, (int) rec->type2));
+	}
+	return(snprintf(s, n, "t=%g %s idr=%ld(mr=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typer=%d type1=%d type2=%d\n",
+		rec->t, rec->kind, rec->idr, rec->mr, rec->id1, rec->m1, rec->id2, rec->m2, rec->r,
+		(int) rec->typer, (int) rec->type1, (int) rec->type2));
+}
+
+/**
+* @brief Formats a black hole merger as the line of the text bhmerger file it stands for
+*
+* @param s output string
+* @param n size of s
+* @param rec record
+*
+* @return number of characters that the line takes, as for snprintf
+*/
+int evlog_bhmerger_format(char *s, size_t n, evlog_bhmerger_t *rec)
+{
+	return(snprintf(s, n, "%.18g %s %g %ld %ld %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g\n",
+		rec->t, rec->kind, rec->r, rec->id1, rec->id2,
+		rec->v[0], rec->v[1], rec->v[2], rec->v[3], rec->v[4], rec->v[5], rec->v[6], rec->v[7],
+		rec->v[8], rec->v[9], rec->v[10], rec->v[11], rec->v[12], rec->v[13], rec->v[14], rec->v[15]));
+}
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
 #include <time.h>
@@ -437,14 +438,98 @@ double GetTimeStep(gsl_rng *rng) {
 	return (Dt);
 }
 
+/**
+* @brief Writes the escape file entry of a star that is being removed from the cluster, either as a line of text or, if BINARY_LOGS is set, as a binary record
+*
+* @param i index of star
+* @param m mass of star, as it is to appear in the file
+* @param r position of star
+* @param E energy of star
+* @param J angular momentum of star
+* @param phi_rtidal potential at tidal radius
+* @param phi_zero potential at zero
+*/
+static void log_escaped_star(long i, double m, double r, double E, double J, double phi_rtidal, double phi_zero)
+{
+	evlog_esc_t rec;
+	long k, n, j;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.tcount = tcount;
+	rec.t = TotalTime;
+	rec.m = m;
+	rec.r = r;
+	rec.vr = star[i].vr;
+	rec.vt = star[i].vt;
+	rec.r_peri = star[i].r_peri;
+	rec.r_apo = star[i].r_apo;
+	rec.Rtidal = Rtidal;
+	rec.phi_rtidal = phi_rtidal;
+	rec.phi_zero = phi_zero;
+	rec.E = E;
+	rec.J = J;
+	rec.id = star[i].id;
+
+	k = star[i].binind;
+	if (k) {
+		rec.binflag = 1;
+		rec.m0 = binary[k].m1 * (units.m / clus.N_STAR) / MSUN;
+		rec.m1 = binary[k].m2 * (units.m / clus.N_STAR) / MSUN;
+		rec.id0 = binary[k].id1;
+		rec.id1 = binary[k].id2;
+		rec.a = binary[k].a * units.l / AU;
+		rec.e = binary[k].e;
+		rec.kw0 = binary[k].bse_kw[0];
+		rec.kw1 = binary[k].bse_kw[1];
+		rec.tb = binary[k].bse_tb;
+		for (j=0; j<2; j++) {
+			rec.rad[j] = binary[k].bse_radius[j];
+			rec.lum[j] = binary[k].bse_lum[j];
+			rec.massc[j] = binary[k].bse_massc[j];
+			rec.radc[j] = binary[k].bse_radc[j];
+			rec.menv[j] = binary[k].bse_menv[j];
+			rec.renv[j] = binary[k].bse_renv[j];
+			rec.tms[j] = binary[k].bse_tms[j];
+			rec.dmdt[j] = binary[k].bse_bcm_dmdt[j];
+			rec.radrol[j] = binary[k].bse_bcm_radrol[j];
+			rec.bospin[j] = binary[k].bse_ospin[j];
+			rec.bB[j] = binary[k].bse_bcm_B[j];
+			rec.bformation[j] = binary[k].bse_bcm_formation[j];
+			rec.bacc[j] = binary[k].bse_bacc[j];
+			rec.tacc[j] = binary[k].bse_tacc[j];
+			rec.mass0[j] = binary[k].bse_mass0[j];
+			rec.epoch[j] = binary[k].bse_epoch[j];
+			rec.bbhspin[j] = binary[k].bse_bhspin[j];
+		}
+	} else {
+		rec.startype = star[i].se_k;
+		rec.bhspin = star[i].se_bhspin;
+		rec.ospin = star[i].se_ospin;
+		rec.B = star[i].se_scm_B;
+		rec.formation = star[i].se_scm_formation;
+	}
+
+	if (BINARY_LOGS) {
+		parabuf_append(&mpi_escfile_wrbuf, &rec, sizeof(rec));
+	} else {
+		/* format straight into the tail of the file buffer */
+		parabuf_reserve(&mpi_escfile_wrbuf, EVLOG_LINE_LEN);
+		n = evlog_esc_format(mpi_escfile_wrbuf.s + mpi_escfile_wrbuf.len, mpi_escfile_wrbuf.size - mpi_escfile_wrbuf.len, &rec);
+		if (mpi_escfile_wrbuf.len + n + 1 > mpi_escfile_wrbuf.size) {
+			parabuf_reserve(&mpi_escfile_wrbuf, n);
+			evlog_esc_format(mpi_escfile_wrbuf.s + mpi_escfile_wrbuf.len, mpi_escfile_wrbuf.size - mpi_escfile_wrbuf.len, &rec);
+		}
+		mpi_escfile_wrbuf.len += n;
+	}
+}
+
 /**
 * @brief removes tidally-stripped stars
 */
 void tidally_strip_stars(void) {
 	double phi_rtidal, phi_zero, gierszalpha;
 	double m, r, phi;
-	long i, j, k;
-	k = 0;
+	long i, j;
 	j = 0;
 	Etidal = 0.0;
 
@@ -496,37 +581,7 @@ void tidally_strip_stars(void) {
 					Etidal += star[i].E * m / clus.N_STAR;
 
 					/* logging */
-					parafprintf(escfile,
-							"%ld %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %ld ",
-							tcount, TotalTime, m * (units.m / clus.N_STAR) / MSUN,
-							r, star[i].vr, star[i].vt, star[i].r_peri,
-							star[i].r_apo, Rtidal, phi_rtidal, phi_zero, star[i].E, star[i].J, star[i].id);
-
-					if (star[i].binind) {
-						k = star[i].binind;
-						parafprintf(escfile, "1 %.8g %.8g %ld %ld %.8g %.8g ", 
-								binary[k].m1 * (units.m / clus.N_STAR) / MSUN, 
-								binary[k].m2 * (units.m / clus.N_STAR) / MSUN, 
-								binary[k].id1, binary[k].id2,
-								binary[k].a * units.l / AU, binary[k].e);
-					} else {
-						parafprintf(escfile, "0 0 0 0 0 0 0 ");	
-					}
-
-					if (star[i].binind == 0) {
-                        //parafprintf(escfile, "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na %g %g",
-                                //star[i].se_k, star[i].se_bhspin, star[i].se_ospin, star[i].se_scm_B);
-
-                        //Sourav: index mistake??
-                        //parafprintf(escfile, "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na",
-                        //        star[j].se_k, star[j].se_bhspin);
-                        parafprintf(escfile, "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na %g %g %g",
-                                star[i].se_k, star[i].se_bhspin, star[i].se_ospin, star[i].se_scm_B, star[i].se_scm_formation);
-					} else {
-                        parafprintf(escfile, "na %d %d %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g na %g %g na na na",
-                                binary[k].bse_kw[0], binary[k].bse_kw[1], binary[k].bse_radius[0], binary[k].bse_radius[1], binary[k].bse_tb, binary[k].bse_lum[0], binary[k].bse_lum[1], binary[k].bse_massc[0], binary[k].bse_massc[1], binary[k].bse_radc[0], binary[k].bse_radc[1], binary[k].bse_menv[0], binary[k].bse_menv[1], binary[k].bse_renv[0], binary[k].bse_renv[1], binary[k].bse_tms[0], binary[k].bse_tms[1], binary[k].bse_bcm_dmdt[0], binary[k].bse_bcm_dmdt[1], binary[k].bse_bcm_radrol[0], binary[k].bse_bcm_radrol[1], binary[k].bse_ospin[0], binary[k].bse_ospin[1], binary[k].bse_bcm_B[0], binary[k].bse_bcm_B[1], binary[k].bse_bcm_formation[0], binary[k].bse_bcm_formation[1], binary[k].bse_bacc[0], binary[k].bse_bacc[1], binary[k].bse_tacc[0], binary[k].bse_tacc[1], binary[k].bse_mass0[0], binary[k].bse_mass0[1], binary[k].bse_epoch[0], binary[k].bse_epoch[1], binary[k].bse_bhspin[0], binary[k].bse_bhspin[1]);
-					}
-					parafprintf (escfile, "\n");
+					log_escaped_star(i, m * (units.m / clus.N_STAR) / MSUN, r, star[i].E, star[i].J, phi_rtidal, phi_zero);
 
 					// Meagan - check for, and count, escaping BHs
 					//Sourav: make sure this is correct
@@ -569,37 +624,7 @@ void tidally_strip_stars(void) {
 					Etidal += star[i].E * m / clus.N_STAR;
 
 					/* logging */
-					parafprintf(escfile,
-							"%ld %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %.8g %ld ",
-							tcount, TotalTime, m,
-							r, star[i].vr, star[i].vt, star[i].r_peri,
-							star[i].r_apo, Rtidal, phi_rtidal, phi_zero, star[i].E, star[i].J, star[i].id);
-
-					if (star[i].binind) {
-						k = star[i].binind;
-						parafprintf(escfile, "1 %.8g %.8g %ld %ld %.8g %.8g ", 
-								binary[k].m1 * (units.m / clus.N_STAR) / MSUN, 
-								binary[k].m2 * (units.m / clus.N_STAR) / MSUN, 
-								binary[k].id1, binary[k].id2,
-								binary[k].a * units.l / AU, binary[k].e);
-					} else {
-						parafprintf(escfile, "0 0 0 0 0 0 0 ");	
-					}
-
-					if (star[i].binind == 0) {
-                        //parafprintf(escfile, "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na %g %g",
-                               //star[i].se_k, star[i].se_bhspin, star[i].se_ospin, star[i].se_scm_B);
-
-                        //Sourav: index mistakes; make sure the fix is correct
-                        //parafprintf(escfile, "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na",
-                        //        star[j].se_k, star[j].se_bhspin);
-			parafprintf(escfile, "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na %g %g %g",
-                                star[i].se_k, star[i].se_bhspin, star[i].se_ospin, star[i].se_scm_B, star[i].se_scm_formation);
-					} else {
-                        parafprintf(escfile, "na %d %d %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g na %g %g na na na",
-                                binary[k].bse_kw[0], binary[k].bse_kw[1], binary[k].bse_radius[0], binary[k].bse_radius[1], binary[k].bse_tb, binary[k].bse_lum[0], binary[k].bse_lum[1], binary[k].bse_massc[0], binary[k].bse_massc[1], binary[k].bse_radc[0], binary[k].bse_radc[1], binary[k].bse_menv[0], binary[k].bse_menv[1], binary[k].bse_renv[0], binary[k].bse_renv[1], binary[k].bse_tms[0], binary[k].bse_tms[1], binary[k].bse_bcm_dmdt[0], binary[k].bse_bcm_dmdt[1], binary[k].bse_bcm_radrol[0], binary[k].bse_bcm_radrol[1], binary[k].bse_ospin[0], binary[k].bse_ospin[1], binary[k].bse_bcm_B[0], binary[k].bse_bcm_B[1], binary[k].bse_bcm_formation[0], binary[k].bse_bcm_formation[1], binary[k].bse_bacc[0], binary[k].bse_bacc[1], binary[k].bse_tacc[0], binary[k].bse_tacc[1], binary[k].bse_mass0[0], binary[k].bse_mass0[1], binary[k].bse_epoch[0], binary[k].bse_epoch[1], binary[k].bse_bhspin[0], binary[k].bse_bhspin[1]);
-					}
-					parafprintf (escfile, "\n");
+					log_escaped_star(i, m, r, star[i].E, star[i].J, phi_rtidal, phi_zero);
 
 					/* perhaps this will fix the problem wherein stars are ejected (and counted)
 					   multiple times */
@@ -654,7 +679,6 @@ void tidally_strip_stars(void) {
 */
 void remove_star(long j, double phi_rtidal, double phi_zero) {
 	double E, J, m, r;
-	long k=0;
 
 	/* dprintf("removing star: i=%ld id=%ld m=%g E=%g bin=%ld\n", j, star[j].id, star[j].m, star[j].E, star[j].binind); */
 
@@ -682,31 +706,7 @@ void remove_star(long j, double phi_rtidal, double phi_zero) {
 	Etidal += E * m / clus.N_STAR;
 
 	/* logging */
-	parafprintf(escfile, "%ld %.8g %.8g ",
-		tcount, TotalTime, m);
-	parafprintf(escfile, "%.8g %.8g %.8g ",
-		r, star[j].vr, star[j].vt);
-	parafprintf(escfile, "%.8g %.8g %.8g %.8g %.8g %.8g %.8g %ld ",
-	        star[j].r_peri, star[j].r_apo, Rtidal, phi_rtidal, phi_zero, E, J, star[j].id);
-	if (star[j].binind) {
-		k = star[j].binind;
-		parafprintf(escfile, "1 %.8g %.8g %ld %ld %.8g %.8g ", 
-				binary[k].m1 * (units.m / clus.N_STAR) / MSUN, 
-				binary[k].m2 * (units.m / clus.N_STAR) / MSUN, 
-				binary[k].id1, binary[k].id2,
-				binary[k].a * units.l / AU, binary[k].e);
-	} else {
-		parafprintf(escfile, "0 0 0 0 0 0 0 ");	
-	}
-
-	if (star[j].binind == 0) {
-		parafprintf(escfile, "%d na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na na %g na na %g %g %g",
-				star[j].se_k, star[j].se_bhspin, star[j].se_ospin, star[j].se_scm_B, star[j].se_scm_formation);
-	} else {
-		parafprintf(escfile, "na %d %d %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g na %g %g na na na",
-                                binary[k].bse_kw[0], binary[k].bse_kw[1], binary[k].bse_radius[0], binary[k].bse_radius[1], binary[k].bse_tb, binary[k].bse_lum[0], binary[k].bse_lum[1], binary[k].bse_massc[0], binary[k].bse_massc[1], binary[k].bse_radc[0], binary[k].bse_radc[1], binary[k].bse_menv[0], binary[k].bse_menv[1], binary[k].bse_renv[0], binary[k].bse_renv[1], binary[k].bse_tms[0], binary[k].bse_tms[1], binary[k].bse_bcm_dmdt[0], binary[k].bse_bcm_dmdt[1], binary[k].bse_bcm_radrol[0], binary[k].bse_bcm_radrol[1], binary[k].bse_ospin[0], binary[k].bse_ospin[1], binary[k].bse_bcm_B[0], binary[k].bse_bcm_B[1], binary[k].bse_bcm_formation[0], binary[k].bse_bcm_formation[1], binary[k].bse_bacc[0], binary[k].bse_bacc[1], binary[k].bse_tacc[0], binary[k].bse_tacc[1], binary[k].bse_mass0[0], binary[k].bse_mass0[1], binary[k].bse_epoch[0], binary[k].bse_epoch[1], binary[k].bse_bhspin[0], binary[k].bse_bhspin[1]);
-	}
-	parafprintf (escfile, "\n");
+	log_escaped_star(j, m, r, E, J, phi_rtidal, phi_zero);
 
 	/* perhaps this will fix the problem wherein stars are ejected (and counted)
 	   multiple times */
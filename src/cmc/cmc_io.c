@@ -15,10 +15,13 @@
 #include <gsl/gsl_rng.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <zlib.h>
 #include "cmc.h"
 #include "cmc_vars.h"
 #include "hdf5.h"
 #include "hdf5_hl.h"
+#include "cmc_snapshot.h"
+#include "cmc_checkpoint.h"
 
 
 /**
@@ -250,7 +253,7 @@ void PrintLogOutput(void)
 	pararootfprintf(logfile, "******************************************************************************\n");
 
 	//MPI: The log file is written both in parallel in PrintParaFileOutput before this where details of interactions between stars etc are printed out, as well as here by the root node where the summary of the timestep is printed out.
-    mpi_para_file_write(mpi_logfile_wrbuf, &mpi_logfile_len, &mpi_logfile_ofst_total, &mpi_logfile);
+    mpi_para_file_write(&mpi_logfile_wrbuf, &mpi_logfile_ofst_total, &mpi_logfile);
 
 }
 
@@ -685,76 +688,218 @@ void find_nstars_within_r(double r, long *ns, long *nb)
 	}
 }
 
+/**
+* @brief Adds a file to the list of files flushed together in PrintParaFileOutput
+*
+* @param file File to be written to, named as in parafprintf
+*/
+#define PARA_FILE_LIST(file) {                             \
+	wrbufs[nfiles] = &(mpi_ ## file ## _wrbuf);           \
+	ofsts[nfiles] = &(mpi_ ## file ## _ofst_total);       \
+	fhs[nfiles] = &(mpi_ ## file);                        \
+	nfiles++; }
+
 /**
 * @brief This is the function which actually writes the parallel file buffers into the file in parallel using MPI IO.
 */
 void PrintParaFileOutput(void)
 {
-	//This macro writes out the corresponding buffer into the corresponding file in parallel using MPI-IO. Here we write out all the files that need contribution from more than one processor.
-    mpi_para_file_write(mpi_logfile_wrbuf, &mpi_logfile_len, &mpi_logfile_ofst_total, &mpi_logfile);
-    mpi_para_file_write(mpi_escfile_wrbuf, &mpi_escfile_len, &mpi_escfile_ofst_total, &mpi_escfile);
-    mpi_para_file_write(mpi_binintfile_wrbuf, &mpi_binintfile_len, &mpi_binintfile_ofst_total, &mpi_binintfile);
-    mpi_para_file_write(mpi_collisionfile_wrbuf, &mpi_collisionfile_len, &mpi_collisionfile_ofst_total, &mpi_collisionfile);
-    mpi_para_file_write(mpi_tidalcapturefile_wrbuf, &mpi_tidalcapturefile_len, &mpi_tidalcapturefile_ofst_total, &mpi_tidalcapturefile);
-    mpi_para_file_write(mpi_semergedisruptfile_wrbuf, &mpi_semergedisruptfile_len, &mpi_semergedisruptfile_ofst_total, &mpi_semergedisruptfile);
-    mpi_para_file_write(mpi_removestarfile_wrbuf, &mpi_removestarfile_len, &mpi_removestarfile_ofst_total, &mpi_removestarfile);
-    mpi_para_file_write(mpi_relaxationfile_wrbuf, &mpi_relaxationfile_len, &mpi_relaxationfile_ofst_total, &mpi_relaxationfile);
-    mpi_para_file_write(mpi_triplefile_wrbuf, &mpi_triplefile_len, &mpi_triplefile_ofst_total, &mpi_triplefile);
+	parabuf_t *wrbufs[MPI_PARA_MAXFILES];
+	long long *ofsts[MPI_PARA_MAXFILES];
+	MPI_File *fhs[MPI_PARA_MAXFILES];
+	int nfiles=0;
+
+	//Here we write out all the files that need contribution from more than one processor. They are all flushed in one go, so the number of collectives per timestep does not grow with the number of files.
+	PARA_FILE_LIST(logfile);
+	PARA_FILE_LIST(escfile);
+	PARA_FILE_LIST(binintfile);
+	PARA_FILE_LIST(collisionfile);
+	PARA_FILE_LIST(tidalcapturefile);
+	PARA_FILE_LIST(semergedisruptfile);
+	PARA_FILE_LIST(removestarfile);
+	PARA_FILE_LIST(relaxationfile);
+	PARA_FILE_LIST(triplefile);
 
 	 if(WRITE_PULSAR_INFO)
-		 mpi_para_file_write(mpi_pulsarfile_wrbuf, &mpi_pulsarfile_len, &mpi_pulsarfile_ofst_total, &mpi_pulsarfile);
+		 PARA_FILE_LIST(pulsarfile);
 
 /* Shi */
     if (WRITE_MOREPULSAR_INFO)
-        mpi_para_file_write(mpi_morepulsarfile_wrbuf, &mpi_morepulsarfile_len, &mpi_morepulsarfile_ofst_total, &mpi_morepulsarfile);
+        PARA_FILE_LIST(morepulsarfile);
 
     /* Meagan's 3bb files */
     if (WRITE_BH_INFO){
-        mpi_para_file_write(mpi_newbhfile_wrbuf, &mpi_newbhfile_len, &mpi_newbhfile_ofst_total, &mpi_newbhfile);
-        mpi_para_file_write(mpi_bhmergerfile_wrbuf, &mpi_bhmergerfile_len, &mpi_bhmergerfile_ofst_total, &mpi_bhmergerfile);
+        PARA_FILE_LIST(newbhfile);
+        PARA_FILE_LIST(bhmergerfile);
     }
 
     if (THREEBODYBINARIES)
     {
-        mpi_para_file_write(mpi_threebbfile_wrbuf, &mpi_threebbfile_len, &mpi_threebbfile_ofst_total, &mpi_threebbfile);
-        mpi_para_file_write(mpi_threebbprobabilityfile_wrbuf, &mpi_threebbprobabilityfile_len, &mpi_threebbprobabilityfile_ofst_total, &mpi_threebbprobabilityfile);
-        mpi_para_file_write(mpi_lightcollisionfile_wrbuf, &mpi_lightcollisionfile_len, &mpi_lightcollisionfile_ofst_total, &mpi_lightcollisionfile);
-        mpi_para_file_write(mpi_threebbdebugfile_wrbuf, &mpi_threebbdebugfile_len, &mpi_threebbdebugfile_ofst_total, &mpi_threebbdebugfile);
+        PARA_FILE_LIST(threebbfile);
+        PARA_FILE_LIST(threebbprobabilityfile);
+        PARA_FILE_LIST(lightcollisionfile);
+        PARA_FILE_LIST(threebbdebugfile);
     }
+
+	mpi_para_files_write(nfiles, wrbufs, ofsts, fhs);
+}
+
+/**
+* @brief Makes sure the buffer has room for n more characters plus the terminating null, growing it geometrically
+*
+* @param b buffer
+* @param n number of characters about to be appended
+*/
+void parabuf_reserve(parabuf_t *b, long long n)
+{
+	long long size;
+	char *s;
+
+	if (b->len + n + 1 <= b->size) return;
+
+	size = MAX(b->size, PARABUF_MIN);
+	while (size < b->len + n + 1) size *= 2;
+
+	s = (char *) realloc(b->s, size);
+	if (s == NULL) {
+		eprintf("cannot grow output buffer to %lld bytes.\n", size);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+	b->s = s;
+	b->size = size;
+}
+
+/**
+* @brief Appends printf-formatted text to the buffer. The text is formatted directly into the tail of the buffer, which is grown and the formatting redone if it did not fit.
+*
+* @param b buffer
+* @param fmt format string, followed by the arguments for it
+*/
+void parabuf_printf(parabuf_t *b, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	parabuf_reserve(b, 0);
+	va_start(ap, fmt);
+	n = vsnprintf(b->s + b->len, b->size - b->len, fmt, ap);
+	va_end(ap);
+
+	if (n < 0) return;
+	if (b->len + n + 1 > b->size) {
+		parabuf_reserve(b, n);
+		va_start(ap, fmt);
+		vsnprintf(b->s + b->len, b->size - b->len, fmt, ap);
+		va_end(ap);
+	}
+	b->len += n;
+}
+
+/**
+* @brief Appends raw bytes to the buffer, for files written in binary
+*
+* @param b buffer
+* @param data bytes to append
+* @param n number of bytes
+*/
+void parabuf_append(parabuf_t *b, const void *data, long long n)
+{
+	parabuf_reserve(b, n);
+	memcpy(b->s + b->len, data, n);
+	b->len += n;
+	b->s[b->len] = '\0';
+}
+
+/**
+* @brief Cuts the buffer back to its first len characters, keeping the allocation
+*
+* @param b buffer
+* @param len new length
+*/
+void parabuf_truncate(parabuf_t *b, long long len)
+{
+	b->len = len;
+	if (b->s != NULL) b->s[len] = '\0';
+}
+
+/**
+* @brief Releases the memory of the buffer
+*
+* @param b buffer
+*/
+void parabuf_free(parabuf_t *b)
+{
+	free(b->s);
+	b->s = NULL;
+	b->len = b->size = 0;
 }
 
 /**
 * @brief Flushes out data in parallel present in the char buffer to the corresponding file using MPI-IO
 *
 * @param wrbuf write buffer containing the data to be flushed out
-* @param len length/size of the data in the buffer
 * @param prev_cum_offset offset of the file where the data needs to be written
 * @param fh MPI-IO File handle
 */
-void mpi_para_file_write(char* wrbuf, long long* len, long long* prev_cum_offset, MPI_File* fh)
+void mpi_para_file_write(parabuf_t *wrbuf, long long* prev_cum_offset, MPI_File* fh)
+{
+	mpi_para_files_write(1, &wrbuf, &prev_cum_offset, &fh);
+}
+
+/**
+* @brief Flushes out the buffers of several files at once using MPI-IO. A single Allgather of all the buffer lengths gives each processor its offset into every file as well as the file totals. Files nobody wrote to are skipped, and the writes for the others are issued together (non-blocking where the MPI library supports it) and completed at the end.
+*
+* @param n number of files
+* @param wrbuf write buffers containing the data to be flushed out
+* @param prev_cum_offset offsets of the files where the data needs to be written
+* @param fh MPI-IO File handles
+*/
+void mpi_para_files_write(int n, parabuf_t **wrbuf, long long **prev_cum_offset, MPI_File **fh)
 {
-    MPI_Offset mpi_offset=0;
-	 long long offset=0;
-	 long long tot_offset=0;
-    MPI_Status mpistat;
+	int i, j, nreq=0;
+	long long *len, *alllen, offset, total;
+	MPI_Request *req;
+
+	len = (long long *) malloc(n * sizeof(long long));
+	alllen = (long long *) malloc(procs * n * sizeof(long long));
+	req = (MPI_Request *) malloc(n * sizeof(MPI_Request));
+
+	for (i=0; i<n; i++) {
+		len[i] = wrbuf[i]->len;
+	}
+	MPI_Allgather(len, n, MPI_LONG_LONG, alllen, n, MPI_LONG_LONG, MPI_COMM_WORLD);
+
+	for (i=0; i<n; i++) {
+		//The offset for this processor is the previous cumulative file offset plus the lengths of the lower ranks
+		offset = *prev_cum_offset[i];
+		total = 0;
+		for (j=0; j<procs; j++) {
+			if (j < myid) offset += alllen[j*n+i];
+			total += alllen[j*n+i];
+		}
 
-	 //First find out the offset for this processor based on the buffer lengths of other procecessors
-    MPI_Exscan(len, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+		//Every processor sees the same total, so they all agree on skipping the collective
+		if (total == 0) continue;
 
-	 //Add this offset to the previous cumulative file offset
-    offset += *prev_cum_offset;
-	 mpi_offset = offset;
+#if MPI_VERSION > 3 || (MPI_VERSION == 3 && MPI_SUBVERSION >= 1)
+		MPI_File_iwrite_at_all(*fh[i], (MPI_Offset) offset, wrbuf[i]->s, len[i], MPI_CHAR, &req[nreq++]);
+#else
+		MPI_File_write_at_all(*fh[i], (MPI_Offset) offset, wrbuf[i]->s, len[i], MPI_CHAR, MPI_STATUS_IGNORE);
+#endif
 
-	 //Write data to file in parallel
-    MPI_File_write_at_all(*fh, mpi_offset, wrbuf, *len, MPI_CHAR, &mpistat);
+		//Update cumulative file offset for next flush
+		*prev_cum_offset[i] += total;
+	}
+	MPI_Waitall(nreq, req, MPI_STATUSES_IGNORE);
 
-	 //Update cumulative file offset for next flush
-    MPI_Allreduce (len, &tot_offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
-    *prev_cum_offset += tot_offset;
+	//Reset buffers, keeping their memory for the next timestep
+	for (i=0; i<n; i++) {
+		parabuf_truncate(wrbuf[i], 0);
+	}
 
-	 //Reset buffer and length variables
-    wrbuf[0] = '\0';
-    *len=0;
+	free(len);
+	free(alllen);
+	free(req);
 }
 
 //void write_logs(){
@@ -1035,6 +1180,24 @@ if(myid==0) {
 					exit(-1);
 				}
 				parsed.SNAPSHOT_WINDOW_UNITS = 1;
+			} else if (strcmp(parameter_name, "SNAPSHOT_WINDOW_FIELDS") == 0) {
+				PRINT_PARSED(PARAMDOC_SNAPSHOT_WINDOW_FIELDS);
+				if (strncmp(values, "NULL", 4) == 0) {
+				    SNAPSHOT_WINDOW_FIELDS=NULL;
+				} else {
+				    SNAPSHOT_WINDOW_FIELDS= (char *) malloc(sizeof(char)*1024);
+				    strncpy(SNAPSHOT_WINDOW_FIELDS, values, 1024);
+				}
+				parsed.SNAPSHOT_WINDOW_FIELDS = 1;
+			} else if (strcmp(parameter_name, "SNAPSHOT_WINDOW_SAMPLE") == 0) {
+				PRINT_PARSED(PARAMDOC_SNAPSHOT_WINDOW_SAMPLE);
+				if (strncmp(values, "NULL", 4) == 0) {
+				    SNAPSHOT_WINDOW_SAMPLE=NULL;
+				} else {
+				    SNAPSHOT_WINDOW_SAMPLE= (char *) malloc(sizeof(char)*300);
+				    strncpy(SNAPSHOT_WINDOW_SAMPLE, values, 300);
+				}
+				parsed.SNAPSHOT_WINDOW_SAMPLE = 1;
 			} else if (strcmp(parameter_name, "IDUM") == 0) {
 				PRINT_PARSED(PARAMDOC_IDUM);
 				sscanf(values, "%ld", &IDUM);
@@ -1561,6 +1724,10 @@ if(myid==0) {
 				PRINT_PARSED(PARAMDOC_BH_RADIUS_MULTIPLYER);
 				sscanf(values, "%lf", &BH_RADIUS_MULTIPLYER);
 				parsed.BH_RADIUS_MULTIPLYER = 1;
+			} else if (strcmp(parameter_name, "PETERS_FAST_PATH_TOL")== 0) {
+				PRINT_PARSED(PARAMDOC_PETERS_FAST_PATH_TOL);
+				sscanf(values, "%lf", &PETERS_FAST_PATH_TOL);
+				parsed.PETERS_FAST_PATH_TOL = 1;
 			} else if (strcmp(parameter_name, "BCONST")== 0) {
 				PRINT_PARSED(PARAMDOC_BSE_BCONST);
 				sscanf(values, "%lf", &BSE_BCONST);
@@ -1581,6 +1748,133 @@ if(myid==0) {
 				PRINT_PARSED(PARAMDOC_TIMER);
 				sscanf(values, "%d", &TIMER);
 				parsed.TIMER = 1;
+			} else if (strcmp(parameter_name, "SE_TRACK_CACHE")== 0) {
+				PRINT_PARSED(PARAMDOC_SE_TRACK_CACHE);
+				sscanf(values, "%d", &SE_TRACK_CACHE);
+				parsed.SE_TRACK_CACHE = 1;
+			} else if (strcmp(parameter_name, "SE_TRACK_CACHE_NMASS")== 0) {
+				PRINT_PARSED(PARAMDOC_SE_TRACK_CACHE_NMASS);
+				sscanf(values, "%d", &SE_TRACK_CACHE_NMASS);
+				parsed.SE_TRACK_CACHE_NMASS = 1;
+			} else if (strcmp(parameter_name, "SE_TRACK_CACHE_NTIME")== 0) {
+				PRINT_PARSED(PARAMDOC_SE_TRACK_CACHE_NTIME);
+				sscanf(values, "%d", &SE_TRACK_CACHE_NTIME);
+				parsed.SE_TRACK_CACHE_NTIME = 1;
+			} else if (strcmp(parameter_name, "SE_TRACK_CACHE_FILE")== 0) {
+				PRINT_PARSED(PARAMDOC_SE_TRACK_CACHE_FILE);
+				if (strncmp(values, "NULL", 4) == 0) {
+					SE_TRACK_CACHE_FILE = NULL;
+				} else{
+					SE_TRACK_CACHE_FILE = (char *) malloc(sizeof(char)*500);
+					strncpy(SE_TRACK_CACHE_FILE, values, 500);
+				}
+				parsed.SE_TRACK_CACHE_FILE = 1;
+			} else if (strcmp(parameter_name, "SE_OVERLAP")== 0) {
+				PRINT_PARSED(PARAMDOC_SE_OVERLAP);
+				sscanf(values, "%d", &SE_OVERLAP);
+				parsed.SE_OVERLAP = 1;
+			} else if (strcmp(parameter_name, "SE_COST_PROFILE")== 0) {
+				PRINT_PARSED(PARAMDOC_SE_COST_PROFILE);
+				sscanf(values, "%d", &SE_COST_PROFILE);
+				parsed.SE_COST_PROFILE = 1;
+			} else if (strcmp(parameter_name, "SE_BALANCE")== 0) {
+				PRINT_PARSED(PARAMDOC_SE_BALANCE);
+				sscanf(values, "%d", &SE_BALANCE);
+				parsed.SE_BALANCE = 1;
+			} else if (strcmp(parameter_name, "BININT_INTEGRATOR")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_INTEGRATOR);
+				sscanf(values, "%d", &BININT_INTEGRATOR);
+				parsed.BININT_INTEGRATOR = 1;
+			} else if (strcmp(parameter_name, "BININT_THREADS")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_THREADS);
+				sscanf(values, "%d", &BININT_THREADS);
+				parsed.BININT_THREADS = 1;
+			} else if (strcmp(parameter_name, "BININT_BALANCE")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_BALANCE);
+				sscanf(values, "%d", &BININT_BALANCE);
+				parsed.BININT_BALANCE = 1;
+			} else if (strcmp(parameter_name, "BININT_FLYBY")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_FLYBY);
+				sscanf(values, "%lf", &BININT_FLYBY);
+				parsed.BININT_FLYBY = 1;
+			} else if (strcmp(parameter_name, "BININT_FLYBY_VALIDATE")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_FLYBY_VALIDATE);
+				sscanf(values, "%d", &BININT_FLYBY_VALIDATE);
+				parsed.BININT_FLYBY_VALIDATE = 1;
+			} else if (strcmp(parameter_name, "BININT_MAX_STEPS")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_MAX_STEPS);
+				sscanf(values, "%ld", &BININT_MAX_STEPS);
+				parsed.BININT_MAX_STEPS = 1;
+			} else if (strcmp(parameter_name, "BININT_ESCALATE")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_ESCALATE);
+				sscanf(values, "%d", &BININT_ESCALATE);
+				parsed.BININT_ESCALATE = 1;
+			} else if (strcmp(parameter_name, "BININT_DUMP")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_DUMP);
+				sscanf(values, "%d", &BININT_DUMP);
+				parsed.BININT_DUMP = 1;
+			} else if (strcmp(parameter_name, "BININT_PN_RPERI")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_PN_RPERI);
+				sscanf(values, "%lf", &BININT_PN_RPERI);
+				parsed.BININT_PN_RPERI = 1;
+			} else if (strcmp(parameter_name, "BININT_WEAK_E")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_WEAK_E);
+				sscanf(values, "%lf", &BININT_WEAK_E);
+				parsed.BININT_WEAK_E = 1;
+			} else if (strcmp(parameter_name, "BININT_WEAK_ACC")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_WEAK_ACC);
+				sscanf(values, "%lf", &BININT_WEAK_ACC);
+				parsed.BININT_WEAK_ACC = 1;
+			} else if (strcmp(parameter_name, "BININT_POLICY_VALIDATE")== 0) {
+				PRINT_PARSED(PARAMDOC_BININT_POLICY_VALIDATE);
+				sscanf(values, "%d", &BININT_POLICY_VALIDATE);
+				parsed.BININT_POLICY_VALIDATE = 1;
+			} else if (strcmp(parameter_name, "BINARY_LOGS")== 0) {
+				PRINT_PARSED(PARAMDOC_BINARY_LOGS);
+				sscanf(values, "%d", &BINARY_LOGS);
+				parsed.BINARY_LOGS = 1;
+			} else if (strcmp(parameter_name, "SNAPSHOT_IO_MODE")== 0) {
+				PRINT_PARSED(PARAMDOC_SNAPSHOT_IO_MODE);
+				sscanf(values, "%d", &SNAPSHOT_IO_MODE);
+				if (SNAPSHOT_IO_MODE < 0 || SNAPSHOT_IO_MODE > 2) {
+					eprintf("SNAPSHOT_IO_MODE must be 0, 1 or 2, not %d.\n", SNAPSHOT_IO_MODE);
+					exit(1);
+				}
+#ifndef H5_HAVE_PARALLEL
+				if (SNAPSHOT_IO_MODE == 2) {
+					wprintf("HDF5 was built without MPI support; using SNAPSHOT_IO_MODE=1, the root node gathering the snapshots, instead of 2.\n");
+					SNAPSHOT_IO_MODE = 1;
+				}
+#endif
+				parsed.SNAPSHOT_IO_MODE = 1;
+			} else if (strcmp(parameter_name, "SNAPSHOT_CHUNK")== 0) {
+				PRINT_PARSED(PARAMDOC_SNAPSHOT_CHUNK);
+				sscanf(values, "%ld", &SNAPSHOT_CHUNK);
+				parsed.SNAPSHOT_CHUNK = 1;
+			} else if (strcmp(parameter_name, "SNAPSHOT_COMPRESS")== 0) {
+				PRINT_PARSED(PARAMDOC_SNAPSHOT_COMPRESS);
+				sscanf(values, "%d", &SNAPSHOT_COMPRESS);
+				parsed.SNAPSHOT_COMPRESS = 1;
+			} else if (strcmp(parameter_name, "SNAPSHOT_COMPRESS_LEVEL")== 0) {
+				PRINT_PARSED(PARAMDOC_SNAPSHOT_COMPRESS_LEVEL);
+				sscanf(values, "%d", &SNAPSHOT_COMPRESS_LEVEL);
+				parsed.SNAPSHOT_COMPRESS_LEVEL = 1;
+			} else if (strcmp(parameter_name, "ASYNC_IO")== 0) {
+				PRINT_PARSED(PARAMDOC_ASYNC_IO);
+				sscanf(values, "%d", &ASYNC_IO);
+				parsed.ASYNC_IO = 1;
+			} else if (strcmp(parameter_name, "RESTART_FORMAT")== 0) {
+				PRINT_PARSED(PARAMDOC_RESTART_FORMAT);
+				sscanf(values, "%d", &RESTART_FORMAT);
+				parsed.RESTART_FORMAT = 1;
+			} else if (strcmp(parameter_name, "CHECKPOINT_FULL_INTERVAL")== 0) {
+				PRINT_PARSED(PARAMDOC_CHECKPOINT_FULL_INTERVAL);
+				sscanf(values, "%d", &CHECKPOINT_FULL_INTERVAL);
+				parsed.CHECKPOINT_FULL_INTERVAL = 1;
+			} else if (strcmp(parameter_name, "CHECKPOINT_COMPRESS")== 0) {
+				PRINT_PARSED(PARAMDOC_CHECKPOINT_COMPRESS);
+				sscanf(values, "%d", &CHECKPOINT_COMPRESS);
+				parsed.CHECKPOINT_COMPRESS = 1;
 			} else {
 				wprintf("unknown parameter: \"%s\".\n", line);
 			}
@@ -1690,6 +1984,8 @@ if(myid==0) {
 	CHECK_PARSED(SNAPSHOT_CORE_COLLAPSE, 0, PARAMDOC_SNAPSHOT_CORE_COLLAPSE);
 	CHECK_PARSED(SNAPSHOT_WINDOWS, NULL, PARAMDOC_SNAPSHOT_WINDOWS);
 	CHECK_PARSED(SNAPSHOT_WINDOW_UNITS, "Trel", PARAMDOC_SNAPSHOT_WINDOW_UNITS);
+	CHECK_PARSED(SNAPSHOT_WINDOW_FIELDS, NULL, PARAMDOC_SNAPSHOT_WINDOW_FIELDS);
+	CHECK_PARSED(SNAPSHOT_WINDOW_SAMPLE, NULL, PARAMDOC_SNAPSHOT_WINDOW_SAMPLE);
 
 	CHECK_PARSED(NUM_CENTRAL_STARS, 300, PARAMDOC_NUM_CENTRAL_STARS);
 	CHECK_PARSED(IDUM, 0, PARAMDOC_IDUM);
@@ -1962,8 +2258,37 @@ if(myid==0) {
 
 
 	CHECK_PARSED(BH_RADIUS_MULTIPLYER, 5, PARAMDOC_BH_RADIUS_MULTIPLYER);
+	CHECK_PARSED(PETERS_FAST_PATH_TOL, 0.01, PARAMDOC_PETERS_FAST_PATH_TOL);
 	CHECK_PARSED(BSE_IDUM, -999, PARAMDOC_BSE_IDUM);
 	CHECK_PARSED(TIMER, 0, PARAMDOC_TIMER);
+	CHECK_PARSED(SE_TRACK_CACHE, 0, PARAMDOC_SE_TRACK_CACHE);
+	CHECK_PARSED(SE_TRACK_CACHE_NMASS, 400, PARAMDOC_SE_TRACK_CACHE_NMASS);
+	CHECK_PARSED(SE_TRACK_CACHE_NTIME, 2000, PARAMDOC_SE_TRACK_CACHE_NTIME);
+	CHECK_PARSED(SE_TRACK_CACHE_FILE, NULL, PARAMDOC_SE_TRACK_CACHE_FILE);
+	CHECK_PARSED(SE_OVERLAP, 0, PARAMDOC_SE_OVERLAP);
+	CHECK_PARSED(SE_COST_PROFILE, 0, PARAMDOC_SE_COST_PROFILE);
+	CHECK_PARSED(SE_BALANCE, 0, PARAMDOC_SE_BALANCE);
+	CHECK_PARSED(BININT_INTEGRATOR, 0, PARAMDOC_BININT_INTEGRATOR);
+	CHECK_PARSED(BININT_THREADS, 0, PARAMDOC_BININT_THREADS);
+	CHECK_PARSED(BININT_BALANCE, 0, PARAMDOC_BININT_BALANCE);
+	CHECK_PARSED(BININT_FLYBY, 0, PARAMDOC_BININT_FLYBY);
+	CHECK_PARSED(BININT_FLYBY_VALIDATE, 0, PARAMDOC_BININT_FLYBY_VALIDATE);
+	CHECK_PARSED(BININT_MAX_STEPS, 0, PARAMDOC_BININT_MAX_STEPS);
+	CHECK_PARSED(BININT_ESCALATE, 0, PARAMDOC_BININT_ESCALATE);
+	CHECK_PARSED(BININT_DUMP, 0, PARAMDOC_BININT_DUMP);
+	CHECK_PARSED(BININT_PN_RPERI, 0, PARAMDOC_BININT_PN_RPERI);
+	CHECK_PARSED(BININT_WEAK_E, 0, PARAMDOC_BININT_WEAK_E);
+	CHECK_PARSED(BININT_WEAK_ACC, 1e-7, PARAMDOC_BININT_WEAK_ACC);
+	CHECK_PARSED(BININT_POLICY_VALIDATE, 0, PARAMDOC_BININT_POLICY_VALIDATE);
+	CHECK_PARSED(BINARY_LOGS, 0, PARAMDOC_BINARY_LOGS);
+	CHECK_PARSED(SNAPSHOT_IO_MODE, 1, PARAMDOC_SNAPSHOT_IO_MODE);
+	CHECK_PARSED(SNAPSHOT_CHUNK, 2048, PARAMDOC_SNAPSHOT_CHUNK);
+	CHECK_PARSED(SNAPSHOT_COMPRESS, 1, PARAMDOC_SNAPSHOT_COMPRESS);
+	CHECK_PARSED(SNAPSHOT_COMPRESS_LEVEL, 6, PARAMDOC_SNAPSHOT_COMPRESS_LEVEL);
+	CHECK_PARSED(ASYNC_IO, 0, PARAMDOC_ASYNC_IO);
+	CHECK_PARSED(RESTART_FORMAT, 0, PARAMDOC_RESTART_FORMAT);
+	CHECK_PARSED(CHECKPOINT_FULL_INTERVAL, 0, PARAMDOC_CHECKPOINT_FULL_INTERVAL);
+	CHECK_PARSED(CHECKPOINT_COMPRESS, 0, PARAMDOC_CHECKPOINT_COMPRESS);
 #undef CHECK_PARSED
 
 	/* exit if something is not set */
@@ -2114,7 +2439,7 @@ if(myid==0)
 		sscanf("a", "%s", outfilemode);
 	
 /*
-MPI: In the parallel version, IO is done in the following way. Some files require data only from the root node, and others need data from all nodes. The former are opened and written to only by the root node using C IO APIs. However, for the latter, the files are opened by all processors using MPI-IO. At places when the files are suposed to be written to in the serial version, in the parallel version, each processor writes the data into a string/char buffer. At the end of the timestep, all processors flush the data from the buffers into the corresponding files in parallel using MPI-IO. The code uses 5 variables for this process - the MPI-IO file pointer, which follows the format mpi_<serial fptr name>, 2 char buffers, which hav the format mpi_<serial fptr name>_buf and mpi_<ser fptr name>_wrbuf, and an int/longlong variables to maintain the length of the buffer (format mpi_<ser fptr name>_len) and the offset in the file (format mpi_<ser fptr name>_ofst_total) where data has to be written.
+MPI: In the parallel version, IO is done in the following way. Some files require data only from the root node, and others need data from all nodes. The former are opened and written to only by the root node using C IO APIs. However, for the latter, the files are opened by all processors using MPI-IO. At places when the files are suposed to be written to in the serial version, in the parallel version, each processor writes the data into a string/char buffer. At the end of the timestep, all processors flush the data from the buffers into the corresponding files in parallel using MPI-IO. The code uses 3 variables for this process - the MPI-IO file pointer, which follows the format mpi_<serial fptr name>, a growable append buffer of type parabuf_t which keeps its own length (format mpi_<ser fptr name>_wrbuf), and a longlong variable to maintain the offset in the file (format mpi_<ser fptr name>_ofst_total) where data has to be written.
 */
 
     //MPI-IO: Following are files that require data only from the root node, and are opened only by the root node using standard C IO APIs.
@@ -2335,12 +2660,12 @@ MPI: In the parallel version, IO is done in the following way. Some files requir
         if(RESTART_TCOUNT <= 0)
                 MPI_File_set_size(mpi_triplefile, 0);
 
-    sprintf(outfile, "%s.esc.dat", outprefix);
+    sprintf(outfile, BINARY_LOGS ? "%s.esc.bin" : "%s.esc.dat", outprefix);
     MPI_File_open(MPI_COMM_WORLD, outfile, MPI_MODE_RESTART, MPI_INFO_NULL, &mpi_escfile);
 	if(RESTART_TCOUNT <= 0)
 		MPI_File_set_size(mpi_escfile, 0);
 
-    sprintf(outfile, "%s.collision.log", outprefix);
+    sprintf(outfile, BINARY_LOGS ? "%s.collision.bin" : "%s.collision.log", outprefix);
     MPI_File_open(MPI_COMM_WORLD, outfile, MPI_MODE_RESTART, MPI_INFO_NULL, &mpi_collisionfile);
 	if(RESTART_TCOUNT <= 0)
 		MPI_File_set_size(mpi_collisionfile, 0);
@@ -2350,7 +2675,7 @@ MPI: In the parallel version, IO is done in the following way. Some files requir
 	if(RESTART_TCOUNT <= 0)
 		MPI_File_set_size(mpi_tidalcapturefile, 0);
 
-    sprintf(outfile, "%s.semergedisrupt.log", outprefix);
+    sprintf(outfile, BINARY_LOGS ? "%s.semergedisrupt.bin" : "%s.semergedisrupt.log", outprefix);
     MPI_File_open(MPI_COMM_WORLD, outfile, MPI_MODE_RESTART, MPI_INFO_NULL, &mpi_semergedisruptfile);
 	if(RESTART_TCOUNT <= 0)
 		MPI_File_set_size(mpi_semergedisruptfile, 0);
@@ -2395,7 +2720,7 @@ MPI: In the parallel version, IO is done in the following way. Some files requir
 		if(RESTART_TCOUNT <= 0)
 			MPI_File_set_size(mpi_newbhfile, 0);
 
-        sprintf(outfile, "%s.bhmerger.dat", outprefix);
+        sprintf(outfile, BINARY_LOGS ? "%s.bhmerger.bin" : "%s.bhmerger.dat", outprefix);
         MPI_File_open(MPI_COMM_WORLD, outfile, MPI_MODE_RESTART, MPI_INFO_NULL, &mpi_bhmergerfile);
 		if(RESTART_TCOUNT <= 0)
 			MPI_File_set_size(mpi_bhmergerfile, 0);
@@ -2410,6 +2735,15 @@ MPI: In the parallel version, IO is done in the following way. Some files requir
 			MPI_File_set_size(mpi_pulsarfile, 0);
 	}
 
+    /* fewbody inputs of the binary interactions, one file per processor */
+    if (BININT_DUMP) {
+        sprintf(outfile, "%s.binint.%d.fb.gz", outprefix, myid);
+        if ((binintdumpfile = fb_open_scatterings(outfile, (RESTART_TCOUNT <= 0) ? "w" : "a")) == NULL) {
+            eprintf("cannot create output file \"%s\".\n", outfile);
+            exit(1);
+        }
+    }
+
     /* Shi */
     if (WRITE_MOREPULSAR_INFO){
         sprintf(outfile, "%s.morepulsars.dat", outprefix);
@@ -2422,15 +2756,29 @@ MPI: In the parallel version, IO is done in the following way. Some files requir
 	//MPI: Headers are written out only by the root node.
    // print header
     if(RESTART_TCOUNT <= 0){
-		pararootfprintf(escfile, "#1:tcount #2:t #3:m[MSUN] #4:r #5:vr #6:vt #7:r_peri #8:r_apo #9:Rtidal #10:phi_rtidal #11:phi_zero #12:E #13:J #14:id #15:binflag #16:m0[MSUN] #17:m1[MSUN] #18:id0 #19:id1 #20:a #21:e #22:startype #23:bin_startype0 #24:bin_startype1 #25:rad0 #26:rad1 #27:tb #28:lum0 #29:lum1 #30:massc0 #31:massc1 #32:radc0 #33:radc1 #34:menv0 #35:menv1 #36:renv0 #37:renv1 #38:tms0 #39:tms1 #40:dmdt0 #41:dmdt1 #42:radrol0 #43:radrol1 #44:ospin0 #45:ospin1 #46:B0 #47:B1 #48:formation0 #49:formation1 #50:bacc0 #51:bacc1 #52:tacc0 $53:tacc1 #54:mass0_0 #55:mass0_1 #56:epoch0 #57:epoch1 #58:bhspin #59:bhspin1 #60:bhspin2 #61:ospin #62:B #63:formation\n");
+		if (BINARY_LOGS) {
+			evlog_header_t head;
+			if (myid==0) {
+				evlog_header_init(&head, EVLOG_ESC, sizeof(evlog_esc_t));
+				parabuf_append(&mpi_escfile_wrbuf, &head, sizeof(head));
+				evlog_header_init(&head, EVLOG_COLL, sizeof(evlog_coll_t));
+				parabuf_append(&mpi_collisionfile_wrbuf, &head, sizeof(head));
+				evlog_header_init(&head, EVLOG_SEMERGE, sizeof(evlog_semerge_t));
+				parabuf_append(&mpi_semergedisruptfile_wrbuf, &head, sizeof(head));
+				if (WRITE_BH_INFO) {
+					evlog_header_init(&head, EVLOG_BHMERGER, sizeof(evlog_bhmerger_t));
+					parabuf_append(&mpi_bhmergerfile_wrbuf, &head, sizeof(head));
+				}
+			}
+		} else {
+			pararootfprintf(escfile, "%s", evlog_esc_header);
+			pararootfprintf(collisionfile, "%s", evlog_coll_header);
+			pararootfprintf(semergedisruptfile, "%s", evlog_semerge_header);
+		}
 	   // print header
 		pararootfprintf(triplefile, "#1:time #2:min0 #3:min1 #4:mout #5:Rin0 #6:Rin1 #7:Rout #8:ain #9:aout #10:ein #11:eout #12:ktypein0 #13:ktypein1 #14:ktypeout #15:Tlk_quad #16:Tlk_oct#17:eps_oct #18:T_GR #19:eps_GR\n");
-	   // print header
-		pararootfprintf(collisionfile, "# time interaction_type id_merger(mass_merger) id1(m1):id2(m2):id3(m3):... (r) type_merger type1 ...\n");
 	   // print header
 		pararootfprintf(tidalcapturefile, "# time interaction_type (id1,m1,k1)+(id2,m2,k2)+(r1,r2,r_peri)+vinf[km/s]+rcm[pc]+(mc0,mc1,rc0,rc1)->[(id1,m1,k1)-a[AU],e-(id2,m2,k2)]+(r1,r2)\n");
-	   // print header
-		pararootfprintf(semergedisruptfile, "# time interaction_type id_rem(mass_rem) id1(m1):id2(m2) (r)\n");
 	   //Sourav:  print header
 		pararootfprintf(removestarfile, "#single destroyed: time star_id star_mass(MSun) star_age(Gyr) star_birth(Gyr) star_lifetime(Gyr)\n");
 		pararootfprintf(removestarfile, "#binary destroyed: time obj_id bin_id removed_comp_id left_comp_id m1(MSun) m2(MSun) removed_m(MSun) left_m(MSun) left_m_sing(MSun) star_age(Gyr) star_birth(Gyr) star_lifetime(Gyr)\n");
@@ -2454,8 +2802,8 @@ MPI: In the parallel version, IO is done in the following way. Some files requir
 		// print header
 		if (WRITE_BH_INFO)
 			pararootfprintf(newbhfile,"#1:time #2:r #3.binary? #4:ID #5:zams_m #6:m_progenitor #7:bh mass #8:bh_spin #9:birth-kick(km/s) #10-25:vsarray\n");
-			pararootfprintf(bhmergerfile,"#1:time #2:type #3.r #4:id1 #5:id2 #6:m1[MSUN] #7:m2[MSUN] #8:spin1 #9:spin2 #10:m_final[MSUN] #11:spin_final #12:vkick[km/s] #13:v_esc[km/s] #14:a_final[AU] #15:e_final #16:a_50M[AU] #17:e_50 #18:a_100M[AU] #19:e_100M #20:a_500M[AU] #21:e_500M\n");
-			pararootfprintf(bhmergerfile,"#NOTE: if repeated mergers occur in fewbody (binary-single or binary-binary), the initial masses will be wrong; check collision.log\n");
+			if (!BINARY_LOGS)
+				pararootfprintf(bhmergerfile, "%s", evlog_bhmerger_header);
 	//"#1:tcount  #2:TotalTime  #3:bh  #4:bh_single  #5:bh_binary  #6:bh-bh  #7:bh-ns  #8:bh-wd  #9:bh-star  #10:bh-nonbh  #11:fb_bh  #12:bh_tot  #13:bh_single_tot  #14:bh_binary_tot  #15:bh-bh_tot  #16:bh-ns_tot  #17:bh-wd_tot  #18:bh-star_tot  #19:bh-nonbh_tot  #20:fb_bh_tot\n");
 
 		/* print header */
@@ -2566,6 +2914,8 @@ void mpi_close_node_buffers(void)
 	MPI_File_close(&mpi_relaxationfile);
 	/*Sourav: closing the file I opened*/
 	MPI_File_close(&mpi_removestarfile);
+	if (BININT_DUMP)
+		gzclose(binintdumpfile);
     /* Meagan: close 3bb log file */
     if (THREEBODYBINARIES)
     {
@@ -2617,8 +2967,8 @@ void print_initial_binaries(void)
 
 	 //MPI: Open corresponding MPI files, and declare buffers reqd for parallel write.
     MPI_File mpi_initbinfile;
-    char mpi_initbinfile_buf[10000], mpi_initbinfile_wrbuf[10000000];
-    long long mpi_initbinfile_len=0, mpi_initbinfile_ofst_total=0;
+    parabuf_t mpi_initbinfile_wrbuf = {NULL, 0, 0};
+    long long mpi_initbinfile_ofst_total=0;
     MPI_File_open(MPI_COMM_WORLD, outfile, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &mpi_initbinfile);
     MPI_File_set_size(mpi_initbinfile, 0);
 
@@ -2639,8 +2989,9 @@ void print_initial_binaries(void)
 	}
 
 	 //MPI: Write in parallel
-    mpi_para_file_write(mpi_initbinfile_wrbuf, &mpi_initbinfile_len, &mpi_initbinfile_ofst_total, &mpi_initbinfile);
+    mpi_para_file_write(&mpi_initbinfile_wrbuf, &mpi_initbinfile_ofst_total, &mpi_initbinfile);
     MPI_File_close(&mpi_initbinfile);
+    parabuf_free(&mpi_initbinfile_wrbuf);
 }
 
 /**
@@ -2751,6 +3102,76 @@ char *sprint_bin_dyn(long k, char string[MAX_STRING_LENGTH])
 	return(string);
 }
 
+/* subsampling of a snapshot (SNAPSHOT_WINDOW_SAMPLE) */
+#define SNAPSHOT_SAMPLE_ALL 0
+#define SNAPSHOT_SAMPLE_RANDOM 1
+#define SNAPSHOT_SAMPLE_RADIAL 2
+
+/**
+* @brief which stars of a snapshot are written
+*/
+typedef struct{
+/**
+* @brief one of SNAPSHOT_SAMPLE_*
+*/
+	int mode;
+/**
+* @brief fraction of the stars kept for SNAPSHOT_SAMPLE_RANDOM, stride in radial order for SNAPSHOT_SAMPLE_RADIAL
+*/
+	double value;
+} snapshot_sample_t;
+
+/* columns (NULL for all of them) and subsampling of each snapshot window */
+static snapshot_fields_t **snapshot_window_fields = NULL;
+static snapshot_sample_t *snapshot_window_samples = NULL;
+
+static void write_snapshot_table(char *filename, int bh_only, char *tablename, snapshot_fields_t *fields, snapshot_sample_t *sample);
+
+/**
+* @brief Sets up the columns and subsampling of each snapshot window from
+* SNAPSHOT_WINDOW_FIELDS and SNAPSHOT_WINDOW_SAMPLE.  Windows not listed get
+* all columns and all stars.
+*/
+static void parse_snapshot_window_options(void) {
+  char buf[1024], *cur, *save=NULL;
+  int j;
+
+  snapshot_window_fields = (snapshot_fields_t **) calloc(snapshot_window_count, sizeof(snapshot_fields_t *));
+  snapshot_window_samples = (snapshot_sample_t *) calloc(snapshot_window_count, sizeof(snapshot_sample_t));
+
+  if (SNAPSHOT_WINDOW_FIELDS != NULL) {
+    snprintf(buf, sizeof(buf), "%s", SNAPSHOT_WINDOW_FIELDS);
+    for (j=0, cur=strtok_r(buf, ";", &save); cur!=NULL && j<snapshot_window_count; j++, cur=strtok_r(NULL, ";", &save)) {
+      if (strcmp(cur, "all") == 0) continue;
+      snapshot_window_fields[j] = (snapshot_fields_t *) malloc(sizeof(snapshot_fields_t));
+      if (snapshot_fields_parse(cur, snapshot_window_fields[j]) != 0) {
+        eprintf("Unrecognized snapshot column list \"%s\" for time window %i.\n", cur, j+1);
+        free_arrays();
+        exit(-1);
+      }
+    }
+  }
+
+  if (SNAPSHOT_WINDOW_SAMPLE != NULL) {
+    snprintf(buf, sizeof(buf), "%s", SNAPSHOT_WINDOW_SAMPLE);
+    for (j=0, cur=strtok_r(buf, ";", &save); cur!=NULL && j<snapshot_window_count; j++, cur=strtok_r(NULL, ";", &save)) {
+      if (strcmp(cur, "all") == 0) continue;
+      if (sscanf(cur, "random:%lf", &snapshot_window_samples[j].value) == 1 &&
+          snapshot_window_samples[j].value > 0.0 && snapshot_window_samples[j].value <= 1.0) {
+        snapshot_window_samples[j].mode = SNAPSHOT_SAMPLE_RANDOM;
+      } else if (sscanf(cur, "radial:%lf", &snapshot_window_samples[j].value) == 1 &&
+          snapshot_window_samples[j].value >= 1.0) {
+        snapshot_window_samples[j].mode = SNAPSHOT_SAMPLE_RADIAL;
+        snapshot_window_samples[j].value = floor(snapshot_window_samples[j].value);
+      } else {
+        eprintf("Unrecognized snapshot subsampling \"%s\" for time window %i.\n", cur, j+1);
+        free_arrays();
+        exit(-1);
+      }
+    }
+  }
+}
+
 /**
 * @brief ?
 *
@@ -2793,6 +3214,7 @@ void parse_snapshot_windows(char *param_string) {
     dprintf("start %g, step %g, stop %g\n", snapshot_windows[3*j], snapshot_windows[3*j+1], snapshot_windows[3*j+2]);
   }
   snapshot_window_counters= (int *) calloc(snapshot_window_count, sizeof(int));
+  parse_snapshot_window_options();
 }
 
 /**
@@ -2826,7 +3248,7 @@ void print_snapshot_windows(void) {
       char tablename[500];
       sprintf(outfile, "%s.window.snapshots.h5", outprefix);
       sprintf(tablename, "%d(t=%.8g%s)",step_counter,total_time,SNAPSHOT_WINDOW_UNITS);
-      write_snapshot(outfile, 0, tablename);
+      write_snapshot_table(outfile, 0, tablename, snapshot_window_fields[i], &snapshot_window_samples[i]);
 //		print_denprof_snapshot(outfile);
 
       snapshot_window_counters[i]++;
@@ -2857,391 +3279,423 @@ int valid_snapshot_window_units(void) {
 }
 
 /**
-* @brief writes out snapshot to the given file
+* @brief Decides whether a star goes into a subsampled snapshot.  Random
+* subsampling hashes the star id rather than drawing from the random stream,
+* so the run is unchanged by it, the result does not depend on the number of
+* processors, and the same stars are kept in every snapshot of a window.
+*
+* @param i local index of the star
+* @param sample subsampling, NULL for all stars
+*
+* @return 1 if the star is written, 0 otherwise
+*/
+static int snapshot_sampled(long i, snapshot_sample_t *sample)
+{
+	unsigned long long h;
+
+	if (sample == NULL || sample->mode == SNAPSHOT_SAMPLE_ALL) {
+		return(1);
+	} else if (sample->mode == SNAPSHOT_SAMPLE_RANDOM) {
+		/* splitmix64 finalizer */
+		h = (unsigned long long) star[i].id + 0x9e3779b97f4a7c15ULL;
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+		h = h ^ (h >> 31);
+		return((h >> 11) * (1.0 / 9007199254740992.0) < sample->value);
+	}
+	return((get_global_idx(i) - 1) % (long) sample->value == 0);
+}
+
+/**
+* @brief Fills in the snapshot records of the stars on this processor
+*
+* @param objs_out set to a newly allocated array of records, to be freed by the caller
+* @param bh_only if bh_only>0 only the BHs are included
+* @param fields columns that will be written, NULL for all of them; the others may be left unset
+* @param sample subsampling, NULL for all stars
+*
+* @return number of records
+*/
+static long snapshot_fill(Snapshot **objs_out, int bh_only, snapshot_fields_t *fields, snapshot_sample_t *sample)
+{
+	long i, j, k=0, NRECORDS=0;
+	double m, r, phi;
+	Snapshot *objs;
+	/* eta needs the average mass squared around each binary, which is not cheap */
+	int want_eta = snapshot_fields_has(fields, SNAPSHOT_FIELD_eta);
+
+	for (i=1; i<=clus.N_MAX_NEW; i++){
+		j=star[i].binind;
+		if( ((bh_only==0) || star[i].se_k==14 || binary[j].bse_kw[0]==14 || binary[j].bse_kw[1]==14) && snapshot_sampled(i, sample) )
+			NRECORDS++;
+	}
+
+	objs = (Snapshot *) malloc(MAX(NRECORDS, 1) * sizeof(Snapshot));
+	if (objs == NULL) {
+		eprintf("cannot allocate %ld snapshot records.\n", NRECORDS);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+        for (i=1; i<=clus.N_MAX_NEW; i++) {
+                long g_i = get_global_idx(i);
+                m = star_m[g_i];
+                r = star_r[g_i];
+                phi = star_phi[g_i];
+		j=star[i].binind;
+		//if bh_only>0, print only BHs
+		if( ((bh_only==0) || ( (bh_only!=0) && (star[i].se_k==14 || binary[j].bse_kw[0]==14 || binary[j].bse_kw[1]==14) )) && snapshot_sampled(i, sample) )
+		{
+                        objs[k].id = star[i].id;
+                        objs[k].m = m * (units.m / clus.N_STAR) / MSUN;
+                        objs[k].r = r;
+                        objs[k].vr = star[i].vr;
+                        objs[k].vt = star[i].vt;
+                        objs[k].E = star[i].E;
+                        objs[k].J = star[i].J;
+			if (j) {
+                                objs[k].binflag = 1;
+                                objs[k].m0 = binary[j].m1 * (units.m / clus.N_STAR) / MSUN;
+                                objs[k].m1 = binary[j].m2 * (units.m / clus.N_STAR) / MSUN;
+                                objs[k].id0 = binary[j].id1;
+                                objs[k].id1 = binary[j].id2;
+                                objs[k].a = binary[j].a * units.l / AU;
+                                objs[k].e = binary[j].e;
+			} else {
+                                objs[k].binflag = -100;
+                                objs[k].m0 = -100;
+                                objs[k].m1 = -100;
+                                objs[k].id0 = -100;
+                                objs[k].id1 = -100;
+                                objs[k].a = -100;
+                                objs[k].e = -100;
+			}
+
+			if (j == 0) {
+                                objs[k].startype = star[i].se_k;
+                                objs[k].luminosity = star[i].se_lum;
+                                objs[k].radius = star[i].rad * units.l / RSUN;
+                                objs[k].bin_startype0 = -100;
+                                objs[k].bin_startype1 = -100;
+                                objs[k].bin_star_lum0 = -100;
+                                objs[k].bin_star_lum1 = -100;
+                                objs[k].bin_star_radius0 = -100;
+                                objs[k].bin_star_radius1 = -100;
+                                objs[k].bin_Eb = -100;
+                                objs[k].eta = -100;
+			} else {
+                                objs[k].startype = -100;
+                                objs[k].luminosity = -100;
+                                objs[k].radius = -100;
+                                objs[k].bin_startype0 = binary[j].bse_kw[0];
+                                objs[k].bin_startype1 = binary[j].bse_kw[1];
+                                objs[k].bin_star_lum0 = binary[j].bse_lum[0];
+                                objs[k].bin_star_lum1 = binary[j].bse_lum[1];
+                                objs[k].bin_star_radius0 = binary[j].rad1*units.l/RSUN;
+                                objs[k].bin_star_radius1 =  binary[j].rad2*units.l/RSUN;
+                                objs[k].bin_Eb = -(binary[j].m1/clus.N_STAR)*(binary[j].m2/clus.N_STAR)/(2*binary[j].a);
+                                objs[k].eta = want_eta ? (binary[j].m1 * binary[j].m2 * sqr(madhoc)) /
+                 (binary[j].a * sqrt(calc_average_mass_sqr(i,clus.N_MAX)) * sqr(sigma_array.sigma[i])) : 0.0;
+			}
+                        objs[k].star_phi = phi;
+			if (j == 0) {
+                                objs[k].rad0 = 0.0 / 0.0;
+                                objs[k].rad1 = 0.0 / 0.0;
+                                objs[k].tb = 0.0 / 0.0;
+                                objs[k].lum0 = 0.0 / 0.0;
+                                objs[k].lum1 = 0.0 / 0.0;
+                                objs[k].massc0 = 0.0 / 0.0;
+                                objs[k].massc1 = 0.0 / 0.0;
+                                objs[k].radc0 = 0.0 / 0.0;
+                                objs[k].radc1 = 0.0 / 0.0;
+                                objs[k].menv0 = 0.0 / 0.0;
+                                objs[k].menv1 = 0.0 / 0.0;
+                                objs[k].renv0 = 0.0 / 0.0;
+                                objs[k].renv1 = 0.0 / 0.0;
+                                objs[k].tms0 = 0.0 / 0.0;
+                                objs[k].tms1 = 0.0 / 0.0;
+                                objs[k].dmdt0 = 0.0 / 0.0;
+                                objs[k].dmdt1 = 0.0 / 0.0;
+                                objs[k].radrol0 = 0.0 / 0.0;
+                                objs[k].radrol1 = 0.0 / 0.0;
+                                objs[k].ospin0 = 0.0 / 0.0;
+                                objs[k].ospin1 = 0.0 / 0.0;
+                                objs[k].B0 = 0.0 / 0.0;
+                                objs[k].B1 = 0.0 / 0.0;
+                                objs[k].formation0 = 0.0 / 0.0;
+                                objs[k].formation1 = 0.0 / 0.0;
+                                objs[k].bacc0 = 0.0 / 0.0;
+                                objs[k].bacc1 = 0.0 / 0.0;
+                                objs[k].tacc0 = 0.0 / 0.0;
+                                objs[k].tacc1 = 0.0 / 0.0;
+                                objs[k].mass0_0 = 0.0 / 0.0;
+                                objs[k].mass0_1 = 0.0 / 0.0;
+                                objs[k].epoch0 = 0.0 / 0.0;
+                                objs[k].epoch1 = 0.0 / 0.0;
+                                objs[k].ospin = star[i].se_ospin;
+                                objs[k].B = star[i].se_scm_B;
+                                objs[k].formation = star[i].se_scm_formation;
+			} else {
+                                objs[k].rad0 = binary[j].bse_radius[0];
+                                objs[k].rad1 = binary[j].bse_radius[1];
+                                objs[k].tb = binary[j].bse_tb;
+                                objs[k].lum0 =binary[j].bse_lum[0];
+                                objs[k].lum1 = binary[j].bse_lum[1];
+                                objs[k].massc0 = binary[j].bse_massc[0];
+                                objs[k].massc1 = binary[j].bse_massc[1];
+                                objs[k].radc0 =  binary[j].bse_radc[0];
+                                objs[k].radc1 =  binary[j].bse_radc[1];
+                                objs[k].menv0 = binary[j].bse_menv[0];
+                                objs[k].menv1 = binary[j].bse_menv[1];
+                                objs[k].renv0 = binary[j].bse_renv[0];
+                                objs[k].renv1 = binary[j].bse_renv[1];
+                                objs[k].tms0 = binary[j].bse_tms[0];
+                                objs[k].tms1 = binary[j].bse_tms[1];
+                                objs[k].dmdt0 = binary[j].bse_bcm_dmdt[0];
+                                objs[k].dmdt1 = binary[j].bse_bcm_dmdt[1];
+                                objs[k].radrol0 = binary[j].bse_bcm_radrol[0];
+                                objs[k].radrol1 = binary[j].bse_bcm_radrol[1];
+                                objs[k].ospin0 = binary[j].bse_ospin[0];
+                                objs[k].ospin1 = binary[j].bse_ospin[1];
+                                objs[k].B0 = binary[j].bse_bcm_B[0];
+                                objs[k].B1 = binary[j].bse_bcm_B[1];
+                                objs[k].formation0 = binary[j].bse_bcm_formation[0];
+                                objs[k].formation1 = binary[j].bse_bcm_formation[1];
+                                objs[k].bacc0 = binary[j].bse_bacc[0];
+                                objs[k].bacc1 = binary[j].bse_bacc[1];
+                                objs[k].tacc0 = binary[j].bse_tacc[0];
+                                objs[k].tacc1 = binary[j].bse_tacc[1];
+                                objs[k].mass0_0 = binary[j].bse_mass0[0];
+                                objs[k].mass0_1 = binary[j].bse_mass0[1];
+                                objs[k].epoch0 = binary[j].bse_epoch[0];
+                                objs[k].epoch1 = binary[j].bse_epoch[1];
+                                objs[k].ospin = -100;
+                                objs[k].B = -100;
+                                objs[k].formation = -100;
+			}
+			k++;
+		}
+	}
+
+	*objs_out = objs;
+	return(NRECORDS);
+}
+
+/**
+* @brief writes out a snapshot table to the given file
 *
 * @param filename name of the file
 * @param bh_only if bh_only>0 this'll print only BHs.
+* @param tablename name of the table
+* @param fields columns to write, NULL for all of them
+* @param sample subsampling, NULL for all stars
 */
-void write_snapshot(char *filename, int bh_only, char *tablename) {
-        /* Define field information */
-        const char *field_names[NFIELDS]  =
-        { "id","m_MSUN", "r", "vr", "vt", "E", "J", "binflag", "m0_MSUN", "m1_MSUN", "id0",
-        "id1", "a_AU", "e", "startype", "luminosity_LSUN", "radius_RSUN", "bin_startype0", "bin_startype1",
-        "bin_star_lum0_LSUN", "bin_star_lum1_LSUN", "bin_star_radius0_RSUN", "bin_star_radius1_RSUN",
-        "bin_Eb", "eta", "star_phi", "rad0", "rad1", "tb", "lum0", "lum1", "massc0", "massc1", "radc0",
-        "radc1", "menv0", "menv1", "renv0", "renv1", "tms0", "tms1", "dmdt0", "dmdt1", "radrol0",
-        "radrol1", "ospin0", "ospin1", "B0", "B1", "formation0", "formation1", "bacc0", "bacc1",
-        "tacc0", "tacc1","mass0_0", "mass0_1", "epoch0","epoch1","ospin", "B","formation"};
-        hid_t      field_type[NFIELDS];
+static void write_snapshot_table(char *filename, int bh_only, char *tablename, snapshot_fields_t *fields, snapshot_sample_t *sample) {
         hid_t      snapfile_hdf5;
-        htri_t          avail;
-        H5Z_filter_t    filter_type;
-        herr_t  status;
-        hsize_t    chunk_size = 10;
-        int        *fill_data = NULL;
-        int        compress  = 1;
-        int 	   ii;
-        unsigned int filter_info;
+        snapshot_opts_t opts;
+        static int compress=-1;
+	long NRECORDS;
+	int k, mode;
+	size_t recsize;
+	Snapshot *all_objects;
+	MPI_Datatype snaptype;
 
 	/*
-     * Check if gzip compression is available and can be used for both
-     * compression and decompression.
+     * Check if the compression filter is available and can be used for both
+     * compression and decompression.  This is done once, on the first
+     * snapshot, so that no HDF5 call is made here later on while the I/O
+     * thread of ASYNC_IO may be writing.
      */
-		avail = H5Zfilter_avail(H5Z_FILTER_DEFLATE);
-		if (!avail) {
-			fprintf (stderr, "WARNING: gzip filter not available for HDF5\n");
-			fprintf (stderr, "Snapshots will be VERY large\n");
-            compress = 0;
-		}
-        status = H5Zget_filter_info (H5Z_FILTER_DEFLATE, &filter_info);
-		if ( !(filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED) ||
-                    !(filter_info & H5Z_FILTER_CONFIG_DECODE_ENABLED) ) {
-			fprintf (stderr, "WARNING: gzip filter not available for encoding and decoding HDF5 groups\n");
-			fprintf (stderr, "Snapshots will be VERY large\n");
-            compress = 0;
-		}
-
-        for (ii = 0; ii < NFIELDS; ++ii){
-          field_type[ii] = H5T_NATIVE_DOUBLE;
+        if (compress < 0) {
+                compress = SNAPSHOT_COMPRESS;
+                if (!snapshot_filter_avail(compress)) {
+                        wprintf("compression filter %d not available for encoding and decoding HDF5 snapshots; snapshots will be VERY large\n", compress);
+                        compress = SNAPSHOT_COMPRESS_NONE;
+                }
+        }
+        opts.chunk = SNAPSHOT_CHUNK;
+        opts.compress = compress;
+        opts.level = SNAPSHOT_COMPRESS_LEVEL;
+        opts.fields = fields;
+        opts.weight = 0.0;
+        if (sample != NULL && sample->mode == SNAPSHOT_SAMPLE_RANDOM) {
+                opts.weight = 1.0 / sample->value;
+        } else if (sample != NULL && sample->mode == SNAPSHOT_SAMPLE_RADIAL) {
+                opts.weight = sample->value;
         }
-        field_type[0] = H5T_NATIVE_LONG;
-        field_type[7] = H5T_NATIVE_LONG;
-        field_type[10] = H5T_NATIVE_LONG;
-        field_type[11] = H5T_NATIVE_LONG;
-        field_type[14] = H5T_NATIVE_INT;
-        field_type[17] = H5T_NATIVE_INT;
-        field_type[18] = H5T_NATIVE_INT;
-        /* Define an array of Particles */
-        Snapshot p_data[1] = {525,0.17924226,3.0778513,0.19755779,0.27799505,-0.15376079,0.85562742,-100.,-100.,-100.,-100,-100,-100.,-100.,0,0.006673921,0.19985968,-100,-100,-100.,-100.,-100.,-100,-100,-100,-0.211915956684,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,0.00000,17.161,0,0.0000};
-        /* Calculate the size and the offsets of our struct members in memory */
-        size_t dst_size =  sizeof( Snapshot );
-        size_t dst_offset[NFIELDS] = {
-                                    /*0*/    HOFFSET( Snapshot, id ),
-                                    /*1*/     HOFFSET( Snapshot, m ),
-                                    /*2*/     HOFFSET( Snapshot, r ),
-                                    /*3*/     HOFFSET( Snapshot, vr ),
-                                    /*4*/     HOFFSET( Snapshot, vt ),
-                                    /*5*/     HOFFSET( Snapshot, E ),
-                                    /*6*/     HOFFSET( Snapshot, J ),
-                                    /*7*/     HOFFSET( Snapshot, binflag ),
-                                    /*8*/     HOFFSET( Snapshot, m0 ),
-                                    /*9*/     HOFFSET( Snapshot, m1 ),
-                                    /*10*/    HOFFSET( Snapshot, id0 ),
-                                    /*11*/    HOFFSET( Snapshot, id1 ),
-                                    /*12*/    HOFFSET( Snapshot, a ),
-                                    /*13*/    HOFFSET( Snapshot, e ),
-                                    /*14*/    HOFFSET( Snapshot, startype ),
-                                    /*15*/    HOFFSET( Snapshot, luminosity ),
-                                    /*16*/    HOFFSET( Snapshot, radius ),
-                                    /*17*/    HOFFSET( Snapshot, bin_startype0 ),
-                                    /*18*/    HOFFSET( Snapshot, bin_startype1 ),
-                                    /*19*/    HOFFSET( Snapshot, bin_star_lum0 ),
-                                    /*20*/    HOFFSET( Snapshot, bin_star_lum1 ),
-                                    /*21*/    HOFFSET( Snapshot, bin_star_radius0),
-                                    /*22*/    HOFFSET( Snapshot, bin_star_radius1 ),
-                                    /*23*/    HOFFSET( Snapshot, bin_Eb ),
-                                    /*24*/    HOFFSET( Snapshot, eta ),
-                                    /*25*/    HOFFSET( Snapshot, star_phi ),
-                                    /*26*/    HOFFSET( Snapshot, rad0 ),
-                                    /*27*/    HOFFSET( Snapshot, rad1 ),
-                                    /*28*/    HOFFSET( Snapshot, tb ),
-                                    /*29*/    HOFFSET( Snapshot, lum0 ),
-                                    /*30*/    HOFFSET( Snapshot, lum1 ),
-                                    /*31*/    HOFFSET( Snapshot, massc0 ),
-                                    /*32*/    HOFFSET( Snapshot, massc1 ),
-                                    /*33*/    HOFFSET( Snapshot, radc0 ),
-                                    /*34*/    HOFFSET( Snapshot, radc1 ),
-                                    /*35*/    HOFFSET( Snapshot, menv0 ),
-                                    /*36*/    HOFFSET( Snapshot, menv1 ),
-                                    /*37*/    HOFFSET( Snapshot, renv0 ),
-                                    /*38*/    HOFFSET( Snapshot, renv1 ),
-                                    /*39*/    HOFFSET( Snapshot, tms0 ),
-                                    /*40*/    HOFFSET( Snapshot, tms1 ),
-                                    /*41*/    HOFFSET( Snapshot, dmdt0 ),
-                                    /*42*/    HOFFSET( Snapshot, dmdt1 ),
-                                    /*43*/    HOFFSET( Snapshot, radrol0 ),
-                                    /*44*/    HOFFSET( Snapshot, radrol1 ),
-                                    /*45*/    HOFFSET( Snapshot, ospin0 ),
-                                    /*46*/    HOFFSET( Snapshot, ospin1 ),
-                                    /*47*/    HOFFSET( Snapshot, B0 ),
-                                    /*48*/    HOFFSET( Snapshot, B1 ),
-                                    /*49*/    HOFFSET( Snapshot, formation0 ),
-                                    /*50*/    HOFFSET( Snapshot, formation1 ),
-                                    /*51*/    HOFFSET( Snapshot, bacc0 ),
-                                    /*52*/    HOFFSET( Snapshot, bacc1 ),
-                                    /*53*/    HOFFSET( Snapshot, tacc0 ),
-                                    /*54*/    HOFFSET( Snapshot, tacc1 ),
-                                    /*55*/    HOFFSET( Snapshot, mass0_0 ),
-                                    /*56*/    HOFFSET( Snapshot, mass0_1 ),
-                                    /*57*/    HOFFSET( Snapshot, epoch0 ),
-                                    /*58*/    HOFFSET( Snapshot, epoch1 ),
-                                    /*59*/    HOFFSET( Snapshot, ospin ),
-                                    /*60*/    HOFFSET( Snapshot, B ),
-                                    /*61*/    HOFFSET( Snapshot, formation ),
-                                    };
-
-
-        size_t dst_sizes[NFIELDS] = {
-                                        sizeof( p_data[0].id ),
-                                        sizeof( p_data[0].m ),
-                                        sizeof( p_data[0].r ),
-                                        sizeof( p_data[0].vr ),
-                                        sizeof( p_data[0].vt ),
-                                        sizeof( p_data[0].E ),
-                                        sizeof( p_data[0].J ),
-                                        sizeof( p_data[0].binflag ),
-                                        sizeof( p_data[0].m0 ),
-                                        sizeof( p_data[0].m1 ),
-                                        sizeof( p_data[0].id0 ),
-                                        sizeof( p_data[0].id1 ),
-                                        sizeof( p_data[0].a ),
-                                        sizeof( p_data[0].e ),
-                                        sizeof( p_data[0].startype ),
-                                        sizeof( p_data[0].luminosity ),
-                                        sizeof( p_data[0].radius ),
-                                        sizeof( p_data[0].bin_startype0 ),
-                                        sizeof( p_data[0].bin_startype1 ),
-                                        sizeof( p_data[0].bin_star_lum0 ),
-                                        sizeof( p_data[0].bin_star_lum1 ),
-                                        sizeof( p_data[0].bin_star_radius0 ),
-                                        sizeof( p_data[0].bin_star_radius1 ),
-                                        sizeof( p_data[0].bin_Eb ),
-                                        sizeof( p_data[0].eta ),
-                                        sizeof( p_data[0].star_phi ),
-                                        sizeof( p_data[0].rad0 ),
-                                        sizeof( p_data[0].rad1 ),
-                                        sizeof( p_data[0].tb ),
-                                        sizeof( p_data[0].lum0 ),
-                                        sizeof( p_data[0].lum1 ),
-                                        sizeof( p_data[0].massc0 ),
-                                        sizeof( p_data[0].massc1 ),
-                                        sizeof( p_data[0].radc0 ),
-                                        sizeof( p_data[0].radc1 ),
-                                        sizeof( p_data[0].menv0 ),
-                                        sizeof( p_data[0].menv1 ),
-                                        sizeof( p_data[0].renv0 ),
-                                        sizeof( p_data[0].renv1 ),
-                                        sizeof( p_data[0].tms0 ),
-                                        sizeof( p_data[0].tms1 ),
-                                        sizeof( p_data[0].dmdt0 ),
-                                        sizeof( p_data[0].dmdt1 ),
-                                        sizeof( p_data[0].radrol0 ),
-                                        sizeof( p_data[0].radrol1 ),
-                                        sizeof( p_data[0].ospin0 ),
-                                        sizeof( p_data[0].ospin1 ),
-                                        sizeof( p_data[0].B0 ),
-                                        sizeof( p_data[0].B1 ),
-                                        sizeof( p_data[0].formation0 ),
-                                        sizeof( p_data[0].formation1 ),
-                                        sizeof( p_data[0].bacc0 ),
-                                        sizeof( p_data[0].bacc1 ),
-                                        sizeof( p_data[0].tacc0 ),
-                                        sizeof( p_data[0].tacc1 ),
-                                        sizeof( p_data[0].mass0_0 ),
-                                        sizeof( p_data[0].mass0_1 ),
-                                        sizeof( p_data[0].epoch0 ),
-                                        sizeof( p_data[0].epoch1 ),
-                                        sizeof( p_data[0].ospin ),
-                                        sizeof( p_data[0].B ),
-                                        sizeof( p_data[0].formation ),
-                                    };
-
-        int k;
-	long i, j;
-	j=0;
-	double m, r, phi;
 
-        //Serializing the snapshot printing.
-        for(k=0; k<procs; k++)
-        {       
-                if(myid==k)
-                {       
-                        //Initial file created only by root node.
-                        if(myid==0){
-                                H5E_BEGIN_TRY {
-                                    snapfile_hdf5 = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
-                                    H5Fclose( snapfile_hdf5 );
-                                } H5E_END_TRY
-                        }
-                }
-                MPI_Barrier(MPI_COMM_WORLD);
+	if (ASYNC_IO) {
+		//The root node gathers the records of all nodes into a staging buffer and hands it to the I/O thread, which creates the file if needed and writes the table while the run goes on.
+		int *counts=NULL, *displs=NULL, n;
+		long total=0;
+		Snapshot *gathered=NULL;
+
+		NRECORDS = snapshot_fill(&all_objects, bh_only, fields, sample);
+		recsize = snapshot_pack(all_objects, NRECORDS, fields);
+		n = (int) NRECORDS;
+		if(myid==0){
+			counts = (int *) malloc(procs * sizeof(int));
+			displs = (int *) malloc(procs * sizeof(int));
+		}
+		MPI_Gather(&n, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		if(myid==0){
+			for(k=0; k<procs; k++){
+				displs[k] = (int) total;
+				total += counts[k];
+			}
+			/* wait for older snapshots to be written if too many bytes of them are still waiting */
+			aio_snapshot_reserve(MAX(total, 1) * recsize);
+			gathered = (Snapshot *) malloc(MAX(total, 1) * recsize);
+			if (gathered == NULL) {
+				eprintf("cannot allocate %ld snapshot records.\n", total);
+				exit_cleanly(-1, __FUNCTION__);
+			}
+		}
+		MPI_Type_contiguous(recsize, MPI_BYTE, &snaptype);
+		MPI_Type_commit(&snaptype);
+		MPI_Gatherv(all_objects, n, snaptype, gathered, counts, displs, snaptype, 0, MPI_COMM_WORLD);
+		MPI_Type_free(&snaptype);
+		free(all_objects);
+
+		if(myid==0){
+			aio_snapshot_submit(filename, tablename, &opts, gathered, total, MAX(total, 1) * recsize);
+			free(counts);
+			free(displs);
+		}
+		return;
+	}
+
+        //Initial file created only by root node.
+        if(myid==0){
+                H5E_BEGIN_TRY {
+                    snapfile_hdf5 = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+                    H5Fclose( snapfile_hdf5 );
+                } H5E_END_TRY
         }
 
-	//Serializing the snapshot printing.
-	for(k=0; k<procs; k++)
-	{
-		if(myid==k)
-		{
-			// then print data
-			long NRECORDS = 0, k = 0;
-			if(bh_only == 0)
-				NRECORDS = clus.N_MAX_NEW;
-			else
-				for (i=1; i<=clus.N_MAX_NEW; i++){
-					j=star[i].binind;
-					if( star[i].se_k==14 || binary[j].bse_kw[0]==14 || binary[j].bse_kw[1]==14 ) 
-						NRECORDS++;
-				}
+	NRECORDS = snapshot_fill(&all_objects, bh_only, fields, sample);
+	recsize = snapshot_pack(all_objects, NRECORDS, fields);
 
-                        Snapshot all_objects[NRECORDS];
-                        for (i=1; i<=clus.N_MAX_NEW; i++) {
-                                long g_i = get_global_idx(i);
-                                m = star_m[g_i];
-                                r = star_r[g_i];
-                                phi = star_phi[g_i];
-				j=star[i].binind;
-				//if bh_only>0, print only BHs
-				if( (bh_only==0) || ( (bh_only!=0) && (star[i].se_k==14 || binary[j].bse_kw[0]==14 || binary[j].bse_kw[1]==14) ) )
-				{
-                                        all_objects[k].id = star[i].id;
-                                        all_objects[k].m = m * (units.m / clus.N_STAR) / MSUN;
-                                        all_objects[k].r = r;
-                                        all_objects[k].vr = star[i].vr;
-                                        all_objects[k].vt = star[i].vt;
-                                        all_objects[k].E = star[i].E;
-                                        all_objects[k].J = star[i].J;
-					if (j) {
-                                                all_objects[k].binflag = 1;
-                                                all_objects[k].m0 = binary[j].m1 * (units.m / clus.N_STAR) / MSUN;
-                                                all_objects[k].m1 = binary[j].m2 * (units.m / clus.N_STAR) / MSUN;
-                                                all_objects[k].id0 = binary[j].id1;
-                                                all_objects[k].id1 = binary[j].id2;
-                                                all_objects[k].a = binary[j].a * units.l / AU;
-                                                all_objects[k].e = binary[j].e;
-					} else {
-                                                all_objects[k].binflag = -100;
-                                                all_objects[k].m0 = -100;
-                                                all_objects[k].m1 = -100;
-                                                all_objects[k].id0 = -100;
-                                                all_objects[k].id1 = -100;
-                                                all_objects[k].a = -100;
-                                                all_objects[k].e = -100;
-					}
+	/* the parser has already checked the mode and turned 2 into 1 without parallel HDF5 */
+	mode = SNAPSHOT_IO_MODE;
 
-					if (j == 0) {
-                                                all_objects[k].startype = star[i].se_k;
-                                                all_objects[k].luminosity = star[i].se_lum;
-                                                all_objects[k].radius = star[i].rad * units.l / RSUN;
-                                                all_objects[k].bin_startype0 = -100;
-                                                all_objects[k].bin_startype1 = -100;
-                                                all_objects[k].bin_star_lum0 = -100;
-                                                all_objects[k].bin_star_lum1 = -100;
-                                                all_objects[k].bin_star_radius0 = -100;
-                                                all_objects[k].bin_star_radius1 = -100;
-                                                all_objects[k].bin_Eb = -100;
-                                                all_objects[k].eta = -100;
-					} else {
-                                                all_objects[k].startype = -100;
-                                                all_objects[k].luminosity = -100;
-                                                all_objects[k].radius = -100;
-                                                all_objects[k].bin_startype0 = binary[j].bse_kw[0];
-                                                all_objects[k].bin_startype1 = binary[j].bse_kw[1];
-                                                all_objects[k].bin_star_lum0 = binary[j].bse_lum[0];
-                                                all_objects[k].bin_star_lum1 = binary[j].bse_lum[1];
-                                                all_objects[k].bin_star_radius0 = binary[j].rad1*units.l/RSUN;
-                                                all_objects[k].bin_star_radius1 =  binary[j].rad2*units.l/RSUN;
-                                                all_objects[k].bin_Eb = -(binary[j].m1/clus.N_STAR)*(binary[j].m2/clus.N_STAR)/(2*binary[j].a);
-                                                all_objects[k].eta = (binary[j].m1 * binary[j].m2 * sqr(madhoc)) /
-                                 (binary[j].a * sqrt(calc_average_mass_sqr(i,clus.N_MAX)) * sqr(sigma_array.sigma[i]));
-					}
-                                        all_objects[k].star_phi = phi;
-					if (j == 0) {
-                                                all_objects[k].rad0 = 0.0 / 0.0;
-                                                all_objects[k].rad1 = 0.0 / 0.0;
-                                                all_objects[k].tb = 0.0 / 0.0;
-                                                all_objects[k].lum0 = 0.0 / 0.0;
-                                                all_objects[k].lum1 = 0.0 / 0.0;
-                                                all_objects[k].massc0 = 0.0 / 0.0;
-                                                all_objects[k].massc1 = 0.0 / 0.0;
-                                                all_objects[k].radc0 = 0.0 / 0.0;
-                                                all_objects[k].radc1 = 0.0 / 0.0;
-                                                all_objects[k].menv0 = 0.0 / 0.0;
-                                                all_objects[k].menv1 = 0.0 / 0.0;
-                                                all_objects[k].renv0 = 0.0 / 0.0;
-                                                all_objects[k].renv1 = 0.0 / 0.0;
-                                                all_objects[k].tms0 = 0.0 / 0.0;
-                                                all_objects[k].tms1 = 0.0 / 0.0;
-                                                all_objects[k].dmdt0 = 0.0 / 0.0;
-                                                all_objects[k].dmdt1 = 0.0 / 0.0;
-                                                all_objects[k].radrol0 = 0.0 / 0.0;
-                                                all_objects[k].radrol1 = 0.0 / 0.0;
-                                                all_objects[k].ospin0 = 0.0 / 0.0;
-                                                all_objects[k].ospin1 = 0.0 / 0.0;
-                                                all_objects[k].B0 = 0.0 / 0.0;
-                                                all_objects[k].B1 = 0.0 / 0.0;
-                                                all_objects[k].formation0 = 0.0 / 0.0;
-                                                all_objects[k].formation1 = 0.0 / 0.0;
-                                                all_objects[k].bacc0 = 0.0 / 0.0;
-                                                all_objects[k].bacc1 = 0.0 / 0.0;
-                                                all_objects[k].tacc0 = 0.0 / 0.0;
-                                                all_objects[k].tacc1 = 0.0 / 0.0;
-                                                all_objects[k].mass0_0 = 0.0 / 0.0;
-                                                all_objects[k].mass0_1 = 0.0 / 0.0;
-                                                all_objects[k].epoch0 = 0.0 / 0.0;
-                                                all_objects[k].epoch1 = 0.0 / 0.0;
-                                                all_objects[k].ospin = star[i].se_ospin;
-                                                all_objects[k].B = star[i].se_scm_B;
-                                                all_objects[k].formation = star[i].se_scm_formation;
-					} else {
-                                                all_objects[k].rad0 = binary[j].bse_radius[0];
-                                                all_objects[k].rad1 = binary[j].bse_radius[1];
-                                                all_objects[k].tb = binary[j].bse_tb;
-                                                all_objects[k].lum0 =binary[j].bse_lum[0];
-                                                all_objects[k].lum1 = binary[j].bse_lum[1];
-                                                all_objects[k].massc0 = binary[j].bse_massc[0];
-                                                all_objects[k].massc1 = binary[j].bse_massc[1];
-                                                all_objects[k].radc0 =  binary[j].bse_radc[0];
-                                                all_objects[k].radc1 =  binary[j].bse_radc[1];
-                                                all_objects[k].menv0 = binary[j].bse_menv[0];
-                                                all_objects[k].menv1 = binary[j].bse_menv[1];
-                                                all_objects[k].renv0 = binary[j].bse_renv[0];
-                                                all_objects[k].renv1 = binary[j].bse_renv[1];
-                                                all_objects[k].tms0 = binary[j].bse_tms[0];
-                                                all_objects[k].tms1 = binary[j].bse_tms[1];
-                                                all_objects[k].dmdt0 = binary[j].bse_bcm_dmdt[0];
-                                                all_objects[k].dmdt1 = binary[j].bse_bcm_dmdt[1];
-                                                all_objects[k].radrol0 = binary[j].bse_bcm_radrol[0];
-                                                all_objects[k].radrol1 = binary[j].bse_bcm_radrol[1];
-                                                all_objects[k].ospin0 = binary[j].bse_ospin[0];
-                                                all_objects[k].ospin1 = binary[j].bse_ospin[1];
-                                                all_objects[k].B0 = binary[j].bse_bcm_B[0];
-                                                all_objects[k].B1 = binary[j].bse_bcm_B[1];
-                                                all_objects[k].formation0 = binary[j].bse_bcm_formation[0];
-                                                all_objects[k].formation1 = binary[j].bse_bcm_formation[1];
-                                                all_objects[k].bacc0 = binary[j].bse_bacc[0];
-                                                all_objects[k].bacc1 = binary[j].bse_bacc[1];
-                                                all_objects[k].tacc0 = binary[j].bse_tacc[0];
-                                                all_objects[k].tacc1 = binary[j].bse_tacc[1];
-                                                all_objects[k].mass0_0 = binary[j].bse_mass0[0];
-                                                all_objects[k].mass0_1 = binary[j].bse_mass0[1];
-                                                all_objects[k].epoch0 = binary[j].bse_epoch[0];
-                                                all_objects[k].epoch1 = binary[j].bse_epoch[1];
-                                                all_objects[k].ospin = -100;
-                                                all_objects[k].B = -100;
-                                                all_objects[k].formation = -100;
+	if (mode == 0) {
+		//Serializing the snapshot printing: each node appends its records in turn.
+		for(k=0; k<procs; k++)
+		{
+			if(myid==k)
+			{
+				snapfile_hdf5 = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+				if(myid==0){
+					snapshot_make_table(snapfile_hdf5, tablename, NRECORDS, all_objects, &opts);
+				}
+				else{
+					snapshot_append_records(snapfile_hdf5, tablename, NRECORDS, all_objects, &opts);
+				}
+				H5Fclose( snapfile_hdf5 );
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+	} else if (mode == 1) {
+		//The root node collects the records of the other nodes one at a time and writes them through a single open file, so only it touches the file and it never holds more than one node's records besides its own.
+		MPI_Type_contiguous(recsize, MPI_BYTE, &snaptype);
+		MPI_Type_commit(&snaptype);
+		if(myid==0){
+			long nmax=0, n;
+
+			snapfile_hdf5 = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+			snapshot_make_table(snapfile_hdf5, tablename, NRECORDS, all_objects, &opts);
+			free(all_objects);
+			all_objects = NULL;
+
+			for(k=1; k<procs; k++){
+				MPI_Recv(&n, 1, MPI_LONG, k, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				if (n > nmax) {
+					nmax = n;
+					all_objects = (Snapshot *) realloc(all_objects, nmax * recsize);
+					if (all_objects == NULL) {
+						eprintf("cannot allocate %ld snapshot records.\n", nmax);
+						exit_cleanly(-1, __FUNCTION__);
 					}
-					k++;
 				}
+				MPI_Recv(all_objects, (int) n, snaptype, k, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				snapshot_append_records(snapfile_hdf5, tablename, n, all_objects, &opts);
 			}
-//                        if(LIGHTCOLLISION_NRECORDS >200){
-//                            write_logs();
-//                            LIGHTCOLLISION_NRECORDS = 0;
-//                        }
-                        if(myid==0){
-                            snapfile_hdf5 = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
-                            H5TBmake_table( "Table Title",snapfile_hdf5, tablename, NFIELDS,NRECORDS,
-                                                dst_size, field_names, dst_offset, field_type,
-                                                chunk_size, fill_data, compress, all_objects);
-                            H5Fclose( snapfile_hdf5 );
-                        }
-                        else{
-                            snapfile_hdf5 = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
-                            H5TBappend_records(snapfile_hdf5, tablename, NRECORDS, dst_size, dst_offset, dst_sizes, &all_objects);
-                            H5Fclose( snapfile_hdf5 );
-                        }
-		}
-		MPI_Barrier(MPI_COMM_WORLD);
+			H5Fclose( snapfile_hdf5 );
+		} else {
+			MPI_Send(&NRECORDS, 1, MPI_LONG, 0, 0, MPI_COMM_WORLD);
+			MPI_Send(all_objects, (int) NRECORDS, snaptype, 0, 1, MPI_COMM_WORLD);
+		}
+		MPI_Type_free(&snaptype);
 	}
+#ifdef H5_HAVE_PARALLEL
+	else {
+		//Parallel HDF5: the root node makes the (empty) table so that it carries the same metadata as always, then all nodes extend it and write their own part of it collectively.
+		hid_t fapl, dxpl, dset, memtype, filespace, memspace;
+		hsize_t dims[1], start[1], count[1];
+		herr_t status;
+		long total, offset;
+
+		if(myid==0){
+			snapfile_hdf5 = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+			snapshot_make_table(snapfile_hdf5, tablename, 0, NULL, &opts);
+			H5Fclose( snapfile_hdf5 );
+		}
+
+		offset = 0;
+		MPI_Exscan(&NRECORDS, &offset, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+		if (myid == 0) offset = 0;
+		MPI_Allreduce(&NRECORDS, &total, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+		fapl = H5Pcreate(H5P_FILE_ACCESS);
+		H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+		snapfile_hdf5 = H5Fopen(filename, H5F_ACC_RDWR, fapl);
+		dset = H5Dopen2(snapfile_hdf5, tablename, H5P_DEFAULT);
+		dims[0] = total;
+		H5Dset_extent(dset, dims);
+
+		memtype = snapshot_type(opts.fields);
+
+		filespace = H5Dget_space(dset);
+		start[0] = offset;
+		count[0] = NRECORDS;
+		memspace = H5Screate_simple(1, count, NULL);
+		if (NRECORDS > 0) {
+			H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, NULL, count, NULL);
+		} else {
+			H5Sselect_none(filespace);
+			H5Sselect_none(memspace);
+		}
+
+		dxpl = H5Pcreate(H5P_DATASET_XFER);
+		H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+		status = H5Dwrite(dset, memtype, memspace, filespace, dxpl, all_objects);
+		if (status < 0) {
+			eprintf("parallel write of snapshot \"%s\" to \"%s\" failed.\n", tablename, filename);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+
+		H5Pclose(dxpl);
+		H5Sclose(memspace);
+		H5Sclose(filespace);
+		H5Tclose(memtype);
+		H5Dclose(dset);
+		H5Fclose(snapfile_hdf5);
+		H5Pclose(fapl);
+	}
+#endif
+
+	free(all_objects);
+}
+
+/**
+* @brief writes out snapshot to the given file
+*
+* @param filename name of the file
+* @param bh_only if bh_only>0 this'll print only BHs.
+* @param tablename name of the table
+*/
+void write_snapshot(char *filename, int bh_only, char *tablename) {
+	write_snapshot_table(filename, bh_only, tablename, NULL, NULL);
 }
 
 /**
@@ -3284,7 +3738,7 @@ void get_star_data(int argc, char *argv[], gsl_rng *rng)
 {
 	/* print version information to log file */
 	pararootfprintf(logfile, "** %s Version %d.%d **\n", CMCPRETTYNAME, CMC_VERSION_MAJOR, CMC_VERSION_MINOR);
-    mpi_para_file_write(mpi_logfile_wrbuf, &mpi_logfile_len, &mpi_logfile_ofst_total, &mpi_logfile);
+    mpi_para_file_write(&mpi_logfile_wrbuf, &mpi_logfile_ofst_total, &mpi_logfile);
 
 	/* initialize the Search_Grid r_grid */
 	//If we use the GPU code, we dont need the SEARCH_GRID. So commenting it out
@@ -3611,18 +4065,18 @@ void save_global_vars(restart_struct_t *rest){
 	rest->s_Etidal                             =Etidal;
     rest->s_Prev_Dt                            =Prev_Dt;
 
-	rest->s_mpi_logfile_len                    =mpi_logfile_len;
-	rest->s_mpi_escfile_len                    =mpi_escfile_len;
-	rest->s_mpi_binintfile_len                 =mpi_binintfile_len;
-	rest->s_mpi_collisionfile_len              =mpi_collisionfile_len;
-	rest->s_mpi_tidalcapturefile_len           =mpi_tidalcapturefile_len;
-	rest->s_mpi_semergedisruptfile_len         =mpi_semergedisruptfile_len;
-	rest->s_mpi_removestarfile_len             =mpi_removestarfile_len;
-	rest->s_mpi_relaxationfile_len             =mpi_relaxationfile_len;
-	rest->s_mpi_pulsarfile_len                 =mpi_pulsarfile_len;
-        rest->s_mpi_morepulsarfile_len             =mpi_morepulsarfile_len;
-        rest->s_mpi_triplefile_len                 =mpi_triplefile_len;
-	rest->s_mpi_bhmergerfile_len               =mpi_bhmergerfile_len;
+	rest->s_mpi_logfile_len                    =mpi_logfile_wrbuf.len;
+	rest->s_mpi_escfile_len                    =mpi_escfile_wrbuf.len;
+	rest->s_mpi_binintfile_len                 =mpi_binintfile_wrbuf.len;
+	rest->s_mpi_collisionfile_len              =mpi_collisionfile_wrbuf.len;
+	rest->s_mpi_tidalcapturefile_len           =mpi_tidalcapturefile_wrbuf.len;
+	rest->s_mpi_semergedisruptfile_len         =mpi_semergedisruptfile_wrbuf.len;
+	rest->s_mpi_removestarfile_len             =mpi_removestarfile_wrbuf.len;
+	rest->s_mpi_relaxationfile_len             =mpi_relaxationfile_wrbuf.len;
+	rest->s_mpi_pulsarfile_len                 =mpi_pulsarfile_wrbuf.len;
+        rest->s_mpi_morepulsarfile_len             =mpi_morepulsarfile_wrbuf.len;
+        rest->s_mpi_triplefile_len                 =mpi_triplefile_wrbuf.len;
+	rest->s_mpi_bhmergerfile_len               =mpi_bhmergerfile_wrbuf.len;
 	rest->s_mpi_logfile_ofst_total             =mpi_logfile_ofst_total;
 	rest->s_mpi_escfile_ofst_total             =mpi_escfile_ofst_total;
 	rest->s_mpi_binaryfile_ofst_total          =mpi_binaryfile_ofst_total;
@@ -3665,18 +4119,20 @@ void load_global_vars(restart_struct_t *rest){
 	Etidal                             =rest->s_Etidal;
     Prev_Dt                            =rest->s_Prev_Dt;
 
-	mpi_logfile_len                    =rest->s_mpi_logfile_len;
-	mpi_escfile_len                    =rest->s_mpi_escfile_len;
-	mpi_binintfile_len                 =rest->s_mpi_binintfile_len;
-	mpi_collisionfile_len              =rest->s_mpi_collisionfile_len;
-	mpi_tidalcapturefile_len           =rest->s_mpi_tidalcapturefile_len;
-	mpi_semergedisruptfile_len         =rest->s_mpi_semergedisruptfile_len;
-	mpi_removestarfile_len             =rest->s_mpi_removestarfile_len;
-	mpi_relaxationfile_len             =rest->s_mpi_relaxationfile_len;
-	mpi_pulsarfile_len                 =rest->s_mpi_pulsarfile_len;
-        mpi_morepulsarfile_len             =rest->s_mpi_morepulsarfile_len;
-        mpi_triplefile_len                 =rest->s_mpi_triplefile_len;
-	mpi_bhmergerfile_len               =rest->s_mpi_bhmergerfile_len;
+	/* the buffered text is not part of the restart file, and the buffers
+	   are always flushed before a checkpoint, so they start out empty */
+	parabuf_truncate(&mpi_logfile_wrbuf, 0);
+	parabuf_truncate(&mpi_escfile_wrbuf, 0);
+	parabuf_truncate(&mpi_binintfile_wrbuf, 0);
+	parabuf_truncate(&mpi_collisionfile_wrbuf, 0);
+	parabuf_truncate(&mpi_tidalcapturefile_wrbuf, 0);
+	parabuf_truncate(&mpi_semergedisruptfile_wrbuf, 0);
+	parabuf_truncate(&mpi_removestarfile_wrbuf, 0);
+	parabuf_truncate(&mpi_relaxationfile_wrbuf, 0);
+	parabuf_truncate(&mpi_pulsarfile_wrbuf, 0);
+        parabuf_truncate(&mpi_morepulsarfile_wrbuf, 0);
+        parabuf_truncate(&mpi_triplefile_wrbuf, 0);
+	parabuf_truncate(&mpi_bhmergerfile_wrbuf, 0);
 	mpi_logfile_ofst_total             =rest->s_mpi_logfile_ofst_total;
 	mpi_escfile_ofst_total             =rest->s_mpi_escfile_ofst_total;
 	mpi_binaryfile_ofst_total          =rest->s_mpi_binaryfile_ofst_total;
@@ -3710,6 +4166,647 @@ void load_global_vars(restart_struct_t *rest){
 	cenma.E                            =rest->s_cenma_e;
 }
 
+/* shared, processor-count independent checkpoint (RESTART_FORMAT=1) */
+#define RESTART_MAGIC "CMCRSTRT"
+#define RESTART_VERSION 1
+#define RESTART_ENDIAN 0x01020304
+
+/**
+* @brief Header at the start of a shared checkpoint.  It is followed by one
+* restart_rank_t per processor that wrote it, the snapshot window counters,
+* the live stars of all processors in radial order, and the binaries they hold,
+* in the same order.
+*/
+typedef struct{
+/**
+* @brief RESTART_MAGIC, without the terminating null
+*/
+	char tag[8];
+	int version;
+	int endian;
+/**
+* @brief number of processors that wrote the checkpoint
+*/
+	int nprocs;
+/**
+* @brief sizes of the structures written, which have to match those of the code reading it
+*/
+	int star_size, binary_size, clus_size, rest_size, rng_size;
+	int window_count;
+/**
+* @brief total number of stars and of binaries
+*/
+	long nstar, nbin;
+} restart_header_t;
+
+/**
+* @brief State of one processor in a shared checkpoint
+*/
+typedef struct{
+/**
+* @brief number of stars and of binaries the processor held
+*/
+	long nstar, nbin;
+	struct rng_t113_state rng;
+	restart_struct_t rest;
+	clus_struct_t clus;
+/**
+* @brief star[0], which is not one of the stars
+*/
+	star_t star0;
+} restart_rank_t;
+
+/**
+* @brief Writes a shared checkpoint with MPI-IO.  Only the live stars are
+* written, and the binaries they hold, with binind numbering the binaries
+* across all processors.
+*
+* @param restart_file checkpoint file
+* @param rest global variables of this processor
+*/
+static void save_restart_shared(char *restart_file, restart_struct_t *rest)
+{
+	MPI_File fh;
+	MPI_Offset off_star, off_bin;
+	MPI_Datatype startype, bintype;
+	restart_header_t head;
+	restart_rank_t rec;
+	long nstar=clus.N_MAX_NEW, nbin=0, star_ofst=0, bin_ofst=0, nstar_tot, nbin_tot, i, k;
+	long *binind;
+	binary_t *bins;
+	int rc;
+
+	for (i=1; i<=nstar; i++) {
+		if (star[i].binind > 0) nbin++;
+	}
+	MPI_Exscan(&nstar, &star_ofst, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	MPI_Exscan(&nbin, &bin_ofst, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	if (myid == 0) {
+		star_ofst = 0;
+		bin_ofst = 0;
+	}
+	MPI_Allreduce(&nstar, &nstar_tot, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	MPI_Allreduce(&nbin, &nbin_tot, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+	/* pack the binaries in the order of the stars holding them, and number them globally for the write */
+	bins = (binary_t *) malloc(MAX(nbin, 1) * sizeof(binary_t));
+	binind = (long *) malloc((nstar+1) * sizeof(long));
+	for (i=1, k=0; i<=nstar; i++) {
+		binind[i] = star[i].binind;
+		if (star[i].binind > 0) {
+			bins[k] = binary[star[i].binind];
+			k++;
+			star[i].binind = bin_ofst + k;
+		}
+	}
+
+	memset(&head, 0, sizeof(head));
+	memcpy(head.tag, RESTART_MAGIC, sizeof(head.tag));
+	head.version = RESTART_VERSION;
+	head.endian = RESTART_ENDIAN;
+	head.nprocs = procs;
+	head.star_size = sizeof(star_t);
+	head.binary_size = sizeof(binary_t);
+	head.clus_size = sizeof(clus_struct_t);
+	head.rest_size = sizeof(restart_struct_t);
+	head.rng_size = sizeof(struct rng_t113_state);
+	head.window_count = snapshot_window_count;
+	head.nstar = nstar_tot;
+	head.nbin = nbin_tot;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.nstar = nstar;
+	rec.nbin = nbin;
+	rec.rng = *curr_st;
+	rec.rest = *rest;
+	rec.clus = clus;
+	rec.star0 = star[0];
+
+	off_star = sizeof(restart_header_t) + procs * sizeof(restart_rank_t) + snapshot_window_count * sizeof(int);
+	off_bin = off_star + nstar_tot * sizeof(star_t);
+
+	MPI_Type_contiguous(sizeof(star_t), MPI_BYTE, &startype);
+	MPI_Type_commit(&startype);
+	MPI_Type_contiguous(sizeof(binary_t), MPI_BYTE, &bintype);
+	MPI_Type_commit(&bintype);
+
+	rc = MPI_File_open(MPI_COMM_WORLD, restart_file, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+	if (rc != MPI_SUCCESS) {
+		eprintf("can't open restart file %s for writing!\n", restart_file);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+	MPI_File_set_size(fh, 0);
+	if (myid == 0) {
+		MPI_File_write_at(fh, 0, &head, sizeof(head), MPI_BYTE, MPI_STATUS_IGNORE);
+		if (snapshot_window_count) {
+			MPI_File_write_at(fh, sizeof(restart_header_t) + procs * sizeof(restart_rank_t), snapshot_window_counters,
+					  snapshot_window_count, MPI_INT, MPI_STATUS_IGNORE);
+		}
+	}
+	MPI_File_write_at_all(fh, sizeof(restart_header_t) + myid * sizeof(restart_rank_t), &rec, sizeof(rec), MPI_BYTE, MPI_STATUS_IGNORE);
+	MPI_File_write_at_all(fh, off_star + star_ofst * sizeof(star_t), star+1, (int) nstar, startype, MPI_STATUS_IGNORE);
+	MPI_File_write_at_all(fh, off_bin + bin_ofst * sizeof(binary_t), bins, (int) nbin, bintype, MPI_STATUS_IGNORE);
+	MPI_File_close(&fh);
+
+	MPI_Type_free(&startype);
+	MPI_Type_free(&bintype);
+
+	for (i=1; i<=nstar; i++) {
+		star[i].binind = binind[i];
+	}
+	free(binind);
+	free(bins);
+}
+
+/**
+* @brief Reads a shared checkpoint.  On the number of processors that wrote it
+* every processor gets back exactly what it had.  On any other number the
+* stars are split evenly, in radial order, to be sorted out by the first
+* qsorts_new(); all processors then take the global state of processor 0 and
+* new random streams, jumped past all those of the old run, so the run goes
+* on correctly but does not repeat the original one bit for bit.
+*
+* @param restart_file checkpoint file
+* @param rest set to the global variables of this processor
+*/
+static void load_restart_shared(char *restart_file, restart_struct_t *rest)
+{
+	MPI_File fh;
+	MPI_Offset off_star, off_bin;
+	MPI_Datatype startype, bintype;
+	restart_header_t head;
+	restart_rank_t *recs, rec;
+	long first=0, n, gmin, gmax=0, nb, i;
+	int k, rc;
+
+	rc = MPI_File_open(MPI_COMM_WORLD, restart_file, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+	if (rc != MPI_SUCCESS) {
+		eprintf("can't open restart file %s for reading!\n", restart_file);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+	MPI_File_read_at_all(fh, 0, &head, sizeof(head), MPI_BYTE, MPI_STATUS_IGNORE);
+	if (strncmp(head.tag, RESTART_MAGIC, sizeof(head.tag)) != 0 || head.version != RESTART_VERSION ||
+	    head.endian != RESTART_ENDIAN || head.star_size != sizeof(star_t) || head.binary_size != sizeof(binary_t) ||
+	    head.clus_size != sizeof(clus_struct_t) || head.rest_size != sizeof(restart_struct_t) ||
+	    head.rng_size != sizeof(struct rng_t113_state)) {
+		eprintf("restart file %s was not written by this version of the code on a machine of the same byte order.\n", restart_file);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+	if (head.window_count != snapshot_window_count) {
+		eprintf("restart file %s has %d snapshot windows, but SNAPSHOT_WINDOWS gives %d.\n", restart_file, head.window_count, snapshot_window_count);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+	recs = (restart_rank_t *) malloc(head.nprocs * sizeof(restart_rank_t));
+	MPI_File_read_at_all(fh, sizeof(restart_header_t), recs, head.nprocs * sizeof(restart_rank_t), MPI_BYTE, MPI_STATUS_IGNORE);
+	if (snapshot_window_count) {
+		MPI_File_read_at_all(fh, sizeof(restart_header_t) + head.nprocs * sizeof(restart_rank_t), snapshot_window_counters,
+				     snapshot_window_count, MPI_INT, MPI_STATUS_IGNORE);
+	}
+
+	if (head.nprocs == procs) {
+		for (k=0; k<myid; k++) {
+			first += recs[k].nstar;
+		}
+		n = recs[myid].nstar;
+		rec = recs[myid];
+	} else {
+		if (myid == 0)
+			wprintf("restarting on %d processors from a checkpoint written on %d; the random streams are new, so the run will not repeat the original one bit for bit.\n", procs, head.nprocs);
+		findLimits(head.nstar, MIN_CHUNK_SIZE);
+		first = Start[myid] - 1;
+		n = End[myid] - Start[myid] + 1;
+		rec = recs[0];
+		for (k=0; k<head.nprocs+myid; k++) {
+			rec.rng = rng_t113_jump(rec.rng, JPoly_2_80);
+		}
+		for (k=1; k<head.nprocs; k++) {
+			rec.rest.s_newstarid = MAX(rec.rest.s_newstarid, recs[k].rest.s_newstarid);
+		}
+	}
+	free(recs);
+
+	if (n + 2 > N_STAR_DIM_OPT) {
+		eprintf("%ld stars do not fit into the star array of %ld; restart on more processors.\n", n, N_STAR_DIM_OPT);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+	off_star = sizeof(restart_header_t) + head.nprocs * sizeof(restart_rank_t) + snapshot_window_count * sizeof(int);
+	off_bin = off_star + head.nstar * sizeof(star_t);
+
+	MPI_Type_contiguous(sizeof(star_t), MPI_BYTE, &startype);
+	MPI_Type_commit(&startype);
+	MPI_Type_contiguous(sizeof(binary_t), MPI_BYTE, &bintype);
+	MPI_Type_commit(&bintype);
+
+	MPI_File_read_at_all(fh, off_star + first * sizeof(star_t), star+1, (int) n, startype, MPI_STATUS_IGNORE);
+	star[0] = rec.star0;
+
+	/* the binaries of a run of stars are a run of binaries too */
+	gmin = head.nbin + 1;
+	for (i=1; i<=n; i++) {
+		if (star[i].binind > 0) {
+			gmin = MIN(gmin, star[i].binind);
+			gmax = MAX(gmax, star[i].binind);
+		}
+	}
+	nb = (gmax > 0) ? gmax - gmin + 1 : 0;
+	if (nb + 1 > N_BIN_DIM_OPT) {
+		eprintf("%ld binaries do not fit into the binary array of %ld; restart on more processors.\n", nb, N_BIN_DIM_OPT);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+	MPI_File_read_at_all(fh, off_bin + (nb > 0 ? gmin - 1 : 0) * sizeof(binary_t), binary+1, (int) nb, bintype, MPI_STATUS_IGNORE);
+	for (i=1; i<=n; i++) {
+		if (star[i].binind > 0) {
+			star[i].binind -= gmin - 1;
+		}
+	}
+
+	MPI_File_close(&fh);
+	MPI_Type_free(&startype);
+	MPI_Type_free(&bintype);
+
+	*curr_st = rec.rng;
+	*rest = rec.rest;
+	clus = rec.clus;
+	clus.N_MAX_NEW = n;
+}
+
+/* incremental checkpoints (CHECKPOINT_FULL_INTERVAL) */
+#define CHECKPOINT_BLOCK 65536
+#define CHECKPOINT_DELTA_MAGIC "CMCDELTA"
+
+/**
+* @brief Header of a delta checkpoint.  For each block of the checkpoint that
+* changed since the full checkpoint it is based on, it is followed by the
+* index of the block (long), the length of its zlib stream (int, 0 if the
+* block is stored as it is), and the block.
+*/
+typedef struct{
+/**
+* @brief CHECKPOINT_DELTA_MAGIC, without the terminating null
+*/
+	char tag[8];
+/**
+* @brief number of the full checkpoint
+*/
+	long base;
+/**
+* @brief size of the full checkpoint
+*/
+	long size;
+	int block;
+	long nchanged;
+} checkpoint_delta_t;
+
+/* checksums of the blocks of the last full checkpoint, and its number */
+static unsigned long long *checkpoint_hash=NULL;
+static long checkpoint_nblocks=0, checkpoint_base=-1;
+/* full checkpoint kept back because the oldest checkpoint kept is based on it */
+static long checkpoint_held=-1;
+/* set once checkpoint_held has been recovered from the files of a previous run */
+static int checkpoint_held_recovered=0;
+
+/**
+* @brief Lists the pieces of the per-processor checkpoint, in the order they are written
+*
+* @param seg pieces (at least 6)
+* @param rest global variables
+*
+* @return number of pieces
+*/
+static int checkpoint_segments(checkpoint_seg_t *seg, restart_struct_t *rest)
+{
+	seg[0].p = (char *) curr_st;
+	seg[0].size = sizeof(struct rng_t113_state);
+	seg[0].recsize = 1;
+	seg[1].p = (char *) rest;
+	seg[1].size = sizeof(restart_struct_t);
+	seg[1].recsize = 1;
+	seg[2].p = (char *) &clus;
+	seg[2].size = sizeof(clus_struct_t);
+	seg[2].recsize = 1;
+	seg[3].p = (char *) star;
+	seg[3].size = N_STAR_DIM_OPT * sizeof(star_t);
+	seg[3].recsize = sizeof(star_t);
+	seg[4].p = (char *) binary;
+	seg[4].size = N_BIN_DIM_OPT * sizeof(binary_t);
+	seg[4].recsize = sizeof(binary_t);
+	seg[5].p = (char *) snapshot_window_counters;
+	seg[5].size = snapshot_window_count * sizeof(int);
+	seg[5].recsize = sizeof(int);
+	return(6);
+}
+
+/* kinds of per-processor checkpoint files */
+#define CHECKPOINT_FILE_RAW 0
+#define CHECKPOINT_FILE_COMPRESSED 1
+#define CHECKPOINT_FILE_DELTA 2
+
+/**
+* @brief Finds the file of a per-processor checkpoint, which is a delta
+* (.delta), compressed (.binz) or raw (.bin) checkpoint
+*
+* @param filename set to the name of the file (.bin if there is none)
+* @param folder restart folder
+* @param prefix output prefix of the run that wrote the checkpoint
+* @param num number of the checkpoint
+*
+* @return kind of file, one of CHECKPOINT_FILE_*
+*/
+static int checkpoint_filename(char *filename, char *folder, char *prefix, long num)
+{
+	struct stat st;
+
+	sprintf(filename, "%s/%s.restart.%ld-%d.delta", folder, prefix, num, myid);
+	if (stat(filename, &st) == 0) {
+		return(CHECKPOINT_FILE_DELTA);
+	}
+	sprintf(filename, "%s/%s.restart.%ld-%d.binz", folder, prefix, num, myid);
+	if (stat(filename, &st) == 0) {
+		return(CHECKPOINT_FILE_COMPRESSED);
+	}
+	sprintf(filename, "%s/%s.restart.%ld-%d.bin", folder, prefix, num, myid);
+	return(CHECKPOINT_FILE_RAW);
+}
+
+/**
+* @brief Copies a block of the checkpoint out of the pieces, or back into them
+*
+* @param seg pieces
+* @param nseg number of pieces
+* @param blk index of the block
+* @param buf block
+* @param to_pieces 0 to copy from the pieces into buf, 1 to copy buf into the pieces
+*
+* @return length of the block (less than CHECKPOINT_BLOCK for the last one)
+*/
+static size_t checkpoint_copy_block(checkpoint_seg_t *seg, int nseg, long blk, char *buf, int to_pieces)
+{
+	size_t start=blk*CHECKPOINT_BLOCK, end=start+CHECKPOINT_BLOCK, pos=0, lo, hi, n=0;
+	int k;
+
+	for (k=0; k<nseg && pos<end; k++) {
+		lo = MAX(start, pos);
+		hi = MIN(end, pos + seg[k].size);
+		if (lo < hi) {
+			if (to_pieces) {
+				memcpy(seg[k].p + (lo - pos), buf + (lo - start), hi - lo);
+			} else {
+				memcpy(buf + (lo - start), seg[k].p + (lo - pos), hi - lo);
+			}
+			n += hi - lo;
+		}
+		pos += seg[k].size;
+	}
+	return(n);
+}
+
+/**
+* @brief 64-bit checksum of a block
+*
+* @param p block
+* @param n length
+*
+* @return checksum
+*/
+static unsigned long long checkpoint_checksum(const char *p, size_t n)
+{
+	unsigned long long h=0x9e3779b97f4a7c15ULL ^ n, w;
+	size_t i;
+
+	for (i=0; i+8<=n; i+=8) {
+		memcpy(&w, p+i, 8);
+		h = (h ^ w) * 0xff51afd7ed558ccdULL;
+		h ^= h >> 32;
+	}
+	for (; i<n; i++) {
+		h = (h ^ (unsigned char) p[i]) * 0x100000001b3ULL;
+	}
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return(h);
+}
+
+/**
+* @brief Number of blocks in a checkpoint
+*
+* @param seg pieces
+* @param nseg number of pieces
+*
+* @return number of blocks
+*/
+static long checkpoint_count_blocks(checkpoint_seg_t *seg, int nseg)
+{
+	size_t size=0;
+	int k;
+
+	for (k=0; k<nseg; k++) {
+		size += seg[k].size;
+	}
+	return((size + CHECKPOINT_BLOCK - 1) / CHECKPOINT_BLOCK);
+}
+
+/**
+* @brief Keeps the checksums of the blocks of a full checkpoint, for the delta checkpoints to come
+*
+* @param seg pieces
+* @param nseg number of pieces
+* @param num number of the checkpoint
+*/
+static void checkpoint_set_base(checkpoint_seg_t *seg, int nseg, long num)
+{
+	char *buf;
+	size_t n;
+	long i;
+
+	checkpoint_nblocks = checkpoint_count_blocks(seg, nseg);
+	checkpoint_hash = (unsigned long long *) realloc(checkpoint_hash, checkpoint_nblocks * sizeof(unsigned long long));
+	buf = (char *) malloc(CHECKPOINT_BLOCK);
+	for (i=0; i<checkpoint_nblocks; i++) {
+		n = checkpoint_copy_block(seg, nseg, i, buf, 0);
+		checkpoint_hash[i] = checkpoint_checksum(buf, n);
+	}
+	free(buf);
+	checkpoint_base = num;
+}
+
+/**
+* @brief Writes the blocks of the checkpoint that changed since the last full one
+*
+* @param filename delta checkpoint file
+* @param seg pieces
+* @param nseg number of pieces
+*
+* @return number of blocks written
+*/
+static long checkpoint_write_delta(char *filename, checkpoint_seg_t *seg, int nseg)
+{
+	FILE *fp;
+	checkpoint_delta_t head;
+	char *buf, *zbuf;
+	uLongf zlen;
+	size_t n;
+	long i;
+	int len, err=0;
+
+	if ((fp = fopen(filename, "wb")) == NULL) {
+		eprintf("can't open restart file %s for writing!\n", filename);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+	memset(&head, 0, sizeof(head));
+	memcpy(head.tag, CHECKPOINT_DELTA_MAGIC, sizeof(head.tag));
+	head.base = checkpoint_base;
+	head.size = 0;
+	for (i=0; i<nseg; i++) {
+		head.size += seg[i].size;
+	}
+	head.block = CHECKPOINT_BLOCK;
+	/* marks the file as incomplete until the header is written again at the end */
+	head.nchanged = -1;
+	err |= (fwrite(&head, sizeof(head), 1, fp) != 1);
+	head.nchanged = 0;
+
+	buf = (char *) malloc(CHECKPOINT_BLOCK);
+	zbuf = (char *) malloc(compressBound(CHECKPOINT_BLOCK));
+	for (i=0; i<checkpoint_nblocks && !err; i++) {
+		n = checkpoint_copy_block(seg, nseg, i, buf, 0);
+		if (checkpoint_checksum(buf, n) == checkpoint_hash[i]) {
+			continue;
+		}
+		zlen = compressBound(CHECKPOINT_BLOCK);
+		if (compress2((Bytef *) zbuf, &zlen, (Bytef *) buf, n, 1) == Z_OK && zlen < n) {
+			len = zlen;
+			err |= (fwrite(&i, sizeof(long), 1, fp) != 1 || fwrite(&len, sizeof(int), 1, fp) != 1 ||
+				fwrite(zbuf, 1, zlen, fp) != zlen);
+		} else {
+			len = 0;
+			err |= (fwrite(&i, sizeof(long), 1, fp) != 1 || fwrite(&len, sizeof(int), 1, fp) != 1 ||
+				fwrite(buf, 1, n, fp) != n);
+		}
+		head.nchanged++;
+	}
+	free(buf);
+	free(zbuf);
+
+	/* now that it is known, fill in the number of blocks */
+	if (!err) {
+		err |= (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&head, sizeof(head), 1, fp) != 1);
+	}
+	if (fclose(fp) != 0 || err) {
+		eprintf("could not write restart file %s\n", filename);
+		remove(filename);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+	return(head.nchanged);
+}
+
+/**
+* @brief Applies a delta checkpoint on top of the full checkpoint it is based on, which is already loaded
+*
+* @param fp delta checkpoint file, just past the header
+* @param head header of the delta checkpoint
+* @param filename name of the delta checkpoint file
+* @param rest global variables
+*/
+static void checkpoint_apply_delta(FILE *fp, checkpoint_delta_t *head, char *filename, restart_struct_t *rest)
+{
+	checkpoint_seg_t seg[CHECKPOINT_MAXSEG];
+	char *buf, *zbuf;
+	uLongf ulen;
+	size_t n, size=0;
+	long i, k;
+	int nseg, len;
+
+	nseg = checkpoint_segments(seg, rest);
+	for (k=0; k<nseg; k++) {
+		size += seg[k].size;
+	}
+	if (head->nchanged < 0) {
+		eprintf("restart file %s was not completely written.\n", filename);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+	if (head->size != size || head->block != CHECKPOINT_BLOCK) {
+		eprintf("restart file %s does not match the arrays of this run.\n", filename);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+	buf = (char *) malloc(CHECKPOINT_BLOCK);
+	zbuf = (char *) malloc(compressBound(CHECKPOINT_BLOCK));
+	for (k=0; k<head->nchanged; k++) {
+		if (fread(&i, sizeof(long), 1, fp) != 1 || fread(&len, sizeof(int), 1, fp) != 1 ||
+		    i < 0 || i * CHECKPOINT_BLOCK >= size || len < 0 || (uLong) len > compressBound(CHECKPOINT_BLOCK)) {
+			eprintf("restart file %s is corrupt.\n", filename);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+		n = MIN(CHECKPOINT_BLOCK, size - i * CHECKPOINT_BLOCK);
+		if (len > 0) {
+			ulen = n;
+			if (fread(zbuf, 1, len, fp) != (size_t) len ||
+			    uncompress((Bytef *) buf, &ulen, (Bytef *) zbuf, len) != Z_OK || ulen != n) {
+				eprintf("restart file %s is corrupt.\n", filename);
+				exit_cleanly(-1, __FUNCTION__);
+			}
+		} else if (fread(buf, 1, n, fp) != n) {
+			eprintf("restart file %s is corrupt.\n", filename);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+		checkpoint_copy_block(seg, nseg, i, buf, 1);
+	}
+	free(buf);
+	free(zbuf);
+}
+
+/**
+* @brief Number of the full checkpoint a checkpoint is restored from
+*
+* @param folder restart folder
+* @param num number of the checkpoint
+*
+* @return number of the full checkpoint, num itself if it is one
+*/
+static long checkpoint_base_of(char *folder, long num)
+{
+	char filename[300];
+	checkpoint_delta_t head;
+	FILE *fp;
+	long base=num;
+
+	sprintf(filename, "%s/%s.restart.%ld-%d.delta", folder, outprefix, num, myid);
+	if ((fp = fopen(filename, "rb")) != NULL) {
+		if (fread(&head, sizeof(head), 1, fp) == 1) {
+			base = head.base;
+		}
+		fclose(fp);
+	}
+	return(base);
+}
+
+/**
+* @brief Removes the per-processor checkpoint files of a number that are in another format than the one about to be written; a run restarted from an earlier checkpoint otherwise leaves them behind, and a delta checkpoint would be loaded instead of the new one
+*
+* @param folder restart folder
+* @param num number of the checkpoint
+* @param keep name of the file about to be written
+*/
+static void checkpoint_remove_stale(char *folder, long num, char *keep)
+{
+	const char *ext[3] = {"bin", "binz", "delta"};
+	char filename[300];
+	int k;
+
+	for (k=0; k<3; k++) {
+		sprintf(filename, "%s/%s.restart.%ld-%d.%s", folder, outprefix, num, myid, ext[k]);
+		if (strcmp(filename, keep) != 0) {
+			remove(filename);
+		}
+	}
+}
+
 void save_restart_file(){
 	FILE *my_restart_file;
 	char restart_file[200];
@@ -3719,6 +4816,9 @@ void save_restart_file(){
 	int num_bin=0;
 	struct stat folder_thing = {0};
 	restart_struct_t restart_struct;
+	checkpoint_seg_t seg[CHECKPOINT_MAXSEG];
+	int nseg=0, delta=0;
+	long held_to_delete=-1, need, nchanged=0;
 	
 	sprintf(restart_folder, "./%s-RESTART", outprefix);
 	sprintf(restart_file, "%s/%s.restart.%ld-%d.bin",restart_folder,outprefix,NEXT_RESTART,myid);
@@ -3729,13 +4829,6 @@ void save_restart_file(){
 		mkdir(restart_folder, 0700);
 	}
 
-	my_restart_file = fopen(restart_file,"wb");
-	if (!my_restart_file){
-		eprintf("can't open restart file %s for writing!\n",restart_file);
-		exit_cleanly(-1, __FUNCTION__);
-	}
-
-	
 	/*Save the entire star and binary arrays, including the many empty stars at
 	 * the end; easier this way, and it ensures a bit-by-bit restart (also, the
 	 * N_*_DIM_OPT are never updated, and should be the same as when the
@@ -3743,24 +4836,128 @@ void save_restart_file(){
 	clus.N_BINARY = N_b;
 	save_global_vars(&restart_struct);
 
-	fwrite(curr_st, sizeof(struct rng_t113_state), 1, my_restart_file);
-	fwrite(&restart_struct, sizeof(restart_struct_t), 1, my_restart_file);
-	fwrite(&clus, sizeof(clus_struct_t), 1, my_restart_file);
-	fwrite(star, sizeof(star_t), N_STAR_DIM_OPT, my_restart_file);
-	fwrite(binary, sizeof(binary_t), N_BIN_DIM_OPT, my_restart_file);
-	fwrite(snapshot_window_counters, sizeof(int), snapshot_window_count, my_restart_file);
-
-	fclose(my_restart_file);
+	/*With incremental checkpoints, only the blocks that changed since the last
+	 * full checkpoint are written, until it is time for a full one again (the
+	 * first checkpoint of a run, restarted or not, is always full)*/
+	if (RESTART_FORMAT == 0) {
+		nseg = checkpoint_segments(seg, &restart_struct);
+		if (CHECKPOINT_FULL_INTERVAL > 1) {
+			delta = (checkpoint_hash != NULL && checkpoint_nblocks == checkpoint_count_blocks(seg, nseg) &&
+				 NEXT_RESTART - checkpoint_base < CHECKPOINT_FULL_INTERVAL);
+		}
+		if (delta) {
+			sprintf(restart_file, "%s/%s.restart.%ld-%d.delta",restart_folder,outprefix,NEXT_RESTART,myid);
+		} else if (CHECKPOINT_COMPRESS != CHECKPOINT_COMPRESS_NONE) {
+			sprintf(restart_file, "%s/%s.restart.%ld-%d.binz",restart_folder,outprefix,NEXT_RESTART,myid);
+		}
+		checkpoint_remove_stale(restart_folder, NEXT_RESTART, restart_file);
+	}
 
-	/*Delete the last restart (or the last after however many we want to keep)*/
+	/*The last restart (or the last after however many we want to keep), to be
+	 * deleted once this one is written*/
 	long restart_to_delete = NEXT_RESTART - CHECKPOINTS_TO_KEEP;
+	delete_file[0] = '\0';
 	if ((restart_to_delete > 0) && (CHECKPOINTS_TO_KEEP != 0)){
-		sprintf(delete_file, "%s/%s.restart.%ld-%d.bin",restart_folder,outprefix,restart_to_delete,myid);
+		if (RESTART_FORMAT == 1) {
+			sprintf(delete_file, "%s/%s.restart.%ld.bin",restart_folder,outprefix,restart_to_delete);
+		} else if (CHECKPOINT_FULL_INTERVAL > 1) {
+			/*After a restart, the full checkpoint the previous run held back
+			 * is the one the oldest checkpoint still kept is restored from*/
+			if (!checkpoint_held_recovered) {
+				need = checkpoint_base_of(restart_folder, restart_to_delete);
+				if (need < restart_to_delete)
+					checkpoint_held = need;
+				checkpoint_held_recovered = 1;
+			}
+			/*A full checkpoint is kept back as long as the oldest checkpoint
+			 * kept is restored from it*/
+			if (restart_to_delete + 1 == NEXT_RESTART)
+				need = delta ? checkpoint_base : NEXT_RESTART;
+			else
+				need = checkpoint_base_of(restart_folder, restart_to_delete + 1);
+			if (checkpoint_held > 0 && checkpoint_held != need) {
+				held_to_delete = checkpoint_held;
+				checkpoint_held = -1;
+			}
+			if (restart_to_delete == need) {
+				checkpoint_held = restart_to_delete;
+			} else {
+				checkpoint_filename(delete_file, restart_folder, outprefix, restart_to_delete);
+			}
+		} else {
+			checkpoint_filename(delete_file, restart_folder, outprefix, restart_to_delete);
+		}
+	}
+
+	if (delta) {
+		nchanged = checkpoint_write_delta(restart_file, seg, nseg);
+		if (delete_file[0] != '\0') {
+			remove(delete_file);
+		}
+	} else if (RESTART_FORMAT == 1) {
+		/*One file for all processors, written collectively, so it is not
+		 * handed to the I/O thread of ASYNC_IO (which makes no MPI calls)*/
+		sprintf(restart_file, "%s/%s.restart.%ld.bin",restart_folder,outprefix,NEXT_RESTART);
+		save_restart_shared(restart_file, &restart_struct);
+		if (myid == 0 && delete_file[0] != '\0') {
+			remove(delete_file);
+		}
+	} else if (ASYNC_IO) {
+		/*Copy everything into the staging buffer and let the I/O thread
+		 * compress it, write it out and delete the old restart once the new
+		 * one is there*/
+		checkpoint_seg_t staged[CHECKPOINT_MAXSEG];
+		size_t size=0, off=0;
+		char *buf;
+
+		for (i=0; i<nseg; i++) {
+			size += seg[i].size;
+		}
+		buf = aio_checkpoint_buffer(size);
+		for (i=0; i<nseg; i++) {
+			if (seg[i].size > 0) {
+				memcpy(buf+off, seg[i].p, seg[i].size);
+			}
+			staged[i] = seg[i];
+			staged[i].p = buf+off;
+			off += seg[i].size;
+		}
+		aio_checkpoint_submit(restart_file, staged, nseg, CHECKPOINT_COMPRESS, delete_file[0] != '\0' ? delete_file : NULL);
+	} else {
+		my_restart_file = fopen(restart_file,"wb");
+		if (!my_restart_file){
+			eprintf("can't open restart file %s for writing!\n",restart_file);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+
+		if (checkpoint_write(my_restart_file, seg, nseg, CHECKPOINT_COMPRESS) != 0 || fclose(my_restart_file) != 0) {
+			eprintf("could not write restart file %s\n",restart_file);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+
+		if (delete_file[0] != '\0') {
+			remove(delete_file);
+		}
+	}
+
+	if (CHECKPOINT_FULL_INTERVAL > 1 && nseg > 0 && !delta) {
+		checkpoint_set_base(seg, nseg, NEXT_RESTART);
+	}
+
+	/*A full checkpoint no longer needed; the checkpoint now restored from
+	 * another one may still be being written by the I/O thread, though*/
+	if (held_to_delete > 0) {
+		if (ASYNC_IO) aio_wait();
+		checkpoint_filename(delete_file, restart_folder, outprefix, held_to_delete);
 		remove(delete_file);
 	}
 
 	rootprintf("******************************************************************************\n");
-	rootprintf("Saving checkpoint %ld at time %g in folder %s\n",NEXT_RESTART,TotalTime,restart_folder);
+	if (delta) {
+		rootprintf("Saving checkpoint %ld at time %g in folder %s (%ld blocks changed since checkpoint %ld on node 0)\n",NEXT_RESTART,TotalTime,restart_folder,nchanged,checkpoint_base);
+	} else {
+		rootprintf("Saving checkpoint %ld at time %g in folder %s\n",NEXT_RESTART,TotalTime,restart_folder);
+	}
 	rootprintf("******************************************************************************\n");
 		
 	NEXT_RESTART += 1;
@@ -3776,41 +4973,73 @@ void load_restart_file(){
 	struct stat folder_thing = {0};
 	restart_struct_t restart_struct;
     long local_restart = RESTART_TCOUNT > 0 ? RESTART_TCOUNT : -RESTART_TCOUNT;
+	FILE *delta_file=NULL;
+	checkpoint_delta_t delta;
+	char delta_name[200];
+	checkpoint_seg_t seg[CHECKPOINT_MAXSEG];
+	int kind;
 
 	sprintf(restart_folder, "./%s-RESTART", oldoutprefix);
-	sprintf(restart_file, "%s/%s.restart.%ld-%d.bin",restart_folder,oldoutprefix,local_restart,myid);
 
 	if (stat(restart_folder,&folder_thing) == -1) {
 		eprintf("can't find the restart folder %s\n",restart_folder);
 		exit_cleanly(-1, __FUNCTION__);
 	}
 
-	my_restart_file = fopen(restart_file,"rb");
-	if (!my_restart_file){
-		eprintf("can't open restart file %s for writing!\n",restart_file);
-		exit_cleanly(-1, __FUNCTION__);
-	}
-
-	/*These must be allocated here for the binary files to load correctly*/
-	star = (star_t *) malloc(N_STAR_DIM_OPT*sizeof(star_t));
-	binary = (binary_t *) malloc(N_BIN_DIM_OPT*sizeof(binary_t));
-	curr_st = (struct rng_t113_state*) malloc(sizeof(struct rng_t113_state));
-
 	/*Set the units using the original data from the fits file*/
 	units_set();
-	
-	/*Load the entire star and binaries arrays at once.  Because this is done in
-	 * a single chunk of memory and with the same size of arrays as was
-	 * generated from the FITS file, this should load the exact local state into
-	 * each file*/
-	fread(curr_st, sizeof(struct rng_t113_state), 1, my_restart_file);
-	fread(&restart_struct, sizeof(restart_struct_t), 1, my_restart_file);
-	fread(&clus, sizeof(clus_struct_t), 1, my_restart_file);
-	fread(star, sizeof(star_t), N_STAR_DIM_OPT, my_restart_file);
-	fread(binary, sizeof(binary_t), N_BIN_DIM_OPT, my_restart_file);
-	fread(snapshot_window_counters, sizeof(int), snapshot_window_count, my_restart_file);
-
-	fclose(my_restart_file);
+
+	/*A shared checkpoint (RESTART_FORMAT=1) is used if there is one, whatever
+	 * RESTART_FORMAT is set to now*/
+	sprintf(restart_file, "%s/%s.restart.%ld.bin",restart_folder,oldoutprefix,local_restart);
+	if (stat(restart_file,&folder_thing) == 0) {
+		star = (star_t *) calloc(N_STAR_DIM_OPT, sizeof(star_t));
+		binary = (binary_t *) calloc(N_BIN_DIM_OPT, sizeof(binary_t));
+		curr_st = (struct rng_t113_state*) malloc(sizeof(struct rng_t113_state));
+
+		load_restart_shared(restart_file, &restart_struct);
+	} else {
+		/*A delta checkpoint (CHECKPOINT_FULL_INTERVAL) is restored by loading
+		 * the full checkpoint it is based on, then the blocks that changed*/
+		kind = checkpoint_filename(restart_file, restart_folder, oldoutprefix, local_restart);
+		if (kind == CHECKPOINT_FILE_DELTA) {
+			strcpy(delta_name, restart_file);
+			delta_file = fopen(restart_file,"rb");
+			if (!delta_file || fread(&delta, sizeof(checkpoint_delta_t), 1, delta_file) != 1 ||
+			    strncmp(delta.tag, CHECKPOINT_DELTA_MAGIC, sizeof(delta.tag)) != 0) {
+				eprintf("restart file %s is corrupt.\n",restart_file);
+				exit_cleanly(-1, __FUNCTION__);
+			}
+			kind = checkpoint_filename(restart_file, restart_folder, oldoutprefix, delta.base);
+		}
+
+		my_restart_file = fopen(restart_file,"rb");
+		if (!my_restart_file){
+			eprintf("can't open restart file %s for reading!\n",restart_file);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+
+		/*These must be allocated here for the binary files to load correctly*/
+		star = (star_t *) malloc(N_STAR_DIM_OPT*sizeof(star_t));
+		binary = (binary_t *) malloc(N_BIN_DIM_OPT*sizeof(binary_t));
+		curr_st = (struct rng_t113_state*) malloc(sizeof(struct rng_t113_state));
+
+		/*Load the entire star and binaries arrays at once.  Because this is done in
+		 * a single chunk of memory and with the same size of arrays as was
+		 * generated from the FITS file, this should load the exact local state into
+		 * each file*/
+		if (checkpoint_read(my_restart_file, seg, checkpoint_segments(seg, &restart_struct), kind == CHECKPOINT_FILE_COMPRESSED) != 0) {
+			eprintf("restart file %s is corrupt or was written with different arrays.\n",restart_file);
+			exit_cleanly(-1, __FUNCTION__);
+		}
+
+		fclose(my_restart_file);
+
+		if (delta_file != NULL) {
+			checkpoint_apply_delta(delta_file, &delta, delta_name, &restart_struct);
+			fclose(delta_file);
+		}
+	}
 
 	/*Set the random number generator back where it was*/
 	set_rng_t113(*curr_st);
@@ -3856,19 +5085,19 @@ void load_restart_file(){
              MPI_File_seek(mpi_morepulsarfile,mpi_morepulsarfile_ofst_total,MPI_SEEK_SET);
         }
     } else{
-        mpi_logfile_len=0;
-        mpi_escfile_len=0;
-        mpi_binintfile_len=0;
-        mpi_collisionfile_len=0;
-        mpi_tidalcapturefile_len=0;
-        mpi_semergedisruptfile_len=0;
-        mpi_removestarfile_len=0;
-        mpi_relaxationfile_len=0;
-        mpi_pulsarfile_len=0;
-	mpi_morepulsarfile_len=0;
-	mpi_triplefile_len=0;
-	mpi_newbhfile_len=0;
-	mpi_bhmergerfile_len=0;
+        parabuf_truncate(&mpi_logfile_wrbuf, 0);
+        parabuf_truncate(&mpi_escfile_wrbuf, 0);
+        parabuf_truncate(&mpi_binintfile_wrbuf, 0);
+        parabuf_truncate(&mpi_collisionfile_wrbuf, 0);
+        parabuf_truncate(&mpi_tidalcapturefile_wrbuf, 0);
+        parabuf_truncate(&mpi_semergedisruptfile_wrbuf, 0);
+        parabuf_truncate(&mpi_removestarfile_wrbuf, 0);
+        parabuf_truncate(&mpi_relaxationfile_wrbuf, 0);
+        parabuf_truncate(&mpi_pulsarfile_wrbuf, 0);
+	parabuf_truncate(&mpi_morepulsarfile_wrbuf, 0);
+	parabuf_truncate(&mpi_triplefile_wrbuf, 0);
+	parabuf_truncate(&mpi_newbhfile_wrbuf, 0);
+	parabuf_truncate(&mpi_bhmergerfile_wrbuf, 0);
 
         mpi_logfile_ofst_total=0;
         mpi_escfile_ofst_total=0;
@@ -0,0 +1,110 @@
+/* vi: set filetype=c.doxygen: */
+/* Turns a binary event log written with BINARY_LOGS=1 back into the text
+   file the run would otherwise have written. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmc_evlog.h"
+
+/**
+* @brief prints the usage
+*
+* @param stream output stream
+* @param argv0 name of the program
+*/
+static void print_usage(FILE *stream, char *argv0)
+{
+	fprintf(stream, "USAGE:\n");
+	fprintf(stream, "  %s <infile> [outfile]\n", argv0);
+	fprintf(stream, "\n");
+	fprintf(stream, "Converts a binary event log (<prefix>.esc.bin, .collision.bin, .semergedisrupt.bin\n");
+	fprintf(stream, "or .bhmerger.bin) into its text form (e.g. <prefix>.esc.dat).  The text goes to\n");
+	fprintf(stream, "stdout if no outfile is given.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *in, *out=stdout;
+	evlog_header_t head;
+	union {
+		evlog_esc_t esc;
+		evlog_coll_t coll;
+		evlog_semerge_t semerge;
+		evlog_bhmerger_t bhmerger;
+	} rec;
+	const char *header;
+	size_t recsize;
+	char line[EVLOG_LINE_LEN];
+	long nrec=0;
+
+	if (argc < 2 || argc > 3 || strcmp(argv[1], "-h") == 0) {
+		print_usage(argc < 2 ? stderr : stdout, argv[0]);
+		return(argc < 2 || argc > 3 ? 1 : 0);
+	}
+
+	if ((in = fopen(argv[1], "rb")) == NULL) {
+		fprintf(stderr, "cannot open input file \"%s\".\n", argv[1]);
+		return(1);
+	}
+	if (fread(&head, sizeof(head), 1, in) != 1) {
+		head.type = 0;
+	}
+	switch (head.type) {
+	case EVLOG_ESC:
+		header = evlog_esc_header;
+		recsize = sizeof(evlog_esc_t);
+		break;
+	case EVLOG_COLL:
+		header = evlog_coll_header;
+		recsize = sizeof(evlog_coll_t);
+		break;
+	case EVLOG_SEMERGE:
+		header = evlog_semerge_header;
+		recsize = sizeof(evlog_semerge_t);
+		break;
+	case EVLOG_BHMERGER:
+		header = evlog_bhmerger_header;
+		recsize = sizeof(evlog_bhmerger_t);
+		break;
+	default:
+		header = NULL;
+		recsize = 0;
+		break;
+	}
+	if (header == NULL || evlog_header_check(&head, head.type, recsize) != 0) {
+		fprintf(stderr, "\"%s\" is not an event log written by this version of the code on a machine of the same byte order.\n", argv[1]);
+		return(1);
+	}
+	if (argc == 3 && (out = fopen(argv[2], "w")) == NULL) {
+		fprintf(stderr, "cannot create output file \"%s\".\n", argv[2]);
+		return(1);
+	}
+
+	fputs(header, out);
+	while (fread(&rec, recsize, 1, in) == 1) {
+		switch (head.type) {
+		case EVLOG_ESC:
+			evlog_esc_format(line, sizeof(line), &rec.esc);
+			break;
+		case EVLOG_COLL:
+			evlog_coll_format(line, sizeof(line), &rec.coll);
+			break;
+		case EVLOG_SEMERGE:
+			evlog_semerge_format(line, sizeof(line), &rec.semerge);
+			break;
+		case EVLOG_BHMERGER:
+			evlog_bhmerger_format(line, sizeof(line), &rec.bhmerger);
+			break;
+		}
+		fputs(line, out);
+		nrec++;
+	}
+	if (!feof(in)) {
+		fprintf(stderr, "error reading \"%s\" after %ld records.\n", argv[1], nrec);
+		return(1);
+	}
+
+	fclose(in);
+	if (out != stdout) fclose(out);
+	return(0);
+}
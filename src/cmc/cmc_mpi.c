@@ -158,6 +158,150 @@ MPI_Comm inv_comm_create(int procs, MPI_Comm old_comm)
 	return new_comm;
 }
 
+/**
+* @brief Resets an exact accumulator to zero.
+*
+* @param s accumulator
+*/
+void exact_sum_init(exact_sum_t *s)
+{
+	memset(s, 0, sizeof(exact_sum_t));
+}
+
+/**
+* @brief Propagates the carries so that every digit but the most significant one lies in [0, 2^32).  The most significant digit carries the sign.  The resulting representation of a given value is unique.
+*
+* @param s accumulator
+*/
+static void exact_sum_normalize(exact_sum_t *s)
+{
+	int i;
+	long long lo;
+
+	for (i=0; i<EXACT_SUM_NDIGIT-1; i++) {
+		lo = s->d[i] & 0xffffffffLL;
+		s->d[i+1] += (s->d[i] - lo) / 4294967296LL;
+		s->d[i] = lo;
+	}
+	s->nadd = 0;
+}
+
+/**
+* @brief Adds x to the accumulator without any rounding.
+*
+* @param s accumulator
+* @param x value to add
+*/
+void exact_sum_add(exact_sum_t *s, double x)
+{
+	int e, shift, idx, off;
+	long long m, lo, sign;
+
+	if (x == 0.0) return;
+	if (!isfinite(x)) {
+		s->special += x;
+		return;
+	}
+
+	/* |x| = m * 2^(e-53) with m a 53-bit integer; shift is the position of
+	   the lowest bit of m relative to 2^-1074 */
+	sign = (x < 0.0) ? -1 : 1;
+	m = (long long) ldexp(frexp(fabs(x), &e), 53);
+	shift = e - 53 + 1074;
+	if (shift < 0) {
+		/* subnormal: the dropped bits are all zero */
+		m >>= -shift;
+		shift = 0;
+	}
+	idx = shift / 32;
+	off = shift % 32;
+
+	lo = (m & ((1LL << (32 - off)) - 1)) << off;
+	m >>= 32 - off;
+	s->d[idx] += sign * lo;
+	s->d[idx+1] += sign * (m & 0xffffffffLL);
+	s->d[idx+2] += sign * (m >> 32);
+
+	/* each addition changes a digit by less than 2^32; propagate the carries
+	   long before a 64-bit slot can overflow */
+	if (++s->nadd >= (1L << 30)) {
+		exact_sum_normalize(s);
+	}
+}
+
+/**
+* @brief Rounds the accumulated sum to a double.  Since the conversion starts from the unique normalized representation, the result depends only on the exact value of the sum.
+*
+* @param s accumulator
+*
+* @return the sum
+*/
+double exact_sum_value(exact_sum_t *s)
+{
+	exact_sum_t t = *s;
+	double sign = 1.0, v = 0.0;
+	int i;
+
+	exact_sum_normalize(&t);
+	if (t.d[EXACT_SUM_NDIGIT-1] < 0) {
+		for (i=0; i<EXACT_SUM_NDIGIT; i++) {
+			t.d[i] = -t.d[i];
+		}
+		exact_sum_normalize(&t);
+		sign = -1.0;
+	}
+
+	for (i=0; i<EXACT_SUM_NDIGIT; i++) {
+		if (t.d[i] != 0) {
+			v += ldexp((double) t.d[i], 32 * i - 1074);
+		}
+	}
+
+	return sign * v + s->special;
+}
+
+/**
+* @brief MPI user operation adding exact accumulators element-wise.  The inputs are normalized, so the digit sums cannot overflow.
+*/
+static void exact_sum_op(void *in, void *inout, int *len, MPI_Datatype *datatype)
+{
+	exact_sum_t *a = (exact_sum_t *) in, *b = (exact_sum_t *) inout;
+	int i, k;
+
+	for (k=0; k<*len; k++) {
+		for (i=0; i<EXACT_SUM_NDIGIT; i++) {
+			b[k].d[i] += a[k].d[i];
+		}
+		b[k].special += a[k].special;
+		exact_sum_normalize(&b[k]);
+	}
+}
+
+/**
+* @brief Sums an array of exact accumulators across all processors in comm, in place.  Unlike MPI_SUM over doubles, the result is bitwise identical for any reduction order and any number of processors.
+*
+* @param s array of accumulators
+* @param count number of accumulators
+* @param comm communicator
+*/
+void exact_sum_allreduce(exact_sum_t *s, int count, MPI_Comm comm)
+{
+	static MPI_Datatype type = MPI_DATATYPE_NULL;
+	static MPI_Op op = MPI_OP_NULL;
+	int i;
+
+	if (type == MPI_DATATYPE_NULL) {
+		MPI_Type_contiguous(sizeof(exact_sum_t), MPI_BYTE, &type);
+		MPI_Type_commit(&type);
+		MPI_Op_create(exact_sum_op, 1, &op);
+	}
+
+	for (i=0; i<count; i++) {
+		exact_sum_normalize(&s[i]);
+	}
+	MPI_Allreduce(MPI_IN_PLACE, s, count, type, op, comm);
+}
+
 //Function to find start index (displacement) and length for each processor for a loop over N. Not used anymore.
 /*
 void mpiFindDispAndLen( long N, int* mpiDisp, int* mpiLen )
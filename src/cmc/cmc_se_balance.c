@@ -0,0 +1,525 @@
+/* vi: set filetype=c.doxygen: */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "cmc.h"
+#include "cmc_vars.h"
+#include "bse_wrap.h"
+
+/* single-star BSE tasks of this timestep that were evolved on other processors */
+static se_task_t *se_balance_tasks = NULL;
+/* single-star BSE tasks of this timestep that stayed here, evolved while the others were away */
+static se_task_t *se_balance_own = NULL;
+/* position of each local star in se_balance_tasks (-1 if it stayed here) */
+static long *se_balance_slot = NULL;
+/* position of each local star in se_balance_own (-1 if it was not evolved ahead) */
+static long *se_balance_own_slot = NULL;
+static long se_balance_nslot = 0;
+
+/**
+* @brief Copies the BSE state of a single star into a task.
+*
+* @param t task
+* @param k local index of the star
+*/
+void se_task_from_star(se_task_t *t, long k)
+{
+	t->k = k;
+	t->id = star[k].id;
+	t->zams_mass = star[k].zams_mass;
+	t->kw = star[k].se_k;
+	t->mass0 = star[k].se_mass;
+	t->mt = star[k].se_mt;
+	t->radius = star[k].se_radius;
+	t->lum = star[k].se_lum;
+	t->mc = star[k].se_mc;
+	t->rc = star[k].se_rc;
+	t->menv = star[k].se_menv;
+	t->renv = star[k].se_renv;
+	t->ospin = star[k].se_ospin;
+	t->B_0 = star[k].se_B_0;
+	t->bacc = star[k].se_bacc;
+	t->tacc = star[k].se_tacc;
+	t->epoch = star[k].se_epoch;
+	t->tms = star[k].se_tms;
+	t->bhspin = star[k].se_bhspin;
+	t->tphys = star[k].se_tphys;
+	t->scm_formation = star[k].se_scm_formation;
+	t->scm_B = star[k].se_scm_B;
+	t->cost = 0.0;
+}
+
+/**
+* @brief Copies the evolved BSE state of a task back into its star.
+*
+* @param t task
+* @param k local index of the star
+*/
+void se_task_to_star(se_task_t *t, long k)
+{
+	star[k].se_k = t->kw;
+	star[k].se_mass = t->mass0;
+	star[k].se_mt = t->mt;
+	star[k].se_radius = t->radius;
+	star[k].se_lum = t->lum;
+	star[k].se_mc = t->mc;
+	star[k].se_rc = t->rc;
+	star[k].se_menv = t->menv;
+	star[k].se_renv = t->renv;
+	star[k].se_ospin = t->ospin;
+	star[k].se_B_0 = t->B_0;
+	star[k].se_bacc = t->bacc;
+	star[k].se_tacc = t->tacc;
+	star[k].se_epoch = t->epoch;
+	star[k].se_tms = t->tms;
+	star[k].se_bhspin = t->bhspin;
+	star[k].se_tphys = t->tphys;
+	star[k].se_scm_formation = t->scm_formation;
+	star[k].se_scm_B = t->scm_B;
+	star[k].se_cost = t->cost;
+}
+
+/**
+* @brief Evolves a single star to tphysf with BSE, and extracts the pulsar
+* information from the bcm array.  Only uses the task, so the star may live on
+* another processor.
+*
+* @param t task, updated in place
+* @param tphysf time to evolve to (Myr)
+*/
+void se_evolve_single_bse(se_task_t *t, double tphysf)
+{
+	binary_t tempbinary;
+	double dtp = 0.0, tstart;
+	int i, reduced_timestep = 0;
+
+	/* Update star id for pass through. */
+	bse_set_id1_pass(t->id);
+	bse_set_id2_pass(0);
+	tempbinary.bse_mass0[0] = t->mass0;
+	tempbinary.bse_mass0[1] = 0.0;
+	tempbinary.bse_kw[0] = t->kw;
+	tempbinary.bse_kw[1] = 15;
+	tempbinary.bse_mass[0] = t->mt;
+	tempbinary.bse_mass[1] = 0.0;
+	tempbinary.bse_radius[0] = t->radius;
+	tempbinary.bse_radius[1] = 0.0;
+	tempbinary.bse_lum[0] = t->lum;
+	tempbinary.bse_lum[1] = 0.0;
+	tempbinary.bse_massc[0] = t->mc;
+	tempbinary.bse_massc[1] = 0.0;
+	tempbinary.bse_radc[0] = t->rc;
+	tempbinary.bse_radc[1] = 0.0;
+	tempbinary.bse_menv[0] = t->menv;
+	tempbinary.bse_menv[1] = 0.0;
+	tempbinary.bse_renv[0] = t->renv;
+	tempbinary.bse_renv[1] = 0.0;
+	tempbinary.bse_ospin[0] = t->ospin;
+	tempbinary.bse_ospin[1] = 0.0;
+	tempbinary.bse_B_0[0] = t->B_0;
+	tempbinary.bse_B_0[1] = 0.0;
+	tempbinary.bse_bacc[0] = t->bacc;
+	tempbinary.bse_bacc[1] = 0.0;
+	tempbinary.bse_tacc[0] = t->tacc;
+	tempbinary.bse_tacc[1] = 0.0;
+	tempbinary.bse_epoch[0] = t->epoch;
+	tempbinary.bse_epoch[1] = 0.0;
+	tempbinary.bse_tms[0] = t->tms;
+	tempbinary.bse_tms[1] = 0.0;
+	tempbinary.bse_bhspin[0] = t->bhspin;
+	tempbinary.bse_bhspin[1] = 0.0;
+	tempbinary.bse_tb = 0.0;
+	tempbinary.e = 0.0;
+
+	/*If we've got a large MS star, we need to reduce the timestep, otherwise
+	 * we miss the transition from MS to HG to giant, and won't start applying
+	 * winds for massive stars at the right time*/
+	if(t->zams_mass > 18){
+		bse_set_pts1(BSE_PTS1/10.);
+		reduced_timestep = 1;
+	}
+
+	tstart = MPI_Wtime();
+	bse_set_taus113state(*curr_st, 0);
+	bse_evolv2_safely(&(tempbinary.bse_kw[0]), &(tempbinary.bse_mass0[0]), &(tempbinary.bse_mass[0]),
+		&(tempbinary.bse_radius[0]), &(tempbinary.bse_lum[0]), &(tempbinary.bse_massc[0]),
+		&(tempbinary.bse_radc[0]), &(tempbinary.bse_menv[0]), &(tempbinary.bse_renv[0]),
+		&(tempbinary.bse_ospin[0]), &(tempbinary.bse_B_0[0]), &(tempbinary.bse_bacc[0]), &(tempbinary.bse_tacc[0]),
+		&(tempbinary.bse_epoch[0]), &(tempbinary.bse_tms[0]),
+		&(t->tphys), &tphysf, &dtp, &METALLICITY, zpars,
+		&(tempbinary.bse_tb), &(tempbinary.e), t->vs, &(tempbinary.bse_bhspin[0]));
+	*curr_st=bse_get_taus113state();
+	t->cost = MPI_Wtime() - tstart;
+	se_cost_record(t->id, t->cost);
+
+	t->mass0 = tempbinary.bse_mass0[0];
+	t->kw = tempbinary.bse_kw[0];
+	t->mt = tempbinary.bse_mass[0];
+	t->radius = tempbinary.bse_radius[0];
+	t->lum = tempbinary.bse_lum[0];
+	t->mc = tempbinary.bse_massc[0];
+	t->rc = tempbinary.bse_radc[0];
+	t->menv = tempbinary.bse_menv[0];
+	t->renv = tempbinary.bse_renv[0];
+	t->ospin = tempbinary.bse_ospin[0];
+	t->B_0 = tempbinary.bse_B_0[0];
+	t->bacc = tempbinary.bse_bacc[0];
+	t->tacc = tempbinary.bse_tacc[0];
+	t->epoch = tempbinary.bse_epoch[0];
+	t->tms = tempbinary.bse_tms[0];
+	t->bhspin = tempbinary.bse_bhspin[0];
+
+	/*Reset the MS timestep once we're done*/
+	if(reduced_timestep == 1)
+		bse_set_pts1(BSE_PTS1);
+
+	/* extract info from scm array */ /* PK looping over a large number anticipating further changes */
+	i = 1;
+	while (bse_get_bcm(i,1)>=0.0 && i < 50000) {
+		if(i > 1) {
+			if(bse_get_bcm(i,2) == 13 && bse_get_bcm(i-1,2) < 13){
+				if(bse_get_bcm(i+1,1) >= 0.0){
+					t->scm_formation = bse_get_bcm(i+1,35);
+				} else {
+					t->scm_formation = bse_get_bcm(i,35);
+				}
+			}
+		}
+		i++;
+	}
+	i--;
+	if(i+1 > 50000){
+		i = 0;
+	}
+	if(i>=1) {
+		t->scm_B = bse_get_bcm(i,33);
+	} else {
+		eprintf("Couldn't extract iso star bse info (looking for pulsar data)...");
+		eprintf("Evolv1 info from non scm extraction: id=%ld, kw=%d mass=%g mt=%g rad=%g lum=%g tphysf=%g dtp=%g ",t->id,t->kw,t->mass0,t->mt,t->radius,t->lum,tphysf,dtp);
+	}
+}
+
+/**
+* @brief Adds the wall time of one BSE call to the cost profile of this processor.
+*
+* @param id id of the star or binary
+* @param dt wall time (s)
+*/
+void se_cost_record(long id, double dt)
+{
+	se_cost_profile.se_time += dt;
+	se_cost_profile.se_n++;
+	if (dt > se_cost_profile.se_max) {
+		se_cost_profile.se_max = dt;
+		se_cost_profile.se_max_id = id;
+	}
+}
+
+/**
+* @brief Adds the wall time of one fewbody call to the cost profile of this processor.
+*
+* @param id id of one of the objects in the encounter
+* @param dt wall time (s)
+*/
+void fb_cost_record(long id, double dt)
+{
+	se_cost_profile.fb_time += dt;
+	se_cost_profile.fb_n++;
+	if (dt > se_cost_profile.fb_max) {
+		se_cost_profile.fb_max = dt;
+		se_cost_profile.fb_max_id = id;
+	}
+}
+
+/**
+* @brief Prints the BSE and fewbody cost profile of the timestep to the log
+* file (if SE_COST_PROFILE is set), and resets it.  The ratio of the largest to
+* the mean per-processor time measures the load imbalance of each phase.
+*/
+void se_cost_print_stats(void)
+{
+	se_cost_profile_t *p = &se_cost_profile;
+	double buf[10], *all=NULL, se_sum=0.0, se_maxp=0.0, fb_sum=0.0, fb_maxp=0.0;
+	double se_max=-1.0, fb_max=-1.0, se_max_id=0.0, fb_max_id=0.0, nsent=0.0, se_n=0.0, fb_n=0.0;
+	int i;
+
+	if (SE_COST_PROFILE) {
+		buf[0] = p->se_time;
+		buf[1] = p->se_n;
+		buf[2] = p->se_max;
+		buf[3] = p->se_max_id;
+		buf[4] = p->fb_time;
+		buf[5] = p->fb_n;
+		buf[6] = p->fb_max;
+		buf[7] = p->fb_max_id;
+		buf[8] = p->nsent;
+		buf[9] = p->nrecv;
+
+		if (myid == 0) {
+			all = (double *) malloc(10 * procs * sizeof(double));
+		}
+		double tmpTimeStart = timeStartSimple();
+		MPI_Gather(buf, 10, MPI_DOUBLE, all, 10, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+		timeEndSimple(tmpTimeStart, &t_comm);
+
+		if (myid == 0) {
+			for (i=0; i<procs; i++) {
+				se_sum += all[10*i];
+				se_maxp = MAX(se_maxp, all[10*i]);
+				se_n += all[10*i+1];
+				if (all[10*i+2] > se_max) {
+					se_max = all[10*i+2];
+					se_max_id = all[10*i+3];
+				}
+				fb_sum += all[10*i+4];
+				fb_maxp = MAX(fb_maxp, all[10*i+4]);
+				fb_n += all[10*i+5];
+				if (all[10*i+6] > fb_max) {
+					fb_max = all[10*i+6];
+					fb_max_id = all[10*i+7];
+				}
+				nsent += all[10*i+8];
+			}
+			free(all);
+
+			pararootfprintf(logfile, "%s(): BSE: calls=%.0f time=%g max/mean=%g slowest=%g (id=%.0f) moved=%.0f; fewbody: calls=%.0f time=%g max/mean=%g slowest=%g (id=%.0f)\n",
+				__FUNCTION__, se_n, se_sum, (se_sum > 0.0) ? se_maxp * procs / se_sum : 0.0, se_max, se_max_id, nsent,
+				fb_n, fb_sum, (fb_sum > 0.0) ? fb_maxp * procs / fb_sum : 0.0, fb_max, fb_max_id);
+		}
+	}
+
+	memset(p, 0, sizeof(se_cost_profile_t));
+}
+
+/**
+* @brief Moves the BSE evolution of single stars from processors with a high
+* predicted stellar evolution cost to processors with a low one.  The cost of
+* each object is predicted from the time its last BSE call took.  The transfers
+* are planned identically on all processors from the gathered totals: overloaded
+* processors are matched with underloaded ones in rank order, and each sends
+* singles (in index order) until its share is filled.  The received tasks are
+* evolved right away and their results sent back without blocking; while they
+* are on their way, this processor evolves the singles that stayed here, and
+* only then waits for the results of the ones it sent away, so that the shipped
+* and the local work run at the same time.  do_stellar_evolution() then applies
+* all of them with se_balance_result() instead of calling BSE.  Only single stars
+* are moved, since binaries need the full bcm history for handle_bse_outcome().
+*
+* @param tphysf time to evolve to (Myr)
+*/
+void se_balance_exchange(double tphysf)
+{
+	long k, kb, i, j, n, nsend, nrecv, nown, ncand=0, nknown=0;
+	double *load, mean, mycost=0.0, knowncost=0.0, defcost, *excess, *want, c, amt, q[SE_TRACK_NQ];
+	int *sendcounts, *recvcounts, *sdispls, *rdispls, p, r, s, *dest, done=0;
+	long *cand;
+	se_task_t *sendbuf, *recvbuf;
+	MPI_Request req;
+
+	se_balance_free();
+	if (!SE_BALANCE || procs == 1) {
+		return;
+	}
+
+	n = clus.N_MAX_NEW;
+	se_balance_nslot = n;
+	se_balance_slot = (long *) malloc((n+1) * sizeof(long));
+	se_balance_own_slot = (long *) malloc((n+1) * sizeof(long));
+	cand = (long *) malloc((n+1) * sizeof(long));
+	dest = (int *) malloc((n+1) * sizeof(int));
+
+	/* singles that will go through BSE, and the predicted cost of all objects */
+	for (k=1; k<=n; k++) {
+		se_balance_slot[k] = -1;
+		se_balance_own_slot[k] = -1;
+		if (star[k].se_cost > 0.0) {
+			knowncost += star[k].se_cost;
+			nknown++;
+		}
+	}
+	defcost = (nknown > 0) ? knowncost / nknown : 0.0;
+
+	for (k=1; k<=n; k++) {
+		if (star_m[get_global_idx(k)] <= DBL_MIN) {
+			continue;
+		}
+		if (star[k].binind == 0) {
+			if (SE_TRACK_CACHE == 1 && se_track_lookup(k, tphysf, q)) {
+				continue;
+			}
+			cand[ncand++] = k;
+		} else {
+			kb = star[k].binind;
+			if (binary[kb].bse_kw[0] == 14 && binary[kb].bse_kw[1] == 14) {
+				continue;
+			}
+		}
+		mycost += (star[k].se_cost > 0.0) ? star[k].se_cost : defcost;
+	}
+
+	load = (double *) malloc(procs * sizeof(double));
+	excess = (double *) malloc(procs * sizeof(double));
+	want = (double *) calloc(procs, sizeof(double));
+	sendcounts = (int *) calloc(procs, sizeof(int));
+	recvcounts = (int *) malloc(procs * sizeof(int));
+	sdispls = (int *) malloc(procs * sizeof(int));
+	rdispls = (int *) malloc(procs * sizeof(int));
+
+	double tmpTimeStart = timeStartSimple();
+	MPI_Allgather(&mycost, 1, MPI_DOUBLE, load, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	/* match overloaded with underloaded processors in rank order */
+	mean = 0.0;
+	for (p=0; p<procs; p++) mean += load[p];
+	mean /= procs;
+	for (p=0; p<procs; p++) excess[p] = load[p] - mean;
+	r = 0;
+	for (s=0; s<procs; s++) {
+		while (excess[s] > 0.0) {
+			while (r < procs && excess[r] >= 0.0) r++;
+			if (r == procs) break;
+			amt = MIN(excess[s], -excess[r]);
+			if (s == myid) want[r] += amt;
+			excess[s] -= amt;
+			excess[r] += amt;
+		}
+	}
+
+	/* fill the shares with singles, sending a star if at least half of it fits */
+	p = 0;
+	for (i=0; i<ncand; i++) {
+		k = cand[i];
+		dest[i] = -1;
+		c = (star[k].se_cost > 0.0) ? star[k].se_cost : defcost;
+		while (p < procs && want[p] < 0.5 * c) p++;
+		if (p == procs || c <= 0.0) continue;
+		dest[i] = p;
+		want[p] -= c;
+		sendcounts[p]++;
+	}
+
+	tmpTimeStart = timeStartSimple();
+	MPI_Alltoall(sendcounts, 1, MPI_INT, recvcounts, 1, MPI_INT, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	nsend = nrecv = 0;
+	for (p=0; p<procs; p++) {
+		sdispls[p] = nsend;
+		rdispls[p] = nrecv;
+		nsend += sendcounts[p];
+		nrecv += recvcounts[p];
+	}
+
+	sendbuf = (se_task_t *) malloc((nsend + 1) * sizeof(se_task_t));
+	recvbuf = (se_task_t *) malloc((nrecv + 1) * sizeof(se_task_t));
+
+	/* pack in destination order; sdispls is used as the running position */
+	for (i=0; i<ncand; i++) {
+		if (dest[i] < 0) continue;
+		k = cand[i];
+		j = sdispls[dest[i]]++;
+		se_task_from_star(&sendbuf[j], k);
+		se_balance_slot[k] = j;
+	}
+	for (p=0; p<procs; p++) {
+		sdispls[p] -= sendcounts[p];
+	}
+
+	/* counts and displacements in bytes */
+	for (p=0; p<procs; p++) {
+		sendcounts[p] *= sizeof(se_task_t);
+		recvcounts[p] *= sizeof(se_task_t);
+		sdispls[p] *= sizeof(se_task_t);
+		rdispls[p] *= sizeof(se_task_t);
+	}
+
+	tmpTimeStart = timeStartSimple();
+	MPI_Alltoallv(sendbuf, sendcounts, sdispls, MPI_BYTE, recvbuf, recvcounts, rdispls, MPI_BYTE, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	for (i=0; i<nrecv; i++) {
+		se_evolve_single_bse(&recvbuf[i], tphysf);
+	}
+
+	/* send the results back to where the tasks came from, without waiting for them */
+	tmpTimeStart = timeStartSimple();
+	MPI_Ialltoallv(recvbuf, recvcounts, rdispls, MPI_BYTE, sendbuf, sendcounts, sdispls, MPI_BYTE, MPI_COMM_WORLD, &req);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	/* meanwhile evolve the singles that stayed here, polling so that the exchange progresses */
+	nown = ncand - nsend;
+	se_balance_own = (se_task_t *) malloc((nown + 1) * sizeof(se_task_t));
+	j = 0;
+	for (i=0; i<ncand; i++) {
+		if (dest[i] >= 0) continue;
+		k = cand[i];
+		se_task_from_star(&se_balance_own[j], k);
+		se_evolve_single_bse(&se_balance_own[j], tphysf);
+		se_balance_own_slot[k] = j++;
+		if (!done) {
+			MPI_Test(&req, &done, MPI_STATUS_IGNORE);
+		}
+	}
+
+	tmpTimeStart = timeStartSimple();
+	MPI_Wait(&req, MPI_STATUS_IGNORE);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	se_cost_profile.nsent += nsend;
+	se_cost_profile.nrecv += nrecv;
+	se_balance_tasks = sendbuf;
+
+	free(recvbuf);
+	free(cand);
+	free(dest);
+	free(load);
+	free(excess);
+	free(want);
+	free(sendcounts);
+	free(recvcounts);
+	free(sdispls);
+	free(rdispls);
+}
+
+/**
+* @brief Returns the evolved state of a single star whose BSE evolution was
+* already done by se_balance_exchange() in this timestep, on another processor
+* or ahead of time on this one.
+*
+* @param k local index of the star
+*
+* @return the evolved task, or NULL if the star has to be evolved locally
+*/
+se_task_t *se_balance_result(long k)
+{
+	if (se_balance_slot == NULL || k > se_balance_nslot) {
+		return NULL;
+	}
+	if (se_balance_slot[k] >= 0) {
+		return &(se_balance_tasks[se_balance_slot[k]]);
+	}
+	if (se_balance_own_slot[k] >= 0) {
+		return &(se_balance_own[se_balance_own_slot[k]]);
+	}
+	return NULL;
+}
+
+/**
+* @brief Frees the tasks of the last se_balance_exchange().
+*/
+void se_balance_free(void)
+{
+	free(se_balance_tasks);
+	free(se_balance_own);
+	free(se_balance_slot);
+	free(se_balance_own_slot);
+	se_balance_tasks = NULL;
+	se_balance_own = NULL;
+	se_balance_slot = NULL;
+	se_balance_own_slot = NULL;
+	se_balance_nslot = 0;
+}
@@ -0,0 +1,584 @@
+/* vi: set filetype=c.doxygen: */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <pthread.h>
+
+#include "cmc.h"
+#include "cmc_vars.h"
+#include "bse_wrap.h"
+
+/* first tabulated time (Myr); earlier updates always go through BSE */
+#define SE_TRACK_TMIN 1.0e-2
+
+/* worker thread prefetching the track states during the dynamics */
+static pthread_t se_overlap_thread;
+static int se_overlap_running = 0;
+
+/**
+* @brief Evolves a single star of given ZAMS mass with BSE along the time grid
+* of the track table, storing the state at each grid time.  Once the star turns
+* into a remnant the rest of the track is marked invalid (kw=-1), since remnant
+* formation involves kicks and always has to go through BSE.
+*
+* @param im index of the mass grid point
+*/
+void se_track_build(int im)
+{
+	se_track_table_t *tab = &se_track_table;
+	struct rng_t113_state tmp_st = *curr_st;
+	double tphys, tphysf, dtp, vs[20], tb, ecc, *q;
+	double mass0[2], mass[2], radius[2], lum[2], massc[2], radc[2], menv[2], renv[2];
+	double ospin[2], B_0[2], bacc[2], tacc[2], epoch[2], tms[2], bhspin[2];
+	int kw[2], it;
+
+	mass0[0] = pow(10.0, tab->lmmin + im * (tab->lmmax - tab->lmmin) / (tab->nmass - 1));
+	kw[0] = (mass0[0] <= 0.7) ? 0 : 1;
+	mass[0] = mass0[0];
+	radius[0] = lum[0] = massc[0] = radc[0] = menv[0] = renv[0] = 0.0;
+	ospin[0] = B_0[0] = bacc[0] = tacc[0] = epoch[0] = tms[0] = bhspin[0] = 0.0;
+	kw[1] = 15;
+	mass0[1] = mass[1] = radius[1] = lum[1] = massc[1] = radc[1] = menv[1] = renv[1] = 0.0;
+	ospin[1] = B_0[1] = bacc[1] = tacc[1] = epoch[1] = tms[1] = bhspin[1] = 0.0;
+	tb = 0.0;
+	ecc = 0.0;
+
+	/* same start-up as stellar_evolution_init() */
+	tphys = 0.0;
+	tphysf = 1.0e-6;
+	dtp = 0.0;
+	bse_set_id1_pass(0);
+	bse_set_id2_pass(0);
+	bse_set_taus113state(tmp_st, 0);
+	bse_evolv2(&(kw[0]), &(mass0[0]), &(mass[0]), &(radius[0]), &(lum[0]), &(massc[0]),
+		&(radc[0]), &(menv[0]), &(renv[0]), &(ospin[0]), &(B_0[0]), &(bacc[0]), &(tacc[0]),
+		&(epoch[0]), &(tms[0]), &tphys, &tphysf, &dtp, &METALLICITY, zpars,
+		&tb, &ecc, vs, &(bhspin[0]));
+
+	if (mass0[0] > 18) {
+		bse_set_pts1(BSE_PTS1/10.);
+	}
+
+	for (it=0; it<tab->ntime; it++) {
+		q = &(tab->p[((long) im * tab->ntime + it) * SE_TRACK_NQ]);
+		if (kw[0] >= 10) {
+			q[SE_TRACK_KW] = -1.0;
+			continue;
+		}
+
+		tphysf = pow(10.0, tab->ltmin + it * (tab->ltmax - tab->ltmin) / (tab->ntime - 1));
+		dtp = 0.0;
+		bse_evolv2_safely(&(kw[0]), &(mass0[0]), &(mass[0]), &(radius[0]), &(lum[0]), &(massc[0]),
+			&(radc[0]), &(menv[0]), &(renv[0]), &(ospin[0]), &(B_0[0]), &(bacc[0]), &(tacc[0]),
+			&(epoch[0]), &(tms[0]), &tphys, &tphysf, &dtp, &METALLICITY, zpars,
+			&tb, &ecc, vs, &(bhspin[0]));
+
+		if (kw[0] >= 10) {
+			q[SE_TRACK_KW] = -1.0;
+			continue;
+		}
+		q[SE_TRACK_KW] = kw[0];
+		q[SE_TRACK_MASS0] = mass0[0];
+		q[SE_TRACK_MT] = mass[0];
+		q[SE_TRACK_RADIUS] = radius[0];
+		q[SE_TRACK_LUM] = lum[0];
+		q[SE_TRACK_MC] = massc[0];
+		q[SE_TRACK_RC] = radc[0];
+		q[SE_TRACK_MENV] = menv[0];
+		q[SE_TRACK_RENV] = renv[0];
+		q[SE_TRACK_OSPIN] = ospin[0];
+		q[SE_TRACK_EPOCH] = epoch[0];
+		q[SE_TRACK_TMS] = tms[0];
+	}
+
+	bse_set_pts1(BSE_PTS1);
+	/* the scratch tracks must not leak into the BSE random stream */
+	bse_set_taus113state(*curr_st, 0);
+}
+
+/**
+* @brief Reads the track table from SE_TRACK_CACHE_FILE, if it exists and is
+* compatible with the requested grid.
+*
+* @param lmmin log10 of the smallest ZAMS mass that has to be covered
+* @param lmmax log10 of the largest ZAMS mass that has to be covered
+* @param ltmax log10 of the last time (Myr) that has to be covered
+*
+* @return 1 if the table was loaded, 0 otherwise
+*/
+int se_track_load(double lmmin, double lmmax, double ltmax)
+{
+	se_track_table_t *tab = &se_track_table;
+	FILE *fp;
+	long n;
+
+	if (SE_TRACK_CACHE_FILE == NULL || (fp = fopen(SE_TRACK_CACHE_FILE, "rb")) == NULL) {
+		return 0;
+	}
+
+	if (fread(&(tab->metallicity), sizeof(double), 1, fp) != 1 ||
+	    fread(&(tab->nmass), sizeof(int), 1, fp) != 1 ||
+	    fread(&(tab->ntime), sizeof(int), 1, fp) != 1 ||
+	    fread(&(tab->lmmin), sizeof(double), 1, fp) != 1 ||
+	    fread(&(tab->lmmax), sizeof(double), 1, fp) != 1 ||
+	    fread(&(tab->ltmin), sizeof(double), 1, fp) != 1 ||
+	    fread(&(tab->ltmax), sizeof(double), 1, fp) != 1) {
+		fclose(fp);
+		return 0;
+	}
+
+	if (tab->metallicity != METALLICITY || tab->nmass != SE_TRACK_CACHE_NMASS || tab->ntime != SE_TRACK_CACHE_NTIME ||
+	    tab->lmmin > lmmin || tab->lmmax < lmmax || tab->ltmax < ltmax) {
+		wprintf("track cache file %s does not match this run; rebuilding it\n", SE_TRACK_CACHE_FILE);
+		fclose(fp);
+		return 0;
+	}
+
+	n = (long) tab->nmass * tab->ntime * SE_TRACK_NQ;
+	tab->p = (double *) malloc(n * sizeof(double));
+	if (fread(tab->p, sizeof(double), n, fp) != n) {
+		wprintf("track cache file %s is truncated; rebuilding it\n", SE_TRACK_CACHE_FILE);
+		free(tab->p);
+		tab->p = NULL;
+		fclose(fp);
+		return 0;
+	}
+	fclose(fp);
+
+	return 1;
+}
+
+/**
+* @brief Writes the track table to SE_TRACK_CACHE_FILE (root node only).
+*/
+void se_track_save(void)
+{
+	se_track_table_t *tab = &se_track_table;
+	FILE *fp;
+
+	if (SE_TRACK_CACHE_FILE == NULL || myid != 0) {
+		return;
+	}
+
+	if ((fp = fopen(SE_TRACK_CACHE_FILE, "wb")) == NULL) {
+		wprintf("cannot write track cache file %s\n", SE_TRACK_CACHE_FILE);
+		return;
+	}
+	fwrite(&(tab->metallicity), sizeof(double), 1, fp);
+	fwrite(&(tab->nmass), sizeof(int), 1, fp);
+	fwrite(&(tab->ntime), sizeof(int), 1, fp);
+	fwrite(&(tab->lmmin), sizeof(double), 1, fp);
+	fwrite(&(tab->lmmax), sizeof(double), 1, fp);
+	fwrite(&(tab->ltmin), sizeof(double), 1, fp);
+	fwrite(&(tab->ltmax), sizeof(double), 1, fp);
+	fwrite(tab->p, sizeof(double), (long) tab->nmass * tab->ntime * SE_TRACK_NQ, fp);
+	fclose(fp);
+}
+
+/**
+* @brief Sets up the single-star track cache: loads it from SE_TRACK_CACHE_FILE
+* or tabulates BSE tracks over a log-spaced ZAMS mass grid covering all
+* unperturbed single stars (the mass grid points are shared out among the
+* processors).  Must be called after the BSE globals and zpars are set.
+*/
+void se_track_cache_init(void)
+{
+	se_track_table_t *tab = &se_track_table;
+	double mminmax[2], lmmin, lmmax, ltmax;
+	long k, n;
+	int im;
+
+	tab->p = NULL;
+	tab->ncached = tab->nbse = tab->nvalidated = tab->nprefetched = 0;
+	tab->npre = tab->npre_alloc = 0;
+	tab->pre_zams = tab->pre = NULL;
+	tab->pre_kw = NULL;
+	tab->maxerr_mt = tab->maxerr_radius = tab->maxerr_lum = 0.0;
+
+	if (SE_OVERLAP && SE_TRACK_CACHE != 1) {
+		wprintf("SE_OVERLAP needs SE_TRACK_CACHE=1, ignoring it\n");
+	}
+
+	if (!SE_TRACK_CACHE) {
+		return;
+	}
+
+	if (SE_TRACK_CACHE_NMASS < 2 || SE_TRACK_CACHE_NTIME < 2) {
+		eprintf("SE_TRACK_CACHE_NMASS and SE_TRACK_CACHE_NTIME must be at least 2\n");
+		exit_cleanly(-1, __FUNCTION__);
+	}
+
+	/* mass range of the stars that can use the cache; stored as (-min, max) for a single MAX reduction */
+	mminmax[0] = -DBL_MAX;
+	mminmax[1] = -DBL_MAX;
+	for (k=1; k<=clus.N_MAX_NEW; k++) {
+		if (star[k].binind == 0 && star[k].se_pristine && star[k].zams_mass > 0.0) {
+			mminmax[0] = MAX(mminmax[0], -star[k].zams_mass);
+			mminmax[1] = MAX(mminmax[1], star[k].zams_mass);
+		}
+	}
+	MPI_Allreduce(MPI_IN_PLACE, mminmax, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+	if (mminmax[1] <= 0.0) {
+		rootgprintf("%s(): no unperturbed single stars, track cache not used\n", __FUNCTION__);
+		return;
+	}
+
+	lmmin = log10(-mminmax[0]) - 0.01;
+	lmmax = log10(mminmax[1]) + 0.01;
+	ltmax = log10(MAX(T_MAX_PHYS, 0.014) * 1.0e3);
+
+	if (se_track_load(lmmin, lmmax, ltmax)) {
+		rootgprintf("%s(): read %d x %d single-star track table from %s\n", __FUNCTION__, tab->nmass, tab->ntime, SE_TRACK_CACHE_FILE);
+		return;
+	}
+
+	tab->metallicity = METALLICITY;
+	tab->nmass = SE_TRACK_CACHE_NMASS;
+	tab->ntime = SE_TRACK_CACHE_NTIME;
+	tab->lmmin = lmmin;
+	tab->lmmax = lmmax;
+	tab->ltmin = log10(SE_TRACK_TMIN);
+	tab->ltmax = ltmax;
+
+	n = (long) tab->nmass * tab->ntime * SE_TRACK_NQ;
+	tab->p = (double *) calloc(n, sizeof(double));
+
+	rootgprintf("%s(): tabulating %d single-star tracks (Z=%g, %g-%g MSUN)... ", __FUNCTION__, tab->nmass, METALLICITY, pow(10.0, lmmin), pow(10.0, lmmax));
+	for (im=myid; im<tab->nmass; im+=procs) {
+		se_track_build(im);
+	}
+	/* every table entry is non-zero on exactly one processor, so the sum is exact */
+	MPI_Allreduce(MPI_IN_PLACE, tab->p, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+	rootgprintf("done\n");
+
+	se_track_save();
+}
+
+/**
+* @brief frees the track table
+*/
+void se_track_cache_free(void)
+{
+	se_overlap_finish();
+	free(se_track_table.p);
+	free(se_track_table.pre_zams);
+	free(se_track_table.pre_kw);
+	free(se_track_table.pre);
+	se_track_table.p = NULL;
+	se_track_table.pre_zams = se_track_table.pre = NULL;
+	se_track_table.pre_kw = NULL;
+	se_track_table.npre = se_track_table.npre_alloc = 0;
+}
+
+/**
+* @brief Interpolates the table at the given ZAMS mass and time (bilinear in log
+* mass and log time; radius and luminosity are interpolated in log).  Only
+* succeeds if all four surrounding grid points are of stellar type kw, so type
+* changes are always left to BSE.  Touches nothing but the table, so it is safe
+* to call from the prefetch thread.
+*
+* @param zams_mass ZAMS mass (MSUN)
+* @param kw current stellar type
+* @param tphys time (Myr)
+* @param q array of SE_TRACK_NQ values to be filled
+*
+* @return 1 if the state could be interpolated, 0 otherwise
+*/
+static int se_track_interp(double zams_mass, int kw, double tphys, double *q)
+{
+	se_track_table_t *tab = &se_track_table;
+	double fm, ft, w[4], *c[4];
+	int im, it, i, j;
+
+	fm = (log10(zams_mass) - tab->lmmin) / (tab->lmmax - tab->lmmin) * (tab->nmass - 1);
+	ft = (log10(tphys) - tab->ltmin) / (tab->ltmax - tab->ltmin) * (tab->ntime - 1);
+	if (fm < 0.0 || ft < 0.0 || fm > tab->nmass - 1 || ft > tab->ntime - 1) {
+		return 0;
+	}
+
+	im = MIN((int) fm, tab->nmass - 2);
+	it = MIN((int) ft, tab->ntime - 2);
+	fm -= im;
+	ft -= it;
+
+	c[0] = &(tab->p[((long) im * tab->ntime + it) * SE_TRACK_NQ]);
+	c[1] = &(tab->p[((long) (im+1) * tab->ntime + it) * SE_TRACK_NQ]);
+	c[2] = &(tab->p[((long) im * tab->ntime + it + 1) * SE_TRACK_NQ]);
+	c[3] = &(tab->p[((long) (im+1) * tab->ntime + it + 1) * SE_TRACK_NQ]);
+	w[0] = (1.0 - fm) * (1.0 - ft);
+	w[1] = fm * (1.0 - ft);
+	w[2] = (1.0 - fm) * ft;
+	w[3] = fm * ft;
+
+	for (i=0; i<4; i++) {
+		if ((int) c[i][SE_TRACK_KW] != kw) {
+			return 0;
+		}
+	}
+
+	q[SE_TRACK_KW] = kw;
+	for (j=SE_TRACK_MASS0; j<SE_TRACK_NQ; j++) {
+		q[j] = 0.0;
+		if (j == SE_TRACK_RADIUS || j == SE_TRACK_LUM) {
+			for (i=0; i<4; i++) q[j] += w[i] * log10(c[i][j]);
+			q[j] = pow(10.0, q[j]);
+		} else {
+			for (i=0; i<4; i++) q[j] += w[i] * c[i][j];
+		}
+	}
+
+	return 1;
+}
+
+/**
+* @brief Whether a star can be moved along its tabulated track at all: an
+* unperturbed single star that has not yet become a remnant.
+*
+* @param k local index of the star
+* @param tphys time (Myr)
+*
+* @return 1 if the table may be used for the star
+*/
+static int se_track_eligible(long k, double tphys)
+{
+	return (se_track_table.p != NULL && star[k].binind == 0 && star[k].se_pristine && star[k].se_k < 10 && tphys > 0.0 && star[k].zams_mass > 0.0);
+}
+
+/**
+* @brief Interpolates the state of an unperturbed single star at the given time
+* from the track table.
+*
+* @param k local index of the star
+* @param tphys time (Myr)
+* @param q array of SE_TRACK_NQ values to be filled
+*
+* @return 1 if the star could be interpolated, 0 otherwise
+*/
+int se_track_lookup(long k, double tphys, double *q)
+{
+	if (!se_track_eligible(k, tphys)) {
+		return 0;
+	}
+
+	return se_track_interp(star[k].zams_mass, star[k].se_k, tphys, q);
+}
+
+/**
+* @brief Thread body of the prefetch: interpolates the snapshot taken by
+* se_overlap_start().
+*/
+static void *se_overlap_loop(void *arg)
+{
+	se_track_table_t *tab = &se_track_table;
+	long k;
+
+	for (k=1; k<=tab->npre; k++) {
+		if (tab->pre_kw[k] < 0 || !se_track_interp(tab->pre_zams[k], tab->pre_kw[k], tab->pre_tphys, &(tab->pre[k * SE_TRACK_NQ]))) {
+			tab->pre[k * SE_TRACK_NQ + SE_TRACK_KW] = -1.0;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+* @brief Starts interpolating the tracks of all unperturbed single stars at
+* tphysf on a worker thread, to overlap with dynamics_apply().  The ZAMS mass and
+* type of every star are copied first, so the thread never reads the star array
+* while the dynamics modifies it.  BSE itself (Fortran common blocks, shared
+* random stream) cannot run concurrently with the dynamics, so only the table
+* interpolation is overlapped.
+*
+* @param tphysf time the stellar evolution of this timestep evolves to (Myr)
+*/
+void se_overlap_start(double tphysf)
+{
+	se_track_table_t *tab = &se_track_table;
+	long k;
+	int rc;
+
+	if (se_overlap_running || SE_TRACK_CACHE != 1 || tab->p == NULL) {
+		return;
+	}
+
+	tab->npre = clus.N_MAX_NEW;
+	if (tab->npre + 1 > tab->npre_alloc) {
+		tab->npre_alloc = (tab->npre + 1) * 2;
+		tab->pre_zams = (double *) realloc(tab->pre_zams, tab->npre_alloc * sizeof(double));
+		tab->pre_kw = (int *) realloc(tab->pre_kw, tab->npre_alloc * sizeof(int));
+		tab->pre = (double *) realloc(tab->pre, tab->npre_alloc * SE_TRACK_NQ * sizeof(double));
+	}
+
+	tab->pre_tphys = tphysf;
+	for (k=1; k<=tab->npre; k++) {
+		tab->pre_zams[k] = star[k].zams_mass;
+		tab->pre_kw[k] = se_track_eligible(k, tphysf) ? star[k].se_k : -1;
+	}
+
+	rc = pthread_create(&se_overlap_thread, NULL, se_overlap_loop, NULL);
+	if (rc) {
+		wprintf("return code from pthread_create() is %d, prefetching in serial\n", rc);
+		se_overlap_loop(NULL);
+		return;
+	}
+	se_overlap_running = 1;
+}
+
+/**
+* @brief Waits for the prefetch thread started by se_overlap_start(), if any.
+*/
+void se_overlap_finish(void)
+{
+	int rc;
+
+	if (!se_overlap_running) {
+		return;
+	}
+
+	rc = pthread_join(se_overlap_thread, NULL);
+	if (rc) {
+		eprintf("return code from pthread_join() is %d\n", rc);
+		exit_cleanly(-1, __FUNCTION__);
+	}
+	se_overlap_running = 0;
+}
+
+/**
+* @brief Returns the prefetched state of a star, if it is still valid: the star
+* did not interact during the dynamics and is still the same unperturbed single
+* star as in the snapshot.  The state is then identical to what
+* se_track_lookup() would return now.
+*
+* @param k local index of the star
+* @param tphysf time to evolve to (Myr)
+*
+* @return pointer to the SE_TRACK_NQ prefetched values, or NULL
+*/
+static double *se_track_prefetched(long k, double tphysf)
+{
+	se_track_table_t *tab = &se_track_table;
+
+	if (k > tab->npre || tab->pre_tphys != tphysf || tab->pre_kw[k] < 0 || star[k].interacted) {
+		return NULL;
+	}
+	if (!se_track_eligible(k, tphysf) || tab->pre_kw[k] != star[k].se_k || tab->pre_zams[k] != star[k].zams_mass) {
+		return NULL;
+	}
+	if (tab->pre[k * SE_TRACK_NQ + SE_TRACK_KW] < 0.0) {
+		return NULL;
+	}
+
+	return &(tab->pre[k * SE_TRACK_NQ]);
+}
+
+/**
+* @brief Advances an unperturbed single star to tphysf using the track cache
+* instead of BSE.  Keeps the DMse bookkeeping of the BSE path.
+*
+* @param k local index of the star
+* @param tphysf time to evolve to (Myr)
+*
+* @return 1 if the star was evolved from the table, 0 if it has to go through BSE
+*/
+int se_track_evolve(long k, double tphysf)
+{
+	double qbuf[SE_TRACK_NQ], *q;
+	long g_k;
+
+	if (!SE_TRACK_CACHE) {
+		return 0;
+	}
+
+	if (SE_TRACK_CACHE == 1 && (q = se_track_prefetched(k, tphysf)) != NULL) {
+		se_track_table.nprefetched++;
+	} else if (SE_TRACK_CACHE == 1 && se_track_lookup(k, tphysf, qbuf)) {
+		q = qbuf;
+	} else {
+		se_track_table.nbse++;
+		return 0;
+	}
+
+	g_k = get_global_idx(k);
+	exact_sum_add(&DMse_sum, star_m[g_k] * madhoc);
+
+	star[k].se_mass = q[SE_TRACK_MASS0];
+	star[k].se_mt = q[SE_TRACK_MT];
+	star[k].se_radius = q[SE_TRACK_RADIUS];
+	star[k].se_lum = q[SE_TRACK_LUM];
+	star[k].se_mc = q[SE_TRACK_MC];
+	star[k].se_rc = q[SE_TRACK_RC];
+	star[k].se_menv = q[SE_TRACK_MENV];
+	star[k].se_renv = q[SE_TRACK_RENV];
+	star[k].se_ospin = q[SE_TRACK_OSPIN];
+	star[k].se_epoch = q[SE_TRACK_EPOCH];
+	star[k].se_tms = q[SE_TRACK_TMS];
+	star[k].se_tphys = tphysf;
+
+	star[k].rad = star[k].se_radius * RSUN / units.l;
+	star_m[g_k] = star[k].se_mt * MSUN / units.mstar;
+	exact_sum_add(&DMse_sum, -star_m[g_k] * madhoc);
+
+	se_track_table.ncached++;
+	return 1;
+}
+
+/**
+* @brief Compares the interpolated track state of a star with the state BSE
+* just evolved it to, and records the largest relative errors.
+*
+* @param k local index of the star
+* @param q track state from se_track_lookup() for the same time
+*/
+void se_track_validate(long k, double *q)
+{
+	se_track_table_t *tab = &se_track_table;
+
+	/* type changes are never taken from the table, so there is nothing to compare */
+	if ((int) q[SE_TRACK_KW] != star[k].se_k) {
+		return;
+	}
+
+	tab->nvalidated++;
+	tab->maxerr_mt = MAX(tab->maxerr_mt, fabs(q[SE_TRACK_MT] - star[k].se_mt) / star[k].se_mt);
+	tab->maxerr_radius = MAX(tab->maxerr_radius, fabs(q[SE_TRACK_RADIUS] - star[k].se_radius) / star[k].se_radius);
+	tab->maxerr_lum = MAX(tab->maxerr_lum, fabs(q[SE_TRACK_LUM] - star[k].se_lum) / star[k].se_lum);
+}
+
+/**
+* @brief Prints the number of single stars evolved with the track cache and with
+* BSE in this timestep (and the validation errors) to the log file, and resets
+* the counters.
+*/
+void se_track_print_stats(void)
+{
+	se_track_table_t *tab = &se_track_table;
+	long buf_long[4], buf_long_recv[4];
+	double buf_dbl[3], buf_dbl_recv[3];
+
+	buf_long[0] = tab->ncached;
+	buf_long[1] = tab->nbse;
+	buf_long[2] = tab->nvalidated;
+	buf_long[3] = tab->nprefetched;
+	buf_dbl[0] = tab->maxerr_mt;
+	buf_dbl[1] = tab->maxerr_radius;
+	buf_dbl[2] = tab->maxerr_lum;
+
+	double tmpTimeStart = timeStartSimple();
+	MPI_Reduce(buf_long, buf_long_recv, 4, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	MPI_Reduce(buf_dbl, buf_dbl_recv, 3, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	timeEndSimple(tmpTimeStart, &t_comm);
+
+	pararootfprintf(logfile, "%s(): single stars evolved with track cache=%ld BSE=%ld", __FUNCTION__, buf_long_recv[0], buf_long_recv[1]);
+	if (SE_OVERLAP) {
+		pararootfprintf(logfile, " prefetched=%ld", buf_long_recv[3]);
+	}
+	if (SE_TRACK_CACHE == 2) {
+		pararootfprintf(logfile, " validated=%ld max_relerr(mt,R,L)=%g %g %g", buf_long_recv[2], buf_dbl_recv[0], buf_dbl_recv[1], buf_dbl_recv[2]);
+	}
+	pararootfprintf(logfile, "\n");
+
+	tab->ncached = tab->nbse = tab->nvalidated = tab->nprefetched = 0;
+	tab->maxerr_mt = tab->maxerr_radius = tab->maxerr_lum = 0.0;
+}
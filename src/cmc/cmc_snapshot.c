@@ -0,0 +1,353 @@
+/* vi: set filetype=c.doxygen: */
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "cmc_snapshot.h"
+
+/**
+* @brief names of the columns of the snapshot tables
+*/
+static const char *snapshot_field_names[NFIELDS] =
+{ "id","m_MSUN", "r", "vr", "vt", "E", "J", "binflag", "m0_MSUN", "m1_MSUN", "id0",
+"id1", "a_AU", "e", "startype", "luminosity_LSUN", "radius_RSUN", "bin_startype0", "bin_startype1",
+"bin_star_lum0_LSUN", "bin_star_lum1_LSUN", "bin_star_radius0_RSUN", "bin_star_radius1_RSUN",
+"bin_Eb", "eta", "star_phi", "rad0", "rad1", "tb", "lum0", "lum1", "massc0", "massc1", "radc0",
+"radc1", "menv0", "menv1", "renv0", "renv1", "tms0", "tms1", "dmdt0", "dmdt1", "radrol0",
+"radrol1", "ospin0", "ospin1", "B0", "B1", "formation0", "formation1", "bacc0", "bacc1",
+"tacc0", "tacc1","mass0_0", "mass0_1", "epoch0","epoch1","ospin", "B","formation"};
+
+/**
+* @brief offsets of the columns in the Snapshot struct
+*/
+static const size_t snapshot_field_offsets[NFIELDS] = {
+	HOFFSET(Snapshot, id), HOFFSET(Snapshot, m), HOFFSET(Snapshot, r), HOFFSET(Snapshot, vr),
+	HOFFSET(Snapshot, vt), HOFFSET(Snapshot, E), HOFFSET(Snapshot, J), HOFFSET(Snapshot, binflag),
+	HOFFSET(Snapshot, m0), HOFFSET(Snapshot, m1), HOFFSET(Snapshot, id0), HOFFSET(Snapshot, id1),
+	HOFFSET(Snapshot, a), HOFFSET(Snapshot, e), HOFFSET(Snapshot, startype), HOFFSET(Snapshot, luminosity),
+	HOFFSET(Snapshot, radius), HOFFSET(Snapshot, bin_startype0), HOFFSET(Snapshot, bin_startype1),
+	HOFFSET(Snapshot, bin_star_lum0), HOFFSET(Snapshot, bin_star_lum1), HOFFSET(Snapshot, bin_star_radius0),
+	HOFFSET(Snapshot, bin_star_radius1), HOFFSET(Snapshot, bin_Eb), HOFFSET(Snapshot, eta),
+	HOFFSET(Snapshot, star_phi), HOFFSET(Snapshot, rad0), HOFFSET(Snapshot, rad1), HOFFSET(Snapshot, tb),
+	HOFFSET(Snapshot, lum0), HOFFSET(Snapshot, lum1), HOFFSET(Snapshot, massc0), HOFFSET(Snapshot, massc1),
+	HOFFSET(Snapshot, radc0), HOFFSET(Snapshot, radc1), HOFFSET(Snapshot, menv0), HOFFSET(Snapshot, menv1),
+	HOFFSET(Snapshot, renv0), HOFFSET(Snapshot, renv1), HOFFSET(Snapshot, tms0), HOFFSET(Snapshot, tms1),
+	HOFFSET(Snapshot, dmdt0), HOFFSET(Snapshot, dmdt1), HOFFSET(Snapshot, radrol0), HOFFSET(Snapshot, radrol1),
+	HOFFSET(Snapshot, ospin0), HOFFSET(Snapshot, ospin1), HOFFSET(Snapshot, B0), HOFFSET(Snapshot, B1),
+	HOFFSET(Snapshot, formation0), HOFFSET(Snapshot, formation1), HOFFSET(Snapshot, bacc0),
+	HOFFSET(Snapshot, bacc1), HOFFSET(Snapshot, tacc0), HOFFSET(Snapshot, tacc1), HOFFSET(Snapshot, mass0_0),
+	HOFFSET(Snapshot, mass0_1), HOFFSET(Snapshot, epoch0), HOFFSET(Snapshot, epoch1), HOFFSET(Snapshot, ospin),
+	HOFFSET(Snapshot, B), HOFFSET(Snapshot, formation)
+};
+
+/**
+* @brief HDF5 type of a column of the snapshot tables
+*
+* @param i index of the column in the full record
+*
+* @return type
+*/
+static hid_t snapshot_field_type(int i)
+{
+	if (i == SNAPSHOT_FIELD_id || i == SNAPSHOT_FIELD_binflag || i == SNAPSHOT_FIELD_id0 || i == SNAPSHOT_FIELD_id1) {
+		return(H5T_NATIVE_LONG);
+	} else if (i == SNAPSHOT_FIELD_startype || i == SNAPSHOT_FIELD_bin_startype0 || i == SNAPSHOT_FIELD_bin_startype1) {
+		return(H5T_NATIVE_INT);
+	}
+	return(H5T_NATIVE_DOUBLE);
+}
+
+/**
+* @brief Builds the HDF5 compound type of a snapshot record, as H5TBmake_table would from the field list
+*
+* @param fields columns of a packed record, or NULL for the full Snapshot record
+*
+* @return type, to be closed by the caller
+*/
+hid_t snapshot_type(snapshot_fields_t *fields)
+{
+	hid_t type;
+	int i;
+
+	if (fields == NULL) {
+		type = H5Tcreate(H5T_COMPOUND, sizeof(Snapshot));
+		for (i=0; i<NFIELDS; i++) {
+			H5Tinsert(type, snapshot_field_names[i], snapshot_field_offsets[i], snapshot_field_type(i));
+		}
+	} else {
+		type = H5Tcreate(H5T_COMPOUND, fields->size);
+		for (i=0; i<fields->n; i++) {
+			H5Tinsert(type, snapshot_field_names[fields->idx[i]], fields->offset[i], snapshot_field_type(fields->idx[i]));
+		}
+	}
+
+	return(type);
+}
+
+/**
+* @brief Sets up a subset of the columns from a comma separated list of column
+* names, or "basic" for SNAPSHOT_FIELDS_BASIC.  The columns always end up in
+* the order of the full record.
+*
+* @param spec list of columns
+* @param fields columns
+*
+* @return 0 on success, -1 if a column is unknown or none is given
+*/
+int snapshot_fields_parse(const char *spec, snapshot_fields_t *fields)
+{
+	char buf[1024], *tok, *save=NULL;
+	int want[NFIELDS], i;
+	size_t size, off=0, align=8;
+
+	if (strcmp(spec, "basic") == 0) {
+		spec = SNAPSHOT_FIELDS_BASIC;
+	}
+	snprintf(buf, sizeof(buf), "%s", spec);
+
+	memset(want, 0, sizeof(want));
+	for (tok=strtok_r(buf, ", ", &save); tok!=NULL; tok=strtok_r(NULL, ", ", &save)) {
+		for (i=0; i<NFIELDS; i++) {
+			if (strcmp(tok, snapshot_field_names[i]) == 0) break;
+		}
+		if (i == NFIELDS) {
+			return(-1);
+		}
+		want[i] = 1;
+	}
+
+	fields->n = 0;
+	for (i=0; i<NFIELDS; i++) {
+		if (!want[i]) continue;
+		size = H5Tget_size(snapshot_field_type(i));
+		off = (off + size - 1) / size * size;
+		fields->idx[fields->n] = i;
+		fields->offset[fields->n] = off;
+		fields->colsize[fields->n] = size;
+		fields->n++;
+		off += size;
+	}
+	fields->size = (off + align - 1) / align * align;
+
+	return(fields->n > 0 ? 0 : -1);
+}
+
+/**
+* @brief Checks whether a column is written
+*
+* @param fields columns, NULL for all of them
+* @param idx index of the column in the full record
+*
+* @return 1 if it is, 0 otherwise
+*/
+int snapshot_fields_has(snapshot_fields_t *fields, int idx)
+{
+	int i;
+
+	if (fields == NULL) {
+		return(1);
+	}
+	for (i=0; i<fields->n; i++) {
+		if (fields->idx[i] == idx) return(1);
+	}
+	return(0);
+}
+
+/**
+* @brief Packs full records in place down to the given columns.  Each column
+* of a packed record lies no further into the array than it did in the full
+* record, so going through the records and columns in order never overwrites
+* anything still to be read.  Only the column sizes cached by
+* snapshot_fields_parse() are used, so no HDF5 call is made here while the I/O
+* thread of ASYNC_IO may be writing.
+*
+* @param data records
+* @param nrecords number of records
+* @param fields columns, NULL for all of them
+*
+* @return size of a record after packing
+*/
+size_t snapshot_pack(Snapshot *data, hsize_t nrecords, snapshot_fields_t *fields)
+{
+	char *src, *dst;
+	hsize_t k;
+	int i;
+
+	if (fields == NULL) {
+		return(sizeof(Snapshot));
+	}
+
+	for (k=0; k<nrecords; k++) {
+		src = (char *) (data + k);
+		dst = (char *) data + k * fields->size;
+		for (i=0; i<fields->n; i++) {
+			memmove(dst + fields->offset[i], src + snapshot_field_offsets[fields->idx[i]], fields->colsize[i]);
+		}
+	}
+
+	return(fields->size);
+}
+
+/**
+* @brief Checks whether a compression filter can be used for both writing and reading
+*
+* @param compress one of SNAPSHOT_COMPRESS_*
+*
+* @return 1 if it can, 0 otherwise
+*/
+int snapshot_filter_avail(int compress)
+{
+	H5Z_filter_t filter;
+	unsigned int filter_info;
+
+	switch (compress) {
+	case SNAPSHOT_COMPRESS_NONE:
+		return(1);
+	case SNAPSHOT_COMPRESS_GZIP:
+	case SNAPSHOT_COMPRESS_SHUFFLE_GZIP:
+		filter = H5Z_FILTER_DEFLATE;
+		break;
+	case SNAPSHOT_COMPRESS_LZ4:
+		filter = SNAPSHOT_FILTER_LZ4;
+		break;
+	case SNAPSHOT_COMPRESS_ZSTD:
+		filter = SNAPSHOT_FILTER_ZSTD;
+		break;
+	default:
+		return(0);
+	}
+
+	if (H5Zfilter_avail(filter) <= 0) {
+		return(0);
+	}
+	if (H5Zget_filter_info(filter, &filter_info) < 0 ||
+	    !(filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED) ||
+	    !(filter_info & H5Z_FILTER_CONFIG_DECODE_ENABLED)) {
+		return(0);
+	}
+	return(1);
+}
+
+/**
+* @brief Creates a snapshot table, with the same layout and attributes as H5TBmake_table gives it but with the chunking and compression chosen
+*
+* @param file HDF5 file
+* @param tablename name of the table
+* @param nrecords number of records to write into it
+* @param data records, packed if opts->fields is set; may be NULL if nrecords is 0
+* @param opts chunking, compression and columns
+*
+* @return 0 on success, -1 on failure
+*/
+int snapshot_make_table(hid_t file, const char *tablename, hsize_t nrecords, void *data, snapshot_opts_t *opts)
+{
+	hid_t type, space, dcpl, dset;
+	hsize_t dims[1], maxdims[1] = {H5S_UNLIMITED}, chunk[1];
+	unsigned int cd_values[1];
+	char attr_name[32];
+	int i, nfields, ret=0;
+
+	type = snapshot_type(opts->fields);
+	dims[0] = nrecords;
+	space = H5Screate_simple(1, dims, maxdims);
+
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	chunk[0] = opts->chunk > 0 ? opts->chunk : 1;
+	H5Pset_chunk(dcpl, 1, chunk);
+	switch (opts->compress) {
+	case SNAPSHOT_COMPRESS_SHUFFLE_GZIP:
+		H5Pset_shuffle(dcpl);
+		H5Pset_deflate(dcpl, opts->level);
+		break;
+	case SNAPSHOT_COMPRESS_GZIP:
+		H5Pset_deflate(dcpl, opts->level);
+		break;
+	case SNAPSHOT_COMPRESS_LZ4:
+		H5Pset_filter(dcpl, SNAPSHOT_FILTER_LZ4, H5Z_FLAG_OPTIONAL, 0, NULL);
+		break;
+	case SNAPSHOT_COMPRESS_ZSTD:
+		cd_values[0] = opts->level;
+		H5Pset_filter(dcpl, SNAPSHOT_FILTER_ZSTD, H5Z_FLAG_OPTIONAL, 1, cd_values);
+		break;
+	}
+
+	dset = H5Dcreate2(file, tablename, type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+	if (dset < 0) {
+		ret = -1;
+	} else {
+		if (nrecords > 0 && data != NULL && H5Dwrite(dset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data) < 0) {
+			ret = -1;
+		}
+		H5Dclose(dset);
+
+		/* the attributes that mark the dataset as a table for H5TB and PyTables */
+		H5LTset_attribute_string(file, tablename, "CLASS", "TABLE");
+		H5LTset_attribute_string(file, tablename, "VERSION", "3.0");
+		H5LTset_attribute_string(file, tablename, "TITLE", "Table Title");
+		nfields = opts->fields == NULL ? NFIELDS : opts->fields->n;
+		for (i=0; i<nfields; i++) {
+			sprintf(attr_name, "FIELD_%d_NAME", i);
+			H5LTset_attribute_string(file, tablename, attr_name,
+						 snapshot_field_names[opts->fields == NULL ? i : opts->fields->idx[i]]);
+		}
+		/* a subsampled table records how many stars each row stands for */
+		if (opts->weight > 0.0) {
+			H5LTset_attribute_double(file, tablename, "WEIGHT", &opts->weight, 1);
+		}
+	}
+
+	H5Pclose(dcpl);
+	H5Sclose(space);
+	H5Tclose(type);
+
+	return(ret);
+}
+
+/**
+* @brief Appends records to a snapshot table
+*
+* @param file HDF5 file
+* @param tablename name of the table
+* @param nrecords number of records
+* @param data records, packed if opts->fields is set
+* @param opts columns, as given when the table was made
+*
+* @return 0 on success, -1 on failure
+*/
+int snapshot_append_records(hid_t file, const char *tablename, hsize_t nrecords, void *data, snapshot_opts_t *opts)
+{
+	hid_t type, dset, filespace, memspace;
+	hsize_t dims[1], start[1], count[1];
+	int ret=0;
+
+	if (nrecords == 0) {
+		return(0);
+	}
+
+	dset = H5Dopen2(file, tablename, H5P_DEFAULT);
+	if (dset < 0) {
+		return(-1);
+	}
+
+	filespace = H5Dget_space(dset);
+	H5Sget_simple_extent_dims(filespace, dims, NULL);
+	H5Sclose(filespace);
+	start[0] = dims[0];
+	count[0] = nrecords;
+	dims[0] += nrecords;
+	H5Dset_extent(dset, dims);
+
+	type = snapshot_type(opts->fields);
+	filespace = H5Dget_space(dset);
+	H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, NULL, count, NULL);
+	memspace = H5Screate_simple(1, count, NULL);
+	if (H5Dwrite(dset, type, memspace, filespace, H5P_DEFAULT, data) < 0) {
+		ret = -1;
+	}
+
+	H5Sclose(memspace);
+	H5Sclose(filespace);
+	H5Tclose(type);
+	H5Dclose(dset);
+
+	return(ret);
+}
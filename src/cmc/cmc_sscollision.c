@@ -2,12 +2,54 @@
 /* vi: set filetype=c.doxygen: */
 
 #include <stdio.h>
+#include <string.h>
 #include <zlib.h>
 #include <math.h>
 #include "cmc.h"
 #include "cmc_vars.h"
 #include "bse_wrap.h"
 
+/**
+* @brief Writes the collision file entry of a single-single collision
+*
+* @param knew index of the merger product
+* @param k index of first star
+* @param mass_k mass of first star before the collision
+* @param kp index of second star
+* @param mass_kp mass of second star before the collision
+* @param b impact parameter
+* @param W relative speed at infinity
+* @param rperi pericenter distance
+* @param coll_mult collision multiplier
+*/
+static void sscollision_log(long knew, long k, double mass_k, long kp, double mass_kp, double b, double W, double rperi, double coll_mult)
+{
+	evlog_coll_t rec;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.t = TotalTime;
+	strcpy(rec.kind, "single-single");
+	rec.idm = star[knew].id;
+	rec.mm = star_m[get_global_idx(knew)] * units.mstar / FB_CONST_MSUN;
+	rec.r = star_r[get_global_idx(knew)];
+	rec.typem = star[knew].se_k;
+	rec.n = 2;
+	rec.id[0] = star[k].id;
+	rec.m[0] = mass_k * units.mstar / FB_CONST_MSUN;
+	rec.type[0] = star[k].se_k;
+	rec.id[1] = star[kp].id;
+	rec.m[1] = mass_kp * units.mstar / FB_CONST_MSUN;
+	rec.type[1] = star[kp].se_k;
+	rec.ss = 1;
+	rec.b = b*units.l/RSUN;
+	rec.vinf = W*units.l/units.t/1.e5;
+	rec.rad1 = star[k].rad*units.l/RSUN;
+	rec.rad2 = star[kp].rad*units.l/RSUN;
+	rec.rperi = rperi*units.l/RSUN;
+	rec.coll_mult = coll_mult;
+	log_collision(&rec);
+}
+
 /**
 * @brief Does single single collision
 *
@@ -110,10 +152,11 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 		        Einit = 0.5 * mass_k * madhoc * (sqr(star[k].vr)+sqr(star[k].vt)) +
 		                0.5 * mass_kp * madhoc * (sqr(star[kp].vr)+sqr(star[kp].vt)) + 
 			        0.5 * mass_k * madhoc * phi_k + 0.5 * mass_kp * madhoc * phi_kp;
-		        DMse += mass_kp * madhoc;
+		        exact_sum_add(&DMse_sum, mass_kp * madhoc);
 
 		        aj = star[kp].se_tphys - star[kp].se_epoch;
 		        star[kp].se_mt = star[kp].se_mc;
+		        star[kp].se_pristine = 0;
 		        bse_star(&(star[kp].se_k), &(star[kp].se_mass), &(star[kp].se_mt), &tm, &tn, tscls, lums, GB, zpars);
 		        bse_hrdiag(&(star[kp].se_mass), &aj, &(star[kp].se_mt), &tm, &tn, tscls, lums, GB, zpars,
 			           &(star[kp].se_radius), &(star[kp].se_lum), &(star[kp].se_k), &(star[kp].se_mc), 
@@ -121,7 +164,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 		        star[kp].se_epoch = star[kp].se_tphys - aj;
 		        star[kp].rad = star[kp].se_radius * RSUN / units.l;
 		        mass_kp = star[kp].se_mt * MSUN / units.mstar;
-		        DMse -= mass_kp * madhoc;
+		        exact_sum_add(&DMse_sum, -mass_kp * madhoc);
 
 		        /* check to see if MS star overfills RL at pericenter, and destroy if this is the case */
                         /* Shi: this is turned off by the MS_vanish_flag */
@@ -247,13 +290,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 
 
                         /* log collision */
-                        parafprintf(collisionfile, "t=%g single-single idm=%ld(mm=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typem=%d type1=%d type2=%d b[RSUN]=%g vinf[km/s]=%g rad1=%g rad2=%g rperi=%g coll_mult=%g\n",
-                                TotalTime,
-                                star[knew].id, star_m[get_global_idx(knew)] * units.mstar / FB_CONST_MSUN,
-                                star[k].id, mass_k * units.mstar / FB_CONST_MSUN,
-                                star[kp].id, mass_kp * units.mstar / FB_CONST_MSUN,
-                                star_r[get_global_idx(knew)], star[knew].se_k, star[k].se_k, star[kp].se_k,
-                    b*units.l/RSUN,W*units.l/units.t/1.e5, star[k].rad*units.l/RSUN, star[kp].rad*units.l/RSUN, rperi*units.l/RSUN, collisions_multiple_hold);
+                        sscollision_log(knew, k, mass_k, kp, mass_kp, b, W, rperi, collisions_multiple_hold);
 
                         /* destroy two progenitors */
                         destroy_obj(k);
@@ -291,9 +328,10 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 		        Einit = 0.5 * mass_k * madhoc * (sqr(star[k].vr)+sqr(star[k].vt)) +
 			        0.5 * mass_kp * madhoc * (sqr(star[kp].vr)+sqr(star[kp].vt)) + 
 			        0.5 * mass_k * madhoc * phi_k + 0.5 * mass_kp * madhoc * phi_kp;
-		        DMse += mass_k * madhoc;
+		        exact_sum_add(&DMse_sum, mass_k * madhoc);
 		        aj = star[k].se_tphys - star[k].se_epoch;
 		        star[k].se_mt = star[k].se_mc;
+		        star[k].se_pristine = 0;
 		        bse_star(&(star[k].se_k), &(star[k].se_mass), &(star[k].se_mt), &tm, &tn, tscls, lums, GB, zpars);
 		        bse_hrdiag(&(star[k].se_mass), &aj, &(star[k].se_mt), &tm, &tn, tscls, lums, GB, zpars,
 			           &(star[k].se_radius), &(star[k].se_lum), &(star[k].se_k), &(star[k].se_mc), 
@@ -301,7 +339,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 		        star[k].se_epoch = star[k].se_tphys - aj;
 		        star[k].rad = star[k].se_radius * RSUN / units.l;
 		        mass_k = star[k].se_mt * MSUN / units.mstar;
-		        DMse -= mass_k * madhoc;
+		        exact_sum_add(&DMse_sum, -mass_k * madhoc);
 
 		        /* check to see if MS star overfills RL at pericenter, and destroy if this is the case */
                         /* This is turned off by the MS_vanish_flag */
@@ -424,13 +462,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 
 
                         /* log collision */
-                        parafprintf(collisionfile, "t=%g single-single idm=%ld(mm=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typem=%d type1=%d type2=%d b[RSUN]=%g vinf[km/s]=%g rad1=%g rad2=%g rperi=%g coll_mult=%g\n",
-                                TotalTime,
-                                star[knew].id, star_m[get_global_idx(knew)] * units.mstar / FB_CONST_MSUN,
-                                star[k].id, mass_k * units.mstar / FB_CONST_MSUN,
-                                star[kp].id, mass_kp * units.mstar / FB_CONST_MSUN,
-                                star_r[get_global_idx(knew)], star[knew].se_k, star[k].se_k, star[kp].se_k,
-                    b*units.l/RSUN,W*units.l/units.t/1.e5, star[k].rad*units.l/RSUN, star[kp].rad*units.l/RSUN, rperi*units.l/RSUN, collisions_multiple_hold);
+                        sscollision_log(knew, k, mass_k, kp, mass_kp, b, W, rperi, collisions_multiple_hold);
 
                         /* destroy two progenitors */
                         destroy_obj(k);
@@ -456,10 +488,11 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
                                 0.5 * mass_kp * madhoc * (sqr(star[kp].vr)+sqr(star[kp].vt)) +
                                 0.5 * mass_k * madhoc * phi_k + 0.5 * mass_kp * madhoc * phi_kp;
 
-                        DMse += mass_k * madhoc;
-                        DMse += mass_kp * madhoc;
+                        exact_sum_add(&DMse_sum, mass_k * madhoc);
+                        exact_sum_add(&DMse_sum, mass_kp * madhoc);
                         aj_k = star[k].se_tphys - star[k].se_epoch;
                         star[k].se_mt = star[k].se_mc;
+                        star[k].se_pristine = 0;
                         bse_star(&(star[k].se_k), &(star[k].se_mass), &(star[k].se_mt), &tm, &tn, tscls, lums, GB, zpars);
                         bse_hrdiag(&(star[k].se_mass), &aj_k, &(star[k].se_mt), &tm, &tn, tscls, lums, GB, zpars,
                                    &(star[k].se_radius), &(star[k].se_lum), &(star[k].se_k), &(star[k].se_mc), &(star[k].se_rc),
@@ -470,6 +503,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 
                         aj_kp = star[kp].se_tphys - star[kp].se_epoch;
                         star[kp].se_mt = star[kp].se_mc;
+                        star[kp].se_pristine = 0;
                         bse_star(&(star[kp].se_k), &(star[kp].se_mass), &(star[kp].se_mt), &tm, &tn, tscls, lums, GB, zpars);
                         bse_hrdiag(&(star[kp].se_mass), &aj_kp, &(star[kp].se_mt), &tm, &tn, tscls, lums, GB, zpars,
                                    &(star[kp].se_radius), &(star[kp].se_lum), &(star[kp].se_k), &(star[kp].se_mc), &(star[kp].se_rc),
@@ -478,8 +512,8 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
                         star[kp].rad = star[kp].se_radius * RSUN / units.l;
                         mass_kp = star[kp].se_mt * MSUN / units.mstar;
 
-                        DMse -= mass_k * madhoc;
-                        DMse -= mass_kp * madhoc;
+                        exact_sum_add(&DMse_sum, -mass_k * madhoc);
+                        exact_sum_add(&DMse_sum, -mass_kp * madhoc);
 
                         /* form compact binary with stripped RG cores*/
                         /* put new binary together and destroy original stars */
@@ -576,13 +610,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 
 
                         /* log collision */
-                        parafprintf(collisionfile, "t=%g single-single idm=%ld(mm=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typem=%d type1=%d type2=%d b[RSUN]=%g vinf[km/s]=%g rad1=%g rad2=%g rperi=%g coll_mult=%g\n",
-                                TotalTime,
-                                star[knew].id, star_m[get_global_idx(knew)] * units.mstar / FB_CONST_MSUN,
-                                star[k].id, mass_k * units.mstar / FB_CONST_MSUN,
-                                star[kp].id, mass_kp * units.mstar / FB_CONST_MSUN,
-                                star_r[get_global_idx(knew)], star[knew].se_k, star[k].se_k, star[kp].se_k,
-                    b*units.l/RSUN,W*units.l/units.t/1.e5, star[k].rad*units.l/RSUN, star[kp].rad*units.l/RSUN, rperi*units.l/RSUN, collisions_multiple_hold);
+                        sscollision_log(knew, k, mass_k, kp, mass_kp, b, W, rperi, collisions_multiple_hold);
 
                         /* destroy two progenitors */
                         destroy_obj(k);
@@ -769,13 +797,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
 
 
                 /* log collision */
-                parafprintf(collisionfile, "t=%g single-single idm=%ld(mm=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typem=%d type1=%d type2=%d b[RSUN]=%g vinf[km/s]=%g rad1=%g rad2=%g rperi=%g coll_mult=%g\n",
-                        TotalTime,
-                        star[knew].id, star_m[get_global_idx(knew)] * units.mstar / FB_CONST_MSUN,
-                        star[k].id, mass_k * units.mstar / FB_CONST_MSUN,
-                        star[kp].id, mass_kp * units.mstar / FB_CONST_MSUN,
-                        star_r[get_global_idx(knew)], star[knew].se_k, star[k].se_k, star[kp].se_k,
-            b*units.l/RSUN,W*units.l/units.t/1.e5, star[k].rad*units.l/RSUN, star[kp].rad*units.l/RSUN, rperi*units.l/RSUN, collisions_multiple);
+                sscollision_log(knew, k, mass_k, kp, mass_kp, b, W, rperi, collisions_multiple);
 
                 /* destroy two progenitors */
                 destroy_obj(k);
@@ -869,13 +891,7 @@ void sscollision_do(long k, long kp, double rperimax, double w[4], double W, dou
                                         - 0.5 * star_m[g_knew] * madhoc * star_phi[g_knew];
 
                                 /* log collision */
-                                parafprintf(collisionfile, "t=%g single-single idm=%ld(mm=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typem=%d type1=%d type2=%d b[RSUN]=%g vinf[km/s]=%g rad1=%g rad2=%g rperi=%g coll_mult=%g\n",
-                                        TotalTime,
-                                        star[knew].id, star_m[get_global_idx(knew)] * units.mstar / FB_CONST_MSUN,
-                                        star[k].id, mass_k * units.mstar / FB_CONST_MSUN,
-                                        star[kp].id, mass_kp * units.mstar / FB_CONST_MSUN,
-                                        star_r[get_global_idx(knew)], star[knew].se_k, star[k].se_k, star[kp].se_k,
-                            b*units.l/RSUN,W*units.l/units.t/1.e5, star[k].rad*units.l/RSUN, star[kp].rad*units.l/RSUN, rperi*units.l/RSUN, rperi/(star[k].rad+star[kp].rad));
+                                sscollision_log(knew, k, mass_k, kp, mass_kp, b, W, rperi, rperi/(star[k].rad+star[kp].rad));
 
                                 /* destroy two progenitors */
                                 destroy_obj(k);
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <float.h>
+#include <string.h>
 
 #include "cmc.h"
 #include "cmc_vars.h"
@@ -87,6 +88,9 @@ void restart_stellar_evolution(void){
 
   /*Set rng to saved rng seed*/
   bse_set_taus113state(*curr_st, 0);
+
+  /* rebuild (or reload) the single-star tracks */
+  se_track_cache_init();
 }
 
 /**
@@ -184,6 +188,7 @@ void stellar_evolution_init(void){
     if (star[k].binind == 0) { /* single star */
       star[k].se_mass = star_m[g_k] * units.mstar / MSUN;
 	  star[k].zams_mass = star[k].se_mass;
+	  star[k].se_pristine = 1;
       /* setting the type */
       if(star[k].se_mass <= 0.7){
         star[k].se_k = 0;
@@ -202,7 +207,7 @@ void stellar_evolution_init(void){
       tphysf = 1.0e-6;
       dtp = tphysf - star[k].se_tphys;
       dtp = 0.0;
-      DMse += star_m[g_k] * madhoc;
+      exact_sum_add(&DMse_sum, star_m[g_k] * madhoc);
       /* Update star id for pass through. */
       bse_set_id1_pass(star[k].id);
       bse_set_id2_pass(0);
@@ -278,7 +283,7 @@ void stellar_evolution_init(void){
 
       star[k].rad = star[k].se_radius * RSUN / units.l;
       star_m[g_k] = star[k].se_mt * MSUN / units.mstar;
-      DMse -= star_m[g_k] * madhoc;
+      exact_sum_add(&DMse_sum, -star_m[g_k] * madhoc);
       /* birth kicks */
       if (sqrt(vs[1]*vs[1]+vs[2]*vs[2]+vs[2]*vs[2]) != 0.0) {
         //dprintf("birth kick of %f km/s\n", sqrt(vs[0]*vs[0]+vs[1]*vs[1]+vs[2]*vs[2]));
@@ -319,7 +324,7 @@ void stellar_evolution_init(void){
       tphysf = 1.0e-6;
       dtp = tphysf - binary[kb].bse_tphys;
       dtp = 0.0;
-      DMse += (binary[kb].m1 + binary[kb].m2) * madhoc;
+      exact_sum_add(&DMse_sum, (binary[kb].m1 + binary[kb].m2) * madhoc);
       /* Update star id for pass through. */
       bse_set_id1_pass(binary[kb].id1);
       bse_set_id2_pass(binary[kb].id2);
@@ -341,11 +346,12 @@ void stellar_evolution_init(void){
   }
 
 	double tmpTimeStart = timeStartSimple();
-  //if(myid==0)
-    MPI_Allreduce(MPI_IN_PLACE, &DMse, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  //else
-  //  MPI_Allreduce(&DMse, &DMse, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  exact_sum_allreduce(&DMse_sum, 1, MPI_COMM_WORLD);
+  DMse = exact_sum_value(&DMse_sum);
 	timeEndSimple(tmpTimeStart, &t_comm);
+
+  /* tabulate the single-star tracks, now that the ZAMS masses are known */
+  se_track_cache_init();
 }
 
 /* note that this routine is called after perturb_stars() and get_positions() */
@@ -356,8 +362,8 @@ void stellar_evolution_init(void){
 */
 void do_stellar_evolution(gsl_rng *rng)
 {
-  long k, kb, j, jj;
-  int kprev,i, ii;
+  long k, kb;
+  int kprev, ii;
   int kprev0, kprev1;
   double dtp, tphysf, vs[20], VKO;
   double M_beforeSE, M10_beforeSE, M100_beforeSE, M1000_beforeSE, Mcore_beforeSE;
@@ -366,8 +372,20 @@ void do_stellar_evolution(gsl_rng *rng)
   double dM_dt_SE10, dM_dt_SE100, dM_dt_SE1000, dM_dt_SEcore; 
   struct rng_t113_state temp_state;
   int reduced_timestep=0;
-  binary_t tempbinary;
+  int have_track;
+  double track[SE_TRACK_NQ], tstart;
+  se_task_t *setask, setask_local;
+  peters_batch_t peters_batch;
   bse_set_merger(-1.0);
+
+  /* collect the single-star tracks prefetched during the dynamics */
+  se_overlap_finish();
+
+  /* hand part of the single-star BSE work of overloaded processors to others */
+  se_balance_exchange(TotalTime / MEGA_YEAR);
+
+  /* advance the binary black holes that are far from merger all at once */
+  peters_batch_init(&peters_batch);
   /* double vk, theta; */
 
   //MPI: The serial version runs till N_MAX_NEW+1 to account for the sentinel. But in the parallel version, there is no sentinel, so runs only till N_MAX_NEW.
@@ -383,139 +401,28 @@ void do_stellar_evolution(gsl_rng *rng)
       if (star_m[get_global_idx(k)]<=DBL_MIN && star[k].vr==0. && star[k].vt==0. && star[k].E==0. && star[k].J==0.){ //ignoring zeroed out stars
         dprintf ("zeroed out star: skipping SE:\n"); 
         dprintf ("k=%ld m=%g r=%g phi=%g vr=%g vt=%g E=%g J=%g\n", k, star_m[g_k], star_r[g_k], star_phi[g_k], star[k].vr, star[k].vt, star[k].E, star[k].J);
+      } else if (se_track_evolve(k, tphysf)) {
+        /* unperturbed single star moved along its tabulated track, no type change */
       } else {
-        DMse += star_m[g_k] * madhoc;
-        /* Update star id for pass through. */
-        bse_set_id1_pass(star[k].id);
-        bse_set_id2_pass(0);
-        tempbinary.bse_mass0[0] = star[k].se_mass;
-        tempbinary.bse_mass0[1] = 0.0;
-        tempbinary.bse_kw[0] = star[k].se_k;
-        tempbinary.bse_kw[1] = 15;
-        tempbinary.bse_mass[0] = star[k].se_mt;
-        tempbinary.bse_mass[1] = 0.0;
-        tempbinary.bse_radius[0] = star[k].se_radius;
-        tempbinary.bse_radius[1] = 0.0;
-        tempbinary.bse_lum[0] = star[k].se_lum;
-        tempbinary.bse_lum[1] = 0.0;
-        tempbinary.bse_massc[0] = star[k].se_mc;
-        tempbinary.bse_massc[1] = 0.0;
-        tempbinary.bse_radc[0] = star[k].se_rc;
-        tempbinary.bse_radc[1] = 0.0;
-        tempbinary.bse_menv[0] = star[k].se_menv;
-        tempbinary.bse_menv[1] = 0.0;
-        tempbinary.bse_renv[0] = star[k].se_renv;
-        tempbinary.bse_renv[1] = 0.0;
-        tempbinary.bse_ospin[0] = star[k].se_ospin;
-        tempbinary.bse_ospin[1] = 0.0;
-        tempbinary.bse_B_0[0] = star[k].se_B_0;
-        tempbinary.bse_B_0[1] = 0.0;
-        tempbinary.bse_bacc[0] = star[k].se_bacc;
-        tempbinary.bse_bacc[1] = 0.0;
-        tempbinary.bse_tacc[0] = star[k].se_tacc;
-        tempbinary.bse_tacc[1] = 0.0;
-        tempbinary.bse_epoch[0] = star[k].se_epoch;
-        tempbinary.bse_epoch[1] = 0.0;
-        tempbinary.bse_tms[0] = star[k].se_tms;
-        tempbinary.bse_tms[1] = 0.0;
-        tempbinary.bse_bhspin[0] = star[k].se_bhspin;
-        tempbinary.bse_bhspin[1] = 0.0;
-        tempbinary.bse_tb = 0.0;
-        tempbinary.e = 0.0;
-
-		  /*If we've got a large MS star, we need to reduce the timestep, otherwise
-		   * we miss the transition from MS to HG to giant, and won't start applying
-		   * winds for massive stars at the right time*/
-		  if(star[k].zams_mass > 18){
-			  bse_set_pts1(BSE_PTS1/10.);
-			  reduced_timestep = 1;
-		  }
-        /*
-          bse_evolv1(&(star[k].se_k), &(star[k].se_mass), &(star[k].se_mt), &(star[k].se_radius), 
-          &(star[k].se_lum), &(star[k].se_mc), &(star[k].se_rc), &(star[k].se_menv), 
-          &(star[k].se_renv), &(star[k].se_ospin), &(star[k].se_epoch), &(star[k].se_tms), 
-          &(star[k].se_tphys), &tphysf, &dtp, &METALLICITY, zpars, vs);
-         */
-        bse_set_taus113state(*curr_st, 0);
-        bse_evolv2_safely(&(tempbinary.bse_kw[0]), &(tempbinary.bse_mass0[0]), &(tempbinary.bse_mass[0]), 
-            &(tempbinary.bse_radius[0]), &(tempbinary.bse_lum[0]), &(tempbinary.bse_massc[0]), 
-            &(tempbinary.bse_radc[0]), &(tempbinary.bse_menv[0]), &(tempbinary.bse_renv[0]), 
-            &(tempbinary.bse_ospin[0]), &(tempbinary.bse_B_0[0]), &(tempbinary.bse_bacc[0]), &(tempbinary.bse_tacc[0]), 
-            &(tempbinary.bse_epoch[0]), &(tempbinary.bse_tms[0]), 
-            &(star[k].se_tphys), &tphysf, &dtp, &METALLICITY, zpars, 
-            &(tempbinary.bse_tb), &(tempbinary.e), vs, &(tempbinary.bse_bhspin[0]));
-        *curr_st=bse_get_taus113state();
-
-        star[k].se_mass = tempbinary.bse_mass0[0];
-        star[k].se_k = tempbinary.bse_kw[0];
-        star[k].se_mt = tempbinary.bse_mass[0];
-        star[k].se_radius = tempbinary.bse_radius[0];
-        star[k].se_lum = tempbinary.bse_lum[0];
-        star[k].se_mc = tempbinary.bse_massc[0];
-        star[k].se_rc = tempbinary.bse_radc[0];
-        star[k].se_menv = tempbinary.bse_menv[0];
-        star[k].se_renv = tempbinary.bse_renv[0];
-        star[k].se_ospin = tempbinary.bse_ospin[0];
-        star[k].se_B_0 = tempbinary.bse_B_0[0];
-        star[k].se_bacc = tempbinary.bse_bacc[0];
-        star[k].se_tacc = tempbinary.bse_tacc[0];
-        star[k].se_epoch = tempbinary.bse_epoch[0];
-        star[k].se_tms = tempbinary.bse_tms[0];
-	star[k].se_bhspin = tempbinary.bse_bhspin[0];
-
-		  /*Reset the MS timestep once we're done*/
-		  if(reduced_timestep == 1)
-			  bse_set_pts1(BSE_PTS1);
+        /* in validation mode, remember where the track says the star should end up */
+        have_track = (SE_TRACK_CACHE == 2) ? se_track_lookup(k, tphysf, track) : 0;
+        exact_sum_add(&DMse_sum, star_m[g_k] * madhoc);
+        /* evolve with BSE, unless that was already done on another processor */
+        if ((setask = se_balance_result(k)) == NULL) {
+          se_task_from_star(&setask_local, k);
+          se_evolve_single_bse(&setask_local, tphysf);
+          setask = &setask_local;
+        }
+        se_task_to_star(setask, k);
+        for (ii=0; ii<20; ii++) vs[ii] = setask->vs[ii];
+
+        if (have_track) {
+          se_track_validate(k, track);
+        }
 
         star[k].rad = star[k].se_radius * RSUN / units.l;
         star_m[g_k] = star[k].se_mt * MSUN / units.mstar;
-        DMse -= star_m[g_k] * madhoc;
-
-        /* extract info from scm array */ /* PK looping over a large number anticipating further changes */
-	        i = 1;
-	        j = 1;
-        	while (bse_get_bcm(i,1)>=0.0 && i < 50000) {
-          		if(i > 1) {
-            			if(bse_get_bcm(i,2) == 13 && bse_get_bcm(i-1,2) < 13){
-              				if(bse_get_bcm(i+1,1) >= 0.0){
-                				star[k].se_scm_formation = bse_get_bcm(i+1,35);
-                //printf("stel, pulsar sin. 1 : %g %g %g %g %ld \n",star[k].se_B_0,star[k].se_ospin,bse_get_bcm(i+1,33),star[k].se_scm_formation,star[k].id);
-              				} else {
-                				star[k].se_scm_formation = bse_get_bcm(i,35);
-                //printf("stel, pulsar sin. 2 : %g %g %g %g %ld \n",star[k].se_B_0,star[k].se_ospin,bse_get_scm(i,33),star[k].se_scm_formation,star[k].id);
-              				}
-            			}
-          		}
-          		i++;
-        	}
-        	i--;
-        	if(i+1 > 50000){
-          		i = 0;
-        	}
-        	if(i>=1) {
-          		if(i>1){
-            			star[k].se_scm_B = bse_get_bcm(i,33);
-            			if(star[k].se_k == 13) {
-              //printf("stel, pulsar sin. 3 : %g %g %g \n",star[k].se_B_0,star[k].se_ospin,star[k].se_scm_B);
-            			}
-          		} else {
-            			star[k].se_scm_B = bse_get_bcm(i,33);
-            			if(star[k].se_k == 13) {
-              //printf("stel, pulsar sin. 4 : %g %g %g \n",star[k].se_B_0,star[k].se_ospin,star[k].se_scm_B);
-            			}
-          		}
-        	} else {
-          /*         bse_evolv1(&(star[k].se_k), &(star[k].se_mass), &(star[k].se_mt), &(star[k].se_radius), 
-                     &(star[k].se_lum), &(star[k].se_mc), &(star[k].se_rc), &(star[k].se_menv), 
-                     &(star[k].se_renv), &(star[k].se_ospin), 
-                     &(star[k].se_B_0), &(star[k].se_bacc), &(star[k].se_tacc), 
-                     &(star[k].se_epoch), &(star[k].se_tms), 
-                     &(star[k].se_tphys), &tphysf, &dtp, &METALLICITY, zpars, vs); */
-          		eprintf("Couldn't extract iso star bse info (looking for pulsar data)...");
-          		eprintf("Evolv1 info from non scm extraction: k=%ld, kw=%d mass=%g mt=%g rad=%g lum=%g tphysf=%g dtp=%g ",k,star[k].se_k,star[k].se_mass,star[k].se_mt,star[k].se_radius,star[k].se_lum,tphysf,dtp);
-          //           exit_cleanly(-1); //should only enter here if no bcm array entry, 
-          //                               and that should only happen to uninteresting systems and/or outcomes.
-        	}
+        exact_sum_add(&DMse_sum, -star_m[g_k] * madhoc);
 
         /* birth kicks */
         if (sqrt(vs[1]*vs[1]+vs[2]*vs[2]+vs[3]*vs[3]) != 0.0) {
@@ -592,16 +499,18 @@ void do_stellar_evolution(gsl_rng *rng)
 
         /* set binary orbital period (in days) from a */
         binary[kb].bse_tb = sqrt(cub(binary[kb].a * units.l / AU)/(binary[kb].bse_mass[0]+binary[kb].bse_mass[1]))*365.25;
-        DMse += (binary[kb].m1 + binary[kb].m2) * madhoc;
+        exact_sum_add(&DMse_sum, (binary[kb].m1 + binary[kb].m2) * madhoc);
         /* Update star id for pass through. */
         bse_set_id1_pass(binary[kb].id1);
         bse_set_id2_pass(binary[kb].id2);
 		/* If this is a binary black hole, skip BSE and explicitly integrate the
 		 * Peters equations*/
 		if(binary[kb].bse_kw[0] == 14 && binary[kb].bse_kw[1] == 14){
-			integrate_a_e_peters_eqn(kb);
+			if (!peters_batch_apply(&peters_batch, k, kb))
+				integrate_a_e_peters_eqn(kb);
 			for (ii = 0 ; ii < 16 ; ii++) vs[ii] = 0.;
 		} else{
+			tstart = MPI_Wtime();
 			bse_set_taus113state(*curr_st, 0);
 			bse_evolv2_safely(&(binary[kb].bse_kw[0]), &(binary[kb].bse_mass0[0]), &(binary[kb].bse_mass[0]), &(binary[kb].bse_radius[0]), 
 				&(binary[kb].bse_lum[0]), &(binary[kb].bse_massc[0]), &(binary[kb].bse_radc[0]), &(binary[kb].bse_menv[0]), 
@@ -611,6 +520,8 @@ void do_stellar_evolution(gsl_rng *rng)
 				&(binary[kb].bse_tphys), &tphysf, &dtp, &METALLICITY, zpars, 
 				&(binary[kb].bse_tb), &(binary[kb].e), vs, &(binary[kb].bse_bhspin[0]));
 			*curr_st=bse_get_taus113state();
+			star[k].se_cost = MPI_Wtime() - tstart;
+			se_cost_record(star[k].id, star[k].se_cost);
 		}
 
 		/*Reset the MS timestep once we're done*/
@@ -654,22 +565,18 @@ void do_stellar_evolution(gsl_rng *rng)
     }
     bh_count(k);
   }
+  peters_batch_free(&peters_batch);
+  se_balance_free();
 
   double tmpTimeStart = timeStartSimple();
-  double temp = 0.0;
-
-  MPI_Status stat;
-  
-  //MPI: If we use the MPI_Reduce call, we have no control over the order in which the summing is done, so, we avoid that by using send/recv calls and sum up in order to avoid round-off errors and comparison with serial version.
-  if(myid!=0)
-    MPI_Send(&DMse, 1, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
-  else
-    for(i=1;i<procs;i++)
-    {
-      MPI_Recv(&temp, 1, MPI_DOUBLE, i, 0, MPI_COMM_WORLD, &stat);
-      DMse += temp;
-    }
+  //MPI: The mass loss of every star was added to DMse_sum exactly, so the reduced total does not depend on the order of the summation or on the number of processors, and matches the serial version bit for bit.
+  exact_sum_allreduce(&DMse_sum, 1, MPI_COMM_WORLD);
+  DMse = exact_sum_value(&DMse_sum);
 	timeEndSimple(tmpTimeStart, &t_comm);
+
+  if (SE_TRACK_CACHE) {
+    se_track_print_stats();
+  }
 }
 
 /**
@@ -685,8 +592,8 @@ void write_stellar_data(void){
   sprintf(filename, "%s_stellar_info.%05d.dat", outprefix, se_file_counter);
 
   MPI_File mpi_stel_file;
-  char mpi_stel_file_buf[10000], mpi_stel_file_wrbuf[10000000];
-  long long mpi_stel_file_len=0, mpi_stel_file_ofst_total=0;
+  parabuf_t mpi_stel_file_wrbuf = {NULL, 0, 0};
+  long long mpi_stel_file_ofst_total=0;
   MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &mpi_stel_file);
   MPI_File_set_size(mpi_stel_file, 0);
 
@@ -713,7 +620,7 @@ void write_stellar_data(void){
     parafprintf(stel_file, "%08d ", get_global_idx(k));
   }
 
-  mpi_para_file_write(mpi_stel_file_wrbuf, &mpi_stel_file_len, &mpi_stel_file_ofst_total, &mpi_stel_file);
+  mpi_para_file_write(&mpi_stel_file_wrbuf, &mpi_stel_file_ofst_total, &mpi_stel_file);
   MPI_File_close(&mpi_stel_file);
 
   /* binary star info */
@@ -752,8 +659,55 @@ void write_stellar_data(void){
         binary[kb].bse_tacc[0], binary[kb].bse_tacc[1]);
     }
   }
-  mpi_para_file_write(mpi_stel_file_wrbuf, &mpi_stel_file_len, &mpi_stel_file_ofst_total, &mpi_stel_file);
+  mpi_para_file_write(&mpi_stel_file_wrbuf, &mpi_stel_file_ofst_total, &mpi_stel_file);
   MPI_File_close(&mpi_stel_file);
+  parabuf_free(&mpi_stel_file_wrbuf);
+}
+
+/**
+* @brief Writes a semergedisrupt file entry, either as a line of text or, if BINARY_LOGS is set, as a binary record
+*
+* @param kind disruptboth, disrupt1 or disrupt2
+* @param remnant 1 if one star remains, described by idr, mr and typer
+* @param idr id of the remaining star
+* @param mr mass of the remaining star [MSUN]
+* @param id1 id of star 1
+* @param m1 mass of star 1 [MSUN]
+* @param id2 id of star 2
+* @param m2 mass of star 2 [MSUN]
+* @param r position of the binary
+* @param typer stellar type of the remaining star
+* @param type1 stellar type of star 1
+* @param type2 stellar type of star 2
+*/
+static void log_semergedisrupt(const char *kind, int remnant, long idr, double mr, long id1, double m1,
+			       long id2, double m2, double r, int typer, int type1, int type2)
+{
+	evlog_semerge_t rec;
+	char line[EVLOG_LINE_LEN];
+	int n;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.t = TotalTime;
+	strncpy(rec.kind, kind, EVLOG_NAME_LEN-1);
+	rec.remnant = remnant;
+	rec.idr = idr;
+	rec.mr = mr;
+	rec.id1 = id1;
+	rec.m1 = m1;
+	rec.id2 = id2;
+	rec.m2 = m2;
+	rec.r = r;
+	rec.typer = typer;
+	rec.type1 = type1;
+	rec.type2 = type2;
+
+	if (BINARY_LOGS) {
+		parabuf_append(&mpi_semergedisruptfile_wrbuf, &rec, sizeof(rec));
+	} else {
+		n = evlog_semerge_format(line, sizeof(line), &rec);
+		parabuf_append(&mpi_semergedisruptfile_wrbuf, line, n < (int) sizeof(line) ? n : (int) sizeof(line) - 1);
+	}
 }
 
 /**
@@ -858,7 +812,7 @@ void handle_bse_outcome(long k, long kb, double *vs, double tphysf, int kprev0,
     binary[kb].m2 = binary[kb].bse_mass[1] * MSUN / units.mstar;
     int g_k = get_global_idx(k);
     star_m[g_k] = binary[kb].m1 + binary[kb].m2;
-    DMse -= star_m[g_k] * madhoc;
+    exact_sum_add(&DMse_sum, -star_m[g_k] * madhoc);
     binary[kb].a = pow((binary[kb].bse_mass[0]+binary[kb].bse_mass[1])*sqr(binary[kb].bse_tb/365.25), 1.0/3.0)
       * AU / units.l;
     if (sqrt(vs[1]*vs[1]+vs[2]*vs[2]+vs[3]*vs[3]) != 0.0) {
@@ -915,13 +869,12 @@ void handle_bse_outcome(long k, long kb, double *vs, double tphysf, int kprev0,
     knewp = create_star(k, 1);
     cp_binmemb_to_star(k, 0, knew);
     cp_binmemb_to_star(k, 1, knewp);
-    DMse -= (star_m[get_global_idx(knew)] + star_m[get_global_idx(knewp)]) * madhoc;
+    exact_sum_add(&DMse_sum, -(star_m[get_global_idx(knew)] + star_m[get_global_idx(knewp)]) * madhoc);
 
-    parafprintf(semergedisruptfile, "t=%g disruptboth id1=%ld(m1=%g) id2=%ld(m2=%g) (r=%g) type1=%d type2=%d\n",
-      TotalTime,
+    log_semergedisrupt("disruptboth", 0, 0, 0.0,
       star[knew].id, star[knew].se_mt, 
       star[knewp].id, star_m[get_global_idx(knewp)] * units.mstar / FB_CONST_MSUN,
-      star_r[get_global_idx(k)], kprev0, kprev1);
+      star_r[get_global_idx(k)], 0, kprev0, kprev1);
 
     destroy_obj(k);
     /* in this case vs is relative speed between stars at infinity */
@@ -1037,8 +990,7 @@ void handle_bse_outcome(long k, long kb, double *vs, double tphysf, int kprev0,
 	if(kprev0 == 14 && kprev1 == 14)
 		binary_bh_merger(k, kb, knew, kprev0, kprev1, curr_st);
 
-    parafprintf(semergedisruptfile, "t=%g disrupt1 idr=%ld(mr=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typer=%d type1=%d type2=%d\n",
-      TotalTime,
+    log_semergedisrupt("disrupt1", 1,
       star[knew].id, star[knew].se_mt,
       binary[kb].id1, binary[kb].m1 * units.mstar / FB_CONST_MSUN,
       binary[kb].id2, binary[kb].m2 * units.mstar / FB_CONST_MSUN,
@@ -1102,7 +1054,7 @@ void handle_bse_outcome(long k, long kb, double *vs, double tphysf, int kprev0,
     
     star[knew].rad = star[knew].se_radius * RSUN / units.l;
     star_m[get_global_idx(knew)] = star[knew].se_mt * MSUN / units.mstar;
-    DMse -= star_m[get_global_idx(knew)] * madhoc;
+    exact_sum_add(&DMse_sum, -star_m[get_global_idx(knew)] * madhoc);
 
     /* birth kicks */
     /* ALSO REMOVE BELOW AS WE NOW WONT PRODUCE ANOTHER KICK
@@ -1129,8 +1081,7 @@ void handle_bse_outcome(long k, long kb, double *vs, double tphysf, int kprev0,
 	if(kprev0 == 14 && kprev1 == 14)
 		binary_bh_merger(k, kb, knew, kprev0, kprev1, curr_st);
 
-    parafprintf(semergedisruptfile, "t=%g disrupt2 idr=%ld(mr=%g) id1=%ld(m1=%g):id2=%ld(m2=%g) (r=%g) typer=%d type1=%d type2=%d\n",
-      TotalTime,
+    log_semergedisrupt("disrupt2", 1,
       star[knew].id, star[knew].se_mt,
       binary[kb].id1, binary[kb].m1 * units.mstar / FB_CONST_MSUN,
       binary[kb].id2, binary[kb].m2 * units.mstar / FB_CONST_MSUN,
@@ -1195,7 +1146,7 @@ void handle_bse_outcome(long k, long kb, double *vs, double tphysf, int kprev0,
     
     star[knew].rad = star[knew].se_radius * RSUN / units.l;
     star_m[get_global_idx(knew)] = star[knew].se_mt * MSUN / units.mstar;
-    DMse -= star_m[get_global_idx(knew)] * madhoc;
+    exact_sum_add(&DMse_sum, -star_m[get_global_idx(knew)] * madhoc);
 
     /* birth kicks */
     /* REMOVED AGAIN NOT TO ADD KICK AGAIN
@@ -1830,14 +1781,27 @@ void cp_starmass_to_binmember(star_t instar, long binindex, int bid)
 int rhs_peters(double t, const double y[], double f[], void *params){
 	/* dadt and dedt from Peters 1964; note that this is entirely in code units! */
 	double *mG3c5 = (double *) params;
-	f[0] = -((12.8) * (*mG3c5) / (y[0]*y[0]*y[0]*pow(1-y[1]*y[1],3.5)))
-			*(1+3.041666666666667*y[1]*y[1] + 0.3854166666666667*y[1]*y[1]*y[1]*y[1]);
-	f[1] = -((20.2666666666667) * y[1] * (*mG3c5) / (y[0]*y[0]*y[0]*y[0]*pow(1-y[1]*y[1],2.5)))
-			*(1+0.3980263157894737*y[1]*y[1]);
+	peters_rhs(*mG3c5, y[0], y[1], &f[0], &f[1]);
 
 	return GSL_SUCCESS;
 }
 
+/**
+* @brief da/dt and de/dt from Peters 1964, in code units
+*
+* @param mG3c5 prefactor m1*m2*(m1+m2)*madhoc^3/c^5
+* @param a semi-major axis
+* @param e eccentricity
+* @param dadt da/dt
+* @param dedt de/dt
+*/
+void peters_rhs(double mG3c5, double a, double e, double *dadt, double *dedt){
+	*dadt = -((12.8) * mG3c5 / (a*a*a*pow(1-e*e,3.5)))
+			*(1+3.041666666666667*e*e + 0.3854166666666667*e*e*e*e);
+	*dedt = -((20.2666666666667) * e * mG3c5 / (a*a*a*a*pow(1-e*e,2.5)))
+			*(1+0.3980263157894737*e*e);
+}
+
 void integrate_a_e_peters_eqn(long kb){
 	double t = 0.;
 	double h = 1.e-9;
@@ -1887,6 +1851,25 @@ void integrate_a_e_peters_eqn(long kb){
 		}
 	}
 
+	peters_apply(kb, y[0], y[1], collision);
+
+	/* all done; free up the gsl_odeiv stuff */
+	gsl_odeiv2_evolve_free (evolve_ptr);
+	gsl_odeiv2_control_free (control_ptr);
+	gsl_odeiv2_step_free (step_ptr);
+
+	return;
+}
+
+/**
+* @brief stores the result of the Peters integration of a binary black hole
+*
+* @param kb binary index
+* @param a new semi-major axis (code units)
+* @param e new eccentricity
+* @param collision whether the binary merged during the timestep
+*/
+void peters_apply(long kb, double a, double e, int collision){
 	/* If we have a collision, then set the BSE mass to zero, and
 	 * handle_bse_outcome will treat it correctly
 	 *
@@ -1896,18 +1879,164 @@ void integrate_a_e_peters_eqn(long kb){
 		binary[kb].bse_mass[1] = 0.;
 		binary[kb].bse_tb = 0.;
 	} else {
-		binary[kb].a = y[0];
-		binary[kb].e = y[1];
+		binary[kb].a = a;
+		binary[kb].e = e;
 		binary[kb].bse_tb = sqrt(cub(binary[kb].a * units.l / AU)/(binary[kb].bse_mass[0]+binary[kb].bse_mass[1]))*365.25;
 		/* This is used to set a again in handle_bse_outcome; easier to just set
 		 * it here as well*/
 	}
+}
 
-	/* all done; free up the gsl_odeiv stuff */
-	gsl_odeiv2_evolve_free (evolve_ptr);
-	gsl_odeiv2_control_free (control_ptr);
-	gsl_odeiv2_step_free (step_ptr);
+/* number of fixed RK4 steps taken by the fast path */
+#define PETERS_FAST_NSTEP 4
 
-	return;
+/**
+* @brief Advances a batch of binary black holes by t_final under the Peters
+* equations without the adaptive integrator.  Circular binaries follow the exact
+* solution a^4 = a0^4 - 4*beta*t.  Eccentric binaries whose timestep is short
+* compared to their inspiral time a/|da/dt| (by PETERS_FAST_PATH_TOL) take
+* PETERS_FAST_NSTEP classical RK4 steps, whose error is far below the GSL
+* tolerance in that regime.  Everything else is flagged PETERS_NEAR_MERGER and
+* left to integrate_a_e_peters_eqn().
+*
+* @param n number of binaries
+* @param a semi-major axes, updated in place
+* @param e eccentricities, updated in place
+* @param mG3c5 Peters prefactors
+* @param rmin pericenter distances below which the binaries merge
+* @param t_final length of the timestep (code units)
+* @param status outcome for each binary
+*/
+void peters_fast_path(long n, double *a, double *e, double *mG3c5, double *rmin, double t_final, int *status){
+	long i;
+	int j;
+	double a4, dadt, dedt, h, ya, ye, ka[4], ke[4];
+
+	h = t_final / PETERS_FAST_NSTEP;
+	for (i=0; i<n; i++) {
+		if (e[i] == 0.0) {
+			a4 = sqr(sqr(a[i])) - 51.2 * mG3c5[i] * t_final;
+			if (a4 <= sqr(sqr(rmin[i]))) {
+				status[i] = PETERS_MERGED;
+			} else {
+				a[i] = sqrt(sqrt(a4));
+				status[i] = PETERS_DONE;
+			}
+			continue;
+		}
+
+		peters_rhs(mG3c5[i], a[i], e[i], &dadt, &dedt);
+		if (t_final * fabs(dadt) >= PETERS_FAST_PATH_TOL * a[i]) {
+			status[i] = PETERS_NEAR_MERGER;
+			continue;
+		}
+
+		for (j=0; j<PETERS_FAST_NSTEP; j++) {
+			ka[0] = dadt;
+			ke[0] = dedt;
+			ya = a[i] + 0.5 * h * ka[0];
+			ye = e[i] + 0.5 * h * ke[0];
+			peters_rhs(mG3c5[i], ya, ye, &ka[1], &ke[1]);
+			ya = a[i] + 0.5 * h * ka[1];
+			ye = e[i] + 0.5 * h * ke[1];
+			peters_rhs(mG3c5[i], ya, ye, &ka[2], &ke[2]);
+			ya = a[i] + h * ka[2];
+			ye = e[i] + h * ke[2];
+			peters_rhs(mG3c5[i], ya, ye, &ka[3], &ke[3]);
+			a[i] += h / 6.0 * (ka[0] + 2.0 * ka[1] + 2.0 * ka[2] + ka[3]);
+			e[i] += h / 6.0 * (ke[0] + 2.0 * ke[1] + 2.0 * ke[2] + ke[3]);
+			peters_rhs(mG3c5[i], a[i], e[i], &dadt, &dedt);
+		}
+		e[i] = MAX(e[i], 0.0);
+
+		status[i] = (a[i]*(1-e[i]) < rmin[i]) ? PETERS_MERGED : PETERS_DONE;
+	}
+}
+
+/**
+* @brief Collects all local binary black holes before the stellar evolution
+* loop and advances them together with peters_fast_path().
+*
+* @param pb batch to fill
+*/
+void peters_batch_init(peters_batch_t *pb){
+	long k, kb, i;
+	double clight, t_final;
+
+	pb->n = 0;
+	pb->kmax = 0;
+	pb->slot = NULL;
+	if (PETERS_FAST_PATH_TOL <= 0.0) {
+		return;
+	}
+
+	pb->kmax = clus.N_MAX_NEW;
+	pb->slot = (long *) malloc((pb->kmax+1) * sizeof(long));
+	for (k=1; k<=pb->kmax; k++) {
+		kb = star[k].binind;
+		if (kb > 0 && binary[kb].bse_kw[0] == 14 && binary[kb].bse_kw[1] == 14 && binary[kb].a > 0.0) {
+			pb->slot[k] = pb->n++;
+		} else {
+			pb->slot[k] = -1;
+		}
+	}
+
+	pb->a = (double *) malloc(pb->n * sizeof(double));
+	pb->e = (double *) malloc(pb->n * sizeof(double));
+	pb->mG3c5 = (double *) malloc(pb->n * sizeof(double));
+	pb->rmin = (double *) malloc(pb->n * sizeof(double));
+	pb->status = (int *) malloc(pb->n * sizeof(int));
+
+	/* same units and prefactor as integrate_a_e_peters_eqn() */
+	clight = 2.9979e10 / (units.l/units.t);
+	for (k=1; k<=pb->kmax; k++) {
+		if ((i = pb->slot[k]) < 0) continue;
+		kb = star[k].binind;
+		pb->a[i] = binary[kb].a;
+		pb->e[i] = binary[kb].e;
+		pb->mG3c5[i] = binary[kb].m1*binary[kb].m2*(binary[kb].m1+binary[kb].m2)*madhoc*madhoc*madhoc / (clight*clight*clight*clight*clight);
+		pb->rmin[i] = BH_RADIUS_MULTIPLYER*(binary[kb].rad1 + binary[kb].rad2);
+	}
+
+	t_final = Dt * ((double) clus.N_STAR)/ log(GAMMA * ((double) clus.N_STAR));
+	peters_fast_path(pb->n, pb->a, pb->e, pb->mG3c5, pb->rmin, t_final, pb->status);
+}
+
+/**
+* @brief Applies the fast-path result to a binary black hole, if it has one.
+*
+* @param pb batch
+* @param k local star index
+* @param kb binary index
+*
+* @return 1 if the binary was evolved, 0 if it still has to go through integrate_a_e_peters_eqn()
+*/
+int peters_batch_apply(peters_batch_t *pb, long k, long kb){
+	long i;
+
+	if (pb->slot == NULL || k > pb->kmax || (i = pb->slot[k]) < 0 || pb->status[i] == PETERS_NEAR_MERGER) {
+		return 0;
+	}
+
+	peters_apply(kb, pb->a[i], pb->e[i], pb->status[i] == PETERS_MERGED);
+	return 1;
+}
+
+/**
+* @brief frees a batch
+*
+* @param pb batch
+*/
+void peters_batch_free(peters_batch_t *pb){
+	if (pb->slot == NULL) {
+		return;
+	}
+	free(pb->slot);
+	free(pb->a);
+	free(pb->e);
+	free(pb->mG3c5);
+	free(pb->rmin);
+	free(pb->status);
+	pb->slot = NULL;
 }
 
@@ -230,6 +230,7 @@ void free_arrays(void){
 
 	/* MPI Stuff */
 	free(star_r); free(star_m); free(star_phi);
+	se_track_cache_free();
 //Probably not needed anymore
 //	free(new_size); free(disp); free(len);
 }
@@ -603,11 +604,12 @@ int CheckCheckpoint() {
 */
 void ComputeEnergy(void)
 {
-	//MPI: buffer for reduce
-	double buf_reduce[5], phi0 = 0.0;
+	//MPI: exact accumulators for the reduce; 0: K, 1: P, 2: Eint, 3: Eb
+	exact_sum_t buf_reduce[4];
+	double phi0 = 0.0;
 	int i, j=0;
-	for(i=0; i<5; i++)
-		buf_reduce[i] = 0.0;
+	for(i=0; i<4; i++)
+		exact_sum_init(&buf_reduce[i]);
 
 	for (i=1; i<=mpiEnd-mpiBegin+1; i++) {
 		j = get_global_idx(i);
@@ -620,32 +622,29 @@ void ComputeEnergy(void)
 	//MPI: Calculating these variables on each processor
 	for (i=1; i<=mpiEnd-mpiBegin+1; i++) {
 		j = get_global_idx(i);
-		buf_reduce[1] += 0.5 * (sqr(star[i].vr) + sqr(star[i].vt)) * star_m[j] / clus.N_STAR;
-		buf_reduce[2] += star_phi[j] * star_m[j] / clus.N_STAR;
-		buf_reduce[2] += phi0 * cenma.m*madhoc/ clus.N_STAR;
+		exact_sum_add(&buf_reduce[0], 0.5 * (sqr(star[i].vr) + sqr(star[i].vt)) * star_m[j] / clus.N_STAR);
+		exact_sum_add(&buf_reduce[1], star_phi[j] * star_m[j] / clus.N_STAR);
+		exact_sum_add(&buf_reduce[1], phi0 * cenma.m*madhoc/ clus.N_STAR);
 
 		if (star[i].binind == 0) {
-			buf_reduce[3] += star[i].Eint;
+			exact_sum_add(&buf_reduce[2], star[i].Eint);
 		} else if (binary[star[i].binind].inuse) {
-			buf_reduce[4] += -(binary[star[i].binind].m1/clus.N_STAR) * (binary[star[i].binind].m2/clus.N_STAR) / 
-				(2.0 * binary[star[i].binind].a);
-			buf_reduce[3] += binary[star[i].binind].Eint1 + binary[star[i].binind].Eint2;
+			exact_sum_add(&buf_reduce[3], -(binary[star[i].binind].m1/clus.N_STAR) * (binary[star[i].binind].m2/clus.N_STAR) / 
+				(2.0 * binary[star[i].binind].a));
+			exact_sum_add(&buf_reduce[2], binary[star[i].binind].Eint1 + binary[star[i].binind].Eint2);
 		}
 	}
-	
-	buf_reduce[2] *= 0.5;
-	buf_reduce[0] = buf_reduce[1] + buf_reduce[2] + buf_reduce[3] + buf_reduce[4];
 
-	//MPI: And now, summing them up across all processors. There might be slight round-off errors, but since these values are used only for diagnostics, we dont have to worry too much about it.
+	//MPI: And now, summing them up across all processors. The per-star terms were accumulated exactly, so the totals are bitwise identical for any number of processors.
 	double tmpTimeStart = timeStartSimple();
-	MPI_Allreduce(MPI_IN_PLACE, buf_reduce, 5, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);		
+	exact_sum_allreduce(buf_reduce, 4, MPI_COMM_WORLD);
 	timeEndSimple(tmpTimeStart, &t_comm);
 
-	Etotal.tot = buf_reduce[0];
-	Etotal.K = buf_reduce[1];
-	Etotal.P = buf_reduce[2];
-	Etotal.Eint = buf_reduce[3];
-	Etotal.Eb = buf_reduce[4];
+	Etotal.K = exact_sum_value(&buf_reduce[0]);
+	Etotal.P = 0.5 * exact_sum_value(&buf_reduce[1]);
+	Etotal.Eint = exact_sum_value(&buf_reduce[2]);
+	Etotal.Eb = exact_sum_value(&buf_reduce[3]);
+	Etotal.tot = Etotal.K + Etotal.P + Etotal.Eint + Etotal.Eb;
 
 	Etotal.tot += cenma.E + Eescaped + Ebescaped + Eintescaped;
 
@@ -1916,17 +1915,17 @@ void set_global_vars1()
 	Etidal_old = 0.0;
 
     //MPI3: Initializing some MPI IO related variables.
-    mpi_logfile_len=0;
-    mpi_escfile_len=0;
-    mpi_binintfile_len=0;
-    mpi_collisionfile_len=0;
-    mpi_tidalcapturefile_len=0;
-    mpi_semergedisruptfile_len=0;
-    mpi_removestarfile_len=0;
-    mpi_relaxationfile_len=0;
-    mpi_pulsarfile_len=0;
-    mpi_morepulsarfile_len=0;
-    mpi_triplefile_len=0;
+    parabuf_truncate(&mpi_logfile_wrbuf, 0);
+    parabuf_truncate(&mpi_escfile_wrbuf, 0);
+    parabuf_truncate(&mpi_binintfile_wrbuf, 0);
+    parabuf_truncate(&mpi_collisionfile_wrbuf, 0);
+    parabuf_truncate(&mpi_tidalcapturefile_wrbuf, 0);
+    parabuf_truncate(&mpi_semergedisruptfile_wrbuf, 0);
+    parabuf_truncate(&mpi_removestarfile_wrbuf, 0);
+    parabuf_truncate(&mpi_relaxationfile_wrbuf, 0);
+    parabuf_truncate(&mpi_pulsarfile_wrbuf, 0);
+    parabuf_truncate(&mpi_morepulsarfile_wrbuf, 0);
+    parabuf_truncate(&mpi_triplefile_wrbuf, 0);
 
     mpi_logfile_ofst_total=0;
     mpi_escfile_ofst_total=0;
@@ -0,0 +1,513 @@
+/* -*- linux-c -*- */
+/* bench_binsingle.c
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Microbenchmark for the integrator: times the derivatives function on a
+   fixed binary-single configuration, then runs a reproducible set of
+   binary-single scatterings (impact parameters uniform in area out to bmax,
+   random binary orientations and phases) and reports the cost per step,
+   the energy errors and the outcomes, optionally for both integrators. */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_rng.h>
+#include "fewbody.h"
+#include "bench_binsingle.h"
+
+/* print the usage */
+void print_usage(FILE *stream)
+{
+	fprintf(stream, "USAGE:\n");
+	fprintf(stream, "  bench_binsingle [options...]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "OPTIONS:\n");
+	fprintf(stream, "  -n --nscat <nscat>           : set number of scatterings [%d]\n", FB_NSCAT);
+	fprintf(stream, "  -r --nrhs <nrhs>             : set number of derivatives evaluations [%d]\n", FB_NRHS);
+	fprintf(stream, "  -v --vinf <vinf/v_crit>      : set velocity at infinity [%.6g]\n", FB_VINF);
+	fprintf(stream, "  -b --bmax <bmax/a1>          : set maximum impact parameter [%.6g]\n", FB_BMAX);
+	fprintf(stream, "  -c --tcpustop <tcpustop/sec> : set cpu stopping time [%.6g]\n", FB_TCPUSTOP);
+	fprintf(stream, "  -N --countstop <steps>       : set maximum number of integration steps (0=no limit) [%d]\n", FB_COUNTSTOP);
+	fprintf(stream, "  -A --absacc <absacc>         : set integrator's absolute accuracy [%.6g]\n", FB_ABSACC);
+	fprintf(stream, "  -R --relacc <relacc>         : set integrator's relative accuracy [%.6g]\n", FB_RELACC);
+	fprintf(stream, "  -k --ks <ks>                 : turn K-S regularization on or off [%d]\n", FB_KS);
+	fprintf(stream, "  -I --integrator <integrator> : set integrator (0=rk8pd, 1=AR+Bulirsch-Stoer) [%d]\n", FB_INTEGRATOR);
+	fprintf(stream, "  -C --compare                 : run the scattering set with both integrators\n");
+	fprintf(stream, "  -m --mstar <m/MSUN>          : set the mass of each of the three stars [%.6g]\n", FB_MSTAR/FB_CONST_MSUN);
+	fprintf(stream, "  -P --pn                      : turn on the 1PN, 2PN and 2.5PN terms\n");
+	fprintf(stream, "  -s --seed                    : set random seed [%ld]\n", FB_SEED);
+	fprintf(stream, "  -d --debug                   : turn on debugging\n");
+	fprintf(stream, "  -V --version                 : print version info\n");
+	fprintf(stream, "  -h --help                    : display this help text\n");
+}
+
+/* calculate the units used */
+int calc_units(fb_obj_t *obj[2], fb_units_t *units)
+{
+	units->v = sqrt(FB_CONST_G*(obj[0]->m + obj[1]->m)/(obj[0]->m * obj[1]->m) * \
+			(obj[1]->obj[0]->m * obj[1]->obj[1]->m / obj[1]->a));
+	units->l = obj[1]->a;
+	units->t = units->l / units->v;
+	units->m = units->l * fb_sqr(units->v) / FB_CONST_G;
+	units->E = units->m * fb_sqr(units->v);
+
+	return(0);
+}
+
+/* wall clock time in seconds */
+double bench_wtime(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return((double) tv.tv_sec + 1.0e-6 * ((double) tv.tv_usec));
+}
+
+/* set up one binary-single scattering; hier must have been malloc()ed for 3 stars */
+void bench_setup(fb_hier_t *hier, fb_input_t input, fb_units_t *units, double mstar, double vinf, double b,
+		 gsl_rng *rng, struct rng_t113_state *curr_st)
+{
+	int j;
+	double m0, m1, m10, m11, a1, e1, rtid;
+
+	hier->nstar = hier->nstarinit;
+	fb_init_hier(hier);
+
+	/* create binary */
+	hier->hier[hier->hi[2]+0].obj[0] = &(hier->hier[hier->hi[1]+1]);
+	hier->hier[hier->hi[2]+0].obj[1] = &(hier->hier[hier->hi[1]+2]);
+	hier->hier[hier->hi[2]+0].t = 0.0;
+
+	/* give the objects some properties */
+	for (j=0; j<hier->nstar; j++) {
+		hier->hier[hier->hi[1]+j].ncoll = 1;
+		hier->hier[hier->hi[1]+j].id[0] = j;
+		snprintf(hier->hier[hier->hi[1]+j].idstring, FB_MAX_STRING_LENGTH, "%d", j);
+		hier->hier[hier->hi[1]+j].n = 1;
+		hier->hier[hier->hi[1]+j].obj[0] = NULL;
+		hier->hier[hier->hi[1]+j].obj[1] = NULL;
+		hier->hier[hier->hi[1]+j].R = 0.0;
+		hier->hier[hier->hi[1]+j].Eint = 0.0;
+		hier->hier[hier->hi[1]+j].Lint[0] = 0.0;
+		hier->hier[hier->hi[1]+j].Lint[1] = 0.0;
+		hier->hier[hier->hi[1]+j].Lint[2] = 0.0;
+		hier->hier[hier->hi[1]+j].k_type = 1;
+		hier->hier[hier->hi[1]+j].chi = -1.0;
+	}
+
+	hier->hier[hier->hi[1]+0].m = mstar;
+	hier->hier[hier->hi[1]+1].m = mstar;
+	hier->hier[hier->hi[1]+2].m = mstar;
+
+	hier->hier[hier->hi[2]+0].m = 2.0 * mstar;
+	hier->hier[hier->hi[2]+0].a = FB_A1;
+	hier->hier[hier->hi[2]+0].e = FB_E1;
+
+	hier->obj[0] = &(hier->hier[hier->hi[1]+0]);
+	hier->obj[1] = &(hier->hier[hier->hi[2]+0]);
+	hier->obj[2] = NULL;
+
+	/* get the units and normalize */
+	calc_units(hier->obj, units);
+	fb_normalize(hier, *units);
+
+	/* move hierarchies analytically in from infinity along hyperbolic orbit */
+	m0 = hier->obj[0]->m;
+	m1 = hier->obj[1]->m;
+	a1 = hier->obj[1]->a;
+	e1 = hier->obj[1]->e;
+	m10 = hier->obj[1]->obj[0]->m;
+	m11 = hier->obj[1]->obj[1]->m;
+
+	rtid = pow(2.0*m0*m1/input.tidaltol, 1.0/3.0) * pow(m10*m11, -1.0/3.0)*a1*(1.0+e1);
+
+	fb_init_scattering(hier->obj, vinf, b, rtid);
+
+	/* trickle down the binary properties, then back up */
+	fb_randorient(&(hier->hier[hier->hi[2]+0]), rng, curr_st);
+	fb_downsync(&(hier->hier[hier->hi[2]+0]), 0.0);
+	fb_upsync(&(hier->hier[hier->hi[2]+0]), 0.0);
+}
+
+/* redo the allocations the derivatives functions used to make on every call */
+void bench_realloc(fb_scratch_t *scratch, int ks)
+{
+	int k=FB_MAX(scratch->kmax, 1);
+
+	if (ks) {
+		fb_free_matrix(scratch->Q);
+		fb_free_matrix(scratch->P);
+		fb_free_matrix(scratch->p);
+		fb_free_matrix(scratch->A);
+		fb_free_matrix(scratch->TP);
+		fb_free_matrix(scratch->TQ);
+		fb_free_matrix(scratch->UQ);
+		fb_free_vector(scratch->d);
+		scratch->Q = fb_malloc_matrix(k, 4);
+		scratch->P = fb_malloc_matrix(k, 4);
+		scratch->p = fb_malloc_matrix(k, 4);
+		scratch->A = fb_malloc_matrix(k, 4);
+		scratch->TP = fb_malloc_matrix(k, 4);
+		scratch->TQ = fb_malloc_matrix(k, 4);
+		scratch->UQ = fb_malloc_matrix(k, 4);
+		scratch->d = fb_malloc_vector(k);
+	} else {
+		fb_free_vector(scratch->fm);
+		fb_free_vector(scratch->fmr);
+		scratch->fm = fb_malloc_vector(scratch->nmax * scratch->nmax * 3);
+		scratch->fmr = fb_malloc_vector(scratch->nmax * scratch->nmax * 3);
+	}
+}
+
+/* time the derivatives function on the flat hierarchy in hier; if prealloc is
+   zero the scratch space is reallocated before every call, as the derivatives
+   functions used to do; returns the wall time per call */
+double bench_rhs(fb_hier_t *hier, fb_input_t input, fb_units_t units, long nrhs, int prealloc)
+{
+	long i;
+	int n;
+	double *y, *f, tstart, tend;
+	fb_scratch_t scratch;
+	fb_ks_params_t ks_params;
+	fb_nonks_params_t nonks_params;
+
+	/* the stars were downsynced in bench_setup(), so just flatten the hierarchy */
+	fb_init_hier(hier);
+
+	fb_malloc_scratch(&scratch, hier->nstar);
+	ks_params.scratch = &scratch;
+	nonks_params.scratch = &scratch;
+
+	if (input.ks) {
+		ks_params.nstar = hier->nstar;
+		ks_params.kstar = ks_params.nstar*(ks_params.nstar-1)/2;
+		fb_malloc_ks_params(&ks_params);
+		fb_init_ks_params(&ks_params, *hier);
+		n = 8*ks_params.kstar+1;
+		y = fb_malloc_vector(n);
+		y[0] = 0.0;
+		fb_euclidean_to_ks(hier->obj, y, ks_params.nstar, ks_params.kstar);
+	} else {
+		nonks_params.nstar = hier->nstar;
+		fb_malloc_nonks_params(&nonks_params);
+		fb_init_nonks_params(&nonks_params, *hier);
+		nonks_params.PN1 = input.PN1;
+		nonks_params.PN2 = input.PN2;
+		nonks_params.PN25 = input.PN25;
+		nonks_params.PN3 = input.PN3;
+		nonks_params.PN35 = input.PN35;
+		nonks_params.units = units;
+		n = 6*nonks_params.nstar;
+		y = fb_malloc_vector(n);
+		fb_euclidean_to_nonks(hier->obj, y, nonks_params.nstar);
+	}
+	f = fb_malloc_vector(n);
+
+	tstart = bench_wtime();
+	for (i=0; i<nrhs; i++) {
+		if (!prealloc) {
+			bench_realloc(&scratch, input.ks);
+		}
+		if (input.ks) {
+			fb_ks_func(0.0, y, f, &ks_params);
+		} else {
+			fb_nonks_func(0.0, y, f, &nonks_params);
+		}
+	}
+	tend = bench_wtime();
+
+	fb_free_vector(f);
+	fb_free_vector(y);
+	if (input.ks) {
+		fb_free_ks_params(ks_params);
+	} else {
+		fb_free_nonks_params(nonks_params);
+	}
+	fb_free_scratch(&scratch);
+
+	return((tend - tstart) / ((double) FB_MAX(nrhs, 1)));
+}
+
+/* run the scattering set with the given input, reseeding first so every call sees the same set */
+void bench_scatter(fb_input_t input, double mstar, double vinf, double bmax, int nscat, unsigned long int seed, bench_stats_t *stats)
+{
+	int i, j, nsingle;
+	double b, t, tstart, dE;
+	fb_hier_t hier;
+	fb_ret_t retval;
+	fb_units_t units;
+	gsl_rng *rng;
+	struct rng_t113_state curr_st;
+
+	rng = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(rng, seed);
+	reset_rng_t113_new(seed, &curr_st);
+
+	hier.nstarinit = 3;
+	hier.nstar = 3;
+	fb_malloc_hier(&hier);
+
+	memset(stats, 0, sizeof(bench_stats_t));
+	tstart = bench_wtime();
+	for (i=0; i<nscat; i++) {
+		b = bmax * sqrt(rng_t113_dbl_new(&curr_st));
+		bench_setup(&hier, input, &units, mstar, vinf, b, rng, &curr_st);
+		t = 0.0;
+		retval = fewbody(input, units, &hier, &t, rng, &curr_st);
+
+		stats->nsteps += retval.count;
+		stats->tcpu += retval.tcpu;
+		dE = fabs(retval.DeltaEfrac);
+		stats->dEmean += dE / ((double) nscat);
+		stats->dEmax = FB_MAX(stats->dEmax, dE);
+
+		/* outcome: the single star is the one left at the top level */
+		if (retval.retval != 1) {
+			stats->nincomplete++;
+		} else if (hier.nstar < 3) {
+			stats->nmerge++;
+		} else if (hier.nobj == 3) {
+			stats->nionize++;
+		} else if (hier.nobj == 2) {
+			nsingle = -1;
+			for (j=0; j<2; j++) {
+				if (hier.obj[j]->n == 1) {
+					nsingle = hier.obj[j]->id[0];
+				}
+			}
+			if (nsingle == 0) {
+				stats->npreserve++;
+			} else {
+				stats->nexchange++;
+			}
+		} else {
+			stats->ntriple++;
+		}
+	}
+	stats->twall = bench_wtime() - tstart;
+
+	fb_free_hier(hier);
+	gsl_rng_free(rng);
+}
+
+/* print the statistics of one scattering set */
+void bench_print_stats(FILE *stream, const char *name, int nscat, bench_stats_t *stats)
+{
+	fprintf(stream, "  %s:\n", name);
+	fprintf(stream, "    t_wall=%.6g s  t_cpu=%.6g s  steps=%ld  steps/scattering=%.6g  t_wall/step=%.6g us\n", \
+		stats->twall, stats->tcpu, stats->nsteps, ((double) stats->nsteps)/((double) FB_MAX(nscat, 1)), \
+		stats->twall/((double) FB_MAX(stats->nsteps, 1))*1.0e6);
+	fprintf(stream, "    |DeltaE/E0|: mean=%.6g  max=%.6g\n", stats->dEmean, stats->dEmax);
+	fprintf(stream, "    outcomes: preservation=%d  exchange=%d  ionization=%d  triple=%d  merger=%d  incomplete=%d\n", \
+		stats->npreserve, stats->nexchange, stats->nionize, stats->ntriple, stats->nmerge, stats->nincomplete);
+}
+
+/* the main attraction */
+int main(int argc, char *argv[])
+{
+	int i, nscat, compare;
+	long nrhs;
+	unsigned long int seed;
+	double mstar, vinf, bmax, rhs_alloc, rhs_prealloc;
+	fb_hier_t hier;
+	fb_input_t input;
+	fb_units_t units;
+	bench_stats_t stats;
+	gsl_rng *rng;
+	const gsl_rng_type *rng_type=gsl_rng_mt19937;
+	struct rng_t113_state curr_st;
+	const char *short_opts = "n:r:v:b:c:N:A:R:k:I:Cm:Ps:dVh";
+	const struct option long_opts[] = {
+		{"nscat", required_argument, NULL, 'n'},
+		{"nrhs", required_argument, NULL, 'r'},
+		{"vinf", required_argument, NULL, 'v'},
+		{"bmax", required_argument, NULL, 'b'},
+		{"tcpustop", required_argument, NULL, 'c'},
+		{"countstop", required_argument, NULL, 'N'},
+		{"absacc", required_argument, NULL, 'A'},
+		{"relacc", required_argument, NULL, 'R'},
+		{"ks", required_argument, NULL, 'k'},
+		{"integrator", required_argument, NULL, 'I'},
+		{"compare", no_argument, NULL, 'C'},
+		{"mstar", required_argument, NULL, 'm'},
+		{"pn", no_argument, NULL, 'P'},
+		{"seed", required_argument, NULL, 's'},
+		{"debug", no_argument, NULL, 'd'},
+		{"version", no_argument, NULL, 'V'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+
+	/* set parameters to default values */
+	nscat = FB_NSCAT;
+	nrhs = FB_NRHS;
+	mstar = FB_MSTAR;
+	vinf = FB_VINF;
+	bmax = FB_BMAX;
+	compare = 0;
+	input.ks = FB_KS;
+	input.integrator = FB_INTEGRATOR;
+	input.tstop = FB_TSTOP;
+	input.Dflag = 0;
+	input.dt = 0.0;
+	input.tcpustop = FB_TCPUSTOP;
+	input.countstop = FB_COUNTSTOP;
+	input.absacc = FB_ABSACC;
+	input.relacc = FB_RELACC;
+	input.ncount = FB_NCOUNT;
+	input.tidaltol = FB_TIDALTOL;
+	input.speedtol = FB_SPEEDTOL;
+	input.fexp = FB_FEXP;
+	input.PN1 = 0;
+	input.PN2 = 0;
+	input.PN25 = 0;
+	input.PN3 = 0;
+	input.PN35 = 0;
+	input.BH_REFF = 1.0;
+	input.BHNS_TDE_FLAG = 0;
+	input.firstlogentry[0] = '\0';
+	seed = FB_SEED;
+	fb_debug = FB_DEBUG;
+
+	while ((i = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
+		switch (i) {
+		case 'n':
+			nscat = atoi(optarg);
+			break;
+		case 'r':
+			nrhs = atol(optarg);
+			break;
+		case 'v':
+			vinf = atof(optarg);
+			break;
+		case 'b':
+			bmax = atof(optarg);
+			break;
+		case 'c':
+			input.tcpustop = atof(optarg);
+			break;
+		case 'N':
+			input.countstop = atol(optarg);
+			break;
+		case 'A':
+			input.absacc = atof(optarg);
+			break;
+		case 'R':
+			input.relacc = atof(optarg);
+			break;
+		case 'k':
+			input.ks = atoi(optarg);
+			break;
+		case 'I':
+			input.integrator = atoi(optarg);
+			break;
+		case 'C':
+			compare = 1;
+			break;
+		case 'm':
+			mstar = atof(optarg) * FB_CONST_MSUN;
+			break;
+		case 'P':
+			input.PN1 = 1;
+			input.PN2 = 1;
+			input.PN25 = 1;
+			break;
+		case 's':
+			seed = atol(optarg);
+			break;
+		case 'd':
+			fb_debug = 1;
+			break;
+		case 'V':
+			fb_print_version(stdout);
+			return(0);
+		case 'h':
+			fb_print_version(stdout);
+			fprintf(stdout, "\n");
+			print_usage(stdout);
+			return(0);
+		default:
+			break;
+		}
+	}
+
+	/* check to make sure there was nothing crazy on the command line */
+	if (optind < argc) {
+		print_usage(stdout);
+		return(1);
+	}
+
+	/* print out values of paramaters */
+	fprintf(stderr, "PARAMETERS:\n");
+	fprintf(stderr, "  ks=%d  integrator=%d  compare=%d  seed=%ld  nscat=%d  nrhs=%ld\n", \
+		input.ks, input.integrator, compare, seed, nscat, nrhs);
+	fprintf(stderr, "  mstar=%.6g MSUN  PN1=%d  PN2=%d  PN25=%d\n", mstar/FB_CONST_MSUN, input.PN1, input.PN2, input.PN25);
+	fprintf(stderr, "  vinf=%.6g  bmax=%.6g  tcpustop=%.6g  countstop=%ld  abs_acc=%.6g  rel_acc=%.6g\n\n", \
+		vinf, bmax, input.tcpustop, input.countstop, input.absacc, input.relacc);
+
+	/* initialize rngs */
+	gsl_rng_env_setup();
+	rng = gsl_rng_alloc(rng_type);
+	gsl_rng_set(rng, seed);
+	reset_rng_t113_new(seed, &curr_st);
+
+	/* the AR integrator works in the non-regularized coordinates */
+	if (input.integrator == FB_INTEGRATOR_ARBS) {
+		input.ks = 0;
+	}
+
+	hier.nstarinit = 3;
+	hier.nstar = 3;
+	fb_malloc_hier(&hier);
+
+	/* derivatives function on a fixed configuration near pericenter */
+	bench_setup(&hier, input, &units, mstar, vinf, 0.0, rng, &curr_st);
+	rhs_alloc = bench_rhs(&hier, input, units, nrhs, 0);
+	bench_setup(&hier, input, &units, mstar, vinf, 0.0, rng, &curr_st);
+	rhs_prealloc = bench_rhs(&hier, input, units, nrhs, 1);
+
+	fprintf(stderr, "RHS:\n");
+	fprintf(stderr, "  per-call allocation:  %.6g ns/call\n", rhs_alloc*1.0e9);
+	fprintf(stderr, "  preallocated:         %.6g ns/call\n", rhs_prealloc*1.0e9);
+	fprintf(stderr, "  speedup:              %.4g\n\n", rhs_alloc/rhs_prealloc);
+
+	/* the scattering set, with the same seed for each integrator */
+	fprintf(stderr, "SCATTERINGS:\n");
+	if (compare) {
+		input.integrator = FB_INTEGRATOR_RK8PD;
+		bench_scatter(input, mstar, vinf, bmax, nscat, seed, &stats);
+		bench_print_stats(stderr, "rk8pd", nscat, &stats);
+		input.integrator = FB_INTEGRATOR_ARBS;
+		input.ks = 0;
+		bench_scatter(input, mstar, vinf, bmax, nscat, seed, &stats);
+		bench_print_stats(stderr, "AR+Bulirsch-Stoer", nscat, &stats);
+	} else {
+		bench_scatter(input, mstar, vinf, bmax, nscat, seed, &stats);
+		bench_print_stats(stderr, (input.integrator==FB_INTEGRATOR_ARBS?"AR+Bulirsch-Stoer":"rk8pd"), nscat, &stats);
+	}
+
+	/* free everything */
+	fb_free_hier(hier);
+	gsl_rng_free(rng);
+
+	return(0);
+}
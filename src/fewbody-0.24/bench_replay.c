@@ -0,0 +1,318 @@
+/* -*- linux-c -*- */
+/* bench_replay.c
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Replays the scatterings CMC dumped with BININT_DUMP=1: each one is rerun
+   from exactly the inputs and random stream state it had in the cluster, and
+   the wall clock time and number of integration steps are reported, along
+   with whether repeated runs of the same scattering give the same outcome.
+   The integrator, the accuracy and the stopping conditions can be changed to
+   see what they cost on a realistic mix of encounters. */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <zlib.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_rng.h>
+#include "fewbody.h"
+#include "bench_replay.h"
+
+/* print the usage */
+void print_usage(FILE *stream)
+{
+	fprintf(stream, "USAGE:\n");
+	fprintf(stream, "  bench_replay [options...] <file.fb.gz> [<file.fb.gz>...]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "OPTIONS:\n");
+	fprintf(stream, "  -n --nmax <n>                : replay at most n scatterings from each file (0=all) [%d]\n", FB_NMAX);
+	fprintf(stream, "  -r --repeat <n>              : run each scattering n times and compare the outcomes [%d]\n", FB_NREPEAT);
+	fprintf(stream, "  -I --integrator <integrator> : set integrator (0=rk8pd, 1=AR+Bulirsch-Stoer) [as dumped]\n");
+	fprintf(stream, "  -c --tcpustop <tcpustop/sec> : set cpu stopping time [as dumped]\n");
+	fprintf(stream, "  -N --countstop <steps>       : set maximum number of integration steps (0=no limit) [as dumped]\n");
+	fprintf(stream, "  -A --absacc <absacc>         : set integrator's absolute accuracy [as dumped]\n");
+	fprintf(stream, "  -R --relacc <relacc>         : set integrator's relative accuracy [as dumped]\n");
+	fprintf(stream, "  -v --verbose                 : print a line for each scattering\n");
+	fprintf(stream, "  -d --debug                   : turn on debugging\n");
+	fprintf(stream, "  -V --version                 : print version info\n");
+	fprintf(stream, "  -h --help                    : display this help text\n");
+}
+
+/* wall clock time in seconds */
+double bench_wtime(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return((double) tv.tv_sec + 1.0e-6 * ((double) tv.tv_usec));
+}
+
+/* the result of one run, in a form that can be compared bit for bit */
+void replay_outcome(fb_hier_t *hier, fb_ret_t *retval, double t, replay_outcome_t *outcome)
+{
+	int i, k;
+
+	memset(outcome, 0, sizeof(replay_outcome_t));
+	outcome->retval = retval->retval;
+	outcome->nstar = hier->nstar;
+	outcome->nobj = hier->nobj;
+	outcome->count = retval->count;
+	outcome->t = t;
+	outcome->DeltaE = retval->DeltaE;
+	outcome->DeltaL = retval->DeltaL;
+	for (i=0; i<hier->nobj; i++) {
+		outcome->m[i] = hier->obj[i]->m;
+		for (k=0; k<3; k++) {
+			outcome->x[i][k] = hier->obj[i]->x[k];
+			outcome->v[i][k] = hier->obj[i]->v[k];
+		}
+	}
+}
+
+/* replay the scatterings in one file; returns 1 if the file cannot be read */
+int replay_file(const char *fname, fb_ctx_t *ctx, replay_opts_t *opts, int nrepeat, long nmax, int verbose, replay_stats_t *stats)
+{
+	int j, status;
+	long i;
+	size_t size=0;
+	char *ic=NULL, string[FB_MAX_STRING_LENGTH];
+	double t0, t, tstart, twall, dE;
+	gzFile fp;
+	fb_hier_t hier;
+	fb_input_t *input;
+	fb_units_t units;
+	fb_ret_t retval;
+	gsl_rng *rng;
+	struct rng_t113_state st0, curr_st;
+	replay_outcome_t first, outcome;
+
+	if ((fp = fb_open_scatterings(fname, "r")) == NULL) {
+		fprintf(stderr, "cannot read %s\n", fname);
+		return(1);
+	}
+
+	/* the input is too large for the stack */
+	input = (fb_input_t *) malloc(sizeof(fb_input_t));
+	rng = gsl_rng_alloc(gsl_rng_mt19937);
+	hier.nstarinit = 0;
+
+	for (i=0; nmax <= 0 || i < nmax; i++) {
+		status = fb_read_scattering(fp, input, &units, &hier, &t0, &st0);
+		if (status == 0) {
+			break;
+		} else if (status < 0) {
+			fprintf(stderr, "%s: scattering %ld is truncated or corrupt\n", fname, i);
+			break;
+		}
+
+		if (opts->integrator >= 0) {
+			input->integrator = opts->integrator;
+			if (input->integrator == FB_INTEGRATOR_ARBS) {
+				input->ks = 0;
+			}
+		}
+		if (opts->countstop >= 0) input->countstop = opts->countstop;
+		if (opts->tcpustop >= 0.0) input->tcpustop = opts->tcpustop;
+		if (opts->absacc >= 0.0) input->absacc = opts->absacc;
+		if (opts->relacc >= 0.0) input->relacc = opts->relacc;
+
+		/* keep the initial conditions for the repeats */
+		if (fb_pack_hier_size(hier.nstarinit) > size) {
+			size = fb_pack_hier_size(hier.nstarinit);
+			ic = (char *) realloc(ic, size);
+		}
+		fb_pack_hier(&hier, ic);
+
+		for (j=0; j<nrepeat; j++) {
+			if (j > 0) {
+				fb_unpack_hier(ic, &hier);
+			}
+			t = t0;
+			curr_st = st0;
+			gsl_rng_set(rng, FB_SEED);
+
+			tstart = bench_wtime();
+			retval = fewbody_ctx(ctx, *input, units, &hier, &t, rng, &curr_st);
+			twall = bench_wtime() - tstart;
+
+			if (j == 0) {
+				replay_outcome(&hier, &retval, t, &first);
+			} else {
+				replay_outcome(&hier, &retval, t, &outcome);
+				if (memcmp(&first, &outcome, sizeof(replay_outcome_t)) != 0) {
+					stats->nmismatch++;
+					fprintf(stderr, "%s: scattering %ld gave a different outcome on run %d\n", fname, i, j+1);
+					break;
+				}
+			}
+
+			/* the statistics are of the first run */
+			if (j == 0) {
+				stats->nscat++;
+				stats->twall += twall;
+				stats->tcpu += retval.tcpu;
+				stats->nsteps += retval.count;
+				stats->nstepsmax = FB_MAX(stats->nstepsmax, retval.count);
+				if (twall > stats->twallmax) {
+					stats->twallmax = twall;
+					stats->imax = i;
+				}
+				dE = fabs(retval.DeltaEfrac);
+				stats->dEmean += dE;
+				stats->dEmax = FB_MAX(stats->dEmax, dE);
+				if (retval.retval != 1) {
+					stats->nincomplete++;
+				}
+				if (verbose) {
+					fprintf(stdout, "%ld  nstar=%d  steps=%ld  t_wall=%.6g s  DeltaE/E0=%.3g  retval=%d  %s\n", \
+						i, hier.nstarinit, retval.count, twall, retval.DeltaEfrac, retval.retval, \
+						fb_sprint_hier(hier, string));
+				}
+			}
+		}
+	}
+
+	if (hier.nstarinit > 0) {
+		fb_free_hier(hier);
+	}
+	free(ic);
+	free(input);
+	gsl_rng_free(rng);
+	gzclose(fp);
+
+	return(0);
+}
+
+/* print the statistics of the replayed scatterings */
+void replay_print_stats(FILE *stream, replay_stats_t *stats)
+{
+	double n=(double) FB_MAX(stats->nscat, 1);
+
+	fprintf(stream, "  scatterings=%ld  incomplete=%ld  not reproduced=%ld\n", stats->nscat, stats->nincomplete, stats->nmismatch);
+	fprintf(stream, "  t_wall=%.6g s  t_cpu=%.6g s  t_wall/scattering=%.6g ms  slowest=%.6g s (scattering %ld)\n", \
+		stats->twall, stats->tcpu, stats->twall/n*1.0e3, stats->twallmax, stats->imax);
+	fprintf(stream, "  steps=%ld  steps/scattering=%.6g  max steps=%ld  t_wall/step=%.6g us\n", \
+		stats->nsteps, ((double) stats->nsteps)/n, stats->nstepsmax, \
+		stats->twall/((double) FB_MAX(stats->nsteps, 1))*1.0e6);
+	fprintf(stream, "  |DeltaE/E0|: mean=%.6g  max=%.6g\n", stats->dEmean/n, stats->dEmax);
+}
+
+/* the main attraction */
+int main(int argc, char *argv[])
+{
+	int i, nrepeat, verbose, err=0;
+	long nmax;
+	fb_ctx_t ctx;
+	replay_opts_t opts;
+	replay_stats_t stats;
+	const char *short_opts = "n:r:I:c:N:A:R:vdVh";
+	const struct option long_opts[] = {
+		{"nmax", required_argument, NULL, 'n'},
+		{"repeat", required_argument, NULL, 'r'},
+		{"integrator", required_argument, NULL, 'I'},
+		{"tcpustop", required_argument, NULL, 'c'},
+		{"countstop", required_argument, NULL, 'N'},
+		{"absacc", required_argument, NULL, 'A'},
+		{"relacc", required_argument, NULL, 'R'},
+		{"verbose", no_argument, NULL, 'v'},
+		{"debug", no_argument, NULL, 'd'},
+		{"version", no_argument, NULL, 'V'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+
+	/* set parameters to default values */
+	nmax = FB_NMAX;
+	nrepeat = FB_NREPEAT;
+	verbose = 0;
+	opts.integrator = -1;
+	opts.countstop = -1;
+	opts.tcpustop = -1.0;
+	opts.absacc = -1.0;
+	opts.relacc = -1.0;
+	fb_debug = FB_DEBUG;
+
+	while ((i = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
+		switch (i) {
+		case 'n':
+			nmax = atol(optarg);
+			break;
+		case 'r':
+			nrepeat = FB_MAX(atoi(optarg), 1);
+			break;
+		case 'I':
+			opts.integrator = atoi(optarg);
+			break;
+		case 'c':
+			opts.tcpustop = atof(optarg);
+			break;
+		case 'N':
+			opts.countstop = atol(optarg);
+			break;
+		case 'A':
+			opts.absacc = atof(optarg);
+			break;
+		case 'R':
+			opts.relacc = atof(optarg);
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 'd':
+			fb_debug = 1;
+			break;
+		case 'V':
+			fb_print_version(stdout);
+			return(0);
+		case 'h':
+			fb_print_version(stdout);
+			fprintf(stdout, "\n");
+			print_usage(stdout);
+			return(0);
+		default:
+			break;
+		}
+	}
+
+	/* there must be something to replay */
+	if (optind >= argc) {
+		print_usage(stdout);
+		return(1);
+	}
+
+	/* print out values of paramaters */
+	fprintf(stderr, "PARAMETERS:\n");
+	fprintf(stderr, "  nmax=%ld  repeat=%d  integrator=%d  countstop=%ld  tcpustop=%.6g  abs_acc=%.6g  rel_acc=%.6g  (negative=as dumped)\n\n", \
+		nmax, nrepeat, opts.integrator, opts.countstop, opts.tcpustop, opts.absacc, opts.relacc);
+
+	/* one work space for everything, as in CMC */
+	fb_malloc_ctx(&ctx, 4);
+	memset(&stats, 0, sizeof(replay_stats_t));
+	for (i=optind; i<argc; i++) {
+		err |= replay_file(argv[i], &ctx, &opts, nrepeat, nmax, verbose, &stats);
+	}
+	fb_free_ctx(&ctx);
+
+	fprintf(stderr, "REPLAY:\n");
+	replay_print_stats(stderr, &stats);
+
+	return((err || stats.nmismatch > 0) ? 1 : 0);
+}
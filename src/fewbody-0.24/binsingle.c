@@ -134,12 +134,14 @@ int main(int argc, char *argv[])
 	input.Dflag = 0;
 	input.dt = FB_DT;
 	input.tcpustop = FB_TCPUSTOP;
+	input.countstop = 0;
 	input.absacc = FB_ABSACC;
 	input.relacc = FB_RELACC;
 	input.ncount = FB_NCOUNT;
 	input.tidaltol = FB_TIDALTOL;
 	input.speedtol = FB_SPEEDTOL;
 	input.fexp = FB_FEXP;
+	input.integrator = FB_INTEGRATOR_RK8PD;
 	input.PN1 = FB_PN1;
 	input.PN2 = FB_PN2;
 	input.PN25 = FB_PN25;
@@ -32,24 +32,119 @@
 
 int fb_debug = 0;
 
+/* allocate the work space of fewbody_ctx() for up to nmax stars; the
+   perturbation trees and GSL steppers are only allocated when first needed */
+void fb_malloc_ctx(fb_ctx_t *ctx, int nmax)
+{
+	int n;
+
+	ctx->nmax = nmax;
+	ctx->phier = (fb_hier_t *) malloc((nmax+1) * sizeof(fb_hier_t));
+	ctx->ks_step = (gsl_odeiv_step **) malloc((nmax+1) * sizeof(gsl_odeiv_step *));
+	ctx->nonks_step = (gsl_odeiv_step **) malloc((nmax+1) * sizeof(gsl_odeiv_step *));
+	ctx->ks_evolve = (gsl_odeiv_evolve **) malloc((nmax+1) * sizeof(gsl_odeiv_evolve *));
+	ctx->nonks_evolve = (gsl_odeiv_evolve **) malloc((nmax+1) * sizeof(gsl_odeiv_evolve *));
+	for (n=0; n<=nmax; n++) {
+		ctx->phier[n].nstarinit = 0;
+		ctx->ks_step[n] = NULL;
+		ctx->nonks_step[n] = NULL;
+		ctx->ks_evolve[n] = NULL;
+		ctx->nonks_evolve[n] = NULL;
+	}
+
+	ctx->ks_params.nstar = nmax;
+	ctx->ks_params.kstar = nmax*(nmax-1)/2;
+	fb_malloc_ks_params(&(ctx->ks_params));
+	ctx->nonks_params.nstar = nmax;
+	fb_malloc_nonks_params(&(ctx->nonks_params));
+	fb_malloc_scratch(&(ctx->scratch), nmax);
+	fb_malloc_ar(&(ctx->ar), nmax);
+	ctx->y = fb_malloc_vector(FB_MAX(8*ctx->ks_params.kstar+1, 6*nmax));
+	/* the accuracies are set from the input on each call */
+	ctx->control = gsl_odeiv_control_y_new(1.0e-9, 1.0e-9);
+}
+
+/* free the work space of fewbody_ctx() */
+void fb_free_ctx(fb_ctx_t *ctx)
+{
+	int n;
+
+	for (n=0; n<=ctx->nmax; n++) {
+		if (ctx->phier[n].nstarinit) {
+			fb_free_hier(ctx->phier[n]);
+		}
+		if (ctx->ks_step[n] != NULL) {
+			gsl_odeiv_step_free(ctx->ks_step[n]);
+			gsl_odeiv_evolve_free(ctx->ks_evolve[n]);
+		}
+		if (ctx->nonks_step[n] != NULL) {
+			gsl_odeiv_step_free(ctx->nonks_step[n]);
+			gsl_odeiv_evolve_free(ctx->nonks_evolve[n]);
+		}
+	}
+	free(ctx->phier);
+	free(ctx->ks_step);
+	free(ctx->nonks_step);
+	free(ctx->ks_evolve);
+	free(ctx->nonks_evolve);
+
+	fb_free_ks_params(ctx->ks_params);
+	fb_free_nonks_params(ctx->nonks_params);
+	fb_free_scratch(&(ctx->scratch));
+	fb_free_ar(&(ctx->ar));
+	fb_free_vector(ctx->y);
+	gsl_odeiv_control_free(ctx->control);
+}
+
+/* the GSL stepper and evolution for n objects, reset as if newly allocated */
+static void fb_ctx_ode(fb_ctx_t *ctx, int ks, int n, gsl_odeiv_step **ode_step, gsl_odeiv_evolve **ode_evolve)
+{
+	gsl_odeiv_step **step=(ks?ctx->ks_step:ctx->nonks_step);
+	gsl_odeiv_evolve **evolve=(ks?ctx->ks_evolve:ctx->nonks_evolve);
+	size_t dim=(ks ? 8*(n*(n-1)/2)+1 : 6*n);
+
+	if (step[n] == NULL) {
+		step[n] = gsl_odeiv_step_alloc(gsl_odeiv_step_rk8pd, dim);
+		evolve[n] = gsl_odeiv_evolve_alloc(dim);
+	} else {
+		gsl_odeiv_step_reset(step[n]);
+		gsl_odeiv_evolve_reset(evolve[n]);
+	}
+	*ode_step = step[n];
+	*ode_evolve = evolve[n];
+}
+
+/* integrate with work space of its own; see fewbody_ctx() */
 fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t, gsl_rng *rng, struct rng_t113_state *curr_st)
+{
+	fb_ctx_t ctx;
+	fb_ret_t retval;
+
+	fb_malloc_ctx(&ctx, hier->nstar);
+	retval = fewbody_ctx(&ctx, input, units, hier, t, rng, curr_st);
+	fb_free_ctx(&ctx);
+
+	return(retval);
+}
+
+/* integrate the scattering in hier, using (and growing if necessary) the work space in ctx */
+fb_ret_t fewbody_ctx(fb_ctx_t *ctx, fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t, gsl_rng *rng, struct rng_t113_state *curr_st)
 {
 	int i, j, k, status, done=0, forceclassify=0, restart, restep;
-	long clk_tck;
 	double s, slast, sstop=FB_SSTOP, tout, h=FB_H, *y, texpand, tnew, R[3];
 	double Ei, E, Lint[3], Li[3], L[3], DeltaL[3];
 	double E_rel, E_rel_i;
 	double dedt_gw_old,dedt_gw_new;
 	double r_in_M;
 	double s2, s2prev=GSL_POSINF, s2prevprev=GSL_POSINF, s2minprev=GSL_POSINF, s2max=0.0, s2min;
-	struct tms firsttimebuf, currtimebuf;
-	clock_t firstclock, currclock;
+	double tcpu0;
 	fb_hier_t phier;
 	fb_ret_t retval;
 	fb_nonks_params_t nonks_params;
 	fb_ks_params_t ks_params;
+	fb_scratch_t scratch;
+	fb_ar_t ar;
 	char string1[FB_MAX_STRING_LENGTH], string2[FB_MAX_STRING_LENGTH], logentry[FB_MAX_LOGENTRY_LENGTH];
-	const gsl_odeiv_step_type *ode_type=gsl_odeiv_step_rk8pd;
 	gsl_odeiv_step *ode_step;
 	gsl_odeiv_control *ode_control;
 	gsl_odeiv_evolve *ode_evolve;
@@ -65,43 +160,59 @@ fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t,
 	retval.DeltaE_GW = 0.;
 	strncpy(logentry, input.firstlogentry, FB_MAX_LOGENTRY_LENGTH);
 
+	/* algorithmic regularization takes the place of K-S */
+	if (input.integrator == FB_INTEGRATOR_ARBS) {
+		input.ks = 0;
+	}
+
+	if (hier->nstar > ctx->nmax) {
+		fb_free_ctx(ctx);
+		fb_malloc_ctx(ctx, hier->nstar);
+	}
+
 	/* set up the perturbation tree, initially flat */
-	phier.nstarinit = hier->nstar;
+	if (ctx->phier[hier->nstar].nstarinit == 0) {
+		ctx->phier[hier->nstar].nstarinit = hier->nstar;
+		fb_malloc_hier(&(ctx->phier[hier->nstar]));
+	}
+	phier = ctx->phier[hier->nstar];
+	fb_clear_hier(&phier);
 	phier.nstar = hier->nstar;
-	fb_malloc_hier(&phier);
 	fb_init_hier(&phier);
 	for (i=0; i<phier.nstar; i++) {
 		fb_objcpy(&(phier.hier[phier.hi[1]+i]), &(hier->hier[hier->hi[1]+i]));
 	}
 
 	/* initialize GSL integration routine */
+	ode_control = ctx->control;
+	gsl_odeiv_control_init(ode_control, input.absacc, input.relacc, 1.0, 0.0);
+	fb_ctx_ode(ctx, input.ks, hier->nstar, &ode_step, &ode_evolve);
 	if (input.ks) {
-		ode_step = gsl_odeiv_step_alloc(ode_type, 8 * (hier->nstar * (hier->nstar - 1) / 2) + 1);
-		ode_control = gsl_odeiv_control_y_new(input.absacc, input.relacc);
-		ode_evolve = gsl_odeiv_evolve_alloc(8 * (hier->nstar * (hier->nstar - 1) / 2) + 1);
 		ode_sys.function = fb_ks_func;
 		ode_sys.jacobian = NULL;
 		ode_sys.dimension = 8 * (hier->nstar * (hier->nstar - 1) / 2) + 1;
 		ode_sys.params = &ks_params;
 	} else {
-		ode_step = gsl_odeiv_step_alloc(ode_type, 6 * hier->nstar);
-		ode_control = gsl_odeiv_control_y_new(input.absacc, input.relacc);
-		ode_evolve = gsl_odeiv_evolve_alloc(6 * hier->nstar);
 		ode_sys.function = fb_nonks_func;
 		ode_sys.jacobian = fb_nonks_jac;
 		ode_sys.dimension = 6 * hier->nstar;
 		ode_sys.params = &nonks_params;
 	}
 
+	/* the derivatives functions' work space; nstar never grows */
+	scratch = ctx->scratch;
+	ks_params = ctx->ks_params;
+	nonks_params = ctx->nonks_params;
+	ks_params.scratch = &scratch;
+	nonks_params.scratch = &scratch;
+
 	/* set parameters for integrator */
 	if (input.ks) {
 		ks_params.nstar = hier->nstar;
 		ks_params.kstar = ks_params.nstar*(ks_params.nstar-1)/2;
-		fb_malloc_ks_params(&ks_params);
 		fb_init_ks_params(&ks_params, *hier);
 	} else {
 		nonks_params.nstar = hier->nstar;
-		fb_malloc_nonks_params(&nonks_params);
 		fb_init_nonks_params(&nonks_params, *hier);
 		nonks_params.PN1 = input.PN1;
 		nonks_params.PN2 = input.PN2;
@@ -117,15 +228,20 @@ fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t,
 
 	
 	/* set the initial conditions in y_i */
+	y = ctx->y;
 	if (input.ks) {
-		y = fb_malloc_vector(8*ks_params.kstar+1);
 		y[0] = *t;
 		fb_euclidean_to_ks(phier.obj, y, ks_params.nstar, ks_params.kstar);
 		s = 0.0;
 	} else {
-		y = fb_malloc_vector(6*nonks_params.nstar);
 		fb_euclidean_to_nonks(phier.obj, y, nonks_params.nstar);
 		s = *t;
+		if (input.integrator == FB_INTEGRATOR_ARBS) {
+			ar = ctx->ar;
+			ar.nstar = nonks_params.nstar;
+			ar.dim = 6*ar.nstar+2;
+			fb_init_ar(&ar, &nonks_params, y);
+		}
 	}
 
 	/* store the initial energy and angular momentum */
@@ -146,13 +262,16 @@ fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t,
 	retval.count = 0;
 	tout = *t;
 	texpand = 0.0;
-	clk_tck = sysconf(_SC_CLK_TCK);
-	firstclock = times(&firsttimebuf);
+	tcpu0 = fb_cputime();
 	retval.tcpu = 0.0;
-	while (*t < input.tstop && retval.tcpu < input.tcpustop && !done) {
+	while (*t < input.tstop && retval.tcpu < input.tcpustop && (input.countstop <= 0 || retval.count < input.countstop) && !done) {
 		/* take one step */
 		slast = s;
-		status = gsl_odeiv_evolve_apply(ode_evolve, ode_control, ode_step, &ode_sys, &s, sstop, &h, y);
+		if (input.integrator == FB_INTEGRATOR_ARBS) {
+			status = fb_ar_apply(&ar, &s, input.tstop, input.absacc, input.relacc, y);
+		} else {
+			status = gsl_odeiv_evolve_apply(ode_evolve, ode_control, ode_step, &ode_sys, &s, sstop, &h, y);
+		}
 		if (status != GSL_SUCCESS) {
 			break;
 		}
@@ -318,21 +437,15 @@ fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t,
 		/* restart integrator if necessary */
 		if (restart) {
 			fb_dprintf("fewbody: restarting integrator: nobj=%d count=%ld\n", phier.nobj, retval.count);
-			fb_free_vector(y);
 			if (input.ks) {
-				fb_free_ks_params(ks_params);
 				ks_params.nstar = phier.nobj;
 				ks_params.kstar = ks_params.nstar*(ks_params.nstar-1)/2;
-				fb_malloc_ks_params(&ks_params);
 				fb_init_ks_params(&ks_params, phier);
 				
-				y = fb_malloc_vector(8*ks_params.kstar+1);
 				y[0] = *t;
 				fb_euclidean_to_ks(phier.obj, y, ks_params.nstar, ks_params.kstar);
 			} else {
-				fb_free_nonks_params(nonks_params);
 				nonks_params.nstar = phier.nobj;
-				fb_malloc_nonks_params(&nonks_params);
 				fb_init_nonks_params(&nonks_params, phier);
 				nonks_params.PN1 = input.PN1;
 				nonks_params.PN2 = input.PN2;
@@ -341,33 +454,29 @@ fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t,
 				nonks_params.PN35 = input.PN35;
 				nonks_params.units = units;
 				
-				y = fb_malloc_vector(6*nonks_params.nstar);
 				fb_euclidean_to_nonks(phier.obj, y, nonks_params.nstar);
+
+				if (input.integrator == FB_INTEGRATOR_ARBS) {
+					ar.nstar = nonks_params.nstar;
+					ar.dim = 6*ar.nstar+2;
+					fb_init_ar(&ar, &nonks_params, y);
+				}
 			}
 			
-			/* and re-allocate integrator */
-			gsl_odeiv_evolve_free(ode_evolve);
-			gsl_odeiv_control_free(ode_control);
-			gsl_odeiv_step_free(ode_step);
-			
-			/* re-initialize integrator */
+			/* re-initialize integrator for the new number of objects */
+			gsl_odeiv_control_init(ode_control, input.absacc, input.relacc, 1.0, 0.0);
 			if (input.ks) {
-				ode_step = gsl_odeiv_step_alloc(ode_type, 8*ks_params.kstar+1);
-				ode_control = gsl_odeiv_control_y_new(input.absacc, input.relacc);
-				ode_evolve = gsl_odeiv_evolve_alloc(8*ks_params.kstar+1);
+				fb_ctx_ode(ctx, 1, ks_params.nstar, &ode_step, &ode_evolve);
 				ode_sys.dimension = 8*ks_params.kstar+1;
 			} else {
-				ode_step = gsl_odeiv_step_alloc(ode_type, 6*nonks_params.nstar);
-				ode_control = gsl_odeiv_control_y_new(input.absacc, input.relacc);
-				ode_evolve = gsl_odeiv_evolve_alloc(6*nonks_params.nstar);
+				fb_ctx_ode(ctx, 0, nonks_params.nstar, &ode_step, &ode_evolve);
 				ode_sys.dimension = 6*nonks_params.nstar;
 			}
 		}
 
 		/* update variables that change on every integration step */
 		retval.count++;
-		currclock = times(&currtimebuf);
-		retval.tcpu = ((double) (currtimebuf.tms_utime + currtimebuf.tms_stime - firsttimebuf.tms_utime - firsttimebuf.tms_stime))/((double) clk_tck);
+		retval.tcpu = fb_cputime() - tcpu0;
 	}
 	
 	/* do final classification */
@@ -399,21 +508,6 @@ fb_ret_t fewbody(fb_input_t input, fb_units_t units, fb_hier_t *hier, double *t,
 		DeltaL[i] = L[i] - Li[i];
 	}
 
-	/* free GSL stuff */
-	gsl_odeiv_evolve_free(ode_evolve);
-	gsl_odeiv_control_free(ode_control);
-	gsl_odeiv_step_free(ode_step);
-
-	/* free our own stuff */
-	fb_free_vector(y);
-	fb_free_hier(phier);
-
-	if (input.ks) {
-		fb_free_ks_params(ks_params);
-	} else {
-		fb_free_nonks_params(nonks_params);
-	}
-
 	/* done! */
 	retval.DeltaE = E-Ei;
 	retval.DeltaEfrac = E/Ei-1.0;
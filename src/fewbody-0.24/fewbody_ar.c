@@ -0,0 +1,393 @@
+/* -*- linux-c -*- */
+/* fewbody_ar.c
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Algorithmic regularization: the logarithmic-Hamiltonian leapfrog of
+   Mikkola & Tanikawa (1999) and Preto & Tremaine (1999), with the
+   time-transformed step ds = U dt in the kicks and ds = (T + pt) dt in the
+   drifts, so that close passages are integrated with the same number of
+   steps regardless of eccentricity.  The leapfrog is time-symmetric, so
+   Gragg-Bulirsch-Stoer extrapolation in (h/n)^2 of runs with n=2,4,6,...
+   substeps gives a high, adaptive order.  PN terms enter as a
+   velocity-dependent perturbation through the auxiliary velocity of
+   Hellstrom & Mikkola (2010), with pt absorbing the work they do.  The
+   state is kept in the same Euclidean layout as fb_nonks_func() uses, so
+   the rest of fewbody() is unaffected by the choice of integrator. */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gsl/gsl_errno.h>
+#include "fewbody.h"
+
+/* allocate the integrator for nstar stars */
+void fb_malloc_ar(fb_ar_t *ar, int nstar)
+{
+	ar->nstar = nstar;
+	ar->dim = 6*nstar+2;
+	ar->z = fb_malloc_vector(ar->dim);
+	ar->w = fb_malloc_vector(3*nstar);
+	ar->v0 = fb_malloc_vector(3*nstar);
+	ar->aN = fb_malloc_vector(3*nstar);
+	ar->apn = fb_malloc_vector(3*nstar);
+	ar->ytmp = fb_malloc_vector(6*nstar);
+	ar->ftmp = fb_malloc_vector(6*nstar);
+	ar->prev = fb_malloc_matrix(FB_AR_KMAX, ar->dim);
+	ar->curr = fb_malloc_matrix(FB_AR_KMAX, ar->dim);
+}
+
+/* free the integrator */
+void fb_free_ar(fb_ar_t *ar)
+{
+	fb_free_vector(ar->z);
+	fb_free_vector(ar->w);
+	fb_free_vector(ar->v0);
+	fb_free_vector(ar->aN);
+	fb_free_vector(ar->apn);
+	fb_free_vector(ar->ytmp);
+	fb_free_vector(ar->ftmp);
+	fb_free_matrix(ar->prev);
+	fb_free_matrix(ar->curr);
+}
+
+/* Newtonian accelerations of the positions in z, into ar->aN; returns the force function U */
+static double fb_ar_newton(fb_ar_t *ar, const double *z)
+{
+	int i, j, k;
+	double *m=ar->params->m, r[3], r2, rinv, rinv3, U=0.0;
+
+	for (i=0; i<3*ar->nstar; i++) {
+		ar->aN[i] = 0.0;
+	}
+
+	for (i=0; i<ar->nstar-1; i++) {
+		for (j=i+1; j<ar->nstar; j++) {
+			for (k=0; k<3; k++) {
+				r[k] = z[j*6+k] - z[i*6+k];
+			}
+			r2 = r[0]*r[0] + r[1]*r[1] + r[2]*r[2];
+			rinv = 1.0/sqrt(r2);
+			rinv3 = rinv/r2;
+			U += m[i] * m[j] * rinv;
+			for (k=0; k<3; k++) {
+				ar->aN[i*3+k] += m[j] * rinv3 * r[k];
+				ar->aN[j*3+k] -= m[i] * rinv3 * r[k];
+			}
+		}
+	}
+
+	return(U);
+}
+
+/* PN accelerations at the positions in z and velocities v[i*vstride+k], into ar->apn;
+   assumes ar->aN is current */
+static void fb_ar_pn(fb_ar_t *ar, const double *z, const double *v, int vstride)
+{
+	int i, k;
+
+	for (i=0; i<ar->nstar; i++) {
+		for (k=0; k<3; k++) {
+			ar->ytmp[i*6+k] = z[i*6+k];
+			ar->ytmp[i*6+k+3] = v[i*vstride+k];
+		}
+	}
+
+	fb_nonks_func(0.0, ar->ytmp, ar->ftmp, ar->params);
+
+	for (i=0; i<ar->nstar; i++) {
+		for (k=0; k<3; k++) {
+			ar->apn[i*3+k] = ar->ftmp[i*6+k+3] - ar->aN[i*3+k];
+		}
+	}
+}
+
+/* advance the positions and time by a regularized step hs; returns 0 if the
+   time transformation breaks down */
+static int fb_ar_drift(fb_ar_t *ar, double hs)
+{
+	int i, k, n=ar->nstar;
+	double *z=ar->z, *m=ar->params->m, T=0.0, dt;
+
+	for (i=0; i<n; i++) {
+		T += 0.5 * m[i] * (z[i*6+3]*z[i*6+3] + z[i*6+4]*z[i*6+4] + z[i*6+5]*z[i*6+5]);
+	}
+
+	if (!(T + z[6*n+1] > 0.0)) {
+		return(0);
+	}
+
+	dt = hs / (T + z[6*n+1]);
+	for (i=0; i<n; i++) {
+		for (k=0; k<3; k++) {
+			z[i*6+k] += dt * z[i*6+k+3];
+		}
+	}
+	z[6*n] += dt;
+
+	return(1);
+}
+
+/* advance the velocities (and pt) by a regularized step hs */
+static void fb_ar_kick(fb_ar_t *ar, double hs)
+{
+	int i, k, n=ar->nstar;
+	double *z=ar->z, *m=ar->params->m, U, dt, work;
+
+	U = fb_ar_newton(ar, z);
+	dt = hs / U;
+
+	if (!ar->pn) {
+		for (i=0; i<n; i++) {
+			for (k=0; k<3; k++) {
+				z[i*6+k+3] += dt * ar->aN[i*3+k];
+			}
+		}
+		return;
+	}
+
+	/* auxiliary velocity algorithm: half kick of v with w, full kick of w
+	   with v, then the other half kick of v with the new w */
+	for (i=0; i<n; i++) {
+		for (k=0; k<3; k++) {
+			ar->v0[i*3+k] = z[i*6+k+3];
+		}
+	}
+
+	fb_ar_pn(ar, z, ar->w, 3);
+	for (i=0; i<n; i++) {
+		for (k=0; k<3; k++) {
+			z[i*6+k+3] += 0.5 * dt * (ar->aN[i*3+k] + ar->apn[i*3+k]);
+		}
+	}
+
+	fb_ar_pn(ar, z, &(z[3]), 6);
+	for (i=0; i<n; i++) {
+		for (k=0; k<3; k++) {
+			ar->w[i*3+k] += dt * (ar->aN[i*3+k] + ar->apn[i*3+k]);
+		}
+	}
+
+	fb_ar_pn(ar, z, ar->w, 3);
+	work = 0.0;
+	for (i=0; i<n; i++) {
+		for (k=0; k<3; k++) {
+			z[i*6+k+3] += 0.5 * dt * (ar->aN[i*3+k] + ar->apn[i*3+k]);
+			work += m[i] * 0.5 * (ar->v0[i*3+k] + z[i*6+k+3]) * ar->apn[i*3+k];
+		}
+	}
+
+	/* pt is minus the Newtonian energy, which the PN forces change */
+	z[6*n+1] -= dt * work;
+}
+
+/* nsub leapfrog substeps of a total regularized step H, starting from (y, t, pt) */
+static int fb_ar_leapfrog(fb_ar_t *ar, const double *y, double t, double H, int nsub)
+{
+	int i, k, n=ar->nstar;
+	double hs=H/((double) nsub);
+
+	for (i=0; i<6*n; i++) {
+		ar->z[i] = y[i];
+	}
+	ar->z[6*n] = t;
+	ar->z[6*n+1] = ar->pt;
+	if (ar->pn) {
+		for (i=0; i<n; i++) {
+			for (k=0; k<3; k++) {
+				ar->w[i*3+k] = y[i*6+k+3];
+			}
+		}
+	}
+
+	if (!fb_ar_drift(ar, 0.5*hs)) {
+		return(0);
+	}
+	for (i=0; i<nsub; i++) {
+		fb_ar_kick(ar, hs);
+		if (!fb_ar_drift(ar, (i==nsub-1?0.5*hs:hs))) {
+			return(0);
+		}
+	}
+
+	return(1);
+}
+
+/* move the state in y by a short time dt (possibly negative) along the
+   Newtonian accelerations, to land a step exactly on tstop */
+static void fb_ar_coast(fb_ar_t *ar, double *y, double dt)
+{
+	int i, k, n=ar->nstar;
+
+	for (i=0; i<n; i++) {
+		for (k=0; k<3; k++) {
+			y[i*6+k] += dt * y[i*6+k+3];
+		}
+	}
+	fb_ar_newton(ar, y);
+	for (i=0; i<n; i++) {
+		for (k=0; k<3; k++) {
+			y[i*6+k+3] += dt * ar->aN[i*3+k];
+		}
+	}
+}
+
+/* set up the integrator for the state y; ar must be malloc()ed for params->nstar stars */
+void fb_init_ar(fb_ar_t *ar, fb_nonks_params_t *params, const double *y)
+{
+	int i, j, k;
+	double *m=params->m, r[3], T=0.0, U, tmin=GSL_POSINF;
+
+	ar->params = params;
+	ar->pn = (params->PN1 || params->PN2 || params->PN25 || params->PN3 || params->PN35);
+	ar->nrej = 0;
+
+	if (ar->nstar < 2) {
+		ar->pt = 0.0;
+		ar->h = FB_H;
+		return;
+	}
+
+	for (i=0; i<6*ar->nstar; i++) {
+		ar->z[i] = y[i];
+	}
+	U = fb_ar_newton(ar, ar->z);
+	for (i=0; i<ar->nstar; i++) {
+		T += 0.5 * m[i] * (y[i*6+3]*y[i*6+3] + y[i*6+4]*y[i*6+4] + y[i*6+5]*y[i*6+5]);
+	}
+	ar->pt = U - T;
+
+	/* start with a tenth of the shortest two-body time scale; the step
+	   control takes over from there */
+	for (i=0; i<ar->nstar-1; i++) {
+		for (j=i+1; j<ar->nstar; j++) {
+			for (k=0; k<3; k++) {
+				r[k] = y[j*6+k] - y[i*6+k];
+			}
+			tmin = FB_MIN(tmin, sqrt(fb_cub(fb_mod(r))/(m[i]+m[j])));
+		}
+	}
+	ar->h = 0.1 * U * tmin;
+}
+
+/* take one step; same contract as gsl_odeiv_evolve_apply() in the non-regularized
+   case: on success y holds the new positions and velocities and *t the new time,
+   which never passes tstop.  Time is a dependent variable here, so a step that
+   would pass tstop is shortened from the estimate dt/ds = 1/U and then by the
+   secant on the time it actually took, until it lands within FB_AR_TSTOP_TOL of
+   a step from tstop; the rest is coasted. */
+int fb_ar_apply(fb_ar_t *ar, double *t, double tstop, double absacc, double relacc, double *y)
+{
+	int i, j, k, n=ar->nstar, ntry, limited=0, retarget;
+	double H, err, scale, fac, y0, dt, U, **tmp;
+
+	/* a single object just coasts */
+	if (n < 2) {
+		for (k=0; k<3; k++) {
+			y[k] += (tstop - *t) * y[k+3];
+		}
+		*t = tstop;
+		return(GSL_SUCCESS);
+	}
+
+	H = ar->h;
+	for (i=0; i<6*n; i++) {
+		ar->z[i] = y[i];
+	}
+	U = fb_ar_newton(ar, ar->z);
+	if (H / U > tstop - *t) {
+		H = (tstop - *t) * U;
+		limited = 1;
+	}
+	for (ntry=0; ntry<64; ntry++) {
+		err = GSL_POSINF;
+		retarget = 0;
+		for (k=0; k<FB_AR_KMAX; k++) {
+			if (!fb_ar_leapfrog(ar, y, *t, H, 2*(k+1))) {
+				break;
+			}
+
+			/* next row of the extrapolation tableau, polynomial in (H/n)^2 */
+			for (i=0; i<ar->dim; i++) {
+				ar->curr[0][i] = ar->z[i];
+			}
+			for (j=1; j<=k; j++) {
+				fac = fb_sqr(((double) (k+1))/((double) (k-j+1))) - 1.0;
+				for (i=0; i<ar->dim; i++) {
+					ar->curr[j][i] = ar->curr[j-1][i] + (ar->curr[j-1][i] - ar->prev[j-1][i]) / fac;
+				}
+			}
+
+			/* error estimate from the last two columns, scaled as in GSL's y control */
+			if (k > 0) {
+				err = 0.0;
+				for (i=0; i<6*n+1; i++) {
+					y0 = (i<6*n?y[i]:*t);
+					scale = absacc + relacc * FB_MAX(fabs(y0), fabs(ar->curr[k][i]));
+					err = FB_MAX(err, fabs(ar->curr[k][i] - ar->curr[k-1][i]) / scale);
+				}
+				if (!isfinite(err)) {
+					break;
+				}
+				if (err <= 1.0) {
+					dt = ar->curr[k][6*n] - *t;
+					/* passed tstop by more than can be coasted back: aim again */
+					if (*t + dt > tstop && *t + dt - tstop > FB_AR_TSTOP_TOL * dt) {
+						H *= (tstop - *t) / dt;
+						limited = 1;
+						retarget = 1;
+						break;
+					}
+
+					for (i=0; i<6*n; i++) {
+						y[i] = ar->curr[k][i];
+					}
+					*t += dt;
+					ar->pt = ar->curr[k][6*n+1];
+					if (fabs(tstop - *t) <= FB_AR_TSTOP_TOL * dt) {
+						fb_ar_coast(ar, y, tstop - *t);
+						*t = tstop;
+					}
+
+					/* aim to converge in column FB_AR_KOPT next time; a
+					   step shortened to hit tstop does not shrink the next */
+					fac = FB_AR_SAFETY * pow(FB_MAX(err, 1.0e-10), -1.0/((double) (2*k+1)));
+					fac = FB_MAX(0.2, FB_MIN(1.5, fac));
+					if (k >= FB_AR_KOPT) {
+						fac = FB_MIN(fac, 1.0);
+					}
+					ar->h = (limited && fac >= 1.0) ? FB_MAX(H * fac, ar->h) : H * fac;
+					return(GSL_SUCCESS);
+				}
+			}
+
+			tmp = ar->prev;
+			ar->prev = ar->curr;
+			ar->curr = tmp;
+		}
+
+		if (retarget) {
+			continue;
+		}
+
+		/* no convergence: shrink the step and try again */
+		ar->nrej++;
+		H *= (isfinite(err) ? FB_MAX(0.1, FB_MIN(0.5, FB_AR_SAFETY * pow(err, -1.0/((double) (2*FB_AR_KMAX-1))))) : 0.25);
+	}
+
+	return(GSL_FAILURE);
+}
@@ -0,0 +1,295 @@
+/* -*- linux-c -*- */
+/* fewbody_flyby.c
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Analytic outcome of a distant flyby of two objects (singles or binaries).
+   The outer orbit is taken to be the Kepler hyperbola of two point masses,
+   and each binary's eccentricity and angular momentum vectors are evolved
+   through the passage with the orbit-averaged (secular) quadrupole tidal
+   equations, integrated in the true anomaly of the outer orbit.  The
+   semimajor axes do not change at this order; the true energy exchange of a
+   slow distant encounter is exponentially small in the ratio of the passage
+   and orbital time scales. */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+#include "fewbody.h"
+
+/* relative orbit of the two top-level objects */
+typedef struct{
+	double M; /* total mass */
+	double hmod; /* specific angular momentum */
+	double e; /* eccentricity */
+	double p; /* semilatus rectum */
+	double phat[3], qhat[3]; /* pericenter direction, and 90 degrees ahead of it in the orbital plane */
+} fb_flyby_orbit_t;
+
+/* the relative orbit of obj[0] about obj[1]; returns 1 if it is unbound */
+static int fb_flyby_orbit(fb_hier_t *hier, fb_flyby_orbit_t *orb, double r[3], double v[3])
+{
+	int i;
+	double h[3], vxh[3], rmod, Erel;
+
+	orb->M = hier->obj[0]->m + hier->obj[1]->m;
+	for (i=0; i<3; i++) {
+		r[i] = hier->obj[0]->x[i] - hier->obj[1]->x[i];
+		v[i] = hier->obj[0]->v[i] - hier->obj[1]->v[i];
+	}
+	rmod = fb_mod(r);
+	Erel = 0.5 * fb_dot(v, v) - orb->M / rmod;
+	if (Erel <= 0.0) {
+		return(0);
+	}
+
+	fb_cross(r, v, h);
+	orb->hmod = fb_mod(h);
+	if (orb->hmod <= 0.0) {
+		return(0);
+	}
+	fb_cross(v, h, vxh);
+	for (i=0; i<3; i++) {
+		orb->phat[i] = vxh[i] / orb->M - r[i] / rmod;
+	}
+	orb->e = fb_mod(orb->phat);
+	for (i=0; i<3; i++) {
+		orb->phat[i] /= orb->e;
+		h[i] /= orb->hmod;
+	}
+	fb_cross(h, orb->phat, orb->qhat);
+	orb->p = fb_sqr(orb->hmod) / orb->M;
+
+	return(1);
+}
+
+/* ratio of the pericenter distance of the outer orbit to the largest apocenter
+   distance of the binaries taking part; 0 if the hier is not two objects on an
+   unbound orbit with at least one of them a binary (and none more complex) */
+double fb_flyby_ratio(fb_hier_t *hier)
+{
+	int i;
+	double r[3], v[3], amax=0.0;
+	fb_flyby_orbit_t orb;
+
+	if (hier->nobj != 2) {
+		return(0.0);
+	}
+	for (i=0; i<2; i++) {
+		if (hier->obj[i]->n > 2) {
+			return(0.0);
+		} else if (hier->obj[i]->n == 2) {
+			amax = FB_MAX(amax, hier->obj[i]->a * (1.0 + hier->obj[i]->e));
+		}
+	}
+	if (amax <= 0.0 || !fb_flyby_orbit(hier, &orb, r, v)) {
+		return(0.0);
+	}
+
+	return(orb.p / (1.0 + orb.e) / amax);
+}
+
+/* d(e,j)/dnu for a binary of mass mb and semimajor axis a, perturbed by mass m3
+   on the outer orbit; y = (e[3], j[3]) */
+static void fb_flyby_deriv(double nu, const double *y, double *dydnu, fb_flyby_orbit_t *orb, double mb, double m3, double a)
+{
+	int i;
+	double R, n[3], en, jn, C, gE[3], gJ[3], c1[3], c2[3], L, dtdnu;
+	const double *e=y, *j=y+3;
+
+	R = orb->p / (1.0 + orb->e * cos(nu));
+	for (i=0; i<3; i++) {
+		n[i] = cos(nu) * orb->phat[i] + sin(nu) * orb->qhat[i];
+	}
+	en = e[0]*n[0] + e[1]*n[1] + e[2]*n[2];
+	jn = j[0]*n[0] + j[1]*n[1] + j[2]*n[2];
+
+	/* gradients of the orbit-averaged quadrupole potential
+	   <Phi> = -(m3 a^2 / 4 R^3) (15 (e.n)^2 - 3 (j.n)^2 + 1 - 6 e^2) */
+	C = -m3 * a * a / (4.0 * fb_cub(R));
+	for (i=0; i<3; i++) {
+		gE[i] = C * (30.0 * en * n[i] - 12.0 * e[i]);
+		gJ[i] = C * (-6.0 * jn * n[i]);
+	}
+
+	/* Milankovitch equations, converted to d/dnu */
+	L = sqrt(mb * a);
+	dtdnu = R * R / orb->hmod;
+
+	fb_cross((double *) j, gJ, c1);
+	fb_cross((double *) e, gE, c2);
+	for (i=0; i<3; i++) {
+		dydnu[3+i] = -(c1[i] + c2[i]) / L * dtdnu;
+	}
+	fb_cross((double *) j, gE, c1);
+	fb_cross((double *) e, gJ, c2);
+	for (i=0; i<3; i++) {
+		dydnu[i] = -(c1[i] + c2[i]) / L * dtdnu;
+	}
+}
+
+/* evolve the binary obj through the passage, from true anomaly -nu0 to nu0 */
+static void fb_flyby_secular(fb_obj_t *obj, double m3, fb_flyby_orbit_t *orb, double nu0)
+{
+	int i, k;
+	double y[6], y1[6], k1[6], k2[6], k3[6], k4[6], nu, dnu, e, jmod, ej;
+
+	for (i=0; i<3; i++) {
+		y[i] = obj->e * obj->Ahat[i];
+		y[3+i] = sqrt(1.0 - fb_sqr(obj->e)) * obj->Lhat[i];
+	}
+
+	/* classical RK4; the integrand is smooth in the true anomaly */
+	dnu = 2.0 * nu0 / FB_FLYBY_NSTEP;
+	nu = -nu0;
+	for (k=0; k<FB_FLYBY_NSTEP; k++) {
+		fb_flyby_deriv(nu, y, k1, orb, obj->m, m3, obj->a);
+		for (i=0; i<6; i++) y1[i] = y[i] + 0.5 * dnu * k1[i];
+		fb_flyby_deriv(nu + 0.5 * dnu, y1, k2, orb, obj->m, m3, obj->a);
+		for (i=0; i<6; i++) y1[i] = y[i] + 0.5 * dnu * k2[i];
+		fb_flyby_deriv(nu + 0.5 * dnu, y1, k3, orb, obj->m, m3, obj->a);
+		for (i=0; i<6; i++) y1[i] = y[i] + dnu * k3[i];
+		fb_flyby_deriv(nu + dnu, y1, k4, orb, obj->m, m3, obj->a);
+		for (i=0; i<6; i++) y[i] += dnu / 6.0 * (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]);
+		nu += dnu;
+	}
+
+	/* restore e.j=0 and e^2+j^2=1, which the exact flow conserves */
+	e = FB_MIN(fb_mod(y), 1.0 - 1.0e-12);
+	if (e > 0.0) {
+		for (i=0; i<3; i++) {
+			obj->Ahat[i] = y[i] / fb_mod(y);
+		}
+	}
+	ej = y[3]*obj->Ahat[0] + y[4]*obj->Ahat[1] + y[5]*obj->Ahat[2];
+	for (i=0; i<3; i++) {
+		y[3+i] -= ej * obj->Ahat[i];
+	}
+	jmod = fb_mod(y+3);
+	for (i=0; i<3; i++) {
+		obj->Lhat[i] = y[3+i] / jmod;
+	}
+	obj->e = e;
+}
+
+/* angular momentum of the two top-level objects: the outer orbit plus the
+   internal orbital angular momentum of each binary */
+static void fb_flyby_angmom(fb_hier_t *hier, double L[3])
+{
+	int i, k;
+	double l[3], Lb;
+	fb_obj_t *obj;
+
+	for (k=0; k<3; k++) {
+		L[k] = 0.0;
+	}
+	for (i=0; i<2; i++) {
+		obj = hier->obj[i];
+		fb_cross(obj->x, obj->v, l);
+		for (k=0; k<3; k++) {
+			L[k] += obj->m * l[k];
+		}
+		if (obj->n == 2) {
+			Lb = obj->obj[0]->m * obj->obj[1]->m / obj->m * sqrt(obj->m * obj->a * (1.0 - fb_sqr(obj->e)));
+			for (k=0; k<3; k++) {
+				L[k] += Lb * obj->Lhat[k];
+			}
+		}
+	}
+}
+
+/* replace the encounter by its analytic outcome: the objects end up at the
+   mirror image of their initial positions on the outer hyperbola, and each
+   binary has its secularly evolved eccentricity and orientation */
+void fb_flyby(fb_hier_t *hier, double *t, fb_ret_t *retval)
+{
+	int i;
+	double r[3], v[3], rf[3], vf[3], xcm[3], vcm[3], m0, m1, rmod, cosnu, nu0, ah, coshF, F, dt, rp, vp;
+	double Li[3], L[3], DeltaL[3];
+	fb_flyby_orbit_t orb;
+
+	if (!fb_flyby_orbit(hier, &orb, r, v)) {
+		return;
+	}
+	fb_flyby_angmom(hier, Li);
+	m0 = hier->obj[0]->m;
+	m1 = hier->obj[1]->m;
+	rmod = fb_mod(r);
+
+	/* true anomaly of the starting point, and the time to get to its mirror image */
+	cosnu = (orb.p / rmod - 1.0) / orb.e;
+	nu0 = acos(FB_MAX(-1.0, FB_MIN(1.0, cosnu)));
+	ah = orb.p / (fb_sqr(orb.e) - 1.0);
+	coshF = FB_MAX(1.0, (1.0 + rmod / ah) / orb.e);
+	F = log(coshF + sqrt(fb_sqr(coshF) - 1.0));
+	dt = 2.0 * sqrt(fb_cub(ah) / orb.M) * (orb.e * sinh(F) - F);
+
+	for (i=0; i<2; i++) {
+		if (hier->obj[i]->n == 2) {
+			fb_flyby_secular(hier->obj[i], hier->obj[1-i]->m, &orb, nu0);
+		}
+	}
+
+	/* mirror the relative orbit about the pericenter direction */
+	rp = fb_dot(r, orb.phat);
+	vp = fb_dot(v, orb.phat);
+	for (i=0; i<3; i++) {
+		rf[i] = 2.0 * rp * orb.phat[i] - r[i];
+		vf[i] = v[i] - 2.0 * vp * orb.phat[i];
+		xcm[i] = (m0 * hier->obj[0]->x[i] + m1 * hier->obj[1]->x[i]) / orb.M;
+		vcm[i] = (m0 * hier->obj[0]->v[i] + m1 * hier->obj[1]->v[i]) / orb.M;
+	}
+	*t += dt;
+	for (i=0; i<3; i++) {
+		xcm[i] += vcm[i] * dt;
+		hier->obj[0]->x[i] = xcm[i] + m1 / orb.M * rf[i];
+		hier->obj[1]->x[i] = xcm[i] - m0 / orb.M * rf[i];
+		hier->obj[0]->v[i] = vcm[i] + m1 / orb.M * vf[i];
+		hier->obj[1]->v[i] = vcm[i] - m0 / orb.M * vf[i];
+	}
+	for (i=0; i<2; i++) {
+		if (hier->obj[i]->n == 2) {
+			fb_downsync(hier->obj[i], *t);
+		}
+	}
+
+	/* the binaries' eccentricities change but the outer orbit is only mirrored,
+	   so the torque on the binaries is not given back to the outer orbit at
+	   this order; report it the way fewbody() reports its integration error */
+	fb_flyby_angmom(hier, L);
+	for (i=0; i<3; i++) {
+		DeltaL[i] = L[i] - Li[i];
+	}
+
+	retval->count = 0;
+	retval->retval = 1;
+	retval->iclassify = 0;
+	retval->tcpu = 0.0;
+	retval->DeltaE = 0.0;
+	retval->DeltaEfrac = 0.0;
+	retval->DeltaE_GW = 0.0;
+	retval->DeltaE_GWfrac = 0.0;
+	retval->DeltaL = fb_mod(DeltaL);
+	retval->DeltaLfrac = fb_mod(DeltaL)/fb_mod(Li);
+	retval->Rmin = orb.p / (1.0 + orb.e);
+	retval->PN_ON = 0;
+	retval->Rmin_i = 0;
+	retval->Rmin_j = 1;
+	retval->Nosc = 0;
+}
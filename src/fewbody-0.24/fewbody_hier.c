@@ -54,6 +54,29 @@ void fb_malloc_hier(fb_hier_t *hier)
 	hier->obj = (fb_obj_t **) malloc(hier->nstarinit * sizeof(fb_obj_t *));
 }
 
+/* return a hier to the state fb_malloc_hier() leaves it in, so that it can be
+   used again for a new set of stars instead of being freed */
+void fb_clear_hier(fb_hier_t *hier)
+{
+	int i;
+	fb_obj_t obj;
+
+	for (i=0; i<hier->hi[hier->nstarinit]+1; i++) {
+		obj = hier->hier[i];
+		memset(&(hier->hier[i]), 0, sizeof(fb_obj_t));
+		hier->hier[i].id = obj.id;
+		hier->hier[i].vkick = obj.vkick;
+		hier->hier[i].a_merger = obj.a_merger;
+		hier->hier[i].e_merger = obj.e_merger;
+		hier->hier[i].a_50M = obj.a_50M;
+		hier->hier[i].e_50M = obj.e_50M;
+		hier->hier[i].a_100M = obj.a_100M;
+		hier->hier[i].e_100M = obj.e_100M;
+		hier->hier[i].a_500M = obj.a_500M;
+		hier->hier[i].e_500M = obj.e_500M;
+	}
+}
+
 /* initialize to a flat hier */
 void fb_init_hier(fb_hier_t *hier)
 {
@@ -93,6 +116,97 @@ void fb_free_hier(fb_hier_t hier)
 	free(hier.obj);
 }
 
+/* number of bytes fb_pack_hier() needs for a hier with nstarinit stars */
+size_t fb_pack_hier_size(int nstarinit)
+{
+	int nhier, hi[FB_MAX_PACK_NSTAR+1];
+
+	fb_create_indices(hi, nstarinit);
+	nhier = hi[nstarinit] + 1;
+
+	return((3 + (nstarinit-1) + nstarinit) * sizeof(int) +
+	       nhier * (sizeof(fb_obj_t) + 2 * sizeof(int) + nstarinit * (sizeof(long) + 9 * sizeof(double))));
+}
+
+/* pack a hier into a flat buffer, e.g. to send it to another process; pointers
+   within the hier are stored as indices into hier->hier (-1 for NULL) */
+void fb_pack_hier(fb_hier_t *hier, char *buf)
+{
+	int i, j, idx[2], nhier=hier->hi[hier->nstarinit]+1, n=hier->nstarinit;
+	double *arr[9];
+
+	memcpy(buf, &(hier->nstarinit), sizeof(int)); buf += sizeof(int);
+	memcpy(buf, &(hier->nstar), sizeof(int)); buf += sizeof(int);
+	memcpy(buf, &(hier->nobj), sizeof(int)); buf += sizeof(int);
+	memcpy(buf, &(hier->narr[2]), (n-1) * sizeof(int)); buf += (n-1) * sizeof(int);
+	for (i=0; i<n; i++) {
+		idx[0] = (i < hier->nobj) ? (int) (hier->obj[i] - hier->hier) : -1;
+		memcpy(buf, &(idx[0]), sizeof(int)); buf += sizeof(int);
+	}
+
+	for (i=0; i<nhier; i++) {
+		memcpy(buf, &(hier->hier[i]), sizeof(fb_obj_t)); buf += sizeof(fb_obj_t);
+		for (j=0; j<2; j++) {
+			idx[j] = (hier->hier[i].obj[j] == NULL) ? -1 : (int) (hier->hier[i].obj[j] - hier->hier);
+		}
+		memcpy(buf, idx, 2 * sizeof(int)); buf += 2 * sizeof(int);
+		memcpy(buf, hier->hier[i].id, n * sizeof(long)); buf += n * sizeof(long);
+		arr[0] = hier->hier[i].vkick; arr[1] = hier->hier[i].a_merger; arr[2] = hier->hier[i].e_merger;
+		arr[3] = hier->hier[i].a_50M; arr[4] = hier->hier[i].e_50M; arr[5] = hier->hier[i].a_100M;
+		arr[6] = hier->hier[i].e_100M; arr[7] = hier->hier[i].a_500M; arr[8] = hier->hier[i].e_500M;
+		for (j=0; j<9; j++) {
+			memcpy(buf, arr[j], n * sizeof(double)); buf += n * sizeof(double);
+		}
+	}
+}
+
+/* unpack a buffer written by fb_pack_hier() into a hier allocated by
+   fb_malloc_hier() with the same nstarinit */
+void fb_unpack_hier(const char *buf, fb_hier_t *hier)
+{
+	int i, j, idx[2], nhier=hier->hi[hier->nstarinit]+1, n=hier->nstarinit;
+	fb_obj_t tmp;
+	double *arr[9];
+
+	buf += sizeof(int);
+	memcpy(&(hier->nstar), buf, sizeof(int)); buf += sizeof(int);
+	memcpy(&(hier->nobj), buf, sizeof(int)); buf += sizeof(int);
+	memcpy(&(hier->narr[2]), buf, (n-1) * sizeof(int)); buf += (n-1) * sizeof(int);
+	for (i=0; i<n; i++) {
+		memcpy(&(idx[0]), buf, sizeof(int)); buf += sizeof(int);
+		if (i < hier->nobj) {
+			hier->obj[i] = &(hier->hier[idx[0]]);
+		}
+	}
+
+	for (i=0; i<nhier; i++) {
+		/* keep our own arrays, take everything else */
+		memcpy(&tmp, buf, sizeof(fb_obj_t)); buf += sizeof(fb_obj_t);
+		tmp.id = hier->hier[i].id;
+		tmp.vkick = hier->hier[i].vkick;
+		tmp.a_merger = hier->hier[i].a_merger;
+		tmp.e_merger = hier->hier[i].e_merger;
+		tmp.a_50M = hier->hier[i].a_50M;
+		tmp.e_50M = hier->hier[i].e_50M;
+		tmp.a_100M = hier->hier[i].a_100M;
+		tmp.e_100M = hier->hier[i].e_100M;
+		tmp.a_500M = hier->hier[i].a_500M;
+		tmp.e_500M = hier->hier[i].e_500M;
+		memcpy(idx, buf, 2 * sizeof(int)); buf += 2 * sizeof(int);
+		for (j=0; j<2; j++) {
+			tmp.obj[j] = (idx[j] < 0) ? NULL : &(hier->hier[idx[j]]);
+		}
+		hier->hier[i] = tmp;
+		memcpy(hier->hier[i].id, buf, n * sizeof(long)); buf += n * sizeof(long);
+		arr[0] = hier->hier[i].vkick; arr[1] = hier->hier[i].a_merger; arr[2] = hier->hier[i].e_merger;
+		arr[3] = hier->hier[i].a_50M; arr[4] = hier->hier[i].e_50M; arr[5] = hier->hier[i].a_100M;
+		arr[6] = hier->hier[i].e_100M; arr[7] = hier->hier[i].a_500M; arr[8] = hier->hier[i].e_500M;
+		for (j=0; j<9; j++) {
+			memcpy(arr[j], buf, n * sizeof(double)); buf += n * sizeof(double);
+		}
+	}
+}
+
 /* trickle down hier */
 void fb_trickle(fb_hier_t *hier, double t)
 {
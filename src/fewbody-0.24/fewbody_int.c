@@ -112,3 +112,35 @@ void fb_free_nonks_params(fb_nonks_params_t nonks_params)
 	fb_free_vector(nonks_params.m);
 }
 
+
+/* allocate the derivatives functions' scratch space for up to nmax stars */
+void fb_malloc_scratch(fb_scratch_t *scratch, int nmax)
+{
+	scratch->nmax = nmax;
+	scratch->kmax = nmax*(nmax-1)/2;
+	scratch->fm = fb_malloc_vector(nmax * nmax * 3);
+	scratch->fmr = fb_malloc_vector(nmax * nmax * 3);
+	scratch->Q = fb_malloc_matrix(FB_MAX(scratch->kmax, 1), 4);
+	scratch->P = fb_malloc_matrix(FB_MAX(scratch->kmax, 1), 4);
+	scratch->p = fb_malloc_matrix(FB_MAX(scratch->kmax, 1), 4);
+	scratch->A = fb_malloc_matrix(FB_MAX(scratch->kmax, 1), 4);
+	scratch->TP = fb_malloc_matrix(FB_MAX(scratch->kmax, 1), 4);
+	scratch->TQ = fb_malloc_matrix(FB_MAX(scratch->kmax, 1), 4);
+	scratch->UQ = fb_malloc_matrix(FB_MAX(scratch->kmax, 1), 4);
+	scratch->d = fb_malloc_vector(FB_MAX(scratch->kmax, 1));
+}
+
+/* free the derivatives functions' scratch space */
+void fb_free_scratch(fb_scratch_t *scratch)
+{
+	fb_free_vector(scratch->fm);
+	fb_free_vector(scratch->fmr);
+	fb_free_matrix(scratch->Q);
+	fb_free_matrix(scratch->P);
+	fb_free_matrix(scratch->p);
+	fb_free_matrix(scratch->A);
+	fb_free_matrix(scratch->TP);
+	fb_free_matrix(scratch->TQ);
+	fb_free_matrix(scratch->UQ);
+	fb_free_vector(scratch->d);
+}
@@ -21,7 +21,9 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <zlib.h>
 #include "fewbody.h"
 
 /* print the version */
@@ -103,3 +105,137 @@ void fb_print_story(fb_obj_t *star, int nstar, double t, char *logentry)
 	
 	fprintf(stdout, ")Particle\n");
 }
+
+/* the part of fb_input_t before the log entry, and the part after it; the log
+   entry itself is not stored with a scattering */
+#define FB_SCAT_INPUT_HEAD (offsetof(fb_input_t, firstlogentry))
+#define FB_SCAT_INPUT_TAIL (sizeof(fb_input_t) - offsetof(fb_input_t, fexp))
+
+/* file header: the tag, the format version, and the sizes of the structures
+   stored verbatim, so that a file from an incompatible build is refused */
+typedef struct{
+	char tag[8];
+	int version, objsize, headsize, tailsize;
+} fb_scat_header_t;
+
+static void fb_scat_header(fb_scat_header_t *header)
+{
+	memset(header, 0, sizeof(fb_scat_header_t));
+	strncpy(header->tag, FB_SCAT_MAGIC, sizeof(header->tag));
+	header->version = FB_SCAT_VERSION;
+	header->objsize = (int) sizeof(fb_obj_t);
+	header->headsize = (int) FB_SCAT_INPUT_HEAD;
+	header->tailsize = (int) FB_SCAT_INPUT_TAIL;
+}
+
+/* open a file of scatterings written by fb_write_scattering(); mode is "r" to
+   read (the header is checked), "w" to start a new file, or "a" to append to an
+   existing one (which is started like "w" if it is empty or missing); returns
+   NULL on failure */
+gzFile fb_open_scatterings(const char *fname, const char *mode)
+{
+	FILE *fp;
+	gzFile gzfp;
+	fb_scat_header_t header, fheader;
+	int empty=1;
+
+	fb_scat_header(&header);
+
+	if (mode[0] == 'r') {
+		if ((gzfp = gzopen(fname, "rb")) == NULL) {
+			return(NULL);
+		}
+		if (gzread(gzfp, &fheader, sizeof(fb_scat_header_t)) != (int) sizeof(fb_scat_header_t) || \
+		    memcmp(&header, &fheader, sizeof(fb_scat_header_t)) != 0) {
+			fprintf(stderr, "fb_open_scatterings(): %s was not written by this version of fewbody\n", fname);
+			gzclose(gzfp);
+			return(NULL);
+		}
+		return(gzfp);
+	}
+
+	if (mode[0] == 'a' && (fp = fopen(fname, "rb")) != NULL) {
+		empty = (fgetc(fp) == EOF);
+		fclose(fp);
+	}
+	if ((gzfp = gzopen(fname, empty ? "wb" : "ab")) == NULL) {
+		return(NULL);
+	}
+	if (empty && gzwrite(gzfp, &header, sizeof(fb_scat_header_t)) != (int) sizeof(fb_scat_header_t)) {
+		gzclose(gzfp);
+		return(NULL);
+	}
+
+	return(gzfp);
+}
+
+/* append the exact inputs of one call to fewbody() to fp: everything needed to
+   repeat it, including the state of the random stream; returns 0 on success */
+int fb_write_scattering(gzFile fp, fb_input_t *input, fb_units_t *units, fb_hier_t *hier, double t, struct rng_t113_state *curr_st)
+{
+	size_t size=fb_pack_hier_size(hier->nstarinit);
+	char *buf;
+	int err=0;
+
+	buf = (char *) malloc(size);
+	fb_pack_hier(hier, buf);
+
+	err |= (gzwrite(fp, &(hier->nstarinit), sizeof(int)) != (int) sizeof(int));
+	err |= (gzwrite(fp, &t, sizeof(double)) != (int) sizeof(double));
+	err |= (gzwrite(fp, units, sizeof(fb_units_t)) != (int) sizeof(fb_units_t));
+	err |= (gzwrite(fp, curr_st, sizeof(struct rng_t113_state)) != (int) sizeof(struct rng_t113_state));
+	err |= (gzwrite(fp, input, FB_SCAT_INPUT_HEAD) != (int) FB_SCAT_INPUT_HEAD);
+	err |= (gzwrite(fp, &(input->fexp), FB_SCAT_INPUT_TAIL) != (int) FB_SCAT_INPUT_TAIL);
+	err |= (gzwrite(fp, buf, size) != (int) size);
+
+	free(buf);
+
+	return(err ? -1 : 0);
+}
+
+/* read the next scattering written by fb_write_scattering(); hier is
+   (re)allocated if it does not have the right number of stars, so set
+   hier->nstarinit to 0 before the first call; returns 1 if a scattering was
+   read, 0 at the end of the file, and -1 if the file is truncated or corrupt */
+int fb_read_scattering(gzFile fp, fb_input_t *input, fb_units_t *units, fb_hier_t *hier, double *t, struct rng_t113_state *curr_st)
+{
+	int nstarinit, n, err=0;
+	size_t size;
+	char *buf;
+
+	n = gzread(fp, &nstarinit, sizeof(int));
+	if (n == 0) {
+		return(0);
+	} else if (n != (int) sizeof(int) || nstarinit < 1 || nstarinit > FB_MAX_PACK_NSTAR) {
+		return(-1);
+	}
+
+	if (hier->nstarinit != nstarinit) {
+		if (hier->nstarinit > 0) {
+			fb_free_hier(*hier);
+		}
+		hier->nstarinit = nstarinit;
+		fb_malloc_hier(hier);
+	}
+
+	err |= (gzread(fp, t, sizeof(double)) != (int) sizeof(double));
+	err |= (gzread(fp, units, sizeof(fb_units_t)) != (int) sizeof(fb_units_t));
+	err |= (gzread(fp, curr_st, sizeof(struct rng_t113_state)) != (int) sizeof(struct rng_t113_state));
+	err |= (gzread(fp, input, FB_SCAT_INPUT_HEAD) != (int) FB_SCAT_INPUT_HEAD);
+	err |= (gzread(fp, &(input->fexp), FB_SCAT_INPUT_TAIL) != (int) FB_SCAT_INPUT_TAIL);
+	input->firstlogentry[0] = '\0';
+	if (err) {
+		return(-1);
+	}
+
+	size = fb_pack_hier_size(nstarinit);
+	buf = (char *) malloc(size);
+	if (gzread(fp, buf, size) != (int) size) {
+		free(buf);
+		return(-1);
+	}
+	fb_unpack_hier(buf, hier);
+	free(buf);
+
+	return(1);
+}
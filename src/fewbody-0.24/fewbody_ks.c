@@ -124,30 +124,24 @@ void fb_calc_Tmat(double **a, double *m, double **T, int nstar, int kstar)
 	}
 }
 
-/* the derivatives function for the GSL ODE integrator */
-int fb_ks_func(double s, const double *y, double *f, void *params)
+/* the body of the derivatives function; always inlined, so the 3- and 4-body
+   callers below, which pass a constant kstar and fixed-size stack arrays, get
+   specialized copies with the loops over separations unrolled */
+static int fb_ks_kernel(const double *y, double *f, const fb_ks_params_t *params, const int kstar,
+			double (*Q)[4], double (*P)[4], double (*p)[4], double (*A)[4],
+			double (*TP)[4], double (*TQ)[4], double (*UQ)[4], double *d) __attribute__ ((always_inline));
+static inline int fb_ks_kernel(const double *y, double *f, const fb_ks_params_t *params, const int kstar,
+			       double (*Q)[4], double (*P)[4], double (*p)[4], double (*A)[4],
+			       double (*TP)[4], double (*TQ)[4], double (*UQ)[4], double *d)
 {
-	int k, l, m, kstar;
-	double *M, **amat, **Tmat, Einit;
-	double **Q, **P, **p, **A, **TP, **TQ, **UQ, *d;
+	int k, l, m;
+	double *M, **Tmat, Einit;
 	double Qmat[4][4], Pmat[4][4], Astar[4], T, U, val, L, H, G, GT, GU;
 
 	/* set parameters */
-	kstar = (*(fb_ks_params_t *) params).kstar;
-	M = (*(fb_ks_params_t *) params).M;
-	amat = (*(fb_ks_params_t *) params).amat;
-	Tmat = (*(fb_ks_params_t *) params).Tmat;
-	Einit = (*(fb_ks_params_t *) params).Einit;
-
-	/* allocate memory */
-	Q = fb_malloc_matrix(kstar, 4);
-	P = fb_malloc_matrix(kstar, 4);
-	p = fb_malloc_matrix(kstar, 4);
-	A = fb_malloc_matrix(kstar, 4);
-	TP = fb_malloc_matrix(kstar, 4);
-	TQ = fb_malloc_matrix(kstar, 4);
-	UQ = fb_malloc_matrix(kstar, 4);
-	d = fb_malloc_vector(kstar);
+	M = params->M;
+	Tmat = params->Tmat;
+	Einit = params->Einit;
 
 	/* set Q_k, P_k, and p_k */
 	for (k=0; k<kstar; k++) {
@@ -237,20 +231,36 @@ int fb_ks_func(double s, const double *y, double *f, void *params)
 		}
 	}
 
-	/* free memory */
-	fb_free_matrix(Q);
-	fb_free_matrix(P);
-	fb_free_matrix(p);
-	fb_free_matrix(A);
-	fb_free_matrix(TP);
-	fb_free_matrix(TQ);
-	fb_free_matrix(UQ);
-	fb_free_vector(d);
-
 	/* all done */
 	return(GSL_SUCCESS);
 }
 
+/* the derivatives function for the GSL ODE integrator */
+int fb_ks_func(double s, const double *y, double *f, void *params)
+{
+	int kstar;
+	fb_scratch_t *scratch;
+	double Q[FB_KS_KSMALL][4], P[FB_KS_KSMALL][4], p[FB_KS_KSMALL][4], A[FB_KS_KSMALL][4];
+	double TP[FB_KS_KSMALL][4], TQ[FB_KS_KSMALL][4], UQ[FB_KS_KSMALL][4], d[FB_KS_KSMALL];
+
+	kstar = (*(fb_ks_params_t *) params).kstar;
+
+	/* binary-single and binary-binary, which are nearly all of CMC's scatterings */
+	if (kstar == 3) {
+		return(fb_ks_kernel(y, f, (fb_ks_params_t *) params, 3, Q, P, p, A, TP, TQ, UQ, d));
+	} else if (kstar == 6) {
+		return(fb_ks_kernel(y, f, (fb_ks_params_t *) params, 6, Q, P, p, A, TP, TQ, UQ, d));
+	}
+
+	/* general N; work space allocated once per fewbody() call, with contiguous rows */
+	scratch = (*(fb_ks_params_t *) params).scratch;
+	return(fb_ks_kernel(y, f, (fb_ks_params_t *) params, kstar,
+			    (double (*)[4]) scratch->Q[0], (double (*)[4]) scratch->P[0],
+			    (double (*)[4]) scratch->p[0], (double (*)[4]) scratch->A[0],
+			    (double (*)[4]) scratch->TP[0], (double (*)[4]) scratch->TQ[0],
+			    (double (*)[4]) scratch->UQ[0], scratch->d));
+}
+
 /* function to calculate the Einit parameter for the integrator */
 /* the code here is a verbatim copy from the first part of fb_ks_func */
 double fb_ks_Einit(const double *y, fb_ks_params_t params)
@@ -259,12 +269,12 @@ double fb_ks_Einit(const double *y, fb_ks_params_t params)
 	double **Q, **P, **p, **A, *d;
 	double Qmat[4][4], T, U;
 
-	/* allocate memory */
-	Q = fb_malloc_matrix(params.kstar, 4);
-	P = fb_malloc_matrix(params.kstar, 4);
-	p = fb_malloc_matrix(params.kstar, 4);
-	A = fb_malloc_matrix(params.kstar, 4);
-	d = fb_malloc_vector(params.kstar);
+	/* work space, shared with fb_ks_func() */
+	Q = params.scratch->Q;
+	P = params.scratch->P;
+	p = params.scratch->p;
+	A = params.scratch->A;
+	d = params.scratch->d;
 
 	/* set Q_k, P_k, and p_k */
 	for (k=0; k<params.kstar; k++) {
@@ -310,13 +320,6 @@ double fb_ks_Einit(const double *y, fb_ks_params_t params)
 		U += params.M[k] / fb_ks_dot(Q[k], Q[k]);
 	}
 	
-	/* free memory */
-	fb_free_matrix(Q);
-	fb_free_matrix(P);
-	fb_free_matrix(p);
-	fb_free_matrix(A);
-	fb_free_vector(d);
-	
 	return(T-U);
 }
 
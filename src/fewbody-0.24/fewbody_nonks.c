@@ -32,14 +32,196 @@
 #define FB_REL(i, j, k) fmr[nstar*3*i + 3*j + k]
 #define pi2 9.869604401089359
 
+/* PN coefficients of the relative acceleration of a pair, a_PN = (A n + B v)/r^2 */
+static void fb_nonks_pn(int PN1, int PN2, int PN25, int PN3, int PN35, double clight2, double clight4, double clight5,
+			double SM, double nu, double r_mod, double rdot, double v2, double *Apn, double *Bpn) __attribute__ ((always_inline));
+static inline void fb_nonks_pn(int PN1, int PN2, int PN25, int PN3, int PN35, double clight2, double clight4, double clight5,
+			       double SM, double nu, double r_mod, double rdot, double v2, double *Apn, double *Bpn)
+{
+	double A2=0.,B2=0.,A4=0.,B4=0.,A5=0.,B5=0.,A6=0.,B6=0.,A7=0.,B7=0.;
+	double SM2, SM3, r_mod2, r_mod3;
+	double rdot2,rdot3,rdot4,rdot6,v4,v6;
+
+	SM2 = SM*SM;
+	SM3 = SM2*SM;
+	r_mod2 = r_mod*r_mod;
+	r_mod3 = r_mod2*r_mod;
+	v4 = v2*v2;
+	v6 = v4*v2;
+	rdot2 = rdot*rdot;
+	rdot3 = rdot2*rdot;
+	rdot4 = rdot2*rdot2;
+	rdot6 = rdot4*rdot2;
+
+	if (PN1) {
+		A2 = (-3*rdot2*nu/2 + v2 + 3*nu*v2 - \
+		      SM*(4+2*nu)/r_mod)/clight2;
+		B2 = (-4 + 2*nu)*rdot/clight2;
+	} 
+
+	if (PN2) {
+		A4 = (15*rdot4*nu/8-45*rdot4*nu*nu/8-\
+		      9*rdot2*nu*v2/2+6*rdot2*nu*nu*v2+\
+		      3*nu*v4-4*nu*nu*v2*\
+		      v2+SM*(-2*rdot2-25*rdot2*nu-2*rdot2*nu*nu-\
+					    13*nu*v2/2+2*nu*nu*v2)\
+		      /r_mod+SM2*(9+87*nu/4)/r_mod2)/clight4;
+		B4 = (9*rdot3*nu/2+3*rdot3*nu*nu-15*rdot*nu*v2/\
+		      2-2*rdot*nu*nu*v2+SM*(2*rdot+41*rdot*nu/2+4*rdot*nu*nu)/\
+		      r_mod)/clight4;
+	}
+
+	if (PN25) {
+		A5 = (-24*rdot*nu*v2*SM/(5*r_mod)-\
+		      136*rdot*nu*SM2/(15*r_mod2))/clight5;
+		B5 = (8*nu*v2*SM/(5*r_mod) + \
+		      24*nu*SM2/(5*r_mod2))/clight5;
+	}
+	
+	
+	if (PN3) {
+		A6 = -((16+(1399/12-41*pi2/16)*nu+35.5*nu*nu)*SM3/r_mod3 +\
+		       nu*v2*SM2*(20827/840+123*pi2/64-nu*nu)/r_mod2 - \
+		       rdot2*SM2*(1+(22717/168+615/64*pi2)*nu+11*nu*nu/8-7*nu*nu*nu)/r_mod2 - \
+		       0.25*nu*v6*(11-49*nu+52*nu*nu) + \
+		       35*rdot6*nu*(1-5*nu+5*nu*nu)/16 -\
+		       0.25*nu*SM*v4*(75+32*nu-40*nu*nu)/r_mod - \
+		       0.5*nu*rdot4*SM*(158-69*nu-60*nu*nu)/r_mod + \
+		       nu*SM*rdot2*v2*(121-16*nu-20*nu*nu)/r_mod  + \
+		       3*nu*v4*rdot2*(20-79*nu+60*nu*nu)/8 -\
+		       15*nu*rdot4*v2*(4-18*nu+17*nu*nu)/8 )/clight4/clight2;
+		B6 = -rdot*((4+((5849/840)+(123/32)*pi2)*nu-25*nu*nu-8*nu*nu*nu)*SM2/\
+			    r_mod2+nu*v4*(65-152*nu-48*nu*nu)/8+\
+			    15*nu*rdot4*(3-8*nu-2*nu*nu)/8+nu*(15+27*nu+10*nu*nu)*v2*\
+			    SM/r_mod-nu*SM*rdot2*(329+177*nu+108*nu*nu)/r_mod/6-\
+			    0.75*nu*rdot2*v2*(16-37*nu-16*nu*nu))/clight4/clight2;
+	}
+
+	if (PN35) {
+		A7 =  1.6*nu*SM*rdot*(23*SM2*(43+14*nu)/r_mod2/14+\
+				      3*v4*(61+70*nu)/\
+				      28+70*rdot4+SM*v2*(519-1267*nu)/42/r_mod +\
+				      SM*rdot2*(147+188*nu)/4/r_mod-\
+				      15*rdot2*v2*(19+2*nu)/4)/r_mod/clight5/clight2;
+		B7 = -1.6*nu*SM*(SM2*(1325+546*nu)/r_mod2/42+\
+				 v4*(313+42*nu)/28+75*rdot4-\
+				 SM*v2*(205+777*nu)/r_mod/42   +\
+				 SM*rdot2*(205+424*nu)/r_mod/12-\
+				 0.75*rdot2*v2*(113+2*nu))/r_mod/clight5/clight2;
+	}
+
+	*Apn = A2 + A4 + A5 + A6 + A7;
+	*Bpn = B2 + B4 + B5 + B6 + B7;
+}
+
+/* add the forces between stars i and j to f[]; used by the fixed-N kernels below,
+   which call it pair by pair in the same order as the general loop so each star's
+   acceleration is summed over j in ascending order */
+static void fb_nonks_pair(const double *y, double *f, const double *m, int i, int j, int pn, 
+			  int PN1, int PN2, int PN25, int PN3, int PN35, double clight2, double clight4, double clight5) __attribute__ ((always_inline));
+static inline void fb_nonks_pair(const double *y, double *f, const double *m, int i, int j, int pn,
+				 int PN1, int PN2, int PN25, int PN3, int PN35, double clight2, double clight4, double clight5)
+{
+	double r0, r1, r2, v0, v1, v2, r_mod, r_mod2, val, fm0, fm1, fm2;
+	double SM, nu, rdot, vsq, n0, n1, n2, A, B, fr0, fr1, fr2;
+
+	r0 = y[j*6+0] - y[i*6+0];
+	r1 = y[j*6+1] - y[i*6+1];
+	r2 = y[j*6+2] - y[i*6+2];
+	r_mod = sqrt(r0 * r0 + r1 * r1 + r2 * r2);
+	r_mod2 = r_mod*r_mod;
+	val = 1.0 / (r_mod2*r_mod);
+	fm0 = val * r0;
+	fm1 = val * r1;
+	fm2 = val * r2;
+
+	if (!pn) {
+		f[i*6+3] += m[j] * fm0;
+		f[i*6+4] += m[j] * fm1;
+		f[i*6+5] += m[j] * fm2;
+		f[j*6+3] += m[i] * (-fm0);
+		f[j*6+4] += m[i] * (-fm1);
+		f[j*6+5] += m[i] * (-fm2);
+		return;
+	}
+
+	v0 = y[j*6+3] - y[i*6+3];
+	v1 = y[j*6+4] - y[i*6+4];
+	v2 = y[j*6+5] - y[i*6+5];
+	SM = m[i] + m[j];
+	nu = m[i]*m[j]/(SM*SM);
+	n0 = r0/r_mod;
+	n1 = r1/r_mod;
+	n2 = r2/r_mod;
+	rdot = 0;
+	rdot += n0*v0;
+	rdot += n1*v1;
+	rdot += n2*v2;
+	vsq = sqrt(v0 * v0 + v1 * v1 + v2 * v2);
+	vsq = vsq*vsq;
+
+	fb_nonks_pn(PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5, SM, nu, r_mod, rdot, vsq, &A, &B);
+
+	fr0 = (A*n0+B*v0) / r_mod2;
+	fr1 = (A*n1+B*v1) / r_mod2;
+	fr2 = (A*n2+B*v2) / r_mod2;
+
+	f[i*6+3] += m[j] * fm0 + m[j] * fr0;
+	f[i*6+4] += m[j] * fm1 + m[j] * fr1;
+	f[i*6+5] += m[j] * fm2 + m[j] * fr2;
+	f[j*6+3] += m[i] * (-fm0) + m[i] * (-fr0);
+	f[j*6+4] += m[i] * (-fm1) + m[i] * (-fr1);
+	f[j*6+5] += m[i] * (-fm2) + m[i] * (-fr2);
+}
+
+/* set the velocity half of f[] and zero the accelerations */
+static void fb_nonks_init_f(const double *y, double *f, int nstar) __attribute__ ((always_inline));
+static inline void fb_nonks_init_f(const double *y, double *f, int nstar)
+{
+	int i, k;
+
+	for (i=0; i<nstar; i++) {
+		for (k=0; k<3; k++) {
+			f[i*6+k] = y[i*6+k+3];
+			f[i*6+k+3] = 0.0;
+		}
+	}
+}
+
+/* unrolled kernel for three stars: binary-single */
+static int fb_nonks_func3(const double *y, double *f, const double *m, int pn,
+			  int PN1, int PN2, int PN25, int PN3, int PN35, double clight2, double clight4, double clight5)
+{
+	fb_nonks_init_f(y, f, 3);
+	fb_nonks_pair(y, f, m, 0, 1, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+	fb_nonks_pair(y, f, m, 0, 2, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+	fb_nonks_pair(y, f, m, 1, 2, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+
+	return(GSL_SUCCESS);
+}
+
+/* unrolled kernel for four stars: binary-binary */
+static int fb_nonks_func4(const double *y, double *f, const double *m, int pn,
+			  int PN1, int PN2, int PN25, int PN3, int PN35, double clight2, double clight4, double clight5)
+{
+	fb_nonks_init_f(y, f, 4);
+	fb_nonks_pair(y, f, m, 0, 1, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+	fb_nonks_pair(y, f, m, 0, 2, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+	fb_nonks_pair(y, f, m, 0, 3, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+	fb_nonks_pair(y, f, m, 1, 2, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+	fb_nonks_pair(y, f, m, 1, 3, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+	fb_nonks_pair(y, f, m, 2, 3, pn, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5);
+
+	return(GSL_SUCCESS);
+}
+
 int fb_nonks_func(double t, const double *y, double *f, void *params)
 {
 	int i, j, k, nstar, PN1, PN2, PN25, PN3, PN35;
 	double n[3],r[3],v[3], *m, *fm, *fmr, val, rdot, SM, nu;
-	double  A=0.,B=0.,A2=0.,B2=0.,A4=0.,B4=0.,A5=0.,B5=0.,A6=0.,B6=0.,A7=0.,B7=0.;
-	double clight, clight2, clight4, clight5, R, Mclus, aclus;
-	double SM2, SM3;
-	double rdot2,rdot3,rdot4,rdot6,v2,v4,v6;
+	double A=0.,B=0.;
+	double clight, clight2, clight4, clight5;
+	double v2;
 	double r_mod, r_mod2, r_mod3;
 	fb_units_t units;
 	
@@ -51,14 +233,20 @@ int fb_nonks_func(double t, const double *y, double *f, void *params)
 	PN3 = (*(fb_nonks_params_t *) params).PN3;
 	PN35 = (*(fb_nonks_params_t *) params).PN35;
 	units = (*(fb_nonks_params_t *) params).units;
+	fm = (*(fb_nonks_params_t *) params).scratch->fm;
+	fmr = (*(fb_nonks_params_t *) params).scratch->fmr;
 
 	clight = FB_CONST_C / units.v;
 	clight2 = fb_sqr(clight);
 	clight4 = fb_sqr(clight2);
 	clight5 = clight4 * clight;
 
-	fm = fb_malloc_vector(nstar * nstar * 3);
-	fmr = fb_malloc_vector(nstar * nstar * 3);
+	/* CMC's scatterings are almost all binary-single or binary-binary */
+	if (nstar == 3) {
+		return(fb_nonks_func3(y, f, m, PN1||PN2||PN25||PN3||PN35, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5));
+	} else if (nstar == 4) {
+		return(fb_nonks_func4(y, f, m, PN1||PN2||PN25||PN3||PN35, PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5));
+	}
 
 	/* calculate the matrix */
 	for (i=0; i<nstar; i++) {
@@ -72,10 +260,7 @@ int fb_nonks_func(double t, const double *y, double *f, void *params)
 			
 			/* First, precalculate a lot of quantities */
 			SM = m[i] + m[j];
-			SM2 = SM*SM;
-			nu = m[i]*m[j]/(SM2);
-			SM3 = SM2*SM;
-	
+			nu = m[i]*m[j]/(SM*SM);
 		
 			for (k=0; k<3; k++) {
 				r[k] = y[j*6+k] - y[i*6+k];	
@@ -93,73 +278,8 @@ int fb_nonks_func(double t, const double *y, double *f, void *params)
 			}
 
 			v2 = fb_mod(v)*fb_mod(v);
-			v4 = v2*v2;
-			v6 = v4*v2;
-			rdot2 = rdot*rdot;
-			rdot3 = rdot2*rdot;
-			rdot4 = rdot2*rdot2;
-			rdot6 = rdot4*rdot2;
-			
-			if (PN1) {
-				A2 = (-3*rdot2*nu/2 + v2 + 3*nu*v2 - \
-				      SM*(4+2*nu)/r_mod)/clight2;
-				B2 = (-4 + 2*nu)*rdot/clight2;
-			} 
-
-			if (PN2) {
-				A4 = (15*rdot4*nu/8-45*rdot4*nu*nu/8-\
-				      9*rdot2*nu*v2/2+6*rdot2*nu*nu*v2+\
-				      3*nu*v4-4*nu*nu*v2*\
-				      v2+SM*(-2*rdot2-25*rdot2*nu-2*rdot2*nu*nu-\
-							    13*nu*v2/2+2*nu*nu*v2)\
-				      /r_mod+SM2*(9+87*nu/4)/r_mod2)/clight4;
-				B4 = (9*rdot3*nu/2+3*rdot3*nu*nu-15*rdot*nu*v2/\
-				      2-2*rdot*nu*nu*v2+SM*(2*rdot+41*rdot*nu/2+4*rdot*nu*nu)/\
-				      r_mod)/clight4;
-			}
-
-			if (PN25) {
-				A5 = (-24*rdot*nu*v2*SM/(5*r_mod)-\
-				      136*rdot*nu*SM2/(15*r_mod2))/clight5;
-				B5 = (8*nu*v2*SM/(5*r_mod) + \
-				      24*nu*SM2/(5*r_mod2))/clight5;
-			}
-			
-			
-			if (PN3) {
-				A6 = -((16+(1399/12-41*pi2/16)*nu+35.5*nu*nu)*SM3/r_mod3 +\
-				       nu*v2*SM2*(20827/840+123*pi2/64-nu*nu)/r_mod2 - \
-				       rdot2*SM2*(1+(22717/168+615/64*pi2)*nu+11*nu*nu/8-7*nu*nu*nu)/r_mod2 - \
-				       0.25*nu*v6*(11-49*nu+52*nu*nu) + \
-				       35*rdot6*nu*(1-5*nu+5*nu*nu)/16 -\
-				       0.25*nu*SM*v4*(75+32*nu-40*nu*nu)/r_mod - \
-				       0.5*nu*rdot4*SM*(158-69*nu-60*nu*nu)/r_mod + \
-				       nu*SM*rdot2*v2*(121-16*nu-20*nu*nu)/r_mod  + \
-				       3*nu*v4*rdot2*(20-79*nu+60*nu*nu)/8 -\
-				       15*nu*rdot4*v2*(4-18*nu+17*nu*nu)/8 )/clight4/clight2;
-				B6 = -rdot*((4+((5849/840)+(123/32)*pi2)*nu-25*nu*nu-8*nu*nu*nu)*SM2/\
-					    r_mod2+nu*v4*(65-152*nu-48*nu*nu)/8+\
-					    15*nu*rdot4*(3-8*nu-2*nu*nu)/8+nu*(15+27*nu+10*nu*nu)*v2*\
-					    SM/r_mod-nu*SM*rdot2*(329+177*nu+108*nu*nu)/r_mod/6-\
-					    0.75*nu*rdot2*v2*(16-37*nu-16*nu*nu))/clight4/clight2;
-			}
-
-			if (PN35) {
-				A7 =  1.6*nu*SM*rdot*(23*SM2*(43+14*nu)/r_mod2/14+\
-						      3*v4*(61+70*nu)/\
-						      28+70*rdot4+SM*v2*(519-1267*nu)/42/r_mod +\
-						      SM*rdot2*(147+188*nu)/4/r_mod-\
-						      15*rdot2*v2*(19+2*nu)/4)/r_mod/clight5/clight2;
-				B7 = -1.6*nu*SM*(SM2*(1325+546*nu)/r_mod2/42+\
-						 v4*(313+42*nu)/28+75*rdot4-\
-						 SM*v2*(205+777*nu)/r_mod/42   +\
-						 SM*rdot2*(205+424*nu)/r_mod/12-\
-						 0.75*rdot2*v2*(113+2*nu))/r_mod/clight5/clight2;
-			}
-
-			A = A2 + A4 + A5 + A6 + A7;
-			B = B2 + B4 + B5 + B6 + B7;
 
+			fb_nonks_pn(PN1, PN2, PN25, PN3, PN35, clight2, clight4, clight5, SM, nu, r_mod, rdot, v2, &A, &B);
 
 			val = 1.0 / r_mod3;
 			for (k=0; k<3; k++) {
@@ -189,9 +309,6 @@ int fb_nonks_func(double t, const double *y, double *f, void *params)
 		}
 	}
 
-	fb_free_vector(fm);
-	fb_free_vector(fmr);
-
 	return(GSL_SUCCESS);
 }
 #undef FB_FM
@@ -22,6 +22,9 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <math.h>
+#include <time.h>
+#include <sys/times.h>
+#include <unistd.h>
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_roots.h>
 #include "fewbody.h"
@@ -74,6 +77,25 @@ double fb_cub(double x)
 	return(x*x*x);
 }
 
+/* CPU time (s) used by the calling thread, so that several integrations can
+   run side by side on threads without eating into each other's tcpustop */
+double fb_cputime(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+		return(ts.tv_sec + 1.0e-9 * ts.tv_nsec);
+	}
+#endif
+	{
+		struct tms timebuf;
+
+		times(&timebuf);
+		return(((double) (timebuf.tms_utime + timebuf.tms_stime))/((double) sysconf(_SC_CLK_TCK)));
+	}
+}
+
 /* the dot product of two vectors */
 double fb_dot(double x[3], double y[3])
 {
@@ -147,11 +147,13 @@ int main(int argc, char *argv[])
 	input.Dflag = 0;
 	input.dt = FB_DT;
 	input.tcpustop = FB_TCPUSTOP;
+	input.countstop = 0;
 	input.absacc = FB_ABSACC;
 	input.relacc = FB_RELACC;
 	input.ncount = FB_NCOUNT;
 	input.tidaltol = FB_TIDALTOL;
 	input.fexp = FB_FEXP;
+	input.integrator = FB_INTEGRATOR_RK8PD;
 	seed = FB_SEED;
 	fb_debug = FB_DEBUG;
 	